@@ -0,0 +1,28 @@
+# - Try to find quadmath library (__float128 support of GCC)
+#
+# Usage of this module as follows:
+#
+#     find_package(Quadmath)
+#
+# Variables defined by this module:
+#
+#  QUADMATH_FOUND            Compiler supports __float128 and libquadmath
+#                            can be linked
+#  Quadmath_LIBRARY          The quadmath library.
+
+include(CheckCXXSourceCompiles)
+
+set(CMAKE_REQUIRED_LIBRARIES quadmath)
+check_cxx_source_compiles("
+#include <quadmath.h>
+int main() {
+  __float128 x = sqrtq(2);
+  return x > 1 ? 0 : 1;
+}" QUADMATH_FOUND)
+unset(CMAKE_REQUIRED_LIBRARIES)
+
+if(QUADMATH_FOUND)
+  set(Quadmath_LIBRARY quadmath)
+endif(QUADMATH_FOUND)
+
+mark_as_advanced(Quadmath_LIBRARY)
@@ -0,0 +1,40 @@
+#include "calculator/allocations.hpp"
+
+#include <cstdlib>
+#include <new>
+
+// Replaces global operator new of the program with one counting
+// allocations of every thread (see Allocations). It is linked only
+// into programs measuring allocations, the library itself keeps
+// allocators of programs embedding it.
+
+namespace {
+
+//! Marks allocations as counted before main is entered
+bool const counted = (XX::Calculator::Allocations::counted = true);
+
+}
+
+// they are not inlined, so the compiler sees matching new and delete
+
+__attribute__((noinline)) void* operator new(std::size_t size) {
+  XX::Calculator::Allocations::record(size);
+
+  void* pointer = std::malloc(size > 0 ? size : 1);
+  if (pointer == nullptr)
+    throw std::bad_alloc();
+
+  return pointer;
+}
+
+void* operator new[](std::size_t size) {
+  return operator new(size);
+}
+
+__attribute__((noinline)) void operator delete(void* pointer) noexcept {
+  std::free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept {
+  operator delete(pointer);
+}
@@ -0,0 +1,653 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "calculator/tokenizer.hpp"
+#include "calculator/parser.hpp"
+#include "calculator/linear_solver.hpp"
+#include "calculator/functions.hpp"
+#include "calculator/errors.hpp"
+#include "calculator/allocations.hpp"
+#include "counters.hpp"
+
+using namespace XX;
+
+namespace {
+
+//! Expressions evaluated in every benchmark of types of values
+const std::vector<std::string> expressions = {
+  "2+2*2",
+  "(3+(4-1))*5",
+  "2x+1=2(1-x)",
+  "(x+1)^8",
+  "(x^4-1)/(x-1)",
+  "log(2, 10)*pi+e",
+  "bind((x-2)^3, 5)",
+  "(x^2+2x+1)*(x^3-x+2)*(3x-4)",
+  "(x^2+0.1)*(x^2-0.1)/(x+0.5)",
+  "x/3+x/7=1/11"
+};
+
+//! Invalid expressions evaluated by benchmarks of failures
+const std::vector<std::string> failures = {
+  "2+y*3",
+  "(1+2",
+  "x=x",
+  "2 $ 3",
+  "log(2)",
+  "x^2=5"
+};
+
+//! Degrees of values used by benchmarks of operators
+const std::vector<unsigned long> degrees = {1, 16, 256, 4096};
+
+/**
+ * Benchmark of a single operation. It performs the operation given
+ * number of times and returns a number depending on the results, so
+ * the compiler cannot skip the work.
+ */
+struct Benchmark {
+  //! Name of the benchmark (stage and its parameters)
+  std::string name;
+  //! Performs the operation repeatedly
+  std::function<double(unsigned long iterations)> run;
+};
+
+/**
+ * Measured times of a benchmark
+ */
+struct Result {
+  //! Name of the benchmark
+  std::string name;
+  //! Number of operations in a sample
+  unsigned long iterations;
+  //! Nanoseconds per operation of every sample (sorted)
+  std::vector<double> samples;
+  //! Hardware events counted during every sample
+  IO::Counters::Values counts;
+  //! Allocations made during every sample
+  Calculator::Allocations allocations;
+
+  //! Median time of an operation
+  double median() const { return samples[samples.size() / 2]; }
+
+  //! Average count of an event per operation
+  double per_operation(IO::Counters::Event event) const {
+    return double(counts[event]) / (iterations * samples.size());
+  }
+
+  //! Average number of allocations per operation
+  double allocations_per_operation() const {
+    return double(allocations.count) / (iterations * samples.size());
+  }
+};
+
+/**
+ * Generates random expressions of the calculator. The generator is
+ * seeded, so the same expressions are benchmarked every time.
+ */
+class Generator {
+  public:
+
+  //! Creates generator with given seed
+  explicit Generator(unsigned long seed) : random(seed) { }
+
+  /**
+   * Generates an expression. Values which could fail evaluation
+   * (divisors, exponents and arguments of functions) are constant,
+   * so the expression always evaluates.
+   *
+   * @param depth Largest depth of nested operations
+   * @param polynomial True if x may appear in the expression
+   * @return Text of the expression
+   */
+  std::string expression(unsigned depth, bool polynomial = true) {
+    if (depth == 0 || number(0, 3) == 0)
+      return leaf(polynomial);
+
+    switch (number(0, 7)) {
+      case 0:
+        return expression(depth - 1, polynomial) + "+" + expression(depth - 1, polynomial);
+      case 1:
+        return expression(depth - 1, polynomial) + "-" + expression(depth - 1, polynomial);
+      case 2:
+        return expression(depth - 1, polynomial) + "*" + expression(depth - 1, polynomial);
+      case 3:
+        return "(" + expression(depth - 1, polynomial) + ")/(" + expression(depth - 1, false) + "+100)";
+      case 4:
+        return "(" + expression(depth - 1, polynomial) + ")^" + std::to_string(number(0, 4));
+      case 5:
+        return "log(" + expression(depth - 1, false) + "*" + expression(depth - 1, false) + "+1, 10)";
+      case 6:
+        return "exp(" + leaf(false) + "/100)";
+      default:
+        return "(" + expression(depth - 1, polynomial) + ")";
+    }
+  }
+
+  /**
+   * Generates a linear equation of x.
+   *
+   * @return Text of the equation
+   */
+  std::string equation() {
+    return coefficient() + "x+" + coefficient() + "=" + coefficient() + "(x-" + coefficient() + ")/" +
+           std::to_string(number(2, 9));
+  }
+
+  /**
+   * Generates a monic polynomial with random coefficients.
+   *
+   * @param degree Degree of the polynomial
+   * @param scale Largest absolute value of other coefficients
+   * @return The polynomial
+   */
+  template <typename V>
+  V value(unsigned long degree, double scale = 10) {
+    typedef typename V::coefficient_type T;
+    std::uniform_real_distribution<double> distribution(-scale, scale);
+    std::vector<T> coefficients(degree + 1);
+
+    for (auto& c : coefficients)
+      c = T(distribution(random));
+    coefficients[degree] = T(1);
+
+    return V(coefficients);
+  }
+
+  private:
+
+  //! Random integer in [min, max]
+  unsigned long number(unsigned long min, unsigned long max) {
+    return std::uniform_int_distribution<unsigned long>(min, max)(random);
+  }
+
+  //! Random number as text (integer or decimal)
+  std::string coefficient() {
+    if (number(0, 1) == 0)
+      return std::to_string(number(1, 1000));
+    else
+      return std::to_string(number(0, 99)) + "." + std::to_string(number(0, 999));
+  }
+
+  //! Number, constant or x
+  std::string leaf(bool polynomial) {
+    switch (number(0, polynomial ? 5 : 4)) {
+      case 0:
+        return "pi";
+      case 1:
+        return "e";
+      case 5:
+        return "x";
+      default:
+        return coefficient();
+    }
+  }
+
+  //! Source of randomness
+  std::mt19937_64 random;
+};
+
+/**
+ * Benchmark of a solver with given type of values, evaluating the
+ * fixed expressions (every operation is a single expression).
+ *
+ * @param name Name of the value type
+ * @param direct Whether lines are compiled directly (without tokens)
+ * @return The benchmark
+ */
+template <typename V>
+Benchmark solver_benchmark(std::string const& name, bool direct = false) {
+  return {"solver/" + name, [=](unsigned long iterations) {
+    Calculator::Tokenizer tokenizer;
+    Calculator::Parser parser;
+    Calculator::BasicLinearSolver<V> solver(tokenizer, parser);
+    solver.set_direct_compilation(direct);
+    double sink = 0;
+
+    for (unsigned long i = 0; i < iterations; i++) {
+      try {
+        sink += solver.process(expressions[i % expressions.size()]).degree();
+      }
+      catch (Calculator::Error& error) {
+        sink++;
+      }
+    }
+
+    return sink;
+  }};
+}
+
+/**
+ * Benchmark of a binary operator of values of given degree.
+ *
+ * @param name Name of the operator
+ * @param degree Degree of operands
+ * @param generator Generator of operands
+ * @param operation Performed operation
+ * @return The benchmark
+ */
+Benchmark operator_benchmark(std::string const& name, unsigned long degree, Generator& generator,
+                             std::function<Calculator::Value(Calculator::Value const&, Calculator::Value const&)>
+                               operation) {
+  Calculator::Value a = generator.value<Calculator::Value>(degree);
+  Calculator::Value b = generator.value<Calculator::Value>(degree);
+
+  // divisor has lower degree and small coefficients, so the quotient
+  // does not overflow
+  if (name == "div") {
+    unsigned long divisor_degree = std::max(1ul, degree / 2);
+    b = generator.value<Calculator::Value>(divisor_degree, 0.5 / divisor_degree);
+  }
+
+  return {"value/" + name + "/" + std::to_string(degree), [=](unsigned long iterations) {
+    double sink = 0;
+
+    for (unsigned long i = 0; i < iterations; i++)
+      sink += operation(a, b)[0];
+
+    return sink;
+  }};
+}
+
+/**
+ * Creates benchmarks of every stage of the pipeline.
+ *
+ * @param seed Seed of generated inputs
+ * @return Benchmarks in order of running
+ */
+std::vector<Benchmark> benchmarks(unsigned long seed) {
+  typedef Calculator::Value Value;
+
+  Generator generator(seed);
+  std::vector<Benchmark> list;
+
+  // inputs shared by stages of the pipeline
+  std::vector<std::string> inputs;
+  for (int i = 0; i < 100; i++)
+    inputs.push_back(generator.expression(4));
+
+  Calculator::Tokenizer tokenizer;
+  Calculator::Parser parser;
+  Calculator::PolynomialCalculator calculator(tokenizer, parser);
+
+  std::vector<Calculator::TokenList> tokens, parsed;
+  for (auto const& input : inputs) {
+    tokens.push_back(tokenizer.process(input));
+    parsed.push_back(calculator.parse(input));
+  }
+
+  list.push_back({"tokenizer", [=](unsigned long iterations) {
+    Calculator::Tokenizer tokenizer;
+    double sink = 0;
+
+    for (unsigned long i = 0; i < iterations; i++)
+      sink += tokenizer.process(inputs[i % inputs.size()]).size();
+
+    return sink;
+  }});
+
+  // tokens are consumed by the parser, so a copy is parsed
+  list.push_back({"parser", [=](unsigned long iterations) {
+    Calculator::Tokenizer tokenizer;
+    Calculator::Parser parser;
+    // registers operators with the parser
+    Calculator::PolynomialCalculator calculator(tokenizer, parser);
+    double sink = 0;
+
+    for (unsigned long i = 0; i < iterations; i++) {
+      Calculator::TokenList copy = tokens[i % tokens.size()];
+      sink += parser.process(copy).size();
+    }
+
+    return sink;
+  }});
+
+  list.push_back({"evaluator", [=](unsigned long iterations) {
+    Calculator::Tokenizer tokenizer;
+    Calculator::Parser parser;
+    Calculator::PolynomialCalculator calculator(tokenizer, parser);
+    double sink = 0;
+
+    for (unsigned long i = 0; i < iterations; i++) {
+      Calculator::TokenList const& expression = parsed[i % parsed.size()];
+
+      try {
+        sink += calculator.process([&](Calculator::Evaluator& evaluator,
+                                       Calculator::Evaluator::Program& program) {
+          evaluator.compile(expression, program);
+        }).degree();
+      }
+      catch (Calculator::Error& error) {
+        sink++;
+      }
+    }
+
+    return sink;
+  }});
+
+  // long sum as test/zero_gen.rb writes it
+  std::string sum = "1", difference = "-1";
+  for (int i = 2; i <= 1000; i++) {
+    sum += "+" + std::to_string(i);
+    difference += "-" + std::to_string(i);
+  }
+
+  Calculator::TokenList sum_tokens = parser.process(tokenizer.process(sum + difference));
+
+  // compiled once, as evaluation of scalars does not consume it
+  list.push_back({"evaluator/sum", [=](unsigned long iterations) {
+    typedef Calculator::Evaluator::ScalarFunction::Operation Operation;
+
+    Calculator::Evaluator evaluator;
+    evaluator.register_function("+", 2, Calculator::Functions::addition, Operation::ADDITION, true);
+    evaluator.register_function("-", 2, Calculator::Functions::subtraction, Operation::SUBTRACTION, true);
+
+    Calculator::Evaluator::Program program;
+    evaluator.compile(sum_tokens, program);
+    double sink = 0;
+
+    for (unsigned long i = 0; i < iterations; i++)
+      sink += evaluator.execute(program)[0];
+
+    return sink;
+  }});
+
+  for (unsigned long degree : degrees) {
+    list.push_back(operator_benchmark("add", degree, generator, std::plus<Value>()));
+    list.push_back(operator_benchmark("sub", degree, generator, std::minus<Value>()));
+    list.push_back(operator_benchmark("mul", degree, generator, std::multiplies<Value>()));
+    list.push_back(operator_benchmark("div", degree, generator, std::divides<Value>()));
+  }
+
+  for (unsigned long exponent : {2ul, 8ul, 64ul}) {
+    Value base = generator.value<Value>(4);
+
+    list.push_back({"functions/exponentiation/" + std::to_string(exponent), [=](unsigned long iterations) {
+      double sink = 0;
+
+      for (unsigned long i = 0; i < iterations; i++)
+        sink += Calculator::Functions::exponentiation({base, Value(exponent)})[0];
+
+      return sink;
+    }});
+  }
+
+  list.push_back({"functions/exponentiation/constant", [](unsigned long iterations) {
+    double sink = 0;
+
+    for (unsigned long i = 0; i < iterations; i++)
+      sink += Calculator::Functions::exponentiation({Value(2.5 + i % 7), Value(0.5)})[0];
+
+    return sink;
+  }});
+
+  std::vector<std::string> equations;
+  for (int i = 0; i < 100; i++)
+    equations.push_back(generator.equation());
+
+  list.push_back({"linear_solver", [=](unsigned long iterations) {
+    Calculator::Tokenizer tokenizer;
+    Calculator::Parser parser;
+    Calculator::LinearSolver solver(tokenizer, parser);
+    double sink = 0;
+
+    for (unsigned long i = 0; i < iterations; i++) {
+      try {
+        sink += solver.process(equations[i % equations.size()])[0];
+      }
+      catch (Calculator::Error& error) {
+        sink++;
+      }
+    }
+
+    return sink;
+  }});
+
+  for (unsigned long degree : degrees) {
+    Value value = generator.value<Value>(degree);
+
+    list.push_back({"value/repr/" + std::to_string(degree), [=](unsigned long iterations) {
+      const std::string variable("x");
+      std::string output;
+      double sink = 0;
+
+      for (unsigned long i = 0; i < iterations; i++) {
+        output.clear();
+        value.repr(output, variable);
+        sink += output.size();
+      }
+
+      return sink;
+    }});
+  }
+
+  list.push_back(solver_benchmark<Calculator::FloatValue>("float"));
+  list.push_back(solver_benchmark<Calculator::Value>("double"));
+  list.push_back(solver_benchmark<Calculator::Value>("direct", true));
+  list.push_back(solver_benchmark<Calculator::LongDoubleValue>("long-double"));
+#ifdef XXCALC_FLOAT128
+  list.push_back(solver_benchmark<Calculator::Float128Value>("float128"));
+#endif
+  list.push_back(solver_benchmark<Calculator::ExactValue>("exact"));
+
+  // generated formulas repeat their subexpressions
+  list.push_back({"solver/repeated", [](unsigned long iterations) {
+    Calculator::Tokenizer tokenizer;
+    Calculator::Parser parser;
+    Calculator::LinearSolver solver(tokenizer, parser);
+    double sink = 0;
+
+    for (unsigned long i = 0; i < iterations; i++)
+      sink += solver.process("(x^3+2x-1)^4*(x^3+2x-1)^4+(x^3+2x-1)^4*(x^3+2x-1)-(x^3+2x-1)^4").degree();
+
+    return sink;
+  }});
+
+  list.push_back({"failures/throwing", [](unsigned long iterations) {
+    Calculator::Tokenizer tokenizer;
+    Calculator::Parser parser;
+    Calculator::LinearSolver solver(tokenizer, parser);
+    double sink = 0;
+
+    for (unsigned long i = 0; i < iterations; i++) {
+      try {
+        solver.process(failures[i % failures.size()]);
+      }
+      catch (Calculator::Error& error) {
+        sink += std::strlen(error.what());
+      }
+    }
+
+    return sink;
+  }});
+
+  list.push_back({"failures/status", [](unsigned long iterations) {
+    Calculator::Tokenizer tokenizer;
+    Calculator::Parser parser;
+    Calculator::LinearSolver solver(tokenizer, parser);
+    double sink = 0;
+
+    for (unsigned long i = 0; i < iterations; i++)
+      sink += static_cast<int>(solver.try_process(failures[i % failures.size()]).status.code);
+
+    return sink;
+  }});
+
+  return list;
+}
+
+//! Destination of results of benchmarks
+volatile double sink;
+
+/**
+ * Measures a benchmark. Unless the number of iterations is given,
+ * it is doubled until a sample takes at least given time. Hardware
+ * events and allocations are counted during samples (but not
+ * calibration).
+ *
+ * @param benchmark Measured benchmark
+ * @param counters Hardware counters of the thread
+ * @param iterations Operations in a sample (zero to calibrate)
+ * @param samples Number of samples
+ * @param time Least duration of a sample in seconds
+ * @return Measured times
+ */
+Result measure(Benchmark const& benchmark, IO::Counters const& counters,
+               unsigned long iterations, unsigned samples, double time) {
+  typedef std::chrono::steady_clock Clock;
+
+  auto sample = [&](unsigned long count) {
+    auto start = Clock::now();
+    sink = benchmark.run(count);
+    return std::chrono::duration<double>(Clock::now() - start).count();
+  };
+
+  if (iterations == 0) {
+    iterations = 1;
+    while (sample(iterations) < time)
+      iterations *= 2;
+  }
+
+  Result result{benchmark.name, iterations, {}, {}, {}};
+  result.samples.reserve(samples);
+
+  for (unsigned i = 0; i < samples; i++) {
+    IO::Counters::Values start = counters.read();
+    Calculator::Allocations allocations = Calculator::Allocations::current();
+    result.samples.push_back(sample(iterations) * 1e9 / iterations);
+    result.allocations += Calculator::Allocations::current() - allocations;
+    result.counts += counters.read() - start;
+  }
+
+  std::sort(result.samples.begin(), result.samples.end());
+  return result;
+}
+
+/**
+ * Prints results as a table, with allocations per operation, and
+ * average counts of hardware events per operation and instructions
+ * per cycle if they are counted.
+ */
+void print_text(std::vector<Result> const& results, IO::Counters const& counters) {
+  for (auto const& result : results) {
+    std::cout << std::left << std::setw(36) << result.name << std::right
+              << std::fixed << std::setprecision(1)
+              << std::setw(14) << result.median() << " ns/op"
+              << std::setprecision(0)
+              << std::setw(14) << 1e9 / result.median() << " op/s"
+              << std::setprecision(1)
+              << std::setw(10) << result.allocations_per_operation() << " allocs/op";
+
+    for (int i = 0; i < IO::Counters::EVENTS; i++) {
+      IO::Counters::Event event = IO::Counters::Event(i);
+
+      if (counters.available(event))
+        std::cout << std::setprecision(1) << std::setw(14) << result.per_operation(event)
+                  << ' ' << IO::Counters::name(event);
+    }
+
+    if (counters.available(IO::Counters::CYCLES) && counters.available(IO::Counters::INSTRUCTIONS) &&
+        result.counts[IO::Counters::CYCLES] > 0)
+      std::cout << std::setprecision(2) << std::setw(8)
+                << double(result.counts[IO::Counters::INSTRUCTIONS]) / result.counts[IO::Counters::CYCLES]
+                << " ipc";
+
+    std::cout << std::endl;
+  }
+}
+
+//! Prints results as JSON (with allocations and counts of hardware
+//! events per operation if they are counted)
+void print_json(std::vector<Result> const& results, IO::Counters const& counters, unsigned long seed) {
+  std::cout << std::setprecision(6) << "{\n  \"seed\": " << seed << ",\n  \"unit\": \"ns\",\n"
+            << "  \"benchmarks\": [";
+
+  for (std::size_t i = 0; i < results.size(); i++) {
+    Result const& result = results[i];
+
+    std::cout << (i > 0 ? "," : "") << "\n    {\"name\": \"" << result.name << "\""
+              << ", \"iterations\": " << result.iterations
+              << ", \"samples\": " << result.samples.size()
+              << ", \"median\": " << result.median()
+              << ", \"min\": " << result.samples.front()
+              << ", \"max\": " << result.samples.back()
+              << ", \"allocations\": " << result.allocations_per_operation();
+
+    for (int i = 0; i < IO::Counters::EVENTS; i++) {
+      IO::Counters::Event event = IO::Counters::Event(i);
+
+      if (counters.available(event))
+        std::cout << ", \"" << IO::Counters::name(event) << "\": " << result.per_operation(event);
+    }
+
+    std::cout << "}";
+  }
+
+  std::cout << "\n  ]\n}" << std::endl;
+}
+
+}
+
+int main(int argc, char** argv) {
+  unsigned long iterations = 0;
+  unsigned long seed = 1;
+  unsigned samples = 5;
+  double time = 0.05;
+  bool json = false;
+  std::string filter;
+
+  for (int i = 1; i < argc; i++) {
+    std::string option(argv[i]);
+
+    if ((option == "-n" || option == "--iterations") && i + 1 < argc) {
+      iterations = std::stoul(argv[++i]);
+    } else
+    if ((option == "-s" || option == "--samples") && i + 1 < argc) {
+      samples = std::max(1ul, std::stoul(argv[++i]));
+    } else
+    if ((option == "-t" || option == "--time") && i + 1 < argc) {
+      time = std::stod(argv[++i]);
+    } else
+    if ((option == "-f" || option == "--filter") && i + 1 < argc) {
+      filter = argv[++i];
+    } else
+    if (option == "--seed" && i + 1 < argc) {
+      seed = std::stoul(argv[++i]);
+    } else
+    if (option == "--json") {
+      json = true;
+    } else {
+      std::cerr << "Usage: " << argv[0] << " [--iterations N] [--samples N] [--time SECONDS]"
+                << " [--filter TEXT] [--seed N] [--json]" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  IO::Counters counters;
+  if (!counters.error().empty())
+    std::cerr << counters.error() << ", only counted events are reported" << std::endl;
+
+  std::vector<Result> results;
+
+  for (auto const& benchmark : benchmarks(seed)) {
+    if (benchmark.name.find(filter) == std::string::npos)
+      continue;
+
+    results.push_back(measure(benchmark, counters, iterations, samples, time));
+
+    if (!json)
+      print_text({results.back()}, counters);
+  }
+
+  if (json)
+    print_json(results, counters, seed);
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,303 @@
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+#include "calculator/columns.hpp"
+#include "calculator/format.hpp"
+#include "io.hpp"
+#include "parallel.hpp"
+
+using namespace XX;
+
+namespace {
+
+/**
+ * Appends results to the output - as text, one number per line
+ * (formatted as xxcalc formats constants), or as raw doubles.
+ *
+ * @param results Evaluated results
+ * @param count Number of results
+ * @param raw True to append raw doubles
+ * @param output Destination
+ */
+void append_results(double const* results, std::size_t count, bool raw, std::string& output) {
+  if (raw) {
+    output.append(reinterpret_cast<char const*>(results), count * sizeof(double));
+    return;
+  }
+
+  for (std::size_t i = 0; i < count; i++) {
+    Calculator::append_number(output, results[i]);
+    output += '\n';
+  }
+}
+
+//! Removes spaces and carriage return around a field
+void trim(char const*& begin, char const*& end) {
+  while (begin < end && (*begin == ' ' || *begin == '\t'))
+    begin++;
+  while (end > begin && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r'))
+    end--;
+}
+
+/**
+ * Reads names of columns from the first line of CSV input.
+ *
+ * @param begin Beginning of the input
+ * @param end End of the input
+ * @return Names of columns
+ */
+std::vector<std::string> read_header(char const* begin, char const* end) {
+  char const* line_end = static_cast<char const*>(std::memchr(begin, '\n', end - begin));
+  if (line_end == nullptr)
+    line_end = end;
+
+  std::vector<std::string> names;
+
+  while (true) {
+    char const* field_end = std::find(begin, line_end, ',');
+    char const* name = begin;
+    char const* name_end = field_end;
+
+    trim(name, name_end);
+    names.emplace_back(name, name_end);
+
+    if (field_end == line_end)
+      break;
+    begin = field_end + 1;
+  }
+
+  return names;
+}
+
+/**
+ * Evaluates the expression over a CSV file with a header naming its
+ * columns. Chunks of rows are parsed, evaluated and formatted by
+ * multiple threads (see IO::ParallelBatch), a number which cannot
+ * be parsed is reported and evaluated as nan, so every row has
+ * its result.
+ *
+ * @param expression Evaluated expression
+ * @param path Path of the file (or "-")
+ * @param threads Number of threads
+ * @param raw True to write raw doubles
+ */
+void evaluate_csv(std::string const& expression, std::string const& path, unsigned threads, bool raw) {
+  IO::Input input(path);
+  std::vector<std::string> names = read_header(input.begin(), input.end());
+
+  Calculator::Tokenizer tokenizer;
+  Calculator::Parser parser;
+  Calculator::PolynomialCalculator calculator(tokenizer, parser);
+  Calculator::ColumnProgram program(calculator, expression, names);
+
+  IO::Output output(STDOUT_FILENO);
+  IO::Output errors(STDERR_FILENO, 1 << 16);
+  IO::ParallelBatch batch(input, threads);
+
+  batch.run([&]() -> IO::ParallelBatch::Processor {
+    // columns and results are reused between chunks of a thread
+    auto columns = std::make_shared<std::vector<std::vector<double>>>(names.size());
+    auto results = std::make_shared<std::vector<double>>();
+    auto field = std::make_shared<std::string>();
+
+    return [&, columns, results, field](char const* begin, char const* end,
+                                        std::string& chunk_output, std::string& chunk_errors) {
+      std::vector<double const*> pointers(names.size(), nullptr);
+
+      for (auto& column : *columns)
+        column.clear();
+
+      // the header is not a row
+      if (begin == input.begin()) {
+        char const* header_end = static_cast<char const*>(std::memchr(begin, '\n', end - begin));
+        begin = header_end ? header_end + 1 : end;
+      }
+
+      std::size_t rows = 0;
+
+      while (begin < end) {
+        char const* line_end = static_cast<char const*>(std::memchr(begin, '\n', end - begin));
+        if (line_end == nullptr)
+          line_end = end;
+
+        char const* line = begin;
+        begin = line_end + 1;
+
+        // empty lines are not rows
+        char const* content_end = line_end;
+        trim(line, content_end);
+        if (line == content_end)
+          continue;
+
+        rows++;
+
+        for (std::size_t i = 0; i < names.size(); i++) {
+          char const* field_end = std::find(line, line_end, ',');
+
+          if (program.uses(i)) {
+            char const* value = line;
+            char const* value_end = field_end;
+            trim(value, value_end);
+
+            // strtod needs terminated text
+            field->assign(value, value_end);
+            char* parsed_end;
+            double number = std::strtod(field->c_str(), &parsed_end);
+
+            if (field->empty() || parsed_end != field->c_str() + field->size()) {
+              number = std::numeric_limits<double>::quiet_NaN();
+              chunk_errors.append("Invalid number '").append(*field).append("' in column ")
+                          .append(names[i]) += '\n';
+            }
+
+            (*columns)[i].push_back(number);
+          }
+
+          line = field_end < line_end ? field_end + 1 : line_end;
+        }
+      }
+
+      for (std::size_t i = 0; i < names.size(); i++) {
+        if (program.uses(i))
+          pointers[i] = (*columns)[i].data();
+      }
+
+      results->resize(rows);
+      program.evaluate(pointers.data(), rows, results->data());
+      append_results(results->data(), rows, raw, chunk_output);
+    };
+  }, output, errors);
+}
+
+/**
+ * Evaluates the expression over files of raw doubles (in native byte
+ * order), one file per column. Files are memory mapped and rows are
+ * divided between threads evenly.
+ *
+ * @param expression Evaluated expression
+ * @param files Names of columns and paths of their files
+ * @param threads Number of threads (zero to use every core)
+ * @param raw True to write raw doubles
+ */
+void evaluate_raw(std::string const& expression, std::vector<std::pair<std::string, std::string>> const& files,
+                  unsigned threads, bool raw) {
+  std::vector<std::string> names;
+  std::vector<std::unique_ptr<IO::Input>> inputs;
+  std::vector<double const*> columns;
+  std::size_t rows = 0;
+
+  for (auto const& file : files) {
+    inputs.emplace_back(new IO::Input(file.second));
+
+    std::size_t size = inputs.back()->end() - inputs.back()->begin();
+    if (size % sizeof(double) != 0)
+      throw std::runtime_error("Column " + file.first + " is not an array of doubles");
+    if (!names.empty() && size / sizeof(double) != rows)
+      throw std::runtime_error("Columns have different number of rows");
+
+    names.push_back(file.first);
+    columns.push_back(reinterpret_cast<double const*>(inputs.back()->begin()));
+    rows = size / sizeof(double);
+  }
+
+  Calculator::Tokenizer tokenizer;
+  Calculator::Parser parser;
+  Calculator::PolynomialCalculator calculator(tokenizer, parser);
+  Calculator::ColumnProgram program(calculator, expression, names);
+
+  if (threads == 0)
+    threads = std::max(1u, std::thread::hardware_concurrency());
+
+  // every thread evaluates and formats a range of rows
+  std::vector<double> results(rows);
+  std::vector<std::string> outputs(threads);
+  std::vector<std::thread> workers;
+
+  for (unsigned t = 0; t < threads; t++) {
+    std::size_t first = rows * t / threads;
+    std::size_t last = rows * (t + 1) / threads;
+
+    workers.emplace_back([&, t, first, last]() {
+      std::vector<double const*> range(columns.size());
+      for (std::size_t i = 0; i < columns.size(); i++)
+        range[i] = columns[i] + first;
+
+      program.evaluate(range.data(), last - first, results.data() + first);
+      if (!raw)
+        append_results(results.data() + first, last - first, raw, outputs[t]);
+    });
+  }
+
+  for (auto& worker : workers)
+    worker.join();
+
+  IO::Output output(STDOUT_FILENO);
+
+  if (raw) {
+    output.write(reinterpret_cast<char const*>(results.data()), rows * sizeof(double));
+  } else {
+    for (auto const& text : outputs)
+      output.write(text);
+  }
+}
+
+}
+
+int main(int argc, char** argv) {
+  unsigned threads = 1;
+  bool raw = false;
+  bool usage = false;
+  std::string expression, csv;
+  std::vector<std::pair<std::string, std::string>> files;
+
+  for (int i = 1; i < argc; i++) {
+    std::string option(argv[i]);
+    std::size_t separator = option.find('=');
+
+    if ((option == "-j" || option == "--threads") && i + 1 < argc) {
+      threads = std::stoul(argv[++i]);
+    } else
+    if (option == "-r" || option == "--raw") {
+      raw = true;
+    } else
+    if (expression.empty()) {
+      expression = option;
+    } else
+    if (separator != std::string::npos && separator > 0) {
+      files.emplace_back(option.substr(0, separator), option.substr(separator + 1));
+    } else
+    if (csv.empty() && files.empty()) {
+      csv = option;
+    } else {
+      usage = true;
+    }
+  }
+
+  if (usage || expression.empty() || (!csv.empty() && !files.empty())) {
+    std::cerr << "Usage: " << argv[0] << " [--threads N] [--raw] EXPRESSION [CSV | NAME=FILE...]" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  try {
+    if (files.empty())
+      evaluate_csv(expression, csv.empty() ? "-" : csv, threads, raw);
+    else
+      evaluate_raw(expression, files, threads, raw);
+  }
+  catch (std::exception& error) {
+    std::cerr << error.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
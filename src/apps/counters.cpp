@@ -0,0 +1,196 @@
+#include "counters.hpp"
+
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
+namespace XX {
+namespace IO {
+
+namespace {
+
+//! Names of events
+char const* names[Counters::EVENTS] = {"cycles", "instructions", "cache-misses", "branch-misses"};
+
+//! Current time in nanoseconds
+std::uint64_t now() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+#ifdef __linux__
+//! Hardware configuration of every event
+const std::uint64_t configs[Counters::EVENTS] = {
+  PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+  PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES
+};
+
+//! Opens an event of the calling thread in a group (or a new group)
+int open_event(Counters::Event event, int group) {
+  perf_event_attr attributes;
+  std::memset(&attributes, 0, sizeof(attributes));
+  attributes.size = sizeof(attributes);
+  attributes.type = PERF_TYPE_HARDWARE;
+  attributes.config = configs[event];
+  attributes.read_format = PERF_FORMAT_GROUP;
+  attributes.disabled = group < 0;
+  attributes.exclude_kernel = 1;
+  attributes.exclude_hv = 1;
+
+  return static_cast<int>(::syscall(__NR_perf_event_open, &attributes, 0, -1, group, 0));
+}
+#endif
+
+}
+
+Counters::Values Counters::Values::operator-(Values const& other) const {
+  Values result;
+  for (int i = 0; i < EVENTS; i++)
+    result.counts[i] = counts[i] - other.counts[i];
+  return result;
+}
+
+Counters::Values& Counters::Values::operator+=(Values const& other) {
+  for (int i = 0; i < EVENTS; i++)
+    counts[i] += other.counts[i];
+  return *this;
+}
+
+Counters::Counters() : leader(-1), opened(0) {
+  for (int i = 0; i < EVENTS; i++)
+    descriptors[i] = indices[i] = -1;
+
+#ifdef __linux__
+  for (int i = 0; i < EVENTS; i++) {
+    Event event = Event(i);
+    int descriptor = open_event(event, leader);
+
+    if (descriptor < 0) {
+      if (reason.empty())
+        reason = std::string("Cannot count ") + names[i] + ": " + std::strerror(errno);
+      continue;
+    }
+
+    // the first opened event leads the group
+    if (leader < 0)
+      leader = descriptor;
+
+    descriptors[i] = descriptor;
+    indices[i] = opened++;
+  }
+
+  if (leader >= 0) {
+    ::ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ::ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+  }
+#else
+  reason = "Performance counters are supported only on Linux";
+#endif
+}
+
+Counters::~Counters() {
+  for (int descriptor : descriptors)
+    if (descriptor >= 0)
+      ::close(descriptor);
+}
+
+Counters::Values Counters::read() const {
+  Values values;
+
+  if (leader < 0)
+    return values;
+
+  // number of events followed by their counts
+  std::uint64_t buffer[1 + EVENTS];
+  if (::read(leader, buffer, sizeof(buffer)) < ssize_t(sizeof(std::uint64_t) * (1 + opened)))
+    return values;
+
+  for (int i = 0; i < EVENTS; i++)
+    if (indices[i] >= 0)
+      values.counts[i] = buffer[1 + indices[i]];
+
+  return values;
+}
+
+char const* Counters::name(Event event) {
+  return names[event];
+}
+
+Profile::Sample::Sample(Counters const& counters, Profile& profile, std::string const& name) :
+  counters(counters), profile(profile), name(name), start(counters.read()),
+  allocations(Calculator::Allocations::current()), time(now()) { }
+
+Profile::Sample::~Sample() {
+  std::uint64_t end = now();
+  profile.add(name, counters.read() - start, Calculator::Allocations::current() - allocations, end - time);
+}
+
+void Profile::add(std::string const& name, Counters::Values const& values,
+                  Calculator::Allocations const& allocations, std::uint64_t nanoseconds) {
+  auto part = parts.find(name);
+
+  if (part == parts.end()) {
+    part = parts.emplace(name, Part{0, 0, Counters::Values(), Calculator::Allocations()}).first;
+    order.push_back(name);
+  }
+
+  part->second.calls++;
+  part->second.nanoseconds += nanoseconds;
+  part->second.values += values;
+  part->second.allocations += allocations;
+}
+
+void Profile::report(Counters const& counters, std::string& output) const {
+  char line[200];
+
+  std::snprintf(line, sizeof(line), "%-16s %10s %12s %10s %10s", "part", "calls", "ns", "allocs", "bytes");
+  output += line;
+  for (int i = 0; i < Counters::EVENTS; i++) {
+    std::snprintf(line, sizeof(line), " %14s", names[i]);
+    output += line;
+  }
+  output += "        ipc\n";
+
+  for (auto const& name : order) {
+    Part const& part = parts.at(name);
+    double calls = part.calls;
+
+    std::snprintf(line, sizeof(line), "%-16s %10llu %12.1f", name.c_str(),
+                  (unsigned long long) part.calls, part.nanoseconds / calls);
+    output += line;
+
+    if (Calculator::Allocations::counted)
+      std::snprintf(line, sizeof(line), " %10.1f %10.1f",
+                    part.allocations.count / calls, part.allocations.bytes / calls);
+    else
+      std::snprintf(line, sizeof(line), " %10s %10s", "-", "-");
+    output += line;
+
+    for (int i = 0; i < Counters::EVENTS; i++) {
+      if (counters.available(Counters::Event(i)))
+        std::snprintf(line, sizeof(line), " %14.1f", part.values.counts[i] / calls);
+      else
+        std::snprintf(line, sizeof(line), " %14s", "-");
+      output += line;
+    }
+
+    std::uint64_t cycles = part.values[Counters::CYCLES];
+    if (counters.available(Counters::CYCLES) && counters.available(Counters::INSTRUCTIONS) && cycles > 0)
+      std::snprintf(line, sizeof(line), " %10.2f\n", double(part.values[Counters::INSTRUCTIONS]) / cycles);
+    else
+      std::snprintf(line, sizeof(line), " %10s\n", "-");
+    output += line;
+  }
+}
+
+}
+}
@@ -0,0 +1,198 @@
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "calculator/allocations.hpp"
+
+#pragma once
+
+namespace XX {
+namespace IO {
+
+/**
+ * Hardware performance counters of the calling thread - cycles,
+ * instructions, cache misses and branch misses - opened as a single
+ * group with perf_event_open, so they are always scheduled (and read)
+ * together. Only user space is counted.
+ *
+ * Counters are often unavailable (ie. in containers, virtual machines
+ * or with restrictive perf_event_paranoid), some events may be missing
+ * as well. Nothing fails then - missing events read as zero and
+ * available() tells which of them are counted.
+ */
+class Counters {
+  public:
+
+  /**
+   * Counted hardware event
+   */
+  enum Event {
+    //! CPU cycles
+    CYCLES,
+    //! Retired instructions
+    INSTRUCTIONS,
+    //! Last level cache misses
+    CACHE_MISSES,
+    //! Mispredicted branches
+    BRANCH_MISSES,
+    //! Number of events
+    EVENTS
+  };
+
+  /**
+   * Values of every event at some point (or their difference)
+   */
+  struct Values {
+    //! Count of every event
+    std::uint64_t counts[EVENTS];
+
+    //! Creates zero counts
+    Values() : counts() { }
+
+    //! Count of an event
+    std::uint64_t operator[](Event event) const { return counts[event]; }
+
+    //! Difference of counts
+    Values operator-(Values const& other) const;
+
+    //! Adds counts
+    Values& operator+=(Values const& other);
+  };
+
+  //! Opens counters of the calling thread (never fails)
+  Counters();
+
+  //! Closes counters
+  ~Counters();
+
+  Counters(Counters const&) = delete;
+  Counters& operator=(Counters const&) = delete;
+
+  //! True if any event is counted
+  bool available() const { return leader >= 0; }
+
+  //! True if given event is counted
+  bool available(Event event) const { return indices[event] >= 0; }
+
+  //! Reason why some events are not counted (or empty)
+  std::string const& error() const { return reason; }
+
+  /**
+   * Reads current counts with a single system call. Events which
+   * are not counted are zero.
+   *
+   * @return Counts since counters were opened
+   */
+  Values read() const;
+
+  //! Name of an event
+  static char const* name(Event event);
+
+  private:
+
+  //! Descriptor of the group leader (or -1)
+  int leader;
+  //! Descriptors of every event (or -1)
+  int descriptors[EVENTS];
+  //! Position of every event in the group (or -1)
+  int indices[EVENTS];
+  //! Number of events in the group
+  int opened;
+  //! Reason why some events are not counted
+  std::string reason;
+};
+
+/**
+ * Hardware counters, heap allocations and time spent in named parts
+ * of a program (stages of the calculator or functions), accumulated
+ * over many calls and reported as averages per call.
+ */
+class Profile {
+  public:
+
+  /**
+   * Measures a part of a program by reading counters, allocations
+   * and the clock when created and when destroyed, so a part
+   * failing with an exception is measured as well.
+   */
+  class Sample {
+    public:
+
+    /**
+     * Starts measuring.
+     *
+     * @param counters Read counters
+     * @param profile Destination of the counts
+     * @param name Name of the measured part
+     */
+    Sample(Counters const& counters, Profile& profile, std::string const& name);
+
+    //! Stops measuring, adding measured counts to the profile
+    ~Sample();
+
+    Sample(Sample const&) = delete;
+    Sample& operator=(Sample const&) = delete;
+
+    private:
+
+    //! Read counters
+    Counters const& counters;
+    //! Destination of the counts
+    Profile& profile;
+    //! Name of the measured part
+    std::string name;
+    //! Counts at start
+    Counters::Values start;
+    //! Allocations at start
+    Calculator::Allocations allocations;
+    //! Time at start in nanoseconds
+    std::uint64_t time;
+  };
+
+  /**
+   * Adds a call of a part of a program.
+   *
+   * @param name Name of the part
+   * @param values Counts of the call
+   * @param allocations Allocations of the call
+   * @param nanoseconds Duration of the call
+   */
+  void add(std::string const& name, Counters::Values const& values,
+           Calculator::Allocations const& allocations, std::uint64_t nanoseconds);
+
+  /**
+   * Appends a table of every part (in order they were first
+   * added) - number of calls, average duration, allocations and
+   * allocated bytes, counts of events and instructions per cycle.
+   * Events which are not counted are shown as '-'.
+   *
+   * @param counters Counters used to measure the profile
+   * @param output Destination
+   */
+  void report(Counters const& counters, std::string& output) const;
+
+  private:
+
+  /**
+   * Accumulated calls of a part
+   */
+  struct Part {
+    //! Number of calls
+    std::uint64_t calls;
+    //! Total duration in nanoseconds
+    std::uint64_t nanoseconds;
+    //! Total counts of events
+    Counters::Values values;
+    //! Total allocations
+    Calculator::Allocations allocations;
+  };
+
+  //! Accumulated parts
+  std::map<std::string, Part> parts;
+  //! Names of parts in order of first call
+  std::vector<std::string> order;
+};
+
+}
+}
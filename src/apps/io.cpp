@@ -0,0 +1,138 @@
+#include "io.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace XX {
+namespace IO {
+
+namespace {
+
+//! Creates exception describing failed system call
+std::runtime_error system_error(std::string const& what) {
+  return std::runtime_error(what + ": " + std::strerror(errno));
+}
+
+}
+
+Input::Input(std::string const& path) : data(nullptr), size(0), mapped(false) {
+  int fd = path == "-" ? STDIN_FILENO : ::open(path.c_str(), O_RDONLY);
+
+  if (fd < 0)
+    throw system_error("Cannot open '" + path + "'");
+
+  struct stat status;
+  if (::fstat(fd, &status) == 0 && S_ISREG(status.st_mode) && status.st_size > 0) {
+    void* address = ::mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    if (address != MAP_FAILED) {
+      ::madvise(address, status.st_size, MADV_SEQUENTIAL);
+
+      data = static_cast<char const*>(address);
+      size = status.st_size;
+      mapped = true;
+    }
+  }
+
+  // not mappable, read until end of file
+  if (!mapped) {
+    std::size_t used = 0;
+    buffer.resize(1 << 16);
+
+    while (true) {
+      ssize_t count = ::read(fd, buffer.data() + used, buffer.size() - used);
+
+      if (count < 0 && errno == EINTR)
+        continue;
+
+      if (count < 0) {
+        if (fd != STDIN_FILENO)
+          ::close(fd);
+        throw system_error("Cannot read '" + path + "'");
+      }
+
+      if (count == 0)
+        break;
+
+      used += count;
+      if (used == buffer.size())
+        buffer.resize(buffer.size() * 2);
+    }
+
+    data = buffer.data();
+    size = used;
+  }
+
+  if (fd != STDIN_FILENO)
+    ::close(fd);
+}
+
+Input::~Input() {
+  if (mapped)
+    ::munmap(const_cast<char*>(data), size);
+}
+
+Output::Output(int fd, std::size_t capacity) : fd(fd), buffer(capacity), used(0) {
+}
+
+Output::~Output() {
+  try {
+    flush();
+  }
+  catch (std::runtime_error&) {
+  }
+}
+
+void Output::write(char const* bytes, std::size_t length) {
+  if (used + length > buffer.size()) {
+    flush();
+
+    // too large to be buffered
+    if (length > buffer.size()) {
+      while (length > 0) {
+        ssize_t count = ::write(fd, bytes, length);
+
+        if (count < 0 && errno == EINTR)
+          continue;
+        if (count < 0)
+          throw system_error("Cannot write output");
+
+        bytes += count;
+        length -= count;
+      }
+      return;
+    }
+  }
+
+  std::memcpy(buffer.data() + used, bytes, length);
+  used += length;
+}
+
+void Output::flush() {
+  std::size_t written = 0;
+
+  while (written < used) {
+    ssize_t count = ::write(fd, buffer.data() + written, used - written);
+
+    if (count < 0 && errno == EINTR)
+      continue;
+
+    if (count < 0) {
+      used = 0;
+      throw system_error("Cannot write output");
+    }
+
+    written += count;
+  }
+
+  used = 0;
+}
+
+}
+}
@@ -0,0 +1,107 @@
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#pragma once
+
+namespace XX {
+namespace IO {
+
+/**
+ * Input read as a whole, used for batch processing. Regular files
+ * are memory mapped, so lines are never copied. Other inputs (pipes,
+ * terminals) are read into a buffer until end of file.
+ */
+class Input {
+  public:
+
+  /**
+   * Opens the input.
+   *
+   * @throw std::runtime_error When the input cannot be read
+   * @param path Path of the file, or "-" for standard input
+   */
+  explicit Input(std::string const& path);
+
+  ~Input();
+
+  Input(Input const&) = delete;
+  Input& operator=(Input const&) = delete;
+
+  //! First byte of the input
+  char const* begin() const { return data; }
+
+  //! End of the input
+  char const* end() const { return data + size; }
+
+  private:
+
+  //! Contents of the input
+  char const* data;
+
+  //! Length of the input
+  std::size_t size;
+
+  //! True if data is memory mapped
+  bool mapped;
+
+  //! Contents of the input which cannot be mapped
+  std::vector<char> buffer;
+};
+
+/**
+ * Buffered output writing directly to a file descriptor. Unlike
+ * std::cout with std::endl it is never flushed at the end of line,
+ * only when the buffer is full, explicitly or on destruction.
+ */
+class Output {
+  public:
+
+  /**
+   * Creates output buffer of given capacity.
+   *
+   * @param fd File descriptor to write to
+   * @param capacity Size of the buffer in bytes
+   */
+  explicit Output(int fd, std::size_t capacity = 1 << 20);
+
+  //! Flushes remaining data (ignoring errors)
+  ~Output();
+
+  Output(Output const&) = delete;
+  Output& operator=(Output const&) = delete;
+
+  //! Appends bytes to the buffer
+  void write(char const* bytes, std::size_t length);
+
+  //! Appends a string to the buffer
+  void write(std::string const& text) { write(text.data(), text.size()); }
+
+  //! Appends a single character to the buffer
+  void put(char c) {
+    if (used == buffer.size())
+      flush();
+    buffer[used++] = c;
+  }
+
+  /**
+   * Writes buffered data to the file descriptor.
+   *
+   * @throw std::runtime_error When writing fails
+   */
+  void flush();
+
+  private:
+
+  //! Destination file descriptor
+  int fd;
+
+  //! Buffered data
+  std::vector<char> buffer;
+
+  //! Number of buffered bytes
+  std::size_t used;
+};
+
+}
+}
@@ -0,0 +1,567 @@
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <poll.h>
+#include <unistd.h>
+
+#include "calculator/linear_solver.hpp"
+#include "calculator/status.hpp"
+#include "calculator/allocations.hpp"
+#include "socket.hpp"
+
+using namespace XX;
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+/**
+ * Class of requests, results are reported for every class.
+ */
+enum Class {
+  //! Expressions of constants (including long sums)
+  SCALAR,
+  //! Polynomial arithmetic
+  POLYNOMIAL,
+  //! Linear equations
+  SOLVER,
+  //! Expressions failing to parse or evaluate
+  ERROR,
+  //! Number of classes
+  CLASSES
+};
+
+//! Names of classes
+const char* class_names[CLASSES] = {"scalar", "polynomial", "solver", "error"};
+
+/**
+ * Request sent to a calculator
+ */
+struct Request {
+  //! Text of the expression
+  std::string expression;
+  //! Class of the expression
+  Class type;
+};
+
+/**
+ * Generates requests of every class. The generator is seeded, so
+ * the same workload is replayed every time.
+ */
+class Generator {
+  public:
+
+  //! Creates generator with given seed
+  explicit Generator(unsigned long seed) : random(seed) { }
+
+  /**
+   * Generates an expression of given class.
+   *
+   * @param type Class of the expression
+   * @return Text of the expression
+   */
+  std::string generate(Class type) {
+    switch (type) {
+      case SCALAR:
+        return number(0, 3) == 0 ? long_sum() : arithmetic(3, false);
+
+      case POLYNOMIAL:
+        return number(0, 3) == 0 ? "(" + arithmetic(2, true) + ")^" + std::to_string(number(2, 8))
+                                 : arithmetic(3, true);
+
+      case SOLVER:
+        return coefficient() + "x+" + coefficient() + "=" + coefficient() + "(x-" + coefficient() + ")";
+
+      default:
+        switch (number(0, 4)) {
+          case 0:
+            return arithmetic(2, false) + "*foo";
+          case 1:
+            return "(" + arithmetic(2, true);
+          case 2:
+            return "(" + arithmetic(2, false) + ")/(x^2+" + coefficient() + ")";
+          case 3:
+            return "x^2=" + coefficient();
+          default:
+            return arithmetic(2, false) + "+";
+        }
+    }
+  }
+
+  /**
+   * Generates a workload of expressions with given weights of
+   * classes.
+   *
+   * @param weights Relative weights of classes
+   * @param size Number of expressions
+   * @return Expressions in order of sending
+   */
+  std::vector<Request> workload(std::vector<double> const& weights, std::size_t size) {
+    std::discrete_distribution<int> classes(weights.begin(), weights.end());
+    std::vector<Request> requests;
+
+    for (std::size_t i = 0; i < size; i++) {
+      Class type = static_cast<Class>(classes(random));
+      requests.push_back({generate(type), type});
+    }
+
+    return requests;
+  }
+
+  private:
+
+  //! Random integer in [min, max]
+  unsigned long number(unsigned long min, unsigned long max) {
+    return std::uniform_int_distribution<unsigned long>(min, max)(random);
+  }
+
+  //! Random number as text (integer or decimal)
+  std::string coefficient() {
+    if (number(0, 1) == 0)
+      return std::to_string(number(1, 100));
+    else
+      return std::to_string(number(0, 99)) + "." + std::to_string(number(1, 99));
+  }
+
+  //! Sum of numbers 1 to n minus the same numbers (as zero_gen.rb)
+  std::string long_sum() {
+    unsigned long n = number(10, 200);
+    std::string sum, difference;
+
+    for (unsigned long i = 1; i <= n; i++) {
+      sum += (i > 1 ? "+" : "") + std::to_string(i);
+      difference += "-" + std::to_string(i);
+    }
+
+    return sum + difference;
+  }
+
+  //! Random arithmetic of numbers, constants and (optionally) x
+  std::string arithmetic(unsigned depth, bool polynomial) {
+    if (depth == 0 || number(0, 3) == 0) {
+      switch (number(0, polynomial ? 4 : 3)) {
+        case 0:
+          return "pi";
+        case 4:
+          return "x";
+        default:
+          return coefficient();
+      }
+    }
+
+    static const char* operators[] = {"+", "-", "*"};
+
+    if (number(0, 5) == 0)
+      return "(" + arithmetic(depth - 1, polynomial) + ")/" + coefficient();
+    if (number(0, 5) == 0)
+      return "log(" + coefficient() + ", 10)*" + arithmetic(depth - 1, polynomial);
+
+    return "(" + arithmetic(depth - 1, polynomial) + operators[number(0, 2)] +
+           arithmetic(depth - 1, polynomial) + ")";
+  }
+
+  //! Source of randomness
+  std::mt19937_64 random;
+};
+
+/**
+ * Guesses class of a replayed expression (errors are counted
+ * within the class).
+ *
+ * @param expression Text of the expression
+ * @return Class of the expression
+ */
+Class classify(std::string const& expression) {
+  if (expression.find('=') != std::string::npos)
+    return SOLVER;
+  if (expression.find('x') != std::string::npos)
+    return POLYNOMIAL;
+  return SCALAR;
+}
+
+/**
+ * Statistics of requests of a single class
+ */
+struct ClassStatistics {
+  //! Latencies of requests in seconds
+  std::vector<double> latencies;
+  //! Number of error responses
+  unsigned long errors = 0;
+  //! Number of allocations (only for local calculators)
+  unsigned long allocations = 0;
+  //! Number of allocated bytes (only for local calculators)
+  unsigned long bytes = 0;
+};
+
+/**
+ * Statistics of a single connection (or calculator)
+ */
+struct Statistics {
+  //! Statistics of every class
+  ClassStatistics classes[CLASSES];
+};
+
+/**
+ * Parameters of sending
+ */
+struct Load {
+  //! Requests sent in order (repeated)
+  std::vector<Request> workload;
+  //! Number of requests of a connection
+  unsigned long requests;
+  //! Number of requests in flight (without rate)
+  unsigned long pipeline;
+  //! Requests per second of a connection (zero sends as fast as possible)
+  double rate;
+};
+
+/**
+ * Sends requests over a single connection and measures time until
+ * its response is received. Without rate given number of requests
+ * is kept in flight. With rate requests are sent at fixed intervals
+ * no matter how many responses are missing (open loop), and latency
+ * is measured from the time a request should have been sent, so a
+ * slow server is not hidden by delayed sending.
+ *
+ * @param address Address of the server
+ * @param load Sent requests
+ * @param offset Index of the first sent request in the workload
+ * @param[out] statistics Measured latencies
+ */
+void client(IO::Address const& address, Load const& load, unsigned long offset, Statistics& statistics) {
+  int fd = IO::connect(address);
+
+  std::deque<std::pair<Clock::time_point, Class>> sent;
+  std::string output, input;
+  char buffer[1 << 16];
+  unsigned long next = 0, received = 0;
+
+  Clock::time_point start = Clock::now();
+  auto scheduled = [&](unsigned long i) {
+    return start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(i / load.rate));
+  };
+
+  while (received < load.requests) {
+    Clock::time_point now = Clock::now();
+
+    // fill the pipeline, or send requests which are due
+    output.clear();
+    while (next < load.requests &&
+           (load.rate > 0 ? scheduled(next) <= now : sent.size() < load.pipeline)) {
+      Request const& request = load.workload[(offset + next) % load.workload.size()];
+
+      output += request.expression;
+      output += '\n';
+      sent.emplace_back(load.rate > 0 ? scheduled(next) : now, request.type);
+      next++;
+    }
+
+    for (std::size_t written = 0; written < output.size(); ) {
+      ssize_t count = ::write(fd, output.data() + written, output.size() - written);
+      if (count < 0 && errno == EINTR)
+        continue;
+      if (count < 0)
+        throw std::runtime_error(std::string("Cannot send request: ") + std::strerror(errno));
+      written += count;
+    }
+
+    // wait for responses until the next request is due
+    if (load.rate > 0 && next < load.requests) {
+      auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(scheduled(next) - Clock::now());
+      pollfd descriptor = {fd, POLLIN, 0};
+
+      if (::poll(&descriptor, 1, std::max<long>(0, wait.count())) <= 0)
+        continue;
+    }
+
+    ssize_t count = ::read(fd, buffer, sizeof(buffer));
+    if (count < 0 && errno == EINTR)
+      continue;
+    if (count <= 0)
+      throw std::runtime_error("Connection closed by server");
+
+    now = Clock::now();
+    input.append(buffer, count);
+
+    // every response line completes the oldest request
+    std::size_t begin = 0;
+    for (std::size_t end; (end = input.find('\n', begin)) != std::string::npos; begin = end + 1) {
+      ClassStatistics& s = statistics.classes[sent.front().second];
+
+      if (input.compare(begin, 6, "ERROR ") == 0)
+        s.errors++;
+
+      s.latencies.push_back(std::chrono::duration<double>(now - sent.front().first).count());
+      sent.pop_front();
+      received++;
+    }
+    input.erase(0, begin);
+  }
+
+  ::close(fd);
+}
+
+/**
+ * Evaluates requests by a calculator in this thread, measuring
+ * latency and allocations of every request. With rate requests
+ * are evaluated at fixed intervals and latency includes time a
+ * request waits for the calculator.
+ *
+ * @param load Evaluated requests
+ * @param offset Index of the first request in the workload
+ * @param[out] statistics Measured latencies
+ */
+void local_client(Load const& load, unsigned long offset, Statistics& statistics) {
+  Calculator::Tokenizer tokenizer;
+  Calculator::Parser parser;
+  Calculator::LinearSolver solver(tokenizer, parser);
+  solver.set_direct_compilation(true);
+
+  for (auto& s : statistics.classes)
+    s.latencies.reserve(load.requests);
+
+  Clock::time_point start = Clock::now();
+
+  for (unsigned long i = 0; i < load.requests; i++) {
+    Request const& request = load.workload[(offset + i) % load.workload.size()];
+    ClassStatistics& s = statistics.classes[request.type];
+
+    Clock::time_point begin = Clock::now();
+    if (load.rate > 0) {
+      begin = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(i / load.rate));
+      std::this_thread::sleep_until(begin);
+    }
+
+    Calculator::Allocations first = Calculator::Allocations::current();
+
+    if (!solver.try_process(request.expression).ok())
+      s.errors++;
+
+    Calculator::Allocations made = Calculator::Allocations::current() - first;
+    s.allocations += made.count;
+    s.bytes += made.bytes;
+    s.latencies.push_back(std::chrono::duration<double>(Clock::now() - begin).count());
+  }
+}
+
+/**
+ * Parses weights of classes, ie. "scalar=70,error=5" (classes
+ * which are not given have no weight).
+ *
+ * @param text Comma separated weights
+ * @return Weight of every class
+ */
+std::vector<double> parse_mix(std::string const& text) {
+  std::vector<double> weights(CLASSES, 0);
+  std::istringstream stream(text);
+  std::string item;
+
+  while (std::getline(stream, item, ',')) {
+    std::size_t separator = item.find('=');
+    auto name = std::find(class_names, class_names + CLASSES, item.substr(0, separator));
+
+    if (separator == std::string::npos || name == class_names + CLASSES)
+      throw std::invalid_argument("Unknown class of requests '" + item + "'");
+
+    weights[name - class_names] = std::stod(item.substr(separator + 1));
+  }
+
+  if (std::all_of(weights.begin(), weights.end(), [](double w) { return w <= 0; }))
+    throw std::invalid_argument("Mix of requests is empty");
+
+  return weights;
+}
+
+//! Value of given percentile of sorted samples
+double percentile(std::vector<double> const& sorted, double p) {
+  if (sorted.empty())
+    return 0;
+
+  std::size_t index = std::min(sorted.size() - 1, static_cast<std::size_t>(p / 100 * sorted.size()));
+  return sorted[index];
+}
+
+/**
+ * Prints a row of the report.
+ *
+ * @param name Name of the class
+ * @param s Statistics of the class (with sorted latencies)
+ * @param elapsed Duration of the test in seconds
+ * @param local True if allocations are counted
+ */
+void report(std::string const& name, ClassStatistics const& s, double elapsed, bool local) {
+  double count = std::max<double>(1, s.latencies.size());
+
+  std::cout << std::left << std::setw(12) << name << std::right << std::fixed << std::setprecision(0)
+            << std::setw(10) << s.latencies.size()
+            << std::setw(8) << s.errors
+            << std::setw(12) << s.latencies.size() / elapsed
+            << std::setprecision(1)
+            << std::setw(10) << percentile(s.latencies, 50) * 1e6
+            << std::setw(10) << percentile(s.latencies, 99) * 1e6
+            << std::setw(10) << percentile(s.latencies, 99.9) * 1e6
+            << std::setw(10) << (s.latencies.empty() ? 0 : s.latencies.back() * 1e6);
+
+  if (local)
+    std::cout << std::setw(12) << s.allocations / count << std::setw(12) << s.bytes / count;
+
+  std::cout << std::endl;
+}
+
+}
+
+int main(int argc, char** argv) {
+  IO::Address address = IO::Address::tcp(0);
+  bool local = false;
+  unsigned long connections = 4;
+  unsigned long seed = 1;
+  std::vector<double> weights = {60, 25, 10, 5};
+  std::vector<Request> replayed;
+  Load load;
+  load.requests = 10000;
+  load.pipeline = 16;
+  load.rate = 0;
+  bool usage = false;
+
+  for (int i = 1; i < argc; i++) {
+    std::string option(argv[i]);
+
+    if ((option == "-u" || option == "--socket") && i + 1 < argc) {
+      address = IO::Address::unix_socket(argv[++i]);
+    } else
+    if ((option == "-p" || option == "--port") && i + 1 < argc) {
+      address = IO::Address::tcp(std::stoul(argv[++i]));
+    } else
+    if (option == "-l" || option == "--local") {
+      local = true;
+    } else
+    if ((option == "-c" || option == "--connections") && i + 1 < argc) {
+      connections = std::max(1ul, std::stoul(argv[++i]));
+    } else
+    if ((option == "-n" || option == "--requests") && i + 1 < argc) {
+      load.requests = std::stoul(argv[++i]);
+    } else
+    if ((option == "-d" || option == "--pipeline") && i + 1 < argc) {
+      load.pipeline = std::max(1ul, std::stoul(argv[++i]));
+    } else
+    if ((option == "-r" || option == "--rate") && i + 1 < argc) {
+      load.rate = std::stod(argv[++i]);
+    } else
+    if ((option == "-m" || option == "--mix") && i + 1 < argc) {
+      try {
+        weights = parse_mix(argv[++i]);
+      }
+      catch (std::invalid_argument& error) {
+        std::cerr << error.what() << std::endl;
+        usage = true;
+      }
+    } else
+    if (option == "--seed" && i + 1 < argc) {
+      seed = std::stoul(argv[++i]);
+    } else
+    if ((option == "-i" || option == "--input") && i + 1 < argc) {
+      std::ifstream file(argv[++i]);
+      std::string line;
+
+      replayed.clear();
+      while (std::getline(file, line))
+        if (!line.empty())
+          replayed.push_back({line, classify(line)});
+
+      usage = usage || replayed.empty();
+    } else {
+      usage = true;
+    }
+  }
+
+  if (usage || (!local && address.path.empty() && address.port == 0)) {
+    std::cerr << "Usage: " << argv[0] << " (--socket PATH | --port PORT | --local) [--connections N]"
+              << " [--requests N] [--pipeline N] [--rate R] [--input FILE | --mix CLASS=WEIGHT,...]"
+              << " [--seed N]" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  load.workload = replayed.empty() ? Generator(seed).workload(weights, 4096) : replayed;
+  load.rate /= connections;
+
+  std::vector<Statistics> statistics(connections);
+  std::vector<std::thread> threads;
+  std::atomic<bool> failed(false);
+
+  auto start = Clock::now();
+
+  // connections begin at different requests, so they do not
+  // evaluate the same expressions at once
+  for (unsigned long i = 0; i < connections; i++) {
+    threads.emplace_back([&, i]() {
+      unsigned long offset = i * load.workload.size() / connections;
+
+      try {
+        if (local)
+          local_client(load, offset, statistics[i]);
+        else
+          client(address, load, offset, statistics[i]);
+      }
+      catch (std::runtime_error& error) {
+        std::cerr << error.what() << std::endl;
+        failed = true;
+      }
+    });
+  }
+
+  for (auto& thread : threads)
+    thread.join();
+
+  std::chrono::duration<double> elapsed = Clock::now() - start;
+
+  if (failed)
+    return EXIT_FAILURE;
+
+  ClassStatistics total;
+  std::vector<ClassStatistics> classes(CLASSES);
+
+  for (auto const& s : statistics) {
+    for (int c = 0; c < CLASSES; c++) {
+      for (ClassStatistics* merged : {&classes[c], &total}) {
+        merged->latencies.insert(merged->latencies.end(),
+                                 s.classes[c].latencies.begin(), s.classes[c].latencies.end());
+        merged->errors += s.classes[c].errors;
+        merged->allocations += s.classes[c].allocations;
+        merged->bytes += s.classes[c].bytes;
+      }
+    }
+  }
+
+  std::cout << std::left << std::setw(12) << "class" << std::right
+            << std::setw(10) << "requests" << std::setw(8) << "errors" << std::setw(12) << "req/s"
+            << std::setw(10) << "p50 us" << std::setw(10) << "p99 us" << std::setw(10) << "p999 us"
+            << std::setw(10) << "max us";
+  if (local)
+    std::cout << std::setw(12) << "allocs/req" << std::setw(12) << "bytes/req";
+  std::cout << std::endl;
+
+  for (int c = 0; c < CLASSES; c++) {
+    std::sort(classes[c].latencies.begin(), classes[c].latencies.end());
+    if (!classes[c].latencies.empty())
+      report(class_names[c], classes[c], elapsed.count(), local);
+  }
+
+  std::sort(total.latencies.begin(), total.latencies.end());
+  report("all", total, elapsed.count(), local);
+
+  return EXIT_SUCCESS;
+}
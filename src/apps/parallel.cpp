@@ -0,0 +1,156 @@
+#include "parallel.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace XX {
+namespace IO {
+
+namespace {
+
+/**
+ * Outputs of a processed chunk
+ */
+struct Slot {
+  //! Results
+  std::string output;
+  //! Errors
+  std::string errors;
+  //! True if chunk is processed but not written yet
+  bool ready = false;
+};
+
+}
+
+ParallelBatch::ParallelBatch(Input const& input, unsigned threads, std::size_t chunk_size) :
+  input(input), thread_count(threads), chunk_size(chunk_size) {
+  if (thread_count == 0)
+    thread_count = std::max(1u, std::thread::hardware_concurrency());
+}
+
+char const* ParallelBatch::line_start(std::size_t offset) const {
+  std::size_t size = input.end() - input.begin();
+
+  if (offset == 0)
+    return input.begin();
+  if (offset >= size)
+    return input.end();
+
+  // a line starts after new line character
+  void const* found = std::memchr(input.begin() + offset - 1, '\n', size - offset + 1);
+
+  return found ? static_cast<char const*>(found) + 1 : input.end();
+}
+
+void ParallelBatch::run(Factory factory, Output& output, Output& errors) {
+  std::size_t size = input.end() - input.begin();
+  std::size_t chunks = (size + chunk_size - 1) / chunk_size;
+
+  // single thread needs no synchronization
+  if (thread_count == 1) {
+    Processor process = factory();
+    std::string chunk_output, chunk_errors;
+
+    for (std::size_t chunk = 0; chunk < chunks; chunk++) {
+      chunk_output.clear();
+      chunk_errors.clear();
+
+      process(line_start(chunk * chunk_size), line_start((chunk + 1) * chunk_size),
+              chunk_output, chunk_errors);
+
+      output.write(chunk_output);
+      errors.write(chunk_errors);
+    }
+
+    return;
+  }
+
+  // at most this number of chunks is kept in memory
+  std::size_t window_size = 4 * thread_count;
+  std::vector<Slot> window(window_size);
+
+  std::atomic<std::size_t> next(0);
+  std::size_t written = 0;
+  bool aborted = false;
+
+  std::mutex mutex;
+  std::condition_variable chunk_ready, slot_free;
+
+  auto worker = [&]() {
+    Processor process = factory();
+    std::string chunk_output, chunk_errors;
+
+    for (std::size_t chunk = next++; chunk < chunks; chunk = next++) {
+      chunk_output.clear();
+      chunk_errors.clear();
+
+      process(line_start(chunk * chunk_size), line_start((chunk + 1) * chunk_size),
+              chunk_output, chunk_errors);
+
+      std::unique_lock<std::mutex> lock(mutex);
+      slot_free.wait(lock, [&]() { return chunk < written + window_size || aborted; });
+
+      if (aborted)
+        return;
+
+      Slot& slot = window[chunk % window_size];
+      slot.output.swap(chunk_output);
+      slot.errors.swap(chunk_errors);
+      slot.ready = true;
+
+      chunk_ready.notify_one();
+    }
+  };
+
+  std::vector<std::thread> workers;
+  for (unsigned i = 0; i < thread_count; i++)
+    workers.emplace_back(worker);
+
+  // write chunks in order
+  std::string chunk_output, chunk_errors;
+
+  try {
+    while (written < chunks) {
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        Slot& slot = window[written % window_size];
+        chunk_ready.wait(lock, [&]() { return slot.ready; });
+
+        chunk_output.swap(slot.output);
+        chunk_errors.swap(slot.errors);
+        slot.ready = false;
+        written++;
+
+        slot_free.notify_all();
+      }
+
+      output.write(chunk_output);
+      errors.write(chunk_errors);
+    }
+  }
+  catch (...) {
+    // stop workers waiting for slots before failing
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      aborted = true;
+      next = chunks;
+      slot_free.notify_all();
+    }
+
+    for (auto& thread : workers)
+      thread.join();
+
+    throw;
+  }
+
+  for (auto& thread : workers)
+    thread.join();
+}
+
+}
+}
@@ -0,0 +1,85 @@
+#include "io.hpp"
+
+#include <cstddef>
+#include <functional>
+#include <string>
+
+#pragma once
+
+namespace XX {
+namespace IO {
+
+/**
+ * Processes lines of an input on multiple threads, writing their
+ * results in order of the input.
+ *
+ * The input is divided into chunks of whole lines - a chunk
+ * consists of lines which begin in its range of bytes, so every
+ * thread finds boundaries of a chunk on its own. Threads claim
+ * chunks one by one from a shared counter (so faster threads simply
+ * process more chunks) and store outputs of a chunk in a window of
+ * slots. The calling thread writes completed chunks in order, a
+ * thread which is too far ahead waits until its slot is written.
+ */
+class ParallelBatch {
+  public:
+
+  /**
+   * Processor of lines in [begin, end) of a chunk, appending
+   * results to output and errors. Every thread has its own
+   * processor, so it can keep state between chunks.
+   */
+  typedef std::function<void(char const* begin, char const* end,
+                             std::string& output, std::string& errors)> Processor;
+
+  /**
+   * Creates processor for a thread, called by the thread.
+   */
+  typedef std::function<Processor()> Factory;
+
+  /**
+   * Creates batch processing of the input.
+   *
+   * @param input Input to process
+   * @param threads Number of threads (zero to use every core)
+   * @param chunk_size Size of a chunk in bytes
+   */
+  ParallelBatch(Input const& input, unsigned threads, std::size_t chunk_size = 1 << 16);
+
+  /**
+   * Processes the whole input, blocking until every chunk is
+   * written. With a single thread chunks are processed in order
+   * by the calling thread, exactly as sequential processing.
+   *
+   * @param factory Creates processor for every thread
+   * @param output Destination of results
+   * @param errors Destination of errors
+   */
+  void run(Factory factory, Output& output, Output& errors);
+
+  /**
+   * Finds beginning of the first line which starts at or after
+   * given offset.
+   *
+   * @param offset Offset in the input
+   * @return Beginning of the line (or end of input)
+   */
+  char const* line_start(std::size_t offset) const;
+
+  //! Number of threads used
+  unsigned threads() const { return thread_count; }
+
+  private:
+
+  //! Processed input
+  Input const& input;
+
+  //! Number of threads
+  unsigned thread_count;
+
+  //! Size of a chunk
+  std::size_t chunk_size;
+};
+
+}
+}
@@ -0,0 +1,143 @@
+#include "results.hpp"
+
+#include <cstring>
+#include <stdexcept>
+
+namespace XX {
+namespace IO {
+namespace Results {
+
+namespace {
+
+//! Magic bytes of the stream
+const char magic[4] = {'X', 'X', 'C', 'R'};
+
+//! True if native byte order is little endian
+const bool little_endian = __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__;
+
+//! Copies bytes reversing their order on big endian hosts
+void copy_little_endian(char* destination, char const* source, std::size_t size) {
+  if (little_endian) {
+    std::memcpy(destination, source, size);
+  } else {
+    for (std::size_t i = 0; i < size; i++)
+      destination[i] = source[size - 1 - i];
+  }
+}
+
+//! Appends little endian integer
+template <typename I>
+void append_integer(std::string& output, I value) {
+  char bytes[sizeof(I)];
+  for (std::size_t i = 0; i < sizeof(I); i++)
+    bytes[i] = static_cast<char>(value >> (8 * i));
+  output.append(bytes, sizeof(I));
+}
+
+//! Reads little endian integer
+template <typename I>
+I read_integer(char const* data) {
+  I value = 0;
+  for (std::size_t i = 0; i < sizeof(I); i++)
+    value |= static_cast<I>(static_cast<unsigned char>(data[i])) << (8 * i);
+  return value;
+}
+
+//! Number of padding bytes after a message
+std::size_t padding(std::size_t length) {
+  return (8 - length % 8) % 8;
+}
+
+}
+
+char const* status_name(Status status) {
+  switch (status) {
+    case OK:
+      return "OK";
+    case PARSING:
+      return "PARSING";
+    case VALUE:
+      return "VALUE";
+    case EVALUATION:
+      return "EVALUATION";
+  }
+
+  return "ERROR";
+}
+
+void write_header(std::string& output, Kind kind, std::size_t size) {
+  output.append(magic, sizeof(magic));
+  append_integer<std::uint16_t>(output, version);
+  output += static_cast<char>(kind);
+  output += static_cast<char>(size);
+  output.append(8, '\0');
+}
+
+void write_record_header(std::string& output, Status status, bool solved, std::uint32_t length) {
+  output += static_cast<char>(status);
+  output += static_cast<char>(solved ? 1 : 0);
+  output.append(2, '\0');
+  append_integer<std::uint32_t>(output, length);
+}
+
+void write_coefficient(std::string& output, void const* bytes, std::size_t size, std::size_t used) {
+  char little[32] = {};
+
+  // padding of x87 long double follows its significant bytes
+  copy_little_endian(little, static_cast<char const*>(bytes), used);
+  output.append(little, size);
+}
+
+void write_error(std::string& output, Status status, char const* message) {
+  std::size_t length = std::strlen(message);
+
+  write_record_header(output, status, false, length);
+  output.append(message, length);
+  output.append(padding(length), '\0');
+}
+
+Reader::Reader(char const* begin, char const* end) : position(begin), end(end) {
+  if (end - begin < static_cast<std::ptrdiff_t>(header_size) || std::memcmp(begin, magic, sizeof(magic)) != 0)
+    throw std::runtime_error("Input is not a stream of results");
+
+  if (read_integer<std::uint16_t>(begin + 4) != version)
+    throw std::runtime_error("Unsupported version of stream of results");
+
+  coefficient_kind = static_cast<Kind>(begin[6]);
+  coefficient_size = static_cast<unsigned char>(begin[7]);
+
+  if (coefficient_size == 0 || coefficient_size > 32)
+    throw std::runtime_error("Invalid size of coefficients");
+
+  position += header_size;
+}
+
+bool Reader::next(Record& record) {
+  if (position == end)
+    return false;
+
+  if (end - position < static_cast<std::ptrdiff_t>(record_header_size))
+    throw std::runtime_error("Truncated record");
+
+  record.status = static_cast<Status>(position[0]);
+  record.solved = (position[1] & 1) != 0;
+  record.length = read_integer<std::uint32_t>(position + 4);
+  record.data = position + record_header_size;
+
+  std::size_t size = record.status == OK ?
+    record.length * coefficient_size : record.length + padding(record.length);
+
+  if (static_cast<std::size_t>(end - record.data) < size)
+    throw std::runtime_error("Truncated record");
+
+  position = record.data + size;
+  return true;
+}
+
+void Reader::read_coefficient(char const* data, void* c) const {
+  copy_little_endian(static_cast<char*>(c), data, coefficient_size);
+}
+
+}
+}
+}
@@ -0,0 +1,215 @@
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+
+#pragma once
+
+namespace XX {
+namespace IO {
+
+/**
+ * Binary stream of results, written by `xxcalc --binary` for programs
+ * which consume results as numbers instead of parsing their text.
+ *
+ * The stream begins with a header of 16 bytes: magic "XXCR", version
+ * (16 bits), kind and size of coefficients (8 bits each) and 8 zero
+ * bytes. Every line of input produces a record, which begins with 8
+ * bytes: status, flags (bit 0 is set if x was solved), 2 zero bytes
+ * and a 32 bit length. A result is followed by length coefficients
+ * (beginning with the constant term), an error by length bytes of
+ * message padded with zeros to a multiple of 8 bytes, so coefficients
+ * of doubles stay aligned. All numbers are little endian.
+ */
+namespace Results {
+
+//! Version of the format
+const std::uint16_t version = 1;
+
+//! Size of the stream header
+const std::size_t header_size = 16;
+
+//! Size of a record header
+const std::size_t record_header_size = 8;
+
+/**
+ * Status of a record - either a result or a category of error,
+ * as they are printed by xxcalc.
+ */
+enum Status : std::uint8_t {
+  OK = 0,
+  PARSING = 1,
+  VALUE = 2,
+  EVALUATION = 3
+};
+
+/**
+ * Type of coefficients in the stream.
+ */
+enum Kind : std::uint8_t {
+  FLOAT = 1,
+  DOUBLE = 2,
+  LONG_DOUBLE = 3,
+  FLOAT128 = 4
+};
+
+//! Kind of coefficients of given type
+template <typename T> struct KindOf;
+template <> struct KindOf<float> { static const Kind value = FLOAT; };
+template <> struct KindOf<double> { static const Kind value = DOUBLE; };
+template <> struct KindOf<long double> { static const Kind value = LONG_DOUBLE; };
+#ifdef XXCALC_FLOAT128
+template <> struct KindOf<__float128> { static const Kind value = FLOAT128; };
+#endif
+
+//! Name of the category of error, as printed by xxcalc
+char const* status_name(Status status);
+
+/**
+ * Appends the stream header.
+ *
+ * @param output Destination
+ * @param kind Kind of coefficients
+ * @param size Size of a coefficient in bytes
+ */
+void write_header(std::string& output, Kind kind, std::size_t size);
+
+/**
+ * Appends a header of record.
+ *
+ * @param output Destination
+ * @param status Status of the record
+ * @param solved True if x was solved
+ * @param length Number of coefficients or length of message
+ */
+void write_record_header(std::string& output, Status status, bool solved, std::uint32_t length);
+
+/**
+ * Appends little endian bytes of a coefficient. Bytes which are
+ * not part of the number (padding of long double) are zeroed.
+ *
+ * @param output Destination
+ * @param bytes Coefficient in native byte order
+ * @param size Size of the coefficient
+ * @param used Number of significant bytes
+ */
+void write_coefficient(std::string& output, void const* bytes, std::size_t size, std::size_t used);
+
+/**
+ * Appends an error record.
+ *
+ * @param output Destination
+ * @param status Category of error
+ * @param message Description of error
+ */
+void write_error(std::string& output, Status status, char const* message);
+
+/**
+ * Appends a result record.
+ *
+ * @param output Destination
+ * @param value Result (a BasicValue)
+ * @param solved True if the result is the solution of x
+ */
+template <typename V>
+void write_result(std::string& output, V const& value, bool solved) {
+  typedef typename V::coefficient_type T;
+
+  // x87 extended precision has 80 bits of data in 12 or 16 bytes
+  const std::size_t used = std::numeric_limits<T>::digits == 64 ? 10 : sizeof(T);
+  unsigned long count = value.degree() + 1;
+
+  write_record_header(output, OK, solved, count);
+  for (unsigned long i = 0; i < count; i++) {
+    T c = value[i];
+    write_coefficient(output, &c, sizeof(T), used);
+  }
+}
+
+/**
+ * Record of the stream, pointing into the stream data.
+ */
+struct Record {
+  //! Status of the record
+  Status status;
+
+  //! True if x was solved
+  bool solved;
+
+  //! Number of coefficients or length of message
+  std::uint32_t length;
+
+  //! Coefficients (little endian) or message
+  char const* data;
+
+  //! Message of an error
+  std::string message() const { return std::string(data, length); }
+};
+
+/**
+ * Reads records of a binary stream held in memory (ie. memory
+ * mapped by IO::Input).
+ */
+class Reader {
+  public:
+
+  /**
+   * Reads the stream header.
+   *
+   * @throw std::runtime_error When the header is not valid
+   * @param begin Beginning of the stream
+   * @param end End of the stream
+   */
+  Reader(char const* begin, char const* end);
+
+  /**
+   * Reads the next record.
+   *
+   * @throw std::runtime_error When the record is truncated
+   * @param[out] record Read record
+   * @return False at end of the stream
+   */
+  bool next(Record& record);
+
+  //! Kind of coefficients
+  Kind kind() const { return coefficient_kind; }
+
+  //! Size of a coefficient in bytes
+  std::size_t size() const { return coefficient_size; }
+
+  /**
+   * Reads a coefficient of a record, T must be the type of
+   * coefficients of the stream.
+   *
+   * @param record Record of a result
+   * @param index Index of the coefficient
+   * @return Coefficient in native byte order
+   */
+  template <typename T>
+  T coefficient(Record const& record, std::size_t index) const {
+    T c = T();
+    read_coefficient(record.data + index * coefficient_size, &c);
+    return c;
+  }
+
+  private:
+
+  //! Copies a little endian coefficient in native byte order
+  void read_coefficient(char const* data, void* c) const;
+
+  //! Current position in the stream
+  char const* position;
+
+  //! End of the stream
+  char const* end;
+
+  //! Kind of coefficients
+  Kind coefficient_kind;
+
+  //! Size of a coefficient
+  std::size_t coefficient_size;
+};
+
+}
+}
+}
@@ -0,0 +1,559 @@
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <csignal>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "calculator/tokenizer.hpp"
+#include "calculator/parser.hpp"
+#include "calculator/linear_solver.hpp"
+#include "calculator/budget.hpp"
+#include "calculator/status.hpp"
+#include "socket.hpp"
+
+using namespace XX;
+
+namespace {
+
+//! Longest accepted request line
+const std::size_t max_line = 1 << 20;
+
+//! Connection is not read while this much input is waiting
+const std::size_t max_input = 1 << 22;
+
+//! No new requests of connection are evaluated while this much output is waiting
+const std::size_t max_output = 1 << 22;
+
+/**
+ * Pipelined requests of a connection evaluated by a worker
+ */
+struct Job {
+  //! Identifier of the connection
+  std::uint64_t connection;
+  //! Complete request lines
+  std::string requests;
+  //! Response lines
+  std::string responses;
+  //! Result of previous request of the connection (ans)
+  Calculator::Value last_value;
+  //! Cancelled when the connection is gone
+  std::shared_ptr<Calculator::Cancellation> cancellation;
+};
+
+/**
+ * Calculation server. Connections are handled by a single thread
+ * using epoll event loop, while requests are evaluated by a pool
+ * of workers, each having its own solver.
+ *
+ * Every line received is a request, every request gets exactly
+ * one response line - "OK result" or "ERROR CODE message" (see
+ * Calculator::Status for the codes). All the
+ * complete lines waiting on a connection are evaluated together
+ * by one worker, and a connection has at most one such job at a
+ * time - so responses are sent in order of requests and ans refers
+ * to previous request of the same connection. Different connections
+ * are evaluated in parallel.
+ *
+ * Evaluation of a request is limited (see Calculator::Limits), so
+ * a runaway expression gets BUDGET_EXCEEDED error instead of
+ * holding a worker. Job of a connection which is gone is cancelled.
+ */
+class Server {
+  public:
+
+  /**
+   * Creates server listening on the address.
+   *
+   * @throw std::runtime_error When the address cannot be used
+   * @param address Address to listen on
+   * @param threads Number of workers (zero to use every core)
+   * @param series_order Order of power series arithmetic (or zero)
+   * @param limits Limits of evaluation of a request
+   */
+  Server(IO::Address const& address, unsigned threads, unsigned long series_order,
+         Calculator::Limits const& limits);
+
+  ~Server();
+
+  /**
+   * Serves connections until SIGINT or SIGTERM is received.
+   */
+  void run();
+
+  private:
+
+  /**
+   * State of a client connection
+   */
+  struct Connection {
+    //! Socket
+    int fd;
+    //! Received data not evaluated yet
+    std::string input;
+    //! Responses not sent yet
+    std::string output;
+    //! Result of previous request (ans)
+    Calculator::Value last_value;
+    //! Cancels job of the connection
+    std::shared_ptr<Calculator::Cancellation> cancellation;
+    //! True if a job of the connection is evaluated
+    bool busy = false;
+    //! True if peer will not send more requests
+    bool closing = false;
+    //! Events the socket is registered for
+    std::uint32_t events = 0;
+  };
+
+  //! Accepts waiting connections
+  void accept_connections();
+
+  //! Reads data available on the connection
+  void receive(std::uint64_t id, Connection& connection);
+
+  //! Sends pending responses (as much as possible)
+  void send(Connection& connection);
+
+  //! Starts evaluation of complete lines of the connection
+  void dispatch(std::uint64_t id, Connection& connection);
+
+  //! Collects finished jobs
+  void complete_jobs();
+
+  //! Updates events, closes connection if it is done
+  void update(std::uint64_t id, Connection& connection);
+
+  //! Evaluates jobs until server is stopped
+  void work();
+
+  //! Address of the server
+  IO::Address address;
+
+  //! Order of power series arithmetic
+  unsigned long series_order;
+
+  //! Limits of evaluation of a request
+  Calculator::Limits limits;
+
+  //! Event loop
+  int epoll;
+  //! Listening socket
+  int listener;
+  //! Notification of finished jobs
+  int jobs_done;
+  //! Termination signals
+  int signals;
+
+  //! Open connections
+  std::map<std::uint64_t, Connection> connections;
+  //! Identifier of next connection
+  std::uint64_t next_id;
+
+  //! Jobs waiting for workers
+  std::deque<Job> pending;
+  //! Jobs finished by workers
+  std::deque<Job> finished;
+  //! Guards both queues and stopping flag
+  std::mutex mutex;
+  //! Signalled when job is pending
+  std::condition_variable job_pending;
+  //! True when workers should stop
+  bool stopping;
+
+  //! Worker threads
+  std::vector<std::thread> workers;
+};
+
+//! Events identifiers of special descriptors (connections use higher numbers)
+enum : std::uint64_t { LISTENER, JOBS_DONE, SIGNALS, FIRST_CONNECTION };
+
+Server::Server(IO::Address const& address, unsigned threads, unsigned long series_order,
+               Calculator::Limits const& limits) :
+  address(address), series_order(series_order), limits(limits), next_id(FIRST_CONNECTION), stopping(false) {
+  listener = IO::listen(address);
+  epoll = ::epoll_create1(EPOLL_CLOEXEC);
+  jobs_done = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+  sigset_t mask;
+  sigemptyset(&mask);
+  sigaddset(&mask, SIGINT);
+  sigaddset(&mask, SIGTERM);
+  ::pthread_sigmask(SIG_BLOCK, &mask, nullptr);
+  signals = ::signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+
+  // closed connections are reported by write
+  std::signal(SIGPIPE, SIG_IGN);
+
+  epoll_event event;
+  event.events = EPOLLIN;
+  event.data.u64 = LISTENER;
+  ::epoll_ctl(epoll, EPOLL_CTL_ADD, listener, &event);
+  event.data.u64 = JOBS_DONE;
+  ::epoll_ctl(epoll, EPOLL_CTL_ADD, jobs_done, &event);
+  event.data.u64 = SIGNALS;
+  ::epoll_ctl(epoll, EPOLL_CTL_ADD, signals, &event);
+
+  if (threads == 0)
+    threads = std::max(1u, std::thread::hardware_concurrency());
+
+  for (unsigned i = 0; i < threads; i++)
+    workers.emplace_back(&Server::work, this);
+}
+
+Server::~Server() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+    job_pending.notify_all();
+  }
+
+  // jobs in progress are not waited for
+  for (auto& connection : connections)
+    connection.second.cancellation->cancel();
+
+  for (auto& worker : workers)
+    worker.join();
+
+  for (auto& connection : connections)
+    ::close(connection.second.fd);
+
+  ::close(listener);
+  ::close(jobs_done);
+  ::close(signals);
+  ::close(epoll);
+
+  if (!address.path.empty())
+    ::unlink(address.path.c_str());
+}
+
+void Server::run() {
+  std::vector<epoll_event> events(256);
+
+  while (true) {
+    int count = ::epoll_wait(epoll, events.data(), events.size(), -1);
+
+    if (count < 0 && errno == EINTR)
+      continue;
+    if (count < 0)
+      throw std::runtime_error(std::string("Event loop failed: ") + std::strerror(errno));
+
+    for (int i = 0; i < count; i++) {
+      std::uint64_t id = events[i].data.u64;
+
+      if (id == LISTENER) {
+        accept_connections();
+      } else
+      if (id == JOBS_DONE) {
+        complete_jobs();
+      } else
+      if (id == SIGNALS) {
+        return;
+      } else {
+        auto connection = connections.find(id);
+        if (connection == connections.end())
+          continue;
+
+        // peer is gone in both directions, nobody reads responses
+        if (events[i].events & (EPOLLHUP | EPOLLERR)) {
+          connection->second.cancellation->cancel();
+          ::close(connection->second.fd);
+          connections.erase(connection);
+          continue;
+        }
+
+        if (events[i].events & EPOLLIN)
+          receive(id, connection->second);
+        if (events[i].events & EPOLLOUT)
+          send(connection->second);
+
+        update(id, connection->second);
+      }
+    }
+  }
+}
+
+void Server::accept_connections() {
+  while (true) {
+    int fd = ::accept4(listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+
+    if (fd < 0) {
+      if (errno == EINTR || errno == ECONNABORTED)
+        continue;
+      // EAGAIN or out of descriptors, try again later
+      return;
+    }
+
+    std::uint64_t id = next_id++;
+    Connection& connection = connections[id];
+    connection.fd = fd;
+    connection.cancellation = std::make_shared<Calculator::Cancellation>();
+
+    epoll_event event;
+    event.events = connection.events = EPOLLIN;
+    event.data.u64 = id;
+    ::epoll_ctl(epoll, EPOLL_CTL_ADD, fd, &event);
+  }
+}
+
+void Server::receive(std::uint64_t id, Connection& connection) {
+  char buffer[1 << 16];
+
+  while (connection.input.size() < max_input) {
+    ssize_t count = ::read(connection.fd, buffer, sizeof(buffer));
+
+    if (count < 0 && errno == EINTR)
+      continue;
+
+    if (count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+      break;
+
+    if (count <= 0) {
+      // unterminated last line is still a request
+      if (!connection.input.empty() && connection.input.back() != '\n')
+        connection.input += '\n';
+
+      connection.closing = true;
+      break;
+    }
+
+    connection.input.append(buffer, count);
+  }
+
+  // reject request which never ends
+  if (connection.input.size() > max_line &&
+      connection.input.find('\n') == std::string::npos) {
+    connection.input.clear();
+    connection.output += "ERROR LINE_TOO_LONG Request exceeds " + std::to_string(max_line) + " bytes\n";
+    connection.closing = true;
+  }
+
+  dispatch(id, connection);
+}
+
+void Server::send(Connection& connection) {
+  std::size_t sent = 0;
+
+  while (sent < connection.output.size()) {
+    ssize_t count = ::write(connection.fd, connection.output.data() + sent, connection.output.size() - sent);
+
+    if (count < 0 && errno == EINTR)
+      continue;
+
+    if (count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+      break;
+
+    if (count < 0) {
+      // peer is gone, drop everything
+      connection.cancellation->cancel();
+      connection.input.clear();
+      connection.output.clear();
+      connection.closing = true;
+      return;
+    }
+
+    sent += count;
+  }
+
+  connection.output.erase(0, sent);
+}
+
+void Server::dispatch(std::uint64_t id, Connection& connection) {
+  if (connection.busy || connection.output.size() >= max_output)
+    return;
+
+  std::size_t end = connection.input.rfind('\n');
+  if (end == std::string::npos)
+    return;
+
+  Job job;
+  job.connection = id;
+  job.requests = connection.input.substr(0, end + 1);
+  job.last_value = connection.last_value;
+  job.cancellation = connection.cancellation;
+  connection.input.erase(0, end + 1);
+  connection.busy = true;
+
+  std::lock_guard<std::mutex> lock(mutex);
+  pending.push_back(std::move(job));
+  job_pending.notify_one();
+}
+
+void Server::complete_jobs() {
+  std::uint64_t count;
+  while (::read(jobs_done, &count, sizeof(count)) > 0) { }
+
+  std::deque<Job> jobs;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    jobs.swap(finished);
+  }
+
+  for (auto& job : jobs) {
+    auto connection = connections.find(job.connection);
+
+    // connection closed in the meantime
+    if (connection == connections.end())
+      continue;
+
+    Connection& c = connection->second;
+    c.busy = false;
+    c.last_value = std::move(job.last_value);
+    c.output += job.responses;
+
+    send(c);
+    dispatch(job.connection, c);
+    update(job.connection, c);
+  }
+}
+
+void Server::update(std::uint64_t id, Connection& connection) {
+  // done when everything is answered and nothing more will come
+  if (connection.closing && !connection.busy && connection.output.empty() &&
+      connection.input.find('\n') == std::string::npos) {
+    ::close(connection.fd);
+    connections.erase(id);
+    return;
+  }
+
+  std::uint32_t events = 0;
+  if (!connection.closing && connection.input.size() < max_input)
+    events |= EPOLLIN;
+  if (!connection.output.empty())
+    events |= EPOLLOUT;
+
+  if (events != connection.events) {
+    epoll_event event;
+    event.events = connection.events = events;
+    event.data.u64 = id;
+    ::epoll_ctl(epoll, EPOLL_CTL_MOD, connection.fd, &event);
+  }
+}
+
+void Server::work() {
+  Calculator::Tokenizer tokenizer;
+  Calculator::Parser parser;
+  Calculator::LinearSolver solver(tokenizer, parser);
+  solver.set_series_order(series_order);
+  solver.set_direct_compilation(true);
+
+  std::string line;
+  const std::string variable("x");
+
+  while (true) {
+    Job job;
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      job_pending.wait(lock, [&]() { return stopping || !pending.empty(); });
+
+      if (stopping)
+        return;
+
+      job = std::move(pending.front());
+      pending.pop_front();
+    }
+
+    solver.last_value = job.last_value;
+    solver.set_limits(limits, job.cancellation.get());
+
+    // responses of cancelled job are not read
+    for (std::size_t begin = 0, end; begin < job.requests.size() && !job.cancellation->is_cancelled(); begin = end + 1) {
+      end = job.requests.find('\n', begin);
+      line.assign(job.requests, begin, end - begin);
+
+      Calculator::LinearSolver::Outcome outcome = solver.try_process(line);
+
+      if (outcome.ok()) {
+        job.responses += solver.solved ? "OK x=" : "OK ";
+        outcome.value.repr(job.responses, variable);
+      } else {
+        job.responses.append("ERROR ").append(outcome.status.name()).append(" ").append(outcome.status.message());
+      }
+
+      job.responses += '\n';
+    }
+
+    job.last_value = solver.last_value;
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      finished.push_back(std::move(job));
+    }
+
+    std::uint64_t one = 1;
+    while (::write(jobs_done, &one, sizeof(one)) < 0 && errno == EINTR) { }
+  }
+}
+
+}
+
+int main(int argc, char** argv) {
+  IO::Address address = IO::Address::tcp(0);
+  unsigned threads = 0;
+  unsigned long series_order = 0;
+  Calculator::Limits limits;
+  bool usage = false;
+
+  for (int i = 1; i < argc; i++) {
+    std::string option(argv[i]);
+
+    if ((option == "-u" || option == "--socket") && i + 1 < argc) {
+      address = IO::Address::unix_socket(argv[++i]);
+    } else
+    if ((option == "-p" || option == "--port") && i + 1 < argc) {
+      address = IO::Address::tcp(std::stoul(argv[++i]));
+    } else
+    if ((option == "-j" || option == "--threads") && i + 1 < argc) {
+      threads = std::stoul(argv[++i]);
+    } else
+    if ((option == "-s" || option == "--series") && i + 1 < argc) {
+      series_order = std::stoul(argv[++i]);
+    } else
+    if (option == "--max-degree" && i + 1 < argc) {
+      limits.degree = std::stoul(argv[++i]);
+    } else
+    if (option == "--max-memory" && i + 1 < argc) {
+      limits.memory = std::stoull(argv[++i]);
+    } else
+    if (option == "--max-operations" && i + 1 < argc) {
+      limits.operations = std::stoull(argv[++i]);
+    } else
+    if (option == "--max-time" && i + 1 < argc) {
+      limits.time = std::stod(argv[++i]);
+    } else {
+      usage = true;
+    }
+  }
+
+  if (usage || (address.path.empty() && address.port == 0)) {
+    std::cerr << "Usage: " << argv[0] << " (--socket PATH | --port PORT) [--threads N] [--series ORDER]"
+              << " [--max-degree N] [--max-memory BYTES] [--max-operations N] [--max-time SECONDS]" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  try {
+    Server server(address, threads, series_order, limits);
+    std::cerr << "Listening on " << address.str() << std::endl;
+    server.run();
+  }
+  catch (std::runtime_error& error) {
+    std::cerr << error.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
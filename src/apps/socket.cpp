@@ -0,0 +1,122 @@
+#include "socket.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace XX {
+namespace IO {
+
+namespace {
+
+//! Creates exception describing failed system call
+std::runtime_error system_error(std::string const& what) {
+  return std::runtime_error(what + ": " + std::strerror(errno));
+}
+
+//! Fills Unix domain socket address
+sockaddr_un unix_address(std::string const& path) {
+  sockaddr_un address;
+  std::memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+
+  if (path.size() >= sizeof(address.sun_path))
+    throw std::runtime_error("Socket path '" + path + "' is too long");
+
+  std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+  return address;
+}
+
+//! Fills TCP address on loopback interface
+sockaddr_in tcp_address(unsigned short port) {
+  sockaddr_in address;
+  std::memset(&address, 0, sizeof(address));
+  address.sin_family = AF_INET;
+  address.sin_port = htons(port);
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  return address;
+}
+
+}
+
+std::string Address::str() const {
+  if (path.empty())
+    return "127.0.0.1:" + std::to_string(port);
+  else
+    return path;
+}
+
+int listen(Address const& address) {
+  int fd = ::socket(address.path.empty() ? AF_INET : AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+
+  if (fd < 0)
+    throw system_error("Cannot create socket");
+
+  int result;
+
+  if (address.path.empty()) {
+    int reuse = 1;
+    ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    sockaddr_in in = tcp_address(address.port);
+    result = ::bind(fd, reinterpret_cast<sockaddr*>(&in), sizeof(in));
+  } else {
+    sockaddr_un un = unix_address(address.path);
+    ::unlink(address.path.c_str());
+    result = ::bind(fd, reinterpret_cast<sockaddr*>(&un), sizeof(un));
+  }
+
+  if (result < 0 || ::listen(fd, SOMAXCONN) < 0) {
+    std::runtime_error error = system_error("Cannot listen on " + address.str());
+    ::close(fd);
+    throw error;
+  }
+
+  set_nonblocking(fd);
+
+  return fd;
+}
+
+int connect(Address const& address) {
+  int fd = ::socket(address.path.empty() ? AF_INET : AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+
+  if (fd < 0)
+    throw system_error("Cannot create socket");
+
+  int result;
+
+  if (address.path.empty()) {
+    sockaddr_in in = tcp_address(address.port);
+    result = ::connect(fd, reinterpret_cast<sockaddr*>(&in), sizeof(in));
+
+    // requests are small, do not delay them
+    int nodelay = 1;
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+  } else {
+    sockaddr_un un = unix_address(address.path);
+    result = ::connect(fd, reinterpret_cast<sockaddr*>(&un), sizeof(un));
+  }
+
+  if (result < 0) {
+    std::runtime_error error = system_error("Cannot connect to " + address.str());
+    ::close(fd);
+    throw error;
+  }
+
+  return fd;
+}
+
+void set_nonblocking(int fd) {
+  ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+}
+
+}
+}
@@ -0,0 +1,55 @@
+#include <string>
+
+#pragma once
+
+namespace XX {
+namespace IO {
+
+/**
+ * Address of a local stream socket - either a path of Unix domain
+ * socket or a TCP port on the loopback interface.
+ */
+struct Address {
+  //! Path of Unix domain socket (empty if TCP is used)
+  std::string path;
+  //! TCP port on 127.0.0.1 (used when path is empty)
+  unsigned short port;
+
+  //! Creates address of Unix domain socket
+  static Address unix_socket(std::string const& path) { return Address{path, 0}; }
+
+  //! Creates address of TCP port on loopback interface
+  static Address tcp(unsigned short port) { return Address{std::string(), port}; }
+
+  //! Human readable form of the address
+  std::string str() const;
+};
+
+/**
+ * Creates non blocking socket listening on the address. A stale
+ * Unix domain socket file is replaced.
+ *
+ * @throw std::runtime_error When the socket cannot be created
+ * @param address Address to listen on
+ * @return Listening socket
+ */
+int listen(Address const& address);
+
+/**
+ * Creates blocking socket connected to the address.
+ *
+ * @throw std::runtime_error When the connection fails
+ * @param address Address to connect to
+ * @return Connected socket
+ */
+int connect(Address const& address);
+
+/**
+ * Switches socket to non blocking mode.
+ *
+ * @param fd Socket
+ */
+void set_nonblocking(int fd);
+
+}
+}
@@ -0,0 +1,92 @@
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include "calculator/value.hpp"
+#include "io.hpp"
+#include "results.hpp"
+
+using namespace XX;
+
+/**
+ * Prints records of the stream exactly as xxcalc prints results
+ * and errors in text mode.
+ *
+ * @param reader Reader of the stream
+ * @param output Destination of results
+ * @param errors Destination of errors
+ */
+template <typename T>
+void print(IO::Results::Reader& reader, IO::Output& output, IO::Output& errors) {
+  if (reader.size() != sizeof(T))
+    throw std::runtime_error("Invalid size of coefficients");
+
+  const std::string variable("x");
+  std::vector<T> coefficients;
+  std::string text;
+  IO::Results::Record record;
+
+  while (reader.next(record)) {
+    text.clear();
+
+    if (record.status == IO::Results::OK) {
+      coefficients.resize(record.length);
+      for (std::uint32_t i = 0; i < record.length; i++)
+        coefficients[i] = reader.coefficient<T>(record, i);
+
+      if (record.solved)
+        text += "x=";
+
+      Calculator::BasicValue<T>(coefficients).repr(text, variable);
+      text += '\n';
+      output.write(text);
+    } else {
+      text.append("[").append(IO::Results::status_name(record.status)).append("] ");
+      text.append(record.data, record.length) += '\n';
+      errors.write(text);
+    }
+  }
+}
+
+int main(int argc, char** argv) {
+  if (argc > 2) {
+    std::cerr << "Usage: " << argv[0] << " [FILE]" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  try {
+    IO::Input input(argc > 1 ? argv[1] : "-");
+    IO::Results::Reader reader(input.begin(), input.end());
+
+    IO::Output output(STDOUT_FILENO);
+    IO::Output errors(STDERR_FILENO, 1 << 16);
+
+    switch (reader.kind()) {
+      case IO::Results::FLOAT:
+        print<float>(reader, output, errors);
+        break;
+      case IO::Results::DOUBLE:
+        print<double>(reader, output, errors);
+        break;
+      case IO::Results::LONG_DOUBLE:
+        print<long double>(reader, output, errors);
+        break;
+#ifdef XXCALC_FLOAT128
+      case IO::Results::FLOAT128:
+        print<__float128>(reader, output, errors);
+        break;
+#endif
+      default:
+        throw std::runtime_error("Unsupported type of coefficients");
+    }
+  }
+  catch (std::runtime_error& error) {
+    std::cerr << error.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
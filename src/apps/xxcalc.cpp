@@ -1,23 +1,50 @@
+#include <cctype>
+#include <cstring>
+#include <fstream>
+#include <functional>
 #include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include <unistd.h>
 
 #ifdef READLINE_FOUND
 #include <readline/readline.h>
 #include <readline/history.h>
-#include <cstring>
 #define HISTORY_FILE ".xxcalc_history"
 #endif
 
 #include "calculator/tokenizer.hpp"
 #include "calculator/parser.hpp"
 #include "calculator/linear_solver.hpp"
+#include "calculator/status.hpp"
+#include "calculator/image.hpp"
+#include "calculator/trace.hpp"
+#include "counters.hpp"
+#include "io.hpp"
+#include "parallel.hpp"
+#include "results.hpp"
 
-using namespace XX;
+#ifdef XXCALC_TRACE
+#include <csignal>
+#include <thread>
+#include <pthread.h>
+#endif
 
-int main(int argc, char** argv) {
-  Calculator::Tokenizer tokenizer;
-  Calculator::Parser parser;
-  Calculator::LinearSolver solver(tokenizer, parser);
+// type of coefficients used by the calculator
+#ifndef XXCALC_COEFFICIENT
+#define XXCALC_COEFFICIENT double
+#endif
 
+using namespace XX;
+
+/**
+ * Reads expressions line by line and prints their values
+ * (or errors) until end of input.
+ */
+template <typename V>
+void run(Calculator::BasicLinearSolver<V>& solver) {
 #ifdef READLINE_FOUND
   ::read_history(HISTORY_FILE);
 
@@ -31,7 +58,7 @@ int main(int argc, char** argv) {
 #endif
 
     try {
-      Calculator::Value result = solver.process(line);
+      V result = solver.process(line);
 
       if (solver.solved)
         std::cout << "x=";
@@ -56,6 +83,583 @@ int main(int argc, char** argv) {
 #ifdef READLINE_FOUND
   ::write_history(HISTORY_FILE);
 #endif
+}
+
+//! Name of the variable in printed results
+const std::string variable("x");
+
+/**
+ * Category of a failure, the same as of the error describing it
+ * (a parsing, value or evaluation error).
+ *
+ * @param status Failure of an expression
+ * @return Category of the failure
+ */
+IO::Results::Status category(Calculator::Status const& status) {
+  using Calculator::ErrorCode;
+
+  switch (status.code) {
+    case ErrorCode::EMPTY_EXPRESSION:
+    case ErrorCode::UNKNOWN_OPERATOR:
+    case ErrorCode::MISSING_BRACKET:
+    case ErrorCode::PARSING:
+      return IO::Results::PARSING;
+    case ErrorCode::POLYNOMIAL_CAST:
+    case ErrorCode::POLYNOMIAL_DIVISION:
+    case ErrorCode::SERIES_EXPANSION:
+    case ErrorCode::VALUE:
+      return IO::Results::VALUE;
+    default:
+      return IO::Results::EVALUATION;
+  }
+}
+
+//! Printed names of categories of failures
+char const* const category_names[] = {"[OK] ", "[PARSING] ", "[VALUE] ", "[EVALUATION] "};
+
+/**
+ * Appends result or failure of an expression to given buffers,
+ * exactly as the interactive loop prints them.
+ *
+ * @param solver Solver which evaluated the expression
+ * @param outcome Result or failure of the expression (see try_process)
+ * @param[out] output Result of the expression
+ * @param[out] errors Error of the expression
+ */
+template <typename V>
+void write_text(Calculator::BasicLinearSolver<V> const& solver,
+                typename Calculator::BasicLinearSolver<V>::Outcome const& outcome,
+                std::string& output, std::string& errors) {
+  if (!outcome.ok()) {
+    errors.append(category_names[category(outcome.status)]).append(outcome.status.message()) += '\n';
+    return;
+  }
+
+  if (solver.solved)
+    output += "x=";
+
+  outcome.value.repr(output, variable);
+  output += '\n';
+}
+
+/**
+ * Appends result or failure of an expression as a record of
+ * a binary stream of results.
+ *
+ * @param solver Solver which evaluated the expression
+ * @param outcome Result or failure of the expression (see try_process)
+ * @param[out] output Record of the expression
+ */
+template <typename V>
+void write_record(Calculator::BasicLinearSolver<V> const& solver,
+                  typename Calculator::BasicLinearSolver<V>::Outcome const& outcome, std::string& output) {
+  if (outcome.ok())
+    IO::Results::write_result(output, outcome.value, solver.solved);
+  else
+    IO::Results::write_error(output, category(outcome.status), outcome.status.message().c_str());
+}
+
+/**
+ * Evaluates lines in [begin, end) appending results and errors
+ * to given buffers, exactly as the interactive loop prints them.
+ *
+ * @param solver Solver evaluating the lines
+ * @param begin Beginning of the first line
+ * @param end End of the last line
+ * @param[out] output Results of the lines
+ * @param[out] errors Errors of the lines
+ */
+template <typename V>
+void process_lines(Calculator::BasicLinearSolver<V>& solver, char const* begin, char const* end,
+                   std::string& output, std::string& errors) {
+  // reused for every line, so it is allocated only once per chunk
+  std::string line;
+
+  while (begin < end) {
+    char const* line_end = static_cast<char const*>(std::memchr(begin, '\n', end - begin));
+    if (line_end == nullptr)
+      line_end = end;
+
+    line.assign(begin, line_end);
+    begin = line_end + 1;
+
+    write_text(solver, solver.try_process(line), output, errors);
+  }
+}
+
+/**
+ * Evaluates lines in [begin, end) appending their results and
+ * errors as records of a binary stream of results.
+ *
+ * @param solver Solver evaluating the lines
+ * @param begin Beginning of the first line
+ * @param end End of the last line
+ * @param[out] output Records of the lines
+ * @param[out] errors Unused, errors are written as records
+ */
+template <typename V>
+void process_records(Calculator::BasicLinearSolver<V>& solver, char const* begin, char const* end,
+                     std::string& output, std::string& errors) {
+  std::string line;
+
+  while (begin < end) {
+    char const* line_end = static_cast<char const*>(std::memchr(begin, '\n', end - begin));
+    if (line_end == nullptr)
+      line_end = end;
+
+    line.assign(begin, line_end);
+    begin = line_end + 1;
+
+    write_record(solver, solver.try_process(line), output);
+  }
+}
+
+/**
+ * Evaluates every expression of a compiled image (written by
+ * compile_batch) in order, with the same results and errors as
+ * the lines it was compiled from.
+ *
+ * @param configure Sets up the solver (ie. its series order)
+ * @param input Input holding the image
+ * @param binary True to write a binary stream of results
+ */
+template <typename V>
+void run_image(std::function<void(Calculator::BasicLinearSolver<V>&)> configure,
+               IO::Input const& input, bool binary) {
+  typedef typename V::coefficient_type T;
+  typedef typename Calculator::BasicEvaluator<V>::Program Program;
+
+  Calculator::BasicImage<V> image(input.begin(), input.end());
+
+  Calculator::Tokenizer tokenizer;
+  Calculator::Parser parser;
+  Calculator::BasicLinearSolver<V> solver(tokenizer, parser);
+  configure(solver);
+
+  IO::Output output(STDOUT_FILENO);
+  IO::Output errors(STDERR_FILENO, 1 << 16);
+
+  std::string results, failures, message;
+
+  if (binary)
+    IO::Results::write_header(results, IO::Results::KindOf<T>::value, sizeof(T));
+
+  for (std::size_t i = 0; i < image.size(); i++) {
+    typename Calculator::BasicLinearSolver<V>::Outcome outcome;
+
+    if (image.error(i, message))
+      outcome.status = Calculator::Status::of(Calculator::ParsingError(message));
+    else
+      outcome = solver.try_process([&](Calculator::BasicEvaluator<V>& evaluator, Program& program) {
+        image.link(i, evaluator, program);
+      });
+
+    if (binary)
+      write_record(solver, outcome, results);
+    else
+      write_text(solver, outcome, results, failures);
+
+    output.write(results);
+    errors.write(failures);
+    results.clear();
+    failures.clear();
+  }
+}
+
+// compiled images have coefficients of fixed size
+template <>
+void run_image<Calculator::ExactValue>(std::function<void(Calculator::BasicLinearSolver<Calculator::ExactValue>&)> configure,
+                                       IO::Input const& input, bool binary) {
+  throw std::runtime_error("Compiled images are not supported with exact arithmetic");
+}
+
+/**
+ * Compiles every line of the input into an image, which can be
+ * evaluated later (by run_image) without tokenizing and parsing.
+ *
+ * @param configure Sets up the solver (its operators are parsed)
+ * @param batch Path of the input (or empty for standard input)
+ * @param path Path of the written image
+ */
+template <typename V>
+void compile_batch(std::function<void(Calculator::BasicLinearSolver<V>&)> configure,
+                   std::string const& batch, std::string const& path) {
+  IO::Input input(batch.empty() ? "-" : batch);
+
+  Calculator::Tokenizer tokenizer;
+  Calculator::Parser parser;
+  Calculator::BasicLinearSolver<V> solver(tokenizer, parser);
+  configure(solver);
+
+  typename Calculator::BasicImage<V>::Builder builder;
+  std::string line;
+
+  for (char const* begin = input.begin(); begin < input.end(); ) {
+    char const* line_end = static_cast<char const*>(std::memchr(begin, '\n', input.end() - begin));
+    if (line_end == nullptr)
+      line_end = input.end();
+
+    line.assign(begin, line_end);
+    begin = line_end + 1;
+
+    try {
+      builder.add(parser.process(tokenizer.process(line)));
+    }
+    catch (Calculator::ParsingError& error) {
+      builder.add_error(error.what());
+    }
+  }
+
+  std::string image;
+  builder.write(image);
+
+  std::ofstream file(path, std::ios::binary);
+  file.write(image.data(), image.size());
+
+  if (!file)
+    throw std::runtime_error("Cannot write compiled image to '" + path + "'");
+}
+
+/**
+ * Checks if any line of the input refers to the result of
+ * previous line (ans).
+ *
+ * @param input Batch input
+ * @return True if ans identifier is found
+ */
+bool uses_ans(IO::Input const& input) {
+  auto identifier = [](char c) { return std::isalnum(c) || c == '_'; };
+
+  for (char const* p = input.begin(); p + 3 <= input.end(); p++) {
+    p = static_cast<char const*>(std::memchr(p, 'a', input.end() - p));
+
+    if (p == nullptr || p + 3 > input.end())
+      return false;
+
+    if (p[1] == 'n' && p[2] == 's' &&
+        (p == input.begin() || !identifier(p[-1])) &&
+        (p + 3 == input.end() || !identifier(p[3])))
+      return true;
+  }
+
+  return false;
+}
+
+/**
+ * Processes every line of the batch input non interactively. Results
+ * and errors are written through large buffers (flushed when full,
+ * not after every line), so standard output and standard error
+ * are not interleaved line by line.
+ *
+ * Lines are independent, unless they refer to ans - such inputs are
+ * processed by a single thread, otherwise chunks of lines are
+ * evaluated in parallel, each thread with its own solver. Results
+ * are written in order of input either way.
+ *
+ * @param configure Sets up a new solver (ie. its series order)
+ * @param input Batch input
+ * @param threads Number of threads (zero to use every core)
+ * @param process Evaluates lines of a chunk (process_lines or process_records)
+ * @param header Written before results
+ */
+template <typename V>
+void run_batch(std::function<void(Calculator::BasicLinearSolver<V>&)> configure,
+               IO::Input const& input, unsigned threads,
+               void (*process)(Calculator::BasicLinearSolver<V>&, char const*, char const*,
+                               std::string&, std::string&),
+               std::string const& header) {
+  IO::Output output(STDOUT_FILENO);
+  IO::Output errors(STDERR_FILENO, 1 << 16);
+
+  output.write(header);
+
+  // results of previous lines are not known in parallel
+  if (threads != 1 && uses_ans(input))
+    threads = 1;
+
+  IO::ParallelBatch batch(input, threads);
+
+  batch.run([&]() {
+    // every thread has its own tokenizer, parser and solver
+    auto tokenizer = std::make_shared<Calculator::Tokenizer>();
+    auto parser = std::make_shared<Calculator::Parser>();
+    auto solver = std::make_shared<Calculator::BasicLinearSolver<V>>(*tokenizer, *parser);
+    configure(*solver);
+
+    return [tokenizer, parser, solver, process](char const* begin, char const* end,
+                                                std::string& output, std::string& errors) {
+      process(*solver, begin, end, output, errors);
+    };
+  }, output, errors);
+}
+
+/**
+ * Processes every line of the input by a single thread, measuring
+ * hardware counters and time of tokenizing, parsing and evaluation
+ * of every line, and of every call of each function (failing ones
+ * as well). Results are written as usual, the profile is written
+ * to standard error at the end (see IO::Profile).
+ *
+ * Functions are measured through wrapped handlers, so evaluation
+ * is never done on scalars - the profile shows the polynomial path
+ * and the evaluation includes calls of functions.
+ *
+ * @param configure Sets up the solver (ie. its series order)
+ * @param batch Path of the input (or empty for standard input)
+ */
+template <typename V>
+void profile_batch(std::function<void(Calculator::BasicLinearSolver<V>&)> configure,
+                   std::string const& batch) {
+  typedef typename Calculator::BasicEvaluator<V>::Handler Handler;
+  typedef typename Calculator::BasicEvaluator<V>::Program Program;
+
+  IO::Input input(batch.empty() ? "-" : batch);
+  IO::Output output(STDOUT_FILENO);
+  IO::Output errors(STDERR_FILENO, 1 << 16);
+
+  IO::Counters counters;
+  IO::Profile profile;
+
+  Calculator::Tokenizer tokenizer;
+  Calculator::Parser parser;
+  Calculator::BasicLinearSolver<V> solver(tokenizer, parser);
+  configure(solver);
+
+  solver.wrap_functions([&](std::string const& name, Handler handler) -> Handler {
+    std::string part = "call " + name;
+
+    return [&counters, &profile, part, handler](std::vector<V> const& args) {
+      IO::Profile::Sample sample(counters, profile, part);
+      return handler(args);
+    };
+  });
+
+  std::string line, results, failures;
+  Program program;
+
+  for (char const* begin = input.begin(); begin < input.end(); ) {
+    char const* line_end = static_cast<char const*>(std::memchr(begin, '\n', input.end() - begin));
+    if (line_end == nullptr)
+      line_end = input.end();
+
+    line.assign(begin, line_end);
+    begin = line_end + 1;
+
+    typename Calculator::BasicLinearSolver<V>::Outcome outcome;
+    Calculator::TokenList tokens;
+    {
+      IO::Profile::Sample sample(counters, profile, "tokenize");
+      tokens = tokenizer.process(line);
+    }
+    {
+      IO::Profile::Sample sample(counters, profile, "parse");
+      tokens = parser.process(tokens, outcome.status);
+    }
+
+    if (outcome.ok()) {
+      IO::Profile::Sample sample(counters, profile, "evaluate");
+      outcome = solver.try_process([&](Calculator::BasicEvaluator<V>& evaluator, Program& program) {
+        evaluator.compile(tokens, program);
+      });
+    }
+
+    write_text(solver, outcome, results, failures);
+
+    output.write(results);
+    errors.write(failures);
+    results.clear();
+    failures.clear();
+  }
+
+  output.flush();
+
+  if (!counters.error().empty())
+    failures.append(counters.error()).append(", events which are not counted are shown as '-'\n");
+  profile.report(counters, failures);
+  errors.write(failures);
+}
+
+//! Checks if the input is a compiled image instead of text
+bool is_image(IO::Input const& input) {
+  return Calculator::Image::is_image(input.begin(), input.end());
+}
+
+/**
+ * Runs the solver interactively, or in batch mode if a batch
+ * input is given. A compiled image is evaluated as well.
+ *
+ * @param configure Sets up a new solver (ie. its series order)
+ * @param batch Path of batch input (or empty)
+ * @param threads Number of threads of batch processing
+ */
+template <typename V>
+void start(std::function<void(Calculator::BasicLinearSolver<V>&)> configure,
+           std::string const& batch, unsigned threads) {
+  if (batch.empty()) {
+    Calculator::Tokenizer tokenizer;
+    Calculator::Parser parser;
+    Calculator::BasicLinearSolver<V> solver(tokenizer, parser);
+    configure(solver);
+
+    run(solver);
+  } else {
+    IO::Input input(batch);
+
+    if (is_image(input))
+      run_image(configure, input, false);
+    else
+      run_batch(configure, input, threads, process_lines<V>, std::string());
+  }
+}
+
+/**
+ * Runs the solver in batch mode, writing a binary stream of
+ * results (see IO::Results) instead of text.
+ *
+ * @param configure Sets up a new solver (ie. its series order)
+ * @param batch Path of batch input (or empty for standard input)
+ * @param threads Number of threads of batch processing
+ */
+template <typename V>
+void start_binary(std::function<void(Calculator::BasicLinearSolver<V>&)> configure,
+                  std::string const& batch, unsigned threads) {
+  typedef typename V::coefficient_type T;
+
+  std::string header;
+  IO::Results::write_header(header, IO::Results::KindOf<T>::value, sizeof(T));
+
+  IO::Input input(batch.empty() ? "-" : batch);
+
+  if (is_image(input))
+    run_image(configure, input, true);
+  else
+    run_batch(configure, input, threads, process_records<V>, header);
+}
+
+#ifdef XXCALC_TRACE
+/**
+ * Dumps traces of the calculator to standard error whenever SIGUSR1
+ * is received. The signal is blocked (in every thread created later)
+ * and waited for by a detached thread, so traces are not formatted
+ * in a signal handler.
+ */
+void dump_traces_on_signal() {
+  sigset_t mask;
+  sigemptyset(&mask);
+  sigaddset(&mask, SIGUSR1);
+  ::pthread_sigmask(SIG_BLOCK, &mask, nullptr);
+
+  std::thread([mask]() {
+    std::string output;
+    int signal;
+
+    while (::sigwait(&mask, &signal) == 0) {
+      output.clear();
+      Calculator::Trace::dump(output);
+      IO::Output(STDERR_FILENO, output.size()).write(output);
+    }
+  }).detach();
+}
+#endif
+
+int main(int argc, char** argv) {
+  typedef Calculator::BasicValue<XXCALC_COEFFICIENT> Value;
+
+#ifdef XXCALC_TRACE
+  dump_traces_on_signal();
+#endif
+
+  unsigned long series_order = 0;
+  bool exact = false;
+  bool binary = false;
+  bool profile = false;
+  std::string batch, compile;
+  unsigned threads = 1;
+
+  for (int i = 1; i < argc; i++) {
+    std::string option(argv[i]);
+
+    if ((option == "-s" || option == "--series") && i + 1 < argc) {
+      series_order = std::stoul(argv[++i]);
+    } else
+    if (option == "-e" || option == "--exact") {
+      exact = true;
+    } else
+    if ((option == "-b" || option == "--batch") && i + 1 < argc) {
+      batch = argv[++i];
+    } else
+    if ((option == "-j" || option == "--threads") && i + 1 < argc) {
+      threads = std::stoul(argv[++i]);
+    } else
+    if (option == "-r" || option == "--binary") {
+      binary = true;
+    } else
+    if ((option == "-c" || option == "--compile") && i + 1 < argc) {
+      compile = argv[++i];
+    } else
+    if (option == "-p" || option == "--profile") {
+      profile = true;
+    } else {
+      std::cerr << "Usage: " << argv[0] << " [--series ORDER | --exact] [--batch FILE [--threads N]] [--binary]"
+                << " [--compile IMAGE] [--profile]" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (exact && series_order > 0) {
+    std::cerr << "Power series are not supported with exact arithmetic" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  if (exact && binary) {
+    std::cerr << "Binary results are not supported with exact arithmetic" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  if (exact && !compile.empty()) {
+    std::cerr << "Compiled images are not supported with exact arithmetic" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  if (profile && (binary || !compile.empty())) {
+    std::cerr << "Profiling is supported only with text results" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  try {
+    if (profile) {
+      if (exact)
+        profile_batch<Calculator::ExactValue>([](Calculator::BasicLinearSolver<Calculator::ExactValue>& solver) { },
+                                              batch);
+      else
+        profile_batch<Value>([=](Calculator::BasicLinearSolver<Value>& solver) {
+          solver.set_series_order(series_order);
+        }, batch);
+    } else
+    if (!compile.empty()) {
+      compile_batch<Value>([](Calculator::BasicLinearSolver<Value>& solver) { }, batch, compile);
+    } else
+    if (binary) {
+      start_binary<Value>([=](Calculator::BasicLinearSolver<Value>& solver) {
+        solver.set_series_order(series_order);
+        solver.set_direct_compilation(true);
+      }, batch, threads);
+    } else
+    if (exact) {
+      start<Calculator::ExactValue>([](Calculator::BasicLinearSolver<Calculator::ExactValue>& solver) {
+        solver.set_direct_compilation(true);
+      }, batch, threads);
+    } else {
+      start<Value>([=](Calculator::BasicLinearSolver<Value>& solver) {
+        solver.set_series_order(series_order);
+        solver.set_direct_compilation(true);
+      }, batch, threads);
+    }
+  }
+  catch (std::runtime_error& error) {
+    std::cerr << error.what() << std::endl;
+    return EXIT_FAILURE;
+  }
 
   return EXIT_SUCCESS;
 }
@@ -0,0 +1,28 @@
+#include "allocations.hpp"
+
+namespace {
+
+//! Number of allocations made by the thread
+thread_local std::uint64_t allocations = 0;
+
+//! Number of bytes allocated by the thread
+thread_local std::uint64_t allocated_bytes = 0;
+
+}
+
+namespace XX {
+namespace Calculator {
+
+bool Allocations::counted = false;
+
+Allocations Allocations::current() {
+  return Allocations(allocations, allocated_bytes);
+}
+
+void Allocations::record(std::uint64_t bytes) {
+  allocations++;
+  allocated_bytes += bytes;
+}
+
+}
+}
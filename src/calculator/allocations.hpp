@@ -0,0 +1,67 @@
+#include <cstdint>
+
+#pragma once
+
+namespace XX {
+namespace Calculator {
+
+/**
+ * Counts of heap allocations. Programs linking the counting global
+ * operator new (src/apps/allocations.cpp - the tests, xxcalc-bench
+ * and xxcalc-load) record allocations and allocated bytes of every
+ * thread (a couple of thread local additions), so allocations made
+ * by any part of the calculator - strings of tokens, nodes of token
+ * lists, stacks, arguments of functions and coefficients of values -
+ * can be measured by taking counts before and after it. Other
+ * programs keep operator new of the standard library and their
+ * counts stay zero.
+ *
+ * Only allocations of the calling thread are counted, so counts are
+ * not disturbed by other threads.
+ */
+struct Allocations {
+  //! Number of allocations
+  std::uint64_t count;
+  //! Number of allocated bytes
+  std::uint64_t bytes;
+
+  //! Creates zero counts
+  Allocations() : count(0), bytes(0) { }
+
+  //! Creates given counts
+  Allocations(std::uint64_t count, std::uint64_t bytes) : count(count), bytes(bytes) { }
+
+  //! Difference of counts
+  Allocations operator-(Allocations const& other) const {
+    return Allocations(count - other.count, bytes - other.bytes);
+  }
+
+  //! Adds counts
+  Allocations& operator+=(Allocations const& other) {
+    count += other.count;
+    bytes += other.bytes;
+    return *this;
+  }
+
+  /**
+   * Gets counts of allocations of the calling thread since it
+   * was started.
+   *
+   * @return Current counts
+   */
+  static Allocations current();
+
+  /**
+   * Counts an allocation of the calling thread (called by the
+   * counting operator new).
+   *
+   * @param bytes Size of the allocation
+   */
+  static void record(std::uint64_t bytes);
+
+  //! True if the program counts its allocations (set by the counting operator new)
+  static bool counted;
+};
+
+}
+}
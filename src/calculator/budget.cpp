@@ -0,0 +1,50 @@
+#include "budget.hpp"
+#include "errors.hpp"
+
+#include <string>
+
+namespace XX {
+namespace Calculator {
+
+thread_local Budget* Budget::active = nullptr;
+
+Budget::Budget(Limits const& limits, Cancellation const* cancellation) :
+  limits(limits), cancellation(cancellation), memory(0), operations(0),
+  // the first charge checks cancellation
+  unchecked(check_interval) {
+  if (limits.time > 0)
+    deadline = std::chrono::steady_clock::now() +
+               std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(limits.time));
+}
+
+void Budget::spend(unsigned long degree, std::uint64_t memory, std::uint64_t operations) {
+  if (limits.degree > 0 && degree > limits.degree)
+    throw BudgetExceededError("Degree " + std::to_string(degree) + " exceeds limit of " +
+                              std::to_string(limits.degree));
+
+  this->memory += memory;
+  if (limits.memory > 0 && this->memory > limits.memory)
+    throw BudgetExceededError("Memory of coefficients exceeds limit of " + std::to_string(limits.memory) + " bytes");
+
+  this->operations += operations;
+  if (limits.operations > 0 && this->operations > limits.operations)
+    throw BudgetExceededError("Number of operations exceeds limit of " + std::to_string(limits.operations));
+
+  unchecked += operations;
+  if (unchecked >= check_interval) {
+    unchecked = 0;
+    check();
+  }
+}
+
+void Budget::check() {
+  if (cancellation != nullptr && cancellation->is_cancelled())
+    throw BudgetExceededError("Evaluation was cancelled");
+
+  if (limits.time > 0 && std::chrono::steady_clock::now() > deadline)
+    throw BudgetExceededError("Evaluation exceeds time limit of " +
+                              std::to_string(static_cast<unsigned long>(limits.time * 1000)) + " ms");
+}
+
+}
+}
@@ -0,0 +1,143 @@
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#pragma once
+
+namespace XX {
+namespace Calculator {
+
+/**
+ * Token cancelling evaluations which watch it (see Budget). It can
+ * be cancelled from any thread, ie. by a server whose client has
+ * gone while its request is still evaluated.
+ */
+class Cancellation {
+  public:
+
+  //! Creates token which is not cancelled
+  Cancellation() : cancelled(false) { }
+
+  //! Cancels evaluations watching the token
+  void cancel() { cancelled.store(true, std::memory_order_relaxed); }
+
+  //! True if the token was cancelled
+  bool is_cancelled() const { return cancelled.load(std::memory_order_relaxed); }
+
+  private:
+
+  //! True if the token was cancelled
+  std::atomic<bool> cancelled;
+};
+
+/**
+ * Limits of resources of a single evaluation. Zero means there is
+ * no limit.
+ */
+struct Limits {
+  //! Largest degree of a value
+  unsigned long degree;
+  //! Total size of coefficients of computed values in bytes
+  std::uint64_t memory;
+  //! Number of operations on coefficients and calls of functions
+  std::uint64_t operations;
+  //! Duration of the evaluation in seconds
+  double time;
+
+  //! Creates no limits
+  Limits() : degree(0), memory(0), operations(0), time(0) { }
+
+  //! True if any limit is set
+  bool limited() const { return degree > 0 || memory > 0 || operations > 0 || time > 0; }
+};
+
+/**
+ * Resources spent by an evaluation running on a thread. Kernels of
+ * values charge their work before doing it (so x^100000000 fails
+ * before allocating gigabytes) and the evaluator charges calls of
+ * functions. Once a limit is exceeded (or the evaluation is
+ * cancelled) the charge throws BudgetExceededError, which unwinds
+ * the evaluation like any other error.
+ *
+ * Time and cancellation are checked only once enough operations are
+ * charged since the last check, so charging is a few additions most
+ * of the time. Without an active budget charging is a single test.
+ */
+class Budget {
+  public:
+
+  /**
+   * Creates budget of an evaluation starting now.
+   *
+   * @param limits Limits of the evaluation
+   * @param cancellation Token watched by the evaluation (or null)
+   */
+  Budget(Limits const& limits, Cancellation const* cancellation);
+
+  /**
+   * Makes a budget active on the calling thread for its lifetime
+   * (previously active budget is restored afterwards).
+   */
+  class Scope {
+    public:
+
+    //! Activates the budget (nothing is done if it is null)
+    Scope(Budget* budget) : previous(active) { if (budget != nullptr) active = budget; }
+
+    //! Restores previous budget
+    ~Scope() { active = previous; }
+
+    Scope(Scope const&) = delete;
+    Scope& operator=(Scope const&) = delete;
+
+    private:
+
+    //! Previously active budget
+    Budget* previous;
+  };
+
+  /**
+   * Charges the active budget (if there is any) for work about to
+   * be done.
+   *
+   * @throw BudgetExceededError When a limit is exceeded or the
+   *        evaluation is cancelled
+   * @param degree Degree of a computed value
+   * @param memory Size of coefficients of a computed value in bytes
+   * @param operations Number of operations
+   */
+  static void charge(unsigned long degree, std::uint64_t memory, std::uint64_t operations) {
+    if (active != nullptr)
+      active->spend(degree, memory, operations);
+  }
+
+  private:
+
+  //! Operations charged between checks of time and cancellation
+  static const std::uint64_t check_interval = 1 << 12;
+
+  //! Charges the budget
+  void spend(unsigned long degree, std::uint64_t memory, std::uint64_t operations);
+
+  //! Checks time and cancellation
+  void check();
+
+  //! Limits of the evaluation
+  Limits limits;
+  //! Watched token (or null)
+  Cancellation const* cancellation;
+  //! Deadline of the evaluation (if time is limited)
+  std::chrono::steady_clock::time_point deadline;
+  //! Charged memory
+  std::uint64_t memory;
+  //! Charged operations
+  std::uint64_t operations;
+  //! Operations charged since last check of time and cancellation
+  std::uint64_t unchecked;
+
+  //! Budget active on the thread (or null)
+  static thread_local Budget* active;
+};
+
+}
+}
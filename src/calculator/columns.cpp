@@ -0,0 +1,213 @@
+#include "columns.hpp"
+#include "errors.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+
+namespace XX {
+namespace Calculator {
+
+namespace {
+
+//! Combines operands of a block of rows
+template <typename T, typename Operation>
+void combine(T const* a, T const* b, T* result, std::size_t count, Operation operation) {
+  for (std::size_t i = 0; i < count; i++)
+    result[i] = operation(a[i], b[i]);
+}
+
+}
+
+template <typename V>
+BasicColumnProgram<V>::BasicColumnProgram(BasicPolynomialCalculator<V>& calculator, std::string const& expression,
+                                          std::vector<std::string> const& names) :
+  used(names.size(), false), max_depth(0), max_arity(0) {
+  typedef typename BasicEvaluator<V>::Program Program;
+  typedef typename BasicEvaluator<V>::Instruction::Type Step;
+  typedef typename BasicEvaluator<V>::ScalarFunction::Operation Operation;
+  typedef typename Instruction::Type Type;
+
+  TokenList tokens = calculator.parse(expression);
+
+  // columns are compiled as pushed placeholders, in order of inputs
+  // of the program
+  std::vector<std::size_t> inputs;
+  Program program;
+
+  calculator.compile([&](BasicEvaluator<V>& evaluator, Program& program) {
+    program.clear();
+
+    for (auto const& token : tokens) {
+      if (token.type == TokenType::NUMBER) {
+        try {
+          evaluator.compile_value(V::parse(token.value), token.position, program);
+        }
+        catch (std::logic_error&) {
+          evaluator.compile_number(token.value, token.position, program);
+        }
+      } else
+      if (token.type == TokenType::OPERATOR ||
+          token.type == TokenType::IDENTIFIER) {
+        auto name = std::find(names.begin(), names.end(), token.value);
+
+        if (token.type == TokenType::IDENTIFIER && name != names.end()) {
+          inputs.push_back(name - names.begin());
+          evaluator.compile_input(V(0), token.position, program);
+        } else
+        // nothing is evaluated after failure
+        if (!evaluator.compile_symbol(token.value, token.position, program)) {
+          break;
+        }
+      }
+    }
+
+    // the program is evaluated for every row
+    evaluator.finish(program);
+    evaluator.optimize(program);
+  }, program);
+
+  if (!program.scalar) {
+    // report the same error as evaluation of the expression
+    for (auto const& instruction : program.instructions) {
+      if (instruction.type == Step::PARSE) {
+        throw InvalidNumberError(program.names[instruction.index], instruction.position);
+      } else
+      if (instruction.type == Step::UNKNOWN_SYMBOL) {
+        throw UnknownSymbolError(program.names[instruction.index], instruction.position);
+      } else
+      if (instruction.type == Step::MISSING_ARGUMENT) {
+        throw ArgumentMissingError(program.names[instruction.index], instruction.position);
+      }
+    }
+
+    throw EvaluationError("Expression cannot be evaluated on columns");
+  }
+
+  if (program.depth != 1)
+    throw EvaluationError("Only single expression is allowed", 0);
+
+  for (auto const& instruction : program.instructions) {
+    if (instruction.type == Step::PUSH) {
+      auto input = std::find(program.inputs.begin(), program.inputs.end(), instruction.index);
+
+      if (input != program.inputs.end()) {
+        std::size_t column = inputs[input - program.inputs.begin()];
+        used[column] = true;
+        instructions.push_back({Type::COLUMN, column, nullptr});
+      } else {
+        constants.push_back(program.numbers[instruction.index]);
+        instructions.push_back({Type::CONSTANT, constants.size() - 1, nullptr});
+      }
+
+      continue;
+    }
+
+    // only pushes and calls are scalar
+    auto const& function = *program.functions[instruction.index];
+
+    switch (function.scalar.operation) {
+      case Operation::ADDITION:
+        instructions.push_back({Type::ADDITION, 2, nullptr});
+        break;
+
+      case Operation::SUBTRACTION:
+        instructions.push_back({Type::SUBTRACTION, 2, nullptr});
+        break;
+
+      case Operation::MULTIPLICATION:
+        instructions.push_back({Type::MULTIPLICATION, 2, nullptr});
+        break;
+
+      case Operation::DIVISION:
+        instructions.push_back({Type::DIVISION, 2, nullptr});
+        break;
+
+      default:
+        instructions.push_back({Type::CALL, function.arity, function.scalar.function});
+        max_arity = std::max<std::size_t>(max_arity, function.arity);
+    }
+  }
+
+  max_depth = program.max_depth;
+}
+
+// defined, as std::min takes it by reference
+template <typename V>
+const std::size_t BasicColumnProgram<V>::block_size;
+
+template <typename V>
+void BasicColumnProgram<V>::evaluate(T const* const* columns, std::size_t rows, T* output) const {
+  typedef typename Instruction::Type Type;
+
+  // operands point either to columns or to blocks of the stack,
+  // a result is stored in the block of its first operand
+  std::vector<T> stack(max_depth * block_size);
+  std::vector<T const*> operands(max_depth);
+  std::vector<T> args(max_arity);
+
+  for (std::size_t first = 0; first < rows; first += block_size) {
+    std::size_t count = std::min(block_size, rows - first);
+    std::size_t top = 0;
+
+    for (auto const& instruction : instructions) {
+      T* block;
+
+      switch (instruction.type) {
+        case Type::COLUMN:
+          operands[top++] = columns[instruction.index] + first;
+          continue;
+
+        case Type::CONSTANT:
+          block = &stack[top * block_size];
+          std::fill(block, block + count, constants[instruction.index]);
+          operands[top++] = block;
+          continue;
+
+        default:
+          top -= instruction.index;
+          block = &stack[top * block_size];
+      }
+
+      switch (instruction.type) {
+        case Type::ADDITION:
+          combine(operands[top], operands[top+1], block, count, std::plus<T>());
+          break;
+
+        case Type::SUBTRACTION:
+          combine(operands[top], operands[top+1], block, count, std::minus<T>());
+          break;
+
+        case Type::MULTIPLICATION:
+          combine(operands[top], operands[top+1], block, count, std::multiplies<T>());
+          break;
+
+        case Type::DIVISION:
+          combine(operands[top], operands[top+1], block, count, std::divides<T>());
+          break;
+
+        default:
+          for (std::size_t i = 0; i < count; i++) {
+            for (std::size_t j = 0; j < instruction.index; j++)
+              args[j] = operands[top + j][i];
+
+            block[i] = instruction.function(args.data());
+          }
+      }
+
+      operands[top++] = block;
+    }
+
+    std::copy(operands[0], operands[0] + count, output + first);
+  }
+}
+
+template class BasicColumnProgram<Value>;
+template class BasicColumnProgram<FloatValue>;
+template class BasicColumnProgram<LongDoubleValue>;
+#ifdef XXCALC_FLOAT128
+template class BasicColumnProgram<Float128Value>;
+#endif
+
+}
+}
@@ -0,0 +1,118 @@
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "polynomial_calculator.hpp"
+
+#pragma once
+
+namespace XX {
+namespace Calculator {
+
+/**
+ * Expression compiled once and evaluated over columns of numbers,
+ * row by row - as if the expression was evaluated for every row
+ * with its named inputs replaced by numbers of the row, but without
+ * tokenizing, parsing or formatting of every row.
+ *
+ * Inputs are identifiers of the expression matching names of
+ * columns (they take precedence over constants and functions of the
+ * calculator). The expression must be scalar - every value must be
+ * constant and every function must have a scalar implementation
+ * (see BasicEvaluator::ScalarFunction), so it is evaluated exactly
+ * like the scalar program of the evaluator.
+ *
+ * Rows are evaluated in blocks - each instruction is applied to a
+ * whole block of rows at once, so arithmetic is performed by tight
+ * loops over contiguous arrays (which the compiler vectorizes).
+ * Evaluation does not modify the program, so a single program can
+ * evaluate different rows on multiple threads.
+ *
+ * Programs are available for values with floating point coefficients
+ * (BasicValue), not for ExactValue.
+ */
+template <typename V>
+class BasicColumnProgram {
+  public:
+
+  //! Type of numbers in columns
+  typedef typename V::coefficient_type T;
+
+  //! Number of rows evaluated at once
+  static const std::size_t block_size = 256;
+
+  /**
+   * Compiles the expression using functions and constants of the
+   * calculator. The program refers to functions of the calculator,
+   * so it is valid until they are registered again.
+   *
+   * @throw ParsingError When the expression cannot be parsed
+   * @throw EvaluationError When the expression refers to unknown
+   *        symbols, it is not a single expression or it cannot be
+   *        evaluated on columns (ie. it refers to x or ans)
+   * @param calculator Calculator compiling the expression
+   * @param expression Evaluated expression
+   * @param names Names of columns
+   */
+  BasicColumnProgram(BasicPolynomialCalculator<V>& calculator, std::string const& expression,
+                     std::vector<std::string> const& names);
+
+  /**
+   * Checks if a column is referred to by the expression, other
+   * columns do not have to be provided.
+   *
+   * @param column Index of the column
+   * @return True if the column is an input of the expression
+   */
+  bool uses(std::size_t column) const { return used[column]; }
+
+  /**
+   * Evaluates rows of columns.
+   *
+   * @param columns Arrays of numbers, in order of names (arrays of
+   *                unused columns may be null)
+   * @param rows Number of rows
+   * @param[out] output Array of results (one for every row)
+   */
+  void evaluate(T const* const* columns, std::size_t rows, T* output) const;
+
+  private:
+
+  /**
+   * Single step of the program
+   */
+  struct Instruction {
+    //! Kind of instruction
+    enum class Type { COLUMN, CONSTANT, ADDITION, SUBTRACTION, MULTIPLICATION, DIVISION, CALL };
+
+    //! Kind of instruction
+    Type type;
+    //! Index of column or constant, or arity of called function
+    std::size_t index;
+    //! Called function
+    T (*function)(T const* args);
+  };
+
+  //! Instructions in order of execution
+  std::vector<Instruction> instructions;
+
+  //! Pushed constants
+  std::vector<T> constants;
+
+  //! Columns referred to by the expression
+  std::vector<bool> used;
+
+  //! Largest number of values on the stack
+  std::size_t max_depth;
+
+  //! Largest arity of called functions
+  std::size_t max_arity;
+};
+
+/**
+ * Expression evaluated over columns of doubles
+ */
+typedef BasicColumnProgram<Value> ColumnProgram;
+
+}
+}
@@ -22,6 +22,9 @@ class ParsingError : public Error {
   public:
   ParsingError(std::string const& msg, unsigned long position) :
     Error(msg + " at " + std::to_string(position)) { }
+
+  //! Recreates error with its complete message (ie. from BasicImage)
+  explicit ParsingError(std::string const& msg) : Error(msg) { }
 };
 
 /**
@@ -86,6 +89,16 @@ class PolynomialDivisionError : public ValueError {
     ValueError("Divisor must be same or lower degree than dividend") { }
 };
 
+/**
+ * A value cannot be expanded into a power series (ie. logarithm
+ * of a polynomial with non positive constant term, or an inverse
+ * of a polynomial with empty constant term).
+ */
+class SeriesExpansionError : public ValueError {
+  public:
+  SeriesExpansionError(std::string const& msg) : ValueError(msg) { }
+};
+
 
 /**
  * Generic evaluation error (expression is tokenized and parsed,
@@ -139,6 +152,27 @@ class ArgumentMissingError : public EvaluationError {
     EvaluationError("Argument is missing for function '"+value+"'", position) { }
 };
 
+/**
+ * A number cannot be represented by coefficients of values (ie.
+ * 1e400 is too large for double). Numbers are parsed once they
+ * are reached, so this error is thrown during evaluation.
+ */
+class InvalidNumberError : public EvaluationError {
+  public:
+  InvalidNumberError(std::string const& value, unsigned long position) :
+    EvaluationError("Number " + value + " cannot be represented", position) { }
+};
+
+/**
+ * Evaluation exceeded one of its limits (degree of values, memory
+ * of coefficients, number of operations or time) or it was
+ * cancelled, see Budget.
+ */
+class BudgetExceededError : public EvaluationError {
+  public:
+  BudgetExceededError(std::string const& msg) : EvaluationError(msg) { }
+};
+
 
 /**
  * Generic solver error
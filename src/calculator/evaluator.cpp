@@ -1,81 +1,1089 @@
 #include "evaluator.hpp"
+#include "budget.hpp"
 #include "errors.hpp"
+#include "trace.hpp"
 
-#include <stack>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
 
 namespace XX {
 namespace Calculator {
 
-Value Evaluator::process(TokenList& tokens) {
-  std::stack<Value> stack;
+namespace {
 
-  // process from left to right
-  while (!tokens.empty()) {
-    auto token = tokens.front();
-    tokens.pop_front();
+//! Checks if adding a zero leaves every number unchanged (adding
+//! positive zero to negative zero gives positive zero)
+template <typename T>
+bool neutral_addend(T const& zero) {
+  return T(1) / zero < T(0);
+}
+
+//! Checks if subtracting a zero leaves every number unchanged
+template <typename T>
+bool neutral_subtrahend(T const& zero) {
+  return !neutral_addend(zero);
+}
+
+//! Rational numbers have a single zero
+template <>
+bool neutral_addend<Rational>(Rational const& zero) {
+  return true;
+}
+
+template <>
+bool neutral_subtrahend<Rational>(Rational const& zero) {
+  return true;
+}
+
+//! Divides numbers
+template <typename T>
+T quotient(T const& dividend, T const& divisor) {
+  return dividend / divisor;
+}
+
+//! Quotient of a division by zero is not a rational number
+template <>
+Rational quotient<Rational>(Rational const& dividend, Rational const& divisor) {
+  if (divisor == Rational(0))
+    throw ValueError("Division by zero");
+
+  return dividend / divisor;
+}
+
+//! Checks if values are the same (unlike equal values, zeros of
+//! different signs are not)
+template <typename V>
+bool same(V const& a, V const& b) {
+  typedef typename V::coefficient_type T;
+
+  if (!(a == b))
+    return false;
+
+  for (unsigned long i = 0; i <= a.degree(); i++)
+    if (a[i] == T(0) && neutral_addend<T>(a[i]) != neutral_addend<T>(b[i]))
+      return false;
+
+  return true;
+}
+
+/**
+ * Adds numbers pairwise, so the rounding error grows with logarithm
+ * of their count instead of linearly. Fewer than eight numbers are
+ * added in order (as calls of addition would do), blocks of up to 128
+ * numbers are added by eight independent lanes (which the compiler
+ * may vectorize) and larger sums are split in halves.
+ *
+ * @param numbers Terms of the sum
+ * @param count Number of terms (at least one)
+ * @return Their sum
+ */
+template <typename T>
+T sum(T const* numbers, unsigned long count) {
+  if (count < 8) {
+    T result = numbers[0];
+
+    for (unsigned long i = 1; i < count; i++)
+      result = result + numbers[i];
+
+    return result;
+  }
+
+  if (count <= 128) {
+    T lanes[8];
+    unsigned long i;
+
+    for (i = 0; i < 8; i++)
+      lanes[i] = numbers[i];
+
+    for (; i + 8 <= count; i += 8)
+      for (unsigned long j = 0; j < 8; j++)
+        lanes[j] = lanes[j] + numbers[i + j];
+
+    T result = ((lanes[0] + lanes[1]) + (lanes[2] + lanes[3])) + ((lanes[4] + lanes[5]) + (lanes[6] + lanes[7]));
+
+    for (; i < count; i++)
+      result = result + numbers[i];
+
+    return result;
+  }
+
+  unsigned long half = count / 16 * 8;
+  return sum(numbers, half) + sum(numbers + half, count - half);
+}
+
+//! Mixes a hash into another one
+inline std::size_t mix(std::size_t seed, std::size_t hash) {
+  return seed ^ (hash + 0x9e3779b9 + (seed << 6) + (seed >> 2));
+}
+
+//! Hash of a coefficient, equal coefficients have equal hashes
+template <typename T>
+std::size_t hash_of(T const& x) {
+  return std::hash<T>()(x);
+}
+
+#ifdef XXCALC_FLOAT128
+template <>
+std::size_t hash_of<__float128>(__float128 const& x) {
+  // zeros of both signs are equal
+  __float128 value = x == 0 ? 0 : x;
+  std::uint64_t words[2];
+  std::memcpy(words, &value, sizeof(words));
+
+  return mix(std::hash<std::uint64_t>()(words[0]), std::hash<std::uint64_t>()(words[1]));
+}
+#endif
+
+//! Rational numbers are canonical, so residues of their numerator
+//! and denominator are the same for equal numbers
+template <>
+std::size_t hash_of<Rational>(Rational const& x) {
+  const std::uint32_t prime = 4294967291u;
+
+  std::size_t hash = std::hash<int>()(x.numerator().sign());
+  hash = mix(hash, x.numerator().modulo(prime));
+  return mix(hash, x.denominator().modulo(prime));
+}
+
+}
+
+template <typename V>
+void BasicEvaluator<V>::Program::clear() {
+  instructions.clear();
+  values.clear();
+  numbers.clear();
+  scalar_instructions.clear();
+  functions.clear();
+  names.clear();
+  inputs.clear();
+  starts.clear();
+  depth = 0;
+  max_depth = 0;
+  eliminated = 0;
+  scalar = true;
+}
+
+template <typename V>
+void BasicEvaluator<V>::Graph::build(Program const& program) {
+  typedef typename Instruction::Type Type;
+
+  nodes.clear();
+  operands.clear();
+  of.clear();
+  starts.clear();
+  stack.clear();
+  values.clear();
+  remaining.clear();
+
+  std::size_t size = 16;
+  while (size < 2 * program.instructions.size())
+    size *= 2;
+
+  table.assign(size, 0);
+  repeats.assign(program.instructions.size(), 0);
+
+  for (unsigned long i = 0; i < program.instructions.size(); i++) {
+    Instruction const& instruction = program.instructions[i];
+    unsigned long node;
+
+    if (instruction.type == Type::PUSH) {
+      // inputs differ from every value
+      bool input = std::find(program.inputs.begin(), program.inputs.end(), instruction.index) != program.inputs.end();
+      node = intern(program, nullptr, instruction.index, i, input);
+      starts.push_back(i);
+    } else
+    if (instruction.type == Type::PARSE) {
+      node = intern(program, nullptr, 0, i, true);
+      starts.push_back(i);
+    } else
+    if (instruction.type == Type::CALL) {
+      Function const* function = program.functions[instruction.index];
+      unsigned long first = stack.size() - function->arity;
+
+      operands.reserve(operands.size() + function->arity);
+      for (unsigned long j = first; j < stack.size(); j++)
+        operands.push_back(of[stack[j]]);
+
+      node = intern(program, function, operands.size() - function->arity, i, !function->pure);
+      starts.push_back(function->arity > 0 ? starts[stack[first]] : i);
+      stack.resize(first);
+
+      // the outermost one is the last one
+      if (nodes[node].origin != i)
+        repeats[starts[i]] = i + 1;
+    } else {
+      // nothing is evaluated after failure
+      break;
+    }
+
+    of.push_back(node);
+    stack.push_back(i);
+  }
+
+  for (auto instruction : stack)
+    nodes[of[instruction]].uses++;
+}
+
+template <typename V>
+unsigned long BasicEvaluator<V>::Graph::intern(Program const& program, Function const* function, unsigned long first,
+                                               unsigned long instruction, bool unique) {
+  unsigned long arity = function != nullptr ? function->arity : 0;
+  std::size_t hash = std::hash<Function const*>()(function);
+
+  if (function != nullptr) {
+    for (unsigned long i = first; i < first + arity; i++)
+      hash = mix(hash, std::hash<unsigned long>()(operands[i]));
+  } else
+  if (!unique) {
+    V const& value = program.values[first];
+    hash = mix(hash, std::hash<unsigned long>()(value.degree()));
+
+    for (unsigned long i = 0; i <= value.degree(); i++)
+      hash = mix(hash, hash_of(value[i]));
+  }
+
+  std::size_t bucket = hash & (table.size() - 1);
+
+  if (!unique) {
+    for (; table[bucket] != 0; bucket = (bucket + 1) & (table.size() - 1)) {
+      unsigned long candidate = table[bucket] - 1;
+      Node const& node = nodes[candidate];
+
+      if (node.function != function)
+        continue;
+
+      if (function != nullptr ?
+          std::equal(operands.begin() + first, operands.begin() + first + arity, operands.begin() + node.first) :
+          same(program.values[node.first], program.values[first])) {
+        operands.resize(operands.size() - arity);
+        return candidate;
+      }
+    }
+  }
+
+  // references are counted once for every node, so operands of
+  // a repeated call are not referenced again
+  for (unsigned long i = first; i < first + arity; i++)
+    nodes[operands[i]].uses++;
 
+  nodes.push_back({function, first, 0, instruction, 0});
+  nodes.back().shared = std::numeric_limits<unsigned long>::max();
+
+  if (!unique)
+    table[bucket] = nodes.size();
+
+  return nodes.size() - 1;
+}
+
+template <typename V>
+unsigned long BasicEvaluator<V>::Graph::reusable(unsigned long instruction) const {
+  for (unsigned long last = repeats[instruction]; last > instruction; last--) {
+    Node const& node = nodes[of[last - 1]];
+
+    if (starts[last - 1] == instruction && node.origin != last - 1 &&
+        node.shared < values.size() && remaining[node.shared] > 0)
+      return last;
+  }
+
+  return 0;
+}
+
+template <typename V>
+void BasicEvaluator<V>::Graph::keep(unsigned long node, V const& value) {
+  // the first use is the one which computed it
+  if (nodes[node].function == nullptr || nodes[node].uses < 2 || nodes[node].shared < values.size())
+    return;
+
+  nodes[node].shared = values.size();
+  values.push_back(value);
+  remaining.push_back(nodes[node].uses - 1);
+}
+
+template <typename V>
+V BasicEvaluator<V>::Graph::share(unsigned long node) {
+  unsigned long index = nodes[node].shared;
+
+  if (--remaining[index] == 0)
+    return std::move(values[index]);
+
+  return values[index];
+}
+
+template <typename V>
+V BasicEvaluator<V>::process(TokenList& tokens) {
+  Status status;
+  V result = process(tokens, status);
+
+  status.raise();
+  return result;
+}
+
+template <typename V>
+V BasicEvaluator<V>::process(TokenList& tokens, Status& status) {
+  // memory of previous program is reused, while nested evaluation
+  // (from a function handler) finds it empty and uses its own
+  Program current;
+  std::swap(current, program);
+
+  compile(tokens, current);
+  V result = execute(current, status);
+
+  std::swap(current, program);
+  return result;
+}
+
+template <typename V>
+void BasicEvaluator<V>::compile(TokenList const& tokens, Program& program) {
+  program.clear();
+
+  // process from left to right, tracking size of the stack
+  for (auto const& token : tokens) {
     // put number on a stack
     if (token.type == TokenType::NUMBER) {
-      stack.push(std::stod(token.value));
+      compile_literal(token.value, token.position, program);
     } else
     // identifier or operator are the same
     if (token.type == TokenType::OPERATOR ||
         token.type == TokenType::IDENTIFIER) {
+      // nothing is evaluated after failure
+      if (!compile_symbol(token.value, token.position, program))
+        break;
+    }
+  }
+
+  finish(program);
+}
+
+template <typename V>
+void BasicEvaluator<V>::compile_value(V value, unsigned long position, Program& program) const {
+  typedef typename Instruction::Type Type;
+
+  program.starts.push_back(program.instructions.size());
+  program.values.push_back(std::move(value));
+  program.instructions.push_back({Type::PUSH, program.values.size() - 1, position});
+  program.depth++;
+  program.max_depth = std::max(program.max_depth, program.depth);
+}
+
+template <typename V>
+void BasicEvaluator<V>::compile_input(V value, unsigned long position, Program& program) const {
+  program.inputs.push_back(program.values.size());
+  compile_value(std::move(value), position, program);
+}
+
+template <typename V>
+void BasicEvaluator<V>::compile_literal(std::string const& text, unsigned long position, Program& program) const {
+  try {
+    compile_value(V::parse(text), position, program);
+  }
+  catch (std::logic_error&) {
+    // report invalid number when it is reached
+    compile_number(text, position, program);
+  }
+}
+
+template <typename V>
+void BasicEvaluator<V>::compile_number(std::string const& text, unsigned long position, Program& program) const {
+  typedef typename Instruction::Type Type;
+
+  program.starts.push_back(program.instructions.size());
+  program.names.push_back(text);
+  program.instructions.push_back({Type::PARSE, program.names.size() - 1, position});
+  program.scalar = false;
+  program.depth++;
+  program.max_depth = std::max(program.max_depth, program.depth);
+}
+
+template <typename V>
+bool BasicEvaluator<V>::compile_symbol(std::string const& name, unsigned long position, Program& program) const {
+  typedef typename Instruction::Type Type;
+
+  // if contant replace it with its value
+  auto constant = constants.find(name);
+  if (constant != constants.end()) {
+    compile_value(constant->second, position, program);
+    return true;
+  }
+
+  // find handler
+  auto function = functions.find(name);
+  Type failure = Type::CALL;
+
+  if (function == functions.end()) {
+    failure = Type::UNKNOWN_SYMBOL;
+  } else
+  // require arguments from the stack
+  if (program.depth < function->second.arity) {
+    failure = Type::MISSING_ARGUMENT;
+  }
+
+  if (failure != Type::CALL) {
+    program.names.push_back(name);
+    program.instructions.push_back({failure, program.names.size() - 1, position});
+    program.scalar = false;
+    return false;
+  }
+
+  compile_call(function->second, position, program);
+  return true;
+}
+
+template <typename V>
+void BasicEvaluator<V>::compile_call(Function const& function, unsigned long position, Program& program) const {
+  typedef typename Instruction::Type Type;
+
+  // result starts where its first argument does
+  unsigned long start = function.arity > 0 ? program.starts[program.depth - function.arity]
+                                           : program.instructions.size();
+  program.starts.resize(program.depth - function.arity);
+  program.starts.push_back(start);
+
+  program.functions.push_back(&function);
+  program.instructions.push_back({Type::CALL, program.functions.size() - 1, position});
+  program.depth = program.depth - function.arity + 1;
+  program.max_depth = std::max(program.max_depth, program.depth);
+  program.scalar = program.scalar &&
+                   function.scalar.operation != ScalarFunction::Operation::NONE;
+}
+
+template <typename V>
+bool BasicEvaluator<V>::constant(Program const& program, unsigned long instruction) const {
+  typedef typename Instruction::Type Type;
+
+  Instruction const& push = program.instructions[instruction];
+
+  return push.type == Type::PUSH &&
+         std::find(program.inputs.begin(), program.inputs.end(), push.index) == program.inputs.end();
+}
+
+template <typename V>
+bool BasicEvaluator<V>::fold(Function const& function, unsigned long position, Program& program) {
+  typedef typename ScalarFunction::Operation Operation;
+
+  unsigned long arity = function.arity;
+  unsigned long first = program.instructions.size() - arity;
+
+  // arguments are the last pushed values (as every push appends a value)
+  bool scalar = function.scalar.operation != Operation::NONE;
+
+  for (unsigned long i = first; i < program.instructions.size(); i++) {
+    if (!constant(program, i))
+      return false;
+
+    scalar = scalar && program.values[program.instructions[i].index].degree() == 0;
+  }
+
+  auto args = program.values.end() - arity;
+  V result;
+
+  if (scalar) {
+    // numbers are filled when the program is finished, until then
+    // they hold arguments of folded functions
+    program.numbers.clear();
+    for (auto arg = args; arg != program.values.end(); ++arg)
+      program.numbers.push_back(Number(*arg));
+
+    Number* top = program.numbers.data();
+    bool folded = true;
+
+    // exact numbers reject some calls, which are left to evaluation
+    try {
+      switch (function.scalar.operation) {
+        case Operation::ADDITION:
+          result = V(top[0] + top[1]);
+          break;
+
+        case Operation::SUBTRACTION:
+          result = V(top[0] - top[1]);
+          break;
+
+        case Operation::MULTIPLICATION:
+          result = V(top[0] * top[1]);
+          break;
+
+        case Operation::DIVISION:
+          result = V(quotient(top[0], top[1]));
+          break;
+
+        default:
+          result = V(function.scalar.function(top));
+      }
+    }
+    catch (...) {
+      folded = false;
+    }
+
+    program.numbers.clear();
+
+    if (!folded)
+      return false;
+  } else {
+    // the function reports failures to its own status, a failing
+    // call is left to evaluation (so it fails at the same point)
+    struct Restore {
+      Status*& failure;
+      Status* previous;
+      ~Restore() { failure = previous; }
+    } restore{failure, failure};
+
+    Status status;
+    failure = &status;
+
+    arguments.assign(std::make_move_iterator(args), std::make_move_iterator(program.values.end()));
+    bool folded = true;
+
+    // arithmetic accumulates in place, into the first argument
+    try {
+      switch (function.scalar.operation) {
+        case Operation::ADDITION:
+          result = std::move(arguments[0] += arguments[1]);
+          break;
+
+        case Operation::SUBTRACTION:
+          result = std::move(arguments[0] -= arguments[1]);
+          break;
+
+        case Operation::MULTIPLICATION:
+          result = std::move(arguments[0] *= arguments[1]);
+          break;
+
+        default:
+          result = function.handle(arguments);
+      }
+    }
+    catch (...) {
+      folded = false;
+    }
+
+    if (!folded || !status.ok())
+      std::move(arguments.begin(), arguments.end(), args);
+
+    arguments.clear();
+
+    if (!folded || !status.ok())
+      return false;
+  }
+
+  program.instructions.resize(first);
+  program.values.erase(args, program.values.end());
+  program.starts.resize(program.depth - arity);
+  program.depth -= arity;
+
+  compile_value(std::move(result), position, program);
+  return true;
+}
+
+template <typename V>
+bool BasicEvaluator<V>::simplify(Function const& function, Program& program) const {
+  typedef typename ScalarFunction::Operation Operation;
+  typedef typename Instruction::Type Type;
+
+  Operation operation = function.scalar.operation;
+
+  if (function.arity != 2 || operation == Operation::NONE || operation == Operation::CALL)
+    return false;
+
+  unsigned long left = program.starts[program.depth - 2];
+  unsigned long right = program.starts[program.depth - 1];
+
+  // checks if an operand is a single constant equal to given number
+  auto equals = [&](unsigned long start, unsigned long end, Number const& number) -> bool {
+    if (end - start != 1 || !constant(program, start))
+      return false;
+
+    V const& value = program.values[program.instructions[start].index];
+    return value.degree() == 0 && Number(value) == number;
+  };
+
+  Number zero(0), one(1);
+  unsigned long end = program.instructions.size();
+
+  // e+0, e-0, e*1, e/1 and e^1
+  bool right_neutral = false;
+  if (equals(right, end, zero)) {
+    Number number(program.values[program.instructions[right].index]);
+    right_neutral = (operation == Operation::ADDITION && neutral_addend(number)) ||
+                    (operation == Operation::SUBTRACTION && neutral_subtrahend(number));
+  } else
+  if (equals(right, end, one)) {
+    right_neutral = operation == Operation::MULTIPLICATION || operation == Operation::DIVISION ||
+                    operation == Operation::EXPONENTIATION;
+  }
+
+  if (right_neutral) {
+    program.instructions.pop_back();
+    program.values.pop_back();
+    program.starts.pop_back();
+    program.depth--;
+    return true;
+  }
+
+  // 0+e and 1*e
+  bool left_neutral = false;
+  if (equals(left, right, zero)) {
+    left_neutral = operation == Operation::ADDITION &&
+                   neutral_addend(Number(program.values[program.instructions[left].index]));
+  } else
+  if (equals(left, right, one)) {
+    left_neutral = operation == Operation::MULTIPLICATION;
+  }
+
+  if (left_neutral) {
+    unsigned long index = program.instructions[left].index;
+
+    program.instructions.erase(program.instructions.begin() + left);
+    program.values.erase(program.values.begin() + index);
 
-      // if contant replace it with its value
-      auto constant = constants.find(token.value);
-      if (constant != constants.end()) {
-        stack.push(constant->second);
+    // following values move back
+    for (auto& instruction : program.instructions)
+      if (instruction.type == Type::PUSH && instruction.index > index)
+        instruction.index--;
+    for (auto& input : program.inputs)
+      if (input > index)
+        input--;
+
+    // the other operand starts where the removed one did
+    program.starts.pop_back();
+    program.depth--;
+    return true;
+  }
+
+  return false;
+}
+
+template <typename V>
+void BasicEvaluator<V>::optimize(Program& program) {
+  typedef typename Instruction::Type Type;
+
+  // instructions are compiled again with calls folded or removed,
+  // memory of the previous optimization is reused (while nested
+  // evaluation, from a folded function, finds it empty)
+  Program source;
+  std::swap(source, optimized);
+  std::swap(source, program);
+
+  // memory alternates between both programs, so they are kept large
+  // enough to compile the source again
+  program.instructions.reserve(source.instructions.size());
+  program.values.reserve(source.values.size());
+  program.functions.reserve(source.functions.size());
+  program.starts.reserve(source.starts.capacity());
+  program.inputs.reserve(source.inputs.size());
+  program.numbers.reserve(source.numbers.capacity());
+  program.names.reserve(source.names.size());
+
+  program.eliminated = source.eliminated;
+
+  Graph graph;
+  std::swap(graph, subexpressions);
+  graph.build(source);
+
+  for (unsigned long i = 0; i < source.instructions.size(); i++) {
+    Instruction const& instruction = source.instructions[i];
+
+    // repeated subexpression is replaced with value of the first one
+    if (graph.repeats[i] > 0) {
+      unsigned long last = graph.reusable(i);
+
+      if (last > 0) {
+        for (unsigned long j = i; j < last; j++)
+          program.eliminated += source.instructions[j].type == Type::CALL;
+
+        compile_value(graph.share(graph.of[last - 1]), source.instructions[last - 1].position, program);
+        i = last - 1;
         continue;
       }
+    }
 
-      // find handler
-      auto function = functions.find(token.value);
-      if (function == functions.end()) {
-        throw UnknownSymbolError(token.value, token.position);
+    switch (instruction.type) {
+      case Type::PUSH:
+        if (std::find(source.inputs.begin(), source.inputs.end(), instruction.index) != source.inputs.end())
+          compile_input(std::move(source.values[instruction.index]), instruction.position, program);
+        else
+          compile_value(std::move(source.values[instruction.index]), instruction.position, program);
+        break;
+
+      case Type::PARSE:
+        compile_number(source.names[instruction.index], instruction.position, program);
+        break;
+
+      case Type::CALL: {
+        Function const& function = *source.functions[instruction.index];
+
+        // only the residual work is left
+        if (!function.pure ||
+            !(fold(function, instruction.position, program) || simplify(function, program)))
+          compile_call(function, instruction.position, program);
+        break;
       }
 
-      // require arguments from the stack
-      if (stack.size() < function->second.arity) {
-        throw ArgumentMissingError(token.value, token.position);
+      default:
+        // failing instruction is the last one
+        program.names.push_back(source.names[instruction.index]);
+        program.instructions.push_back({instruction.type, program.names.size() - 1, instruction.position});
+        program.scalar = false;
+    }
+
+    if (i < graph.of.size() && constant(program, program.instructions.size() - 1))
+      graph.keep(graph.of[i], program.values.back());
+  }
+
+  convert(program);
+
+  if (program.scalar)
+    flatten(program);
+
+#ifdef XXCALC_TRACE
+  Trace::histogram(Trace::ELIMINATED).record(program.eliminated);
+#endif
+
+  // values left are not kept until the next optimization
+  graph.values.clear();
+  std::swap(graph, subexpressions);
+
+  source.clear();
+  std::swap(source, optimized);
+}
+
+template <typename V>
+void BasicEvaluator<V>::finish(Program& program) {
+  convert(program);
+
+  // scalar evaluation does not allocate, so it takes less time than
+  // folding would (unless the program is evaluated repeatedly)
+  if (!program.scalar)
+    optimize(program);
+  else
+    flatten(program);
+}
+
+template <typename V>
+void BasicEvaluator<V>::flatten(Program& program) {
+  typedef typename Instruction::Type Type;
+  typedef typename ScalarFunction::Operation Operation;
+
+  std::vector<Instruction>& lowered = program.scalar_instructions;
+  lowered.clear();
+  operands.clear();
+
+  for (auto const& instruction : program.instructions) {
+    if (instruction.type == Type::PUSH) {
+      lowered.push_back(instruction);
+      operands.emplace_back(lowered.size() - 1, false);
+      continue;
+    }
+
+    // only pushes and calls are scalar
+    Function const& function = *program.functions[instruction.index];
+    Operation operation = function.scalar.operation;
+
+    if (operation == Operation::ADDITION || operation == Operation::SUBTRACTION) {
+      unsigned long right = operands.back().first;
+      operands.pop_back();
+
+      if (operation == Operation::SUBTRACTION)
+        lowered.push_back({Type::NEGATE, 0, instruction.position});
+
+      // sum of the left operand is extended, moving it after the
+      // right operand
+      if (operands.back().second) {
+        Instruction sum = lowered[right - 1];
+        lowered.erase(lowered.begin() + right - 1);
+        sum.index++;
+        lowered.push_back(sum);
       } else {
+        lowered.push_back({Type::SUM, 2, instruction.position});
+        operands.back().second = true;
+      }
+    } else {
+      unsigned long start = function.arity > 0 ? operands[operands.size() - function.arity].first : lowered.size();
+      operands.resize(operands.size() - function.arity);
+      operands.emplace_back(start, false);
+      lowered.push_back(instruction);
+    }
+  }
+
+  // terms of sums are on the stack at once
+  unsigned long depth = 0;
+
+  for (auto const& instruction : lowered) {
+    if (instruction.type == Type::PUSH)
+      depth++;
+    else
+    if (instruction.type == Type::SUM)
+      depth -= instruction.index - 1;
+    else
+    if (instruction.type == Type::CALL)
+      depth -= program.functions[instruction.index]->arity - 1;
+
+    program.max_depth = std::max(program.max_depth, depth);
+  }
+}
+
+template <typename V>
+void BasicEvaluator<V>::convert(Program& program) const {
+  program.numbers.clear();
+
+  // scalar evaluation requires constant values only
+  if (program.scalar) {
+    program.numbers.reserve(program.values.size());
+
+    for (auto const& value : program.values) {
+      if (value.degree() > 0) {
+        program.scalar = false;
+        break;
+      }
+
+      program.numbers.push_back(Number(value));
+    }
+  }
+}
+
+template <typename V>
+V BasicEvaluator<V>::execute(Program& program) {
+  Status status;
+  V result = execute(program, status);
+
+  status.raise();
+  return result;
+}
+
+template <typename V>
+V BasicEvaluator<V>::execute(Program& program, Status& status) {
+#ifdef XXCALC_TRACE
+  Trace::histogram(Trace::STACK_DEPTH).record(program.max_depth);
+#endif
+
+  if (program.scalar)
+    return execute_scalar(program, status);
+  else
+    return execute_polynomial(program, status);
+}
+
+template <typename V>
+void BasicEvaluator<V>::fail(Status const& status) {
+  if (failure == nullptr)
+    status.raise();
+
+  *failure = status;
+}
+
+template <typename V>
+V BasicEvaluator<V>::execute_polynomial(Program& program, Status& status) {
+  typedef typename Instruction::Type Type;
+  typedef typename ScalarFunction::Operation Operation;
+
+  // functions report failures to this status, the previous one
+  // (of evaluation calling a nested one) is restored even if an
+  // error is thrown
+  struct Restore {
+    Status*& failure;
+    Status* previous;
+    ~Restore() { failure = previous; }
+  } restore{failure, failure};
+  failure = &status;
+
+  // memory of previous evaluation is reused, while nested evaluation
+  // (from a function handler) finds it empty and uses its own
+  std::vector<V> stack, args;
+  std::swap(stack, polynomials);
+  std::swap(args, arguments);
+
+  // stacks are given back for the next evaluation
+  auto finish = [&]() -> V {
+    V result = stack.size() == 1 && status.ok() ? std::move(stack.back()) : V();
+
+    stack.clear();
+    std::swap(stack, polynomials);
+    std::swap(args, arguments);
+
+    return result;
+  };
+
+  stack.reserve(program.max_depth);
+
+  for (auto const& instruction : program.instructions) {
+    switch (instruction.type) {
+      case Type::PUSH:
+        stack.push_back(std::move(program.values[instruction.index]));
+        break;
+
+      case Type::PARSE:
+        // a number which cannot be represented fails once reached
+        try {
+          stack.push_back(V::parse(program.names[instruction.index]));
+        }
+        catch (std::logic_error&) {
+          status = Status(ErrorCode::INVALID_NUMBER, instruction.position, program.names[instruction.index]);
+          return finish();
+        }
+        break;
+
+      case Type::CALL: {
+        Function const& function = *program.functions[instruction.index];
+        Budget::charge(0, 0, 1);
+
+        // arithmetic accumulates in place, into the left operand (as
+        // operators of values copy it and do the same)
+        switch (function.scalar.operation) {
+          case Operation::ADDITION:
+            stack[stack.size() - 2] += stack.back();
+            stack.pop_back();
+            continue;
+
+          case Operation::SUBTRACTION:
+            stack[stack.size() - 2] -= stack.back();
+            stack.pop_back();
+            continue;
+
+          case Operation::MULTIPLICATION:
+            stack[stack.size() - 2] *= stack.back();
+            stack.pop_back();
+            continue;
+
+          default:
+            break;
+        }
+
         // construct parameters
-        std::vector<Value> args;
-        args.resize(function->second.arity);
+        args.resize(function.arity);
 
-        for (int i = function->second.arity-1; i >= 0; i--) {
-          args[i] = stack.top();
-          stack.pop();
+        for (int i = function.arity-1; i >= 0; i--) {
+          args[i] = std::move(stack.back());
+          stack.pop_back();
         }
 
         // call the function and store result
-        stack.push(function->second.handle(args));
+        stack.push_back(function.handle(args));
+
+        if (!status.ok())
+          return finish();
+        break;
       }
+
+      case Type::UNKNOWN_SYMBOL:
+        status = Status(ErrorCode::UNKNOWN_SYMBOL, instruction.position, program.names[instruction.index]);
+        return finish();
+
+      case Type::MISSING_ARGUMENT:
+        status = Status(ErrorCode::ARGUMENT_MISSING, instruction.position, program.names[instruction.index]);
+        return finish();
+
+      default:
+        // sums are scalar instructions only
+        break;
     }
   }
 
+  // expected a single result
+  if (stack.size() != 1)
+    status = Status(ErrorCode::EVALUATION, 0, "Only single expression is allowed");
+
+  return finish();
+}
+
+template <typename V>
+V BasicEvaluator<V>::execute_scalar(Program const& program, Status& status) {
+  typedef typename Instruction::Type Type;
+  typedef typename ScalarFunction::Operation Operation;
+
+  // scalar operations are charged all at once
+  Budget::charge(0, 0, program.instructions.size());
+
+  scalars.resize(program.max_depth + 1);
+  Number* top = scalars.data();
+
+  for (auto const& instruction : program.scalar_instructions) {
+    switch (instruction.type) {
+      case Type::PUSH:
+        *top++ = program.numbers[instruction.index];
+        continue;
+
+      // nan keeps its sign, as it does when it is subtracted
+      case Type::NEGATE:
+        if (top[-1] == top[-1])
+          top[-1] = -top[-1];
+        continue;
+
+      case Type::SUM:
+        top -= instruction.index;
+        top[0] = sum(top, instruction.index);
+        top++;
+        continue;
+
+      default:
+        break;
+    }
+
+    // additions and subtractions are lowered into sums
+    Function const& function = *program.functions[instruction.index];
+
+    switch (function.scalar.operation) {
+      case Operation::MULTIPLICATION:
+        top--;
+        top[-1] = top[-1] * top[0];
+        break;
+
+      case Operation::DIVISION:
+        top--;
+        top[-1] = quotient(top[-1], top[0]);
+        break;
+
+      default:
+        top -= function.arity;
+        *top = function.scalar.function(top);
+        top++;
+    }
+  }
 
   // expected a single result
-  if (stack.size() == 1) {
-    return stack.top();
+  if (program.depth == 1) {
+    return V(scalars[0]);
   } else {
-    throw EvaluationError("Only single expression is allowed", 0);
+    status = Status(ErrorCode::EVALUATION, 0, "Only single expression is allowed");
+    return V();
   }
 }
 
-void Evaluator::register_function(std::string const& name, unsigned long arity, std::function<Value(std::vector<Value> const&)> f) {
+template <typename V>
+void BasicEvaluator<V>::register_function(std::string const& name, unsigned long arity, std::function<V(std::vector<V> const&)> f,
+                                          ScalarFunction scalar, bool pure) {
   if (constants.find(name) != constants.end())
     throw ConflictingNameError("Cannot add function '"+name+"' as it name is already used by a constant.");
 
-  functions.emplace(name, Function(arity, f));
+  functions.erase(name);
+  functions.emplace(name, Function(arity, f, scalar, pure));
 }
 
-void Evaluator::register_constant(std::string const& name, Value value) {
+template <typename V>
+void BasicEvaluator<V>::wrap_functions(std::function<Handler(std::string const&, Handler)> const& wrap) {
+  for (auto& function : functions) {
+    function.second.handle = wrap(function.first, function.second.handle);
+    function.second.scalar = ScalarFunction();
+    function.second.pure = false;
+  }
+}
+
+template <typename V>
+void BasicEvaluator<V>::register_constant(std::string const& name, V value) {
   if (functions.find(name) != functions.end())
     throw ConflictingNameError("Cannot add constant '"+name+"' as it name is already used by a function.");
 
   constants[name] = value;
 }
 
+template class BasicEvaluator<Value>;
+template class BasicEvaluator<FloatValue>;
+template class BasicEvaluator<LongDoubleValue>;
+#ifdef XXCALC_FLOAT128
+template class BasicEvaluator<Float128Value>;
+#endif
+template class BasicEvaluator<ExactValue>;
+
 }
 }
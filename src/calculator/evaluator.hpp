@@ -4,6 +4,8 @@
 
 #include "tokenizer.hpp"
 #include "value.hpp"
+#include "exact_value.hpp"
+#include "status.hpp"
 
 #pragma once
 
@@ -22,23 +24,186 @@ namespace Calculator {
  * There is no distinction between operators and functions,
  * an operator is just a function with name matching the
  * operator.
+ *
+ * The evaluator is parameterized with a type of value it
+ * operates on, it is instantiated for Value (polynomials
+ * with double coefficients) and ExactValue (polynomials with
+ * rational coefficients). A value type must be constructible
+ * from a number token using static parse method.
+ *
+ * Tokens are first compiled into a Program - a flat list of
+ * instructions with numbers already parsed and symbols already
+ * resolved. If the program never refers to a polynomial (there
+ * is no x in it) and every function used has a scalar
+ * implementation, it is evaluated on plain coefficients instead
+ * of polynomials, which avoids allocation of every intermediate
+ * value. Otherwise a polynomial stack is used. Both ways give
+ * the same results and errors.
+ *
+ * Programs evaluated on polynomials are optimized when they are
+ * compiled (see optimize) - a call of a pure function with constant
+ * arguments is replaced with its result, and arithmetic operators
+ * with an operand which does not change the other one (such as *1,
+ * /1, ^1 or -0) are removed. Only the residual work is left to
+ * evaluation, with the same results and errors.
+ *
+ * An evaluator is not thread-safe - compiling, optimizing and
+ * evaluating reuse memory of the evaluator (a program being
+ * optimized, its graph of subexpressions, operands of lowered sums
+ * and arguments of called functions) between calls, so methods
+ * doing it are not const. Every thread needs its own evaluator, as
+ * every calculator has one.
  */
-class Evaluator {
+template <typename V>
+class BasicEvaluator {
   public:
 
+  //! Type of numbers used by scalar evaluation
+  typedef typename V::coefficient_type Number;
+
+  /**
+   * Scalar implementation of a function, used when an expression
+   * consists only of constant values. Arithmetic operators are
+   * performed inline, other functions are called through a plain
+   * function pointer with arguments in order. It must give the
+   * same result as the polynomial handler of the function given
+   * constant arguments, and it must not have side effects.
+   */
+  struct ScalarFunction {
+    //! Operations performed inline (EXPONENTIATION is called, but
+    //! known to optimization of programs)
+    enum class Operation { NONE, ADDITION, SUBTRACTION, MULTIPLICATION, DIVISION, EXPONENTIATION, CALL };
+
+    //! Kind of implementation (NONE if there is no implementation)
+    Operation operation;
+    //! Called implementation (if operation is CALL or EXPONENTIATION)
+    Number (*function)(Number const* args);
+
+    //! Creates missing implementation
+    ScalarFunction() : operation(Operation::NONE), function(nullptr) { }
+
+    //! Creates inline arithmetic operation
+    ScalarFunction(Operation operation) : operation(operation), function(nullptr) { }
+
+    //! Creates called implementation
+    ScalarFunction(Number (*function)(Number const* args)) : operation(Operation::CALL), function(function) { }
+
+    //! Creates called implementation of a known operation
+    ScalarFunction(Operation operation, Number (*function)(Number const* args)) :
+      operation(operation), function(function) { }
+  };
+
+  struct Function;
+
+  //! Polynomial implementation of a function
+  typedef std::function<V(std::vector<V> const&)> Handler;
+
+  /**
+   * Single step of a compiled program
+   */
+  struct Instruction {
+    //! Kind of instruction
+    enum class Type {
+      //! Pushes a value (index in values)
+      PUSH,
+      //! Parses a number when executed (index in names), used
+      //! when the number could not be parsed during compilation
+      PARSE,
+      //! Calls a function (index in functions)
+      CALL,
+      //! Fails with UnknownSymbolError (index in names)
+      UNKNOWN_SYMBOL,
+      //! Fails with ArgumentMissingError (index in names)
+      MISSING_ARGUMENT,
+      //! Adds values on top of the stack (index is their number),
+      //! used by scalar instructions only
+      SUM,
+      //! Negates value on top of the stack (as a subtrahend), used
+      //! by scalar instructions only
+      NEGATE
+    };
+
+    //! Kind of instruction
+    Type type;
+    //! Index of an operand (depending on type)
+    unsigned long index;
+    //! Position of the token in the input
+    unsigned long position;
+  };
+
+  /**
+   * Expression compiled from tokens in RPN form. Errors found
+   * during compilation (such as unknown symbols) are compiled into
+   * instructions failing at the same point of evaluation, so
+   * errors of functions evaluated earlier are reported first -
+   * exactly as they would be without compilation.
+   */
+  struct Program {
+    //! Instructions in order of execution
+    std::vector<Instruction> instructions;
+    //! Pushed values (numbers and constants)
+    std::vector<V> values;
+    //! Pushed values as scalars (if the program is scalar)
+    std::vector<Number> numbers;
+    //! Instructions of scalar evaluation, with chains of additions and
+    //! subtractions replaced by sums (if the program is scalar)
+    std::vector<Instruction> scalar_instructions;
+    //! Called functions
+    std::vector<Function const*> functions;
+    //! Names of symbols or numbers referenced by failing instructions
+    std::vector<std::string> names;
+    //! Indices of pushed values which are not known during compilation
+    std::vector<unsigned long> inputs;
+    //! First instruction of every value on the stack during compilation
+    std::vector<unsigned long> starts;
+    //! Number of values left on the stack after execution
+    unsigned long depth;
+    //! Largest number of values on the stack during execution
+    unsigned long max_depth;
+    //! Number of calls eliminated by optimization as repeated subexpressions
+    unsigned long eliminated;
+    //! True if the program can be evaluated on scalars
+    bool scalar;
+
+    //! Creates empty program
+    Program() : depth(0), max_depth(0), eliminated(0), scalar(true) { }
+
+    //! Removes all instructions (but keeps allocated memory)
+    void clear();
+  };
+
   /**
    * Registers new function to the evaluator. A function
    * is called when token with its identifier is found.
    * Called function is guaranteed to have exact number
-   * of arguments as arity is checked beforehand.
+   * of arguments as arity is checked beforehand. Registering
+   * already known function replaces its handler.
+   *
+   * A pure function has no side effects and no state (unlike
+   * ans), so it always returns the same result for the same
+   * arguments. Such function may be called during compilation
+   * and its calls may be removed by optimization.
    *
    * @throw ConflictingNameError When name collides with
    *        already registered constant
    * @param name Name of function (or operator)
    * @param arity Required number of arguments
    * @param f Function handler
+   * @param scalar Optional scalar implementation (see ScalarFunction)
+   * @param pure True if the function is pure
+   */
+  void register_function(std::string const& name, unsigned long arity, std::function<V(std::vector<V> const&)> f,
+                         ScalarFunction scalar = ScalarFunction(), bool pure = false);
+
+  /**
+   * Replaces handler of every registered function with a handler
+   * made from it (ie. measuring calls of the original one). Scalar
+   * implementations are removed and functions are no longer pure,
+   * so every call goes through the new handler during evaluation.
+   *
+   * @param wrap Makes new handler from name of a function and its handler
    */
-  void register_function(std::string const& name, unsigned long arity, std::function<Value(std::vector<Value> const&)> f);
+  void wrap_functions(std::function<Handler(std::string const&, Handler)> const& wrap);
 
   /**
    * Registers new constant to the evaluator. A token with
@@ -50,7 +215,7 @@ class Evaluator {
    * @param name Name of constant
    * @param value Constant value
    */
-  void register_constant(std::string const& name, Value value);
+  void register_constant(std::string const& name, V value);
 
   /**
    * Evaluates list of tokens into a polynomial value. Tokens
@@ -75,12 +240,157 @@ class Evaluator {
    * @param tokens Parsed input in RPN form
    * @return Evaluated value (as a polynomial)
    */
-  Value process(TokenList& tokens);
+  V process(TokenList& tokens);
 
   //! Process r-value reference
-  Value process(TokenList&& tokens) { return process(tokens); }
+  V process(TokenList&& tokens) { return process(tokens); }
 
-  private:
+  /**
+   * Evaluates list of tokens like process, but failures of the
+   * program and of functions (see fail) are reported by the status
+   * instead of being thrown. Errors thrown by functions are passed.
+   *
+   * @param tokens Parsed input in RPN form
+   * @param[out] status Failure of evaluation (unchanged on success)
+   * @return Evaluated value (empty on failure)
+   */
+  V process(TokenList& tokens, Status& status);
+
+  /**
+   * Compiles tokens in RPN form into a program. Numbers are
+   * parsed, constants are replaced with their values and
+   * functions are resolved. Compilation itself never fails,
+   * see Program.
+   *
+   * A compiled program refers to registered functions, so it is
+   * valid only until the functions are registered again.
+   *
+   * @param tokens Parsed input in RPN form
+   * @param[out] program Compiled program (its previous content
+   *                     is discarded)
+   */
+  void compile(TokenList const& tokens, Program& program);
+
+  /**
+   * Appends pushing of a value to the program. This and following
+   * methods are steps of compile, they can be used to compile
+   * programs from other sources than tokens (see BasicImage) -
+   * the program must be cleared first and finished at the end.
+   *
+   * @param value Pushed value
+   * @param position Position in the input
+   * @param[out] program Compiled program
+   */
+  void compile_value(V value, unsigned long position, Program& program) const;
+
+  /**
+   * Appends pushing of a value which is not known during
+   * compilation (ie. a placeholder of a column), so nothing
+   * depending on it is folded.
+   *
+   * @param value Pushed value
+   * @param position Position in the input
+   * @param[out] program Compiled program
+   */
+  void compile_input(V value, unsigned long position, Program& program) const;
+
+  /**
+   * Appends a number given by its text. It is parsed now, or when
+   * the program is executed if it cannot be parsed (see
+   * compile_number).
+   *
+   * @param text Number
+   * @param position Position in the input
+   * @param[out] program Compiled program
+   */
+  void compile_literal(std::string const& text, unsigned long position, Program& program) const;
+
+  /**
+   * Appends a number which is parsed when the program is executed
+   * (so it fails at the same point as with tokens). A number which
+   * cannot be represented fails with INVALID_NUMBER status.
+   *
+   * @param text Number which cannot be parsed
+   * @param position Position in the input
+   * @param[out] program Compiled program
+   */
+  void compile_number(std::string const& text, unsigned long position, Program& program) const;
+
+  /**
+   * Appends a constant or a call of a function (or operator).
+   * Unknown symbols and missing arguments are compiled into
+   * failing instructions, nothing should be appended after them.
+   *
+   * @param name Name of the symbol
+   * @param position Position in the input
+   * @param[out] program Compiled program
+   * @return False if the program fails at this symbol
+   */
+  bool compile_symbol(std::string const& name, unsigned long position, Program& program) const;
+
+  /**
+   * Finishes compilation of the program, checking if it can be
+   * evaluated on scalars. Programs which cannot be are optimized.
+   *
+   * @param[out] program Compiled program
+   */
+  void finish(Program& program);
+
+  /**
+   * Optimizes a finished program. Calls of pure functions (see
+   * register_function) with constant arguments are replaced with
+   * their results and calls of arithmetic operators with an operand
+   * which does not change the other one (ie. multiplication by one)
+   * are removed, so evaluation does only the residual work.
+   *
+   * Equal subexpressions (calls of the same pure function with the
+   * same arguments) are nodes of a hash-consed graph, so each of them
+   * is evaluated once and its value is reused by the others - the
+   * number of calls left out this way is counted in eliminated.
+   *
+   * Results and errors of the program are the same - a call which
+   * fails during optimization is left in the program, so it fails
+   * when the program is evaluated. Scalar programs are optimized
+   * only by this method (as their evaluation is faster than folding),
+   * it should be called if they are evaluated many times.
+   *
+   * @param[out] program Finished program
+   */
+  void optimize(Program& program);
+
+  /**
+   * Evaluates compiled program, on scalars if possible.
+   *
+   * @throw UnknownSymbolError When identifier is neither a function
+   *        or a constant
+   * @throw ArgumentMissingError When there are not enough arguments
+   *        on the stack to fullfil function arity
+   * @throw EvaluationError When multiple expression are identifier
+   *        in the input
+   * @param program Compiled program (its values are consumed)
+   * @return Evaluated value (as a polynomial)
+   */
+  V execute(Program& program);
+
+  /**
+   * Evaluates compiled program like execute, but failures are
+   * reported by the status (see process).
+   *
+   * @param program Compiled program (its values are consumed)
+   * @param[out] status Failure of evaluation (unchanged on success)
+   * @return Evaluated value (empty on failure)
+   */
+  V execute(Program& program, Status& status);
+
+  /**
+   * Reports failure of a function without throwing - a function
+   * handler calls it and returns any value, the evaluation then
+   * stops with the failure. Outside of evaluation the failure is
+   * thrown.
+   *
+   * @param status Failure of the function
+   */
+  void fail(Status const& status);
 
   /**
    * Container for function metadata
@@ -89,23 +399,183 @@ class Evaluator {
     //! Arity of function (number of arguments)
     unsigned long arity;
     //! Function handle
-    std::function<Value(std::vector<Value> const&)> handle;
+    std::function<V(std::vector<V> const&)> handle;
+    //! Scalar implementation
+    ScalarFunction scalar;
+    //! True if the function has no side effects
+    bool pure;
 
     /**
      * Creates function of given arity
      *
      * @param arity Number of arguments
      * @param handle Function handle
+     * @param scalar Scalar implementation
+     * @param pure True if the function has no side effects
      */
-    Function(unsigned long arity, std::function<Value(std::vector<Value> const&)> handle) : arity(arity), handle(handle) { }
+    Function(unsigned long arity, std::function<V(std::vector<V> const&)> handle, ScalarFunction scalar,
+             bool pure) :
+      arity(arity), handle(handle), scalar(scalar), pure(pure) { }
   };
 
+  private:
+
+  /**
+   * Hash-consed graph of subexpressions of a program. Values and
+   * calls of pure functions with the same operands are a single
+   * node, so a repeated subexpression is known when its last
+   * instruction is reached.
+   */
+  struct Graph {
+    //! Value or call of a function
+    struct Node {
+      //! Called function (null for values)
+      Function const* function;
+      //! First operand in operands (or index of a value)
+      unsigned long first;
+      //! Number of references from other nodes (and the stack)
+      unsigned long uses;
+      //! Instruction which created the node
+      unsigned long origin;
+      //! Index of value of the node in values (or size of values)
+      unsigned long shared;
+    };
+
+    //! Nodes in order of creation
+    std::vector<Node> nodes;
+    //! Operands of calls (nodes of their arguments)
+    std::vector<unsigned long> operands;
+    //! Open addressing hash table of nodes (node + 1, zero if empty)
+    std::vector<unsigned long> table;
+    //! Node of every instruction
+    std::vector<unsigned long> of;
+    //! First instruction of subexpression of every instruction
+    std::vector<unsigned long> starts;
+    //! Last instruction (plus one) of the outermost repeated
+    //! subexpression starting at every instruction (or zero)
+    std::vector<unsigned long> repeats;
+    //! Instructions of values on the stack
+    std::vector<unsigned long> stack;
+    //! Values of subexpressions used more than once
+    std::vector<V> values;
+    //! Number of remaining uses of every value
+    std::vector<unsigned long> remaining;
+
+    /**
+     * Builds graph of instructions of a program (until the first
+     * failing one).
+     *
+     * @param program Compiled program
+     */
+    void build(Program const& program);
+
+    /**
+     * Finds the outermost repeated subexpression starting at an
+     * instruction, which value is known.
+     *
+     * @param instruction First instruction
+     * @return Its last instruction plus one (or zero)
+     */
+    unsigned long reusable(unsigned long instruction) const;
+
+    //! Keeps value of a node if it is used more than once
+    void keep(unsigned long node, V const& value);
+
+    //! Gets value of a node (moved by its last use)
+    V share(unsigned long node);
+
+    private:
+
+    //! Finds equal node (or adds new one) of a value or a call with
+    //! operands at the end of operands
+    unsigned long intern(Program const& program, Function const* function, unsigned long first,
+                         unsigned long instruction, bool unique);
+  };
+
+  /**
+   * Replaces a call of a pure function with its result, if all
+   * its arguments are constants pushed by the last instructions.
+   *
+   * @param function Called function
+   * @param position Position in the input
+   * @param[out] program Compiled program
+   * @return True if the call was folded
+   */
+  bool fold(Function const& function, unsigned long position, Program& program);
+
+  /**
+   * Removes a call of an arithmetic operator with an operand which
+   * does not change the other one (ie. multiplication by one).
+   *
+   * @param function Called operator
+   * @param[out] program Compiled program
+   * @return True if the call was removed
+   */
+  bool simplify(Function const& function, Program& program) const;
+
+  //! Checks if an instruction pushes a value known during compilation
+  bool constant(Program const& program, unsigned long instruction) const;
+
+  //! Appends a call of a function
+  void compile_call(Function const& function, unsigned long position, Program& program) const;
+
+  //! Converts values of the program to numbers, if it is scalar
+  void convert(Program& program) const;
+
+  /**
+   * Lowers instructions of a scalar program into its scalar
+   * instructions. A chain of additions and subtractions (with
+   * every subtrahend negated) becomes a single sum, so its terms
+   * are added at once instead of by a call for every one of them.
+   *
+   * @param[out] program Scalar program
+   */
+  void flatten(Program& program);
+
+  //! Evaluates program on polynomial values
+  V execute_polynomial(Program& program, Status& status);
+
+  //! Evaluates scalar program
+  V execute_scalar(Program const& program, Status& status);
+
   //! Registered functions
   std::map<std::string, Function> functions;
 
   //! Registered constants
-  std::map<std::string, Value> constants;
+  std::map<std::string, V> constants;
+
+  //! Program reused between evaluations
+  Program program;
+
+  //! Program reused between optimizations
+  Program optimized;
+
+  //! Graph of subexpressions reused between optimizations
+  Graph subexpressions;
+
+  //! First instruction of every value on the stack (and whether it
+  //! is a sum), reused between lowerings
+  std::vector<std::pair<unsigned long, bool>> operands;
+
+  //! Stack of scalar evaluation reused between evaluations
+  std::vector<Number> scalars;
+
+  //! Stack of polynomial evaluation reused between evaluations
+  std::vector<V> polynomials;
+
+  //! Arguments of called functions reused between evaluations (and
+  //! by functions folded during compilation)
+  std::vector<V> arguments;
+
+  //! Status of evaluation in progress (or null), functions folded
+  //! during compilation report to their own status
+  Status* failure = nullptr;
 };
 
+/**
+ * Evaluator of polynomials with double coefficients
+ */
+typedef BasicEvaluator<Value> Evaluator;
+
 }
 }
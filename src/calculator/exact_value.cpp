@@ -0,0 +1,329 @@
+#include "exact_value.hpp"
+#include "ntt.hpp"
+#include "budget.hpp"
+#include "errors.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace XX {
+namespace Calculator {
+
+namespace {
+
+//! Smallest number of terms of both factors multiplied by transform
+const unsigned long transform_threshold = 32;
+
+//! Appends rational number in the form printed by streams
+void append(std::string& output, Rational const& r) {
+  if (r.is_nan()) {
+    output += "nan";
+  } else
+  if (r.is_infinite()) {
+    output += r.numerator().sign() < 0 ? "-inf" : "inf";
+  } else {
+    output += r.numerator().str();
+
+    if (!r.is_integer()) {
+      output += '/';
+      output += r.denominator().str();
+    }
+  }
+}
+
+}
+
+ExactValue ExactValue::parse(std::string const& text) {
+  Rational number = Rational::parse(text);
+
+  if (!number.is_finite())
+    throw std::invalid_argument("Exact numbers are finite");
+
+  return ExactValue(number);
+}
+
+Rational& ExactValue::operator[](const unsigned long index) {
+  if (index >= coefficients.size()) {
+    coefficients.resize(index+1);
+  }
+
+  return coefficients[index];
+}
+
+Rational const& ExactValue::operator[](const unsigned long index) const {
+  return coefficients[index];
+}
+
+unsigned long ExactValue::degree() const {
+  for (unsigned long i = coefficients.size(); i-- > 1; ) {
+    if (coefficients[i] != 0)
+      return i;
+  }
+
+  return 0;
+}
+
+ExactValue::operator double() const {
+  if (degree() > 0)
+    throw PolynomialCastError();
+
+  return double(coefficients[0]);
+}
+
+ExactValue::operator Rational() const {
+  if (degree() > 0)
+    throw PolynomialCastError();
+
+  return coefficients[0];
+}
+
+ExactValue::operator std::string() const {
+  return repr("x");
+}
+
+ExactValue ExactValue::operator()(ExactValue const& x) const {
+  if (x.degree() > 0)
+    throw PolynomialCastError();
+
+  Rational result;
+
+  for (long i = degree(); i >= 0; i--) {
+    result *= x.coefficients[0];
+    result += coefficients[i];
+  }
+
+  return result;
+}
+
+ExactValue& ExactValue::operator+=(ExactValue const& other) {
+  Budget::charge(0, 0, other.coefficients.size());
+
+  if (other.coefficients.size() > coefficients.size()) {
+    coefficients.resize(other.coefficients.size());
+  }
+
+  for (unsigned long i = 0; i < other.coefficients.size(); i++) {
+    coefficients[i] += other.coefficients[i];
+  }
+
+  return *this;
+}
+
+ExactValue& ExactValue::operator-=(ExactValue const& other) {
+  Budget::charge(0, 0, other.coefficients.size());
+
+  if (other.coefficients.size() > coefficients.size()) {
+    coefficients.resize(other.coefficients.size());
+  }
+
+  for (unsigned long i = 0; i < other.coefficients.size(); i++) {
+    coefficients[i] -= other.coefficients[i];
+  }
+
+  return *this;
+}
+
+ExactValue& ExactValue::operator*=(ExactValue const& other) {
+  unsigned long self_degree = degree();
+  unsigned long other_degree = other.degree();
+
+  // product is charged before it is allocated
+  Budget::charge(self_degree + other_degree, (self_degree + other_degree + 1) * sizeof(Rational),
+                 std::uint64_t(self_degree + 1) * (other_degree + 1));
+
+  if (self_degree == 0 && other_degree == 0) {
+    coefficients.resize(1);
+    coefficients[0] *= other.coefficients[0];
+    return *this;
+  }
+
+  bool finite = true;
+  for (unsigned long i = 0; i <= self_degree; i++)
+    finite = finite && coefficients[i].is_finite();
+  for (unsigned long i = 0; i <= other_degree; i++)
+    finite = finite && other.coefficients[i].is_finite();
+
+  std::vector<Rational> c(self_degree + other_degree + 1);
+
+  if (!finite || std::min(self_degree, other_degree) + 1 < transform_threshold) {
+    for (unsigned long a = 0; a <= self_degree; a++) {
+      for (unsigned long b = 0; b <= other_degree; b++) {
+        c[a+b] += coefficients[a] * other.coefficients[b];
+      }
+    }
+  } else {
+    // scale both polynomials to integer coefficients
+    auto scale = [](std::vector<Rational> const& p, unsigned long degree,
+                    std::vector<Integer>& numerators, Integer& denominator) {
+      denominator = 1;
+      for (unsigned long i = 0; i <= degree; i++) {
+        Integer const& d = p[i].denominator();
+        if (d != Integer(1) && !(denominator % d).is_zero())
+          denominator = denominator / Integer::gcd(denominator, d) * d;
+      }
+
+      numerators.resize(degree + 1);
+      for (unsigned long i = 0; i <= degree; i++) {
+        numerators[i] = p[i].numerator();
+        if (p[i].denominator() != denominator)
+          numerators[i] *= denominator / p[i].denominator();
+      }
+    };
+
+    std::vector<Integer> a, b;
+    Integer a_denominator, b_denominator;
+    scale(coefficients, self_degree, a, a_denominator);
+    scale(other.coefficients, other_degree, b, b_denominator);
+
+    std::vector<Integer> product = NTT::convolve(a, b);
+    Integer denominator = a_denominator * b_denominator;
+
+    for (unsigned long i = 0; i < product.size(); i++) {
+      c[i] = Rational(product[i], denominator);
+    }
+  }
+
+  coefficients.swap(c);
+
+  return *this;
+}
+
+ExactValue& ExactValue::operator/=(ExactValue const& other) {
+  unsigned long self_degree = degree();
+  unsigned long other_degree = other.degree();
+
+  if (self_degree < other_degree) {
+    throw PolynomialDivisionError();
+  } else
+  if (other_degree == 0) {
+    // quotient of a division by zero is not a rational number
+    if (other.coefficients[0] == 0 && self_degree > 0)
+      throw PolynomialDivisionError();
+    else
+    if (other.coefficients[0] == 0)
+      throw ValueError("Division by zero");
+
+    for (unsigned long i = 0; i <= self_degree; i++) {
+      coefficients[i] /= other.coefficients[0];
+    }
+    return *this;
+  }
+
+  Budget::charge(self_degree - other_degree, (self_degree - other_degree + 1) * sizeof(Rational),
+                 std::uint64_t(self_degree - other_degree + 1) * (other_degree + 1));
+
+  std::vector<Rational> q(self_degree - other_degree + 1);
+  Rational const& leading = other.coefficients[other_degree];
+
+  for (unsigned long d = self_degree + 1; d-- > other_degree; ) {
+    unsigned long diff = d - other_degree;
+    Rational factor = coefficients[d] / leading;
+    q[diff] = factor;
+
+    for (unsigned long i = 0; i < other_degree; i++) {
+      coefficients[i + diff] -= other.coefficients[i] * factor;
+    }
+
+    // leading term cancels exactly
+    coefficients[d] = 0;
+  }
+
+  coefficients.swap(q);
+
+  return *this;
+}
+
+bool ExactValue::operator==(ExactValue const &other) const {
+  unsigned long d = degree();
+
+  if (other.degree() == d) {
+    for (unsigned long i = 0; i <= d; i++)
+      if (other.coefficients[i] != coefficients[i])
+        return false;
+
+    return true;
+  }
+
+  return false;
+}
+
+bool ExactValue::operator!=(ExactValue const &other) const {
+  return !(*this == other);
+}
+
+const ExactValue ExactValue::operator+(ExactValue const& other) const {
+  return ExactValue(*this) += other;
+}
+
+const ExactValue ExactValue::operator-(ExactValue const& other) const {
+  return ExactValue(*this) -= other;
+}
+
+const ExactValue ExactValue::operator*(ExactValue const& other) const {
+  return ExactValue(*this) *= other;
+}
+
+const ExactValue ExactValue::operator/(ExactValue const& other) const {
+  return ExactValue(*this) /= other;
+}
+
+std::string ExactValue::repr(std::string const& name) const {
+  std::string output;
+  repr(output, name);
+  return output;
+}
+
+void ExactValue::repr(std::string& output, std::string const& name) const {
+  unsigned long d = degree();
+
+  if (d == 0) {
+    append(output, coefficients.empty() ? Rational() : coefficients[0]);
+    return;
+  }
+
+  bool need_sign = false;
+
+  for (int i = d; i >= 0; i--) {
+    Rational const& c = coefficients[i];
+
+    if (c != 0) {
+      if (c > 0 && need_sign) {
+        output += '+';
+        need_sign = false;
+      }
+
+      if (i > 0) {
+        if (c == -1) {
+          output += '-';
+        } else
+        if (!c.is_integer() && c.is_finite()) {
+          if (c < 0) {
+            output += "-(";
+            append(output, -c);
+          } else {
+            output += '(';
+            append(output, c);
+          }
+          output += ')';
+        } else
+        if (c != 1) {
+          append(output, c);
+        }
+
+        output += name;
+
+        if (i > 1) {
+          output += '^';
+          output += std::to_string(i);
+        }
+        need_sign = true;
+      } else {
+        append(output, c);
+      }
+
+    }
+  }
+}
+
+}
+}
@@ -0,0 +1,217 @@
+#include "rational.hpp"
+
+#include <vector>
+#include <string>
+
+#pragma once
+
+namespace XX {
+namespace Calculator {
+
+/**
+ * Exact value is a polynomial with rational coefficients of
+ * arbitrary precision. It can be used in place of Value when
+ * double coefficients are not precise enough (ie. (x+1)^200
+ * or products of large binomials). Decimal numbers are read
+ * exactly (0.1 is 1/10), while irrational results of functions
+ * (like log or pi) are represented exactly as their nearest
+ * double value.
+ *
+ * The interface follows the one of Value, so both types can
+ * be used by the evaluator and calculators. Large polynomials
+ * are multiplied using multi-modular number theoretic transform
+ * (see NTT), which is near linear instead of quadratic.
+ */
+class ExactValue {
+  public:
+
+  //! Type of coefficients
+  typedef Rational coefficient_type;
+
+  /**
+   * Creates value (polynomial) with a list of coefficients.
+   *
+   * @param coefficients List of coefficients
+   */
+  ExactValue(std::vector<Rational> coefficients) : coefficients(std::move(coefficients)) { }
+
+  /**
+   * Creates a linear expression of form ax+b.
+   *
+   * @param b Constant term
+   * @param a Linear coefficient
+   */
+  ExactValue(Rational const& b, Rational const& a) : ExactValue(std::vector<Rational>{b, a}) { }
+
+  /**
+   * Creates degenerative polynomial with just a constant term.
+   *
+   * @param b Constant term
+   */
+  ExactValue(Rational const& b) : ExactValue(std::vector<Rational>{b}) { }
+
+  /**
+   * Creates degenerative polynomial with the exact value of
+   * a double number.
+   *
+   * @param b Constant term
+   */
+  ExactValue(double b) : ExactValue(Rational::from_double(b)) { }
+
+  /**
+   * Creates a linear expression of form ax+b from double
+   * coefficients.
+   *
+   * @param b Constant term
+   * @param a Linear coefficient
+   */
+  ExactValue(double b, double a) : ExactValue(Rational::from_double(b), Rational::from_double(a)) { }
+
+  /**
+   * Creates zero polynomial
+   */
+  ExactValue() : ExactValue(Rational()) { }
+
+  /**
+   * Parses a number into a constant polynomial (see
+   * Rational::parse). Infinity and NaN are not exact numbers.
+   *
+   * @throw std::invalid_argument When text is not a finite number
+   * @param text Decimal number
+   * @return Constant polynomial
+   */
+  static ExactValue parse(std::string const& text);
+
+  /**
+   * Accesses coefficients of the polynomial. If a coefficient
+   * with given index is not existing it is created with a zero
+   * value.
+   *
+   * @param index Coefficient index
+   * @return Reference to coefficient
+   */
+  Rational& operator[](const unsigned long index);
+
+  /**
+   * Accesses coefficients of the polynomial.
+   *
+   * @param index Coefficient index
+   * @return Coefficient value
+   */
+  Rational const& operator[](const unsigned long index) const;
+
+  /**
+   * Computes degree of the polynomial. A degree is an index
+   * of rightmost non zero coefficient.
+   *
+   * @return Degree of polynomial
+   */
+  unsigned long degree() const;
+
+  /**
+   * Creates a human readable string representation of
+   * the polynomial, in the same form as Value::repr does.
+   * Fractional coefficients of non constant terms are
+   * enclosed in brackets (ie. (1/2)x^2+1/3).
+   *
+   * @param name Name of variable used in polynomial
+   * @return Algebraic form
+   */
+  std::string repr(std::string const& name) const;
+
+  /**
+   * Appends the algebraic form of the polynomial to the
+   * string, as Value::repr does.
+   *
+   * @param output Destination string
+   * @param name Name of variable used in polynomial
+   */
+  void repr(std::string& output, std::string const& name) const;
+
+  /**
+   * Evaluates the polynomial using x as its value,
+   * using Horner method.
+   *
+   * @param x Value of x in polynomial (must be constant)
+   * @return Evaluated polynomial
+   */
+  ExactValue operator()(ExactValue const& x) const;
+
+  /**
+   * Converts polynomial to the nearest double value.
+   *
+   * @throw PolynomialCastError When polynomial is not constant
+   * @return Value of constant term
+   */
+  explicit operator double() const;
+
+  /**
+   * Converts polynomial to its exact constant term.
+   *
+   * @throw PolynomialCastError When polynomial is not constant
+   * @return Value of constant term
+   */
+  explicit operator Rational() const;
+
+  /**
+   * Creates an algebraic form of polynomial, using
+   * x as name of the variable.
+   *
+   * @return Algebraic form
+   */
+  explicit operator std::string() const;
+
+  //! Polynomial addition
+  ExactValue& operator+=(ExactValue const& other);
+
+  //! Polynomial subtraction
+  ExactValue& operator-=(ExactValue const& other);
+
+  /**
+   * Performs polynomial multiplication. Small polynomials are
+   * multiplied using O(n*m) method, larger polynomials are
+   * scaled to integer coefficients and multiplied using number
+   * theoretic transform.
+   *
+   * @param other Polynomial to multiply
+   * @return Reference to self
+   */
+  ExactValue& operator*=(ExactValue const& other);
+
+  /**
+   * Performs polynomial long division (remainder is dropped).
+   *
+   * @throw PolynomialDivisionError When degree of
+   *        divider is large than degree of self.
+   * @throw ValueError When a number is divided by zero
+   * @param other Divider
+   * @return Reference to self
+   */
+  ExactValue& operator/=(ExactValue const& other);
+
+  const ExactValue operator+(ExactValue const& other) const;
+  const ExactValue operator-(ExactValue const& other) const;
+  const ExactValue operator*(ExactValue const& other) const;
+  const ExactValue operator/(ExactValue const& other) const;
+
+  /**
+   * Compares equality of two values. They values
+   * are considered equal when they are of the same
+   * degree and contain equal coefficients.
+   *
+   * @param other Value to compare
+   * @return True if equal
+   */
+  bool operator==(ExactValue const &other) const;
+
+  //! Inequality test
+  bool operator!=(ExactValue const &other) const;
+
+  private:
+
+  //! Polynomial coefficients
+  std::vector<Rational> coefficients;
+};
+
+}
+}
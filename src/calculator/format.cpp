@@ -0,0 +1,220 @@
+#include "format.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+namespace XX {
+namespace Calculator {
+
+namespace {
+
+//! Powers of ten fitting in 64 bits
+const std::uint64_t powers_of_ten[] = {
+  1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull, 10000000ull,
+  100000000ull, 1000000000ull, 10000000000ull, 100000000000ull, 1000000000000ull,
+  10000000000000ull, 100000000000000ull, 1000000000000000ull, 10000000000000000ull,
+  100000000000000000ull, 1000000000000000000ull, 10000000000000000000ull
+};
+
+//! Largest precision whose digits fit in 64 bits with a carry
+const int max_precision = 17;
+
+/**
+ * Computes significant digits of a positive finite number, correctly
+ * rounded to given precision. Ties are rounded to even, as printf
+ * does - the number is scaled exactly, using 128 bit integers.
+ *
+ * @param x Positive number
+ * @param precision Number of significant digits
+ * @param[out] digits Digits in range [10^(precision-1), 10^precision)
+ * @param[out] exponent Decimal exponent of the first digit
+ * @return False if the scaled number does not fit in 128 bits
+ */
+bool decimal_digits(double x, int precision, std::uint64_t& digits, int& exponent) {
+#ifdef __SIZEOF_INT128__
+  typedef unsigned __int128 uint128;
+
+  // x = mantissa * 2^binary with integer mantissa
+  int binary;
+  std::uint64_t mantissa = static_cast<std::uint64_t>(std::ldexp(std::frexp(x, &binary), 53));
+
+  // 2^(binary-1) <= x, so the estimate is at most one too small
+  exponent = static_cast<int>(std::floor((binary - 1) * 0.30102999566398120));
+  binary -= 53;
+
+  while (true) {
+    // digits are x * 10^scale rounded to integer
+    int scale = precision - 1 - exponent;
+    uint128 quotient;
+    bool up;
+
+    if (scale >= 0) {
+      // 10^22 < 2^74, so the product fits in 127 bits
+      if (scale > 22)
+        return false;
+
+      uint128 numerator = mantissa;
+      if (scale > 19)
+        numerator *= powers_of_ten[scale - 19];
+      numerator *= powers_of_ten[std::min(scale, 19)];
+
+      if (binary >= 0) {
+        if (binary > 127 || (numerator >> (127 - binary)) != 0)
+          return false;
+
+        quotient = numerator << binary;
+        up = false;
+      } else {
+        int shift = -binary;
+        if (shift >= 128)
+          return false;
+
+        quotient = numerator >> shift;
+        uint128 remainder = numerator & ((uint128(1) << shift) - 1);
+        uint128 half = uint128(1) << (shift - 1);
+        up = remainder > half || (remainder == half && (quotient & 1));
+      }
+    } else {
+      if (-scale > 19 || binary > 74)
+        return false;
+
+      uint128 numerator = mantissa, divisor = powers_of_ten[-scale];
+      if (binary >= 0)
+        numerator <<= binary;
+      else
+        divisor <<= -binary;
+
+      quotient = numerator / divisor;
+      uint128 remainder = numerator - quotient * divisor;
+      up = remainder > divisor - remainder || (remainder == divisor - remainder && (quotient & 1));
+    }
+
+    if (up)
+      quotient++;
+
+    // too many digits - either the estimate was too small or
+    // the rounding carried to the next power of ten
+    if (quotient >= powers_of_ten[precision]) {
+      exponent++;
+      continue;
+    }
+
+    digits = static_cast<std::uint64_t>(quotient);
+    return true;
+  }
+#else
+  return false;
+#endif
+}
+
+//! Writes decimal digits of an integer, returns their number
+std::size_t format_integer(char* buffer, std::uint64_t x) {
+  char reversed[20];
+  std::size_t length = 0;
+
+  do {
+    reversed[length++] = '0' + x % 10;
+    x /= 10;
+  } while (x > 0);
+
+  for (std::size_t i = 0; i < length; i++)
+    buffer[i] = reversed[length - 1 - i];
+
+  return length;
+}
+
+}
+
+std::size_t format_number(char* buffer, double x, int precision) {
+  double value = x;
+  char* p = buffer;
+
+  // precision of zero is treated as one by printf
+  if (precision == 0)
+    precision = 1;
+
+  if (std::signbit(x)) {
+    *p++ = '-';
+    x = -x;
+  }
+
+  if (std::isnan(x) || std::isinf(x)) {
+    std::memcpy(p, std::isnan(x) ? "nan" : "inf", 3);
+    return p + 3 - buffer;
+  }
+
+  if (x == 0) {
+    *p++ = '0';
+    return p - buffer;
+  }
+
+  std::uint64_t digits;
+  int exponent;
+
+  if (precision < 0 || precision > max_precision) {
+    int length = std::snprintf(buffer, max_number_length, "%.*g", precision, value);
+    return std::min<std::size_t>(length, max_number_length - 1);
+  }
+
+  // integers shorter than precision are printed as they are
+  if (x < powers_of_ten[precision] && x == std::floor(x))
+    return p + format_integer(p, static_cast<std::uint64_t>(x)) - buffer;
+
+  if (!decimal_digits(x, precision, digits, exponent))
+    return std::snprintf(buffer, max_number_length, "%.*g", precision, value);
+
+  char text[20];
+  format_integer(text, digits);
+
+  // trailing zeros are not printed
+  int length = precision;
+  while (length > 1 && text[length - 1] == '0')
+    length--;
+
+  if (exponent < -4 || exponent >= precision) {
+    *p++ = text[0];
+    if (length > 1) {
+      *p++ = '.';
+      std::memcpy(p, text + 1, length - 1);
+      p += length - 1;
+    }
+
+    *p++ = 'e';
+    *p++ = exponent < 0 ? '-' : '+';
+    if (exponent < 0)
+      exponent = -exponent;
+    if (exponent < 10)
+      *p++ = '0';
+    p += format_integer(p, exponent);
+  } else
+  if (exponent >= 0) {
+    for (int i = 0; i <= exponent; i++)
+      *p++ = i < length ? text[i] : '0';
+
+    if (length > exponent + 1) {
+      *p++ = '.';
+      std::memcpy(p, text + exponent + 1, length - exponent - 1);
+      p += length - exponent - 1;
+    }
+  } else {
+    *p++ = '0';
+    *p++ = '.';
+    for (int i = -1; i > exponent; i--)
+      *p++ = '0';
+    std::memcpy(p, text, length);
+    p += length;
+  }
+
+  return p - buffer;
+}
+
+void append_number(std::string& output, double x, int precision) {
+  char buffer[max_number_length];
+  output.append(buffer, format_number(buffer, x, precision));
+}
+
+}
+}
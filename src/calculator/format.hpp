@@ -0,0 +1,40 @@
+#include <cstddef>
+#include <string>
+
+#pragma once
+
+namespace XX {
+namespace Calculator {
+
+//! Size of a buffer large enough for any number formatted by format_number
+const std::size_t max_number_length = 48;
+
+/**
+ * Formats a number exactly as an output stream with default flags
+ * does (printf with %.*g) - the number is correctly rounded to given
+ * number of significant digits, trailing zeros are removed and the
+ * exponent notation is used only for very small or large numbers.
+ *
+ * Digits are computed with integer arithmetic, avoiding locales and
+ * stream buffers. Numbers whose digits cannot be computed this way
+ * (very small or large exponents) are formatted by snprintf.
+ *
+ * @param buffer Destination of at least max_number_length characters
+ * @param x Number to format
+ * @param precision Number of significant digits
+ * @return Number of written characters (without terminating zero)
+ */
+std::size_t format_number(char* buffer, double x, int precision = 6);
+
+/**
+ * Appends formatted number to the string.
+ *
+ * @see format_number
+ * @param output Destination string
+ * @param x Number to format
+ * @param precision Number of significant digits
+ */
+void append_number(std::string& output, double x, int precision = 6);
+
+}
+}
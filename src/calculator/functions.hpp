@@ -1,81 +1,270 @@
 #include "value.hpp"
+#include "exact_value.hpp"
 
 #pragma once
 
 namespace XX {
 namespace Calculator {
-namespace Functions {
 
 /**
- * Addition operator
- *
- * @param args Two operands
- * @return Added operands
+ * Built-in functions and operators of the calculators. They are
+ * parameterized with a type of value they operate on, Functions
+ * is a shorthand for functions operating on Value.
  */
-Value addition(std::vector<Value> const& args);
+template <typename V>
+class BasicFunctions {
+  public:
 
-/**
- * Subtraction operator
- *
- * @param args Two operands
- * @return Subtracted operands
- */
-Value subtraction(std::vector<Value> const& args);
+  /**
+   * Addition operator
+   *
+   * @param args Two operands
+   * @return Added operands
+   */
+  static V addition(std::vector<V> const& args);
 
-/**
- * Multiplication operator
- *
- * @param args Two operands
- * @return Multiplied operands
- */
-Value multiplication(std::vector<Value> const& args);
+  /**
+   * Subtraction operator
+   *
+   * @param args Two operands
+   * @return Subtracted operands
+   */
+  static V subtraction(std::vector<V> const& args);
 
-/**
- * Division operator
- *
- * @throw PolynomialDivisionError When degree of first operand
- *        is smaller than degree of second operand
- * @param args Two operands
- * @return Divided operands
- */
-Value division(std::vector<Value> const& args);
+  /**
+   * Multiplication operator
+   *
+   * @param args Two operands
+   * @return Multiplied operands
+   */
+  static V multiplication(std::vector<V> const& args);
 
-/**
- * Exponentiation operator. The exponent must be a
- * constant polynomial otherwise result will no longer
- * be a polynomial.
- *
- * Different methods of exponentiation are used, depending
- * on type of base polynomial. If base is a constant
- * polynomial a standard math function is used. If base is
- * a polynomial with degree 1 a value with appropriate
- * degree and coefficient is created. Otherwise if base
- * polynomial is complex a multiplation of base is performed
- * as many times as in the exponent.
- *
- * @throws ExponentationError When the exponent is not a
- *         constant polynomial.
- * @param args Two operands (a base and an exponent)
- * @return Result of exponentiation
- */
-Value exponentiation(std::vector<Value> const& args);
+  /**
+   * Division operator
+   *
+   * @throw PolynomialDivisionError When degree of first operand
+   *        is smaller than degree of second operand
+   * @param args Two operands
+   * @return Divided operands
+   */
+  static V division(std::vector<V> const& args);
+
+  /**
+   * Exponentiation operator. The exponent must be a
+   * constant polynomial otherwise result will no longer
+   * be a polynomial.
+   *
+   * Different methods of exponentiation are used, depending
+   * on type of base polynomial. If base is a constant
+   * polynomial a standard math function is used. If base is
+   * a polynomial with degree 1 a value with appropriate
+   * degree and coefficient is created. Otherwise if base
+   * polynomial is complex a multiplation of base is performed
+   * as many times as in the exponent.
+   *
+   * Exact values compute powers of constants exactly, powers
+   * which are not rational numbers are rejected.
+   *
+   * @throws ExponentationError When the exponent is not a
+   *         constant polynomial.
+   * @throws ValueError When an exact power is not rational
+   * @param args Two operands (a base and an exponent)
+   * @return Result of exponentiation
+   */
+  static V exponentiation(std::vector<V> const& args);
+
+  /**
+   * Computes decimal logarithm (exact values accept only
+   * rational logarithms, ie. log10(1000) = 3)
+   *
+   * @param args A single argument
+   * @return Logarithmed value
+   */
+  static V log10(std::vector<V> const&);
+
+  /**
+   * Computes logarithm of given base (exact values accept
+   * only rational logarithms, ie. log(8, 4) = 3/2)
+   *
+   * @param args Two arguments (value and base)
+   * @return Logarithmed value
+   */
+  static V log(std::vector<V> const&);
+
+  /**
+   * Computes natural exponential function (exact values
+   * accept only exp(0))
+   *
+   * @param args A single argument
+   * @return Exponentiated value
+   */
+  static V exp(std::vector<V> const&);
+
+  /**
+   * Functions operating on constant values, used by the evaluator
+   * when an expression never refers to a polynomial (see
+   * BasicEvaluator::ScalarFunction). Given constant arguments they
+   * return exactly what their polynomial counterparts return.
+   * Addition, subtraction, multiplication and division are
+   * performed inline by the evaluator.
+   */
+  class Scalar {
+    public:
+
+    //! Type of arguments
+    typedef typename V::coefficient_type T;
+
+    //! Exponentiation of constants
+    static T exponentiation(T const* args);
+
+    //! Decimal logarithm of a constant
+    static T log10(T const* args);
+
+    //! Logarithm of a constant with a constant base
+    static T log(T const* args);
+
+    //! Natural exponential function of a constant
+    static T exp(T const* args);
+
+    //! Evaluation of a constant polynomial (as bind function does)
+    static T bind(T const* args);
+  };
+
+  /**
+   * Power series arithmetic. Values are treated as power series
+   * truncated at given order - only the first order coefficients
+   * are kept, and terms of higher degree are never computed.
+   *
+   * Thanks to that division, logarithm, exponential function and
+   * fractional powers are defined for non constant values, as long
+   * as their constant term is suitable. These operations are
+   * implemented using Newton iteration, which doubles the number
+   * of correct coefficients in each step, so their complexity is
+   * the one of the truncated multiplication O(M(n)).
+   *
+   * Series are available only for values with floating point
+   * coefficients.
+   */
+  class Series {
+    public:
+
+    /**
+     * Multiplies two power series, computing only terms below
+     * given order.
+     *
+     * @param a First factor
+     * @param b Second factor
+     * @param order Number of coefficients to compute
+     * @return Truncated product
+     */
+    static V multiply(V const& a, V const& b, unsigned long order);
+
+    /**
+     * Computes multiplicative inverse of a power series, such that
+     * a * inverse(a) = 1 + O(x^order).
+     *
+     * @throw SeriesExpansionError When constant term is zero
+     * @param a Power series
+     * @param order Number of coefficients to compute
+     * @return Inverted series
+     */
+    static V inverse(V const& a, unsigned long order);
+
+    /**
+     * Computes natural logarithm of a power series.
+     *
+     * @throw SeriesExpansionError When constant term is not positive
+     * @param a Power series
+     * @param order Number of coefficients to compute
+     * @return Logarithm series
+     */
+    static V logarithm(V const& a, unsigned long order);
+
+    /**
+     * Computes natural exponential function of a power series.
+     *
+     * @param a Power series
+     * @param order Number of coefficients to compute
+     * @return Exponential series
+     */
+    static V exponential(V const& a, unsigned long order);
+
+    /**
+     * Raises a power series to a real (constant) power. Natural
+     * exponents are computed using repeated squaring, other using
+     * exponential of scaled logarithm.
+     *
+     * @throw ExponentationError When the power does not exist as
+     *        a power series (ie. x^0.5)
+     * @param a Power series
+     * @param exponent Real exponent
+     * @param order Number of coefficients to compute
+     * @return Powered series
+     */
+    static V power(V const& a, typename V::coefficient_type exponent, unsigned long order);
+
+    //! Addition operator truncated at given order
+    static V addition(std::vector<V> const& args, unsigned long order);
+
+    //! Subtraction operator truncated at given order
+    static V subtraction(std::vector<V> const& args, unsigned long order);
+
+    //! Multiplication operator truncated at given order
+    static V multiplication(std::vector<V> const& args, unsigned long order);
+
+    /**
+     * Division operator. A divisor with empty constant term is
+     * accepted as long as the result is still a power series
+     * (common powers of x are cancelled).
+     *
+     * @throw PolynomialDivisionError When result would contain
+     *        negative powers of x
+     * @param args Two operands
+     * @param order Number of coefficients to compute
+     * @return Divided operands
+     */
+    static V division(std::vector<V> const& args, unsigned long order);
+
+    /**
+     * Exponentiation operator. The exponent must be a constant,
+     * but it may be any real number if the base has positive
+     * constant term.
+     *
+     * @throw ExponentationError When the exponent is not constant
+     *        or the power is not a power series
+     * @param args Two operands (a base and an exponent)
+     * @param order Number of coefficients to compute
+     * @return Result of exponentiation
+     */
+    static V exponentiation(std::vector<V> const& args, unsigned long order);
+
+    //! Decimal logarithm of a power series
+    static V log10(std::vector<V> const& args, unsigned long order);
+
+    //! Logarithm of a power series with a constant base
+    static V log(std::vector<V> const& args, unsigned long order);
+
+    //! Exponential function of a power series
+    static V exp(std::vector<V> const& args, unsigned long order);
+  };
+};
 
 /**
- * Computes decimal logarithm
- *
- * @param args A single argument
- * @return Logarithmed value
+ * Exponentiation of exact values. A constant base is raised
+ * exactly to integer exponents, other exponents are computed
+ * using double precision.
  */
-Value log10(std::vector<Value> const&);
+template <>
+ExactValue BasicFunctions<ExactValue>::exponentiation(std::vector<ExactValue> const& args);
+
+//! Exponentiation of exact constants (as exponentiation does)
+template <>
+Rational BasicFunctions<ExactValue>::Scalar::exponentiation(Rational const* args);
 
 /**
- * Computes logarithm of given base
- *
- * @param args Two arguments (value and base)
- * @return Logarithmed value
+ * Functions operating on polynomials with double coefficients
  */
-Value log(std::vector<Value> const&);
+typedef BasicFunctions<Value> Functions;
 
 }
 }
-}
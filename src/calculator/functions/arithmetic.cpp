@@ -2,24 +2,53 @@
 
 namespace XX {
 namespace Calculator {
-namespace Functions {
 
-Value addition(std::vector<Value> const& args) {
+template <typename V>
+V BasicFunctions<V>::addition(std::vector<V> const& args) {
   return args[0] + args[1];
 }
 
-Value subtraction(std::vector<Value> const& args) {
+template <typename V>
+V BasicFunctions<V>::subtraction(std::vector<V> const& args) {
   return args[0] - args[1];
 }
 
-Value multiplication(std::vector<Value> const& args) {
+template <typename V>
+V BasicFunctions<V>::multiplication(std::vector<V> const& args) {
   return args[0] * args[1];
 }
 
-Value division(std::vector<Value> const& args) {
+template <typename V>
+V BasicFunctions<V>::division(std::vector<V> const& args) {
   return args[0] / args[1];
 }
 
-}
+template Value BasicFunctions<Value>::addition(std::vector<Value> const&);
+template Value BasicFunctions<Value>::subtraction(std::vector<Value> const&);
+template Value BasicFunctions<Value>::multiplication(std::vector<Value> const&);
+template Value BasicFunctions<Value>::division(std::vector<Value> const&);
+
+template FloatValue BasicFunctions<FloatValue>::addition(std::vector<FloatValue> const&);
+template FloatValue BasicFunctions<FloatValue>::subtraction(std::vector<FloatValue> const&);
+template FloatValue BasicFunctions<FloatValue>::multiplication(std::vector<FloatValue> const&);
+template FloatValue BasicFunctions<FloatValue>::division(std::vector<FloatValue> const&);
+
+template LongDoubleValue BasicFunctions<LongDoubleValue>::addition(std::vector<LongDoubleValue> const&);
+template LongDoubleValue BasicFunctions<LongDoubleValue>::subtraction(std::vector<LongDoubleValue> const&);
+template LongDoubleValue BasicFunctions<LongDoubleValue>::multiplication(std::vector<LongDoubleValue> const&);
+template LongDoubleValue BasicFunctions<LongDoubleValue>::division(std::vector<LongDoubleValue> const&);
+
+#ifdef XXCALC_FLOAT128
+template Float128Value BasicFunctions<Float128Value>::addition(std::vector<Float128Value> const&);
+template Float128Value BasicFunctions<Float128Value>::subtraction(std::vector<Float128Value> const&);
+template Float128Value BasicFunctions<Float128Value>::multiplication(std::vector<Float128Value> const&);
+template Float128Value BasicFunctions<Float128Value>::division(std::vector<Float128Value> const&);
+#endif
+
+template ExactValue BasicFunctions<ExactValue>::addition(std::vector<ExactValue> const&);
+template ExactValue BasicFunctions<ExactValue>::subtraction(std::vector<ExactValue> const&);
+template ExactValue BasicFunctions<ExactValue>::multiplication(std::vector<ExactValue> const&);
+template ExactValue BasicFunctions<ExactValue>::division(std::vector<ExactValue> const&);
+
 }
 }
@@ -1,31 +1,96 @@
 #include "../functions.hpp"
+#include "../budget.hpp"
 #include "../errors.hpp"
 
+#include <algorithm>
 #include <cmath>
+#include <limits>
 
 #include <iostream>
 
 namespace XX {
 namespace Calculator {
-namespace Functions {
-Value exponentiation(std::vector<Value> const& args) {
+
+namespace {
+
+//! Charges degree of a power before it is computed (see Budget)
+void charge_power(unsigned long base_degree, double exponent) {
+  double degree = base_degree * exponent;
+  unsigned long largest = std::numeric_limits<unsigned long>::max();
+
+  Budget::charge(degree < largest ? static_cast<unsigned long>(degree) : largest, 0, 0);
+}
+
+//! Largest size of an exactly computed power in bits
+const unsigned long max_power_bits = 1ul << 32;
+
+/**
+ * Computes power of a number exactly. A fractional exponent p/q
+ * is the q-th root raised to p, so the power is computed only if
+ * the root is rational. Powers which are irrational, infinite or
+ * too large are rejected instead of being rounded.
+ *
+ * @throw ValueError When the power cannot be computed exactly
+ */
+Rational exact_power(Rational const& base, Rational const& exponent) {
+  Integer const& p = exponent.numerator();
+  Integer const& q = exponent.denominator();
+
+  if (!base.is_finite() || !exponent.is_finite())
+    throw ValueError("Power of a non finite number is not exact");
+
+  if (base.numerator().is_zero()) {
+    if (p.sign() < 0)
+      throw ValueError("Division by zero");
+    return p.is_zero() ? Rational(1) : Rational(0);
+  }
+
+  Rational root;
+  if (q.bits() >= 53 || !base.root(static_cast<unsigned long>(double(q)), root))
+    throw ValueError("Power is not a rational number");
+
+  // only sign of powers of one depends on large exponents
+  if (root == Rational(1) || root == Rational(-1))
+    return root < Rational(0) && p.modulo(2) == 1 ? Rational(-1) : Rational(1);
+
+  unsigned long bits = std::max(root.numerator().bits(), root.denominator().bits());
+  if (p.bits() >= 53 || double(p.abs()) * bits > max_power_bits)
+    throw ValueError("Power is too large to be computed exactly");
+
+  Budget::charge(0, static_cast<std::uint64_t>(double(p.abs()) * bits / 8), 0);
+
+  return root.power(static_cast<long long>(double(p)));
+}
+
+}
+
+template <typename V>
+V BasicFunctions<V>::exponentiation(std::vector<V> const& args) {
+  typedef typename V::coefficient_type T;
+
   unsigned long base_degree = args[0].degree();
   unsigned long exponent_degree = args[1].degree();
-  double e;
+  T e;
 
   if (exponent_degree > 0) {
     throw ExponentationError("Unable to perform complex exponentation - only constant polynomials supported");
   } else
   if (base_degree == 0) {
-    return Value(pow(args[0][0], args[1][0]));
+    return V(Math<T>::pow(args[0][0], args[1][0]));
   } else
-  if (args[1][0] >= 0 && std::modf(args[1][0], &e) == 0) {
+  if (args[1][0] >= 0 && Math<T>::modf(args[1][0], &e) == 0) {
+    // infinity is integral as well, so it is rejected before any cast
+    if (!(args[1][0] < static_cast<T>(std::numeric_limits<unsigned long>::max())))
+      throw ExponentationError("Exponent is too large");
+
+    charge_power(base_degree, double(args[1][0]));
+
     if (base_degree == 1 && args[0][0] == 0) {
-      Value v;
-      v[args[1][0]] = pow(args[0][1], args[1][0]);
-      return v;
+      std::vector<T> c(static_cast<unsigned long>(args[1][0]) + 1, T(0));
+      c.back() = Math<T>::pow(args[0][1], args[1][0]);
+      return V(c);
     } else {
-      Value v = args[0];
+      V v = args[0];
       unsigned long exponent = args[1][0];
       for (unsigned long i = 1; i < exponent; i++) {
         v *= args[0];
@@ -37,6 +102,46 @@ Value exponentiation(std::vector<Value> const& args) {
   }
 }
 
+template <>
+ExactValue BasicFunctions<ExactValue>::exponentiation(std::vector<ExactValue> const& args) {
+  unsigned long base_degree = args[0].degree();
+  unsigned long exponent_degree = args[1].degree();
+  Rational const& exponent = args[1][0];
+
+  // exponents which fit in a machine word are computed exactly
+  bool integer = exponent.is_integer() && exponent.numerator().bits() < 53;
+
+  if (exponent_degree > 0) {
+    throw ExponentationError("Unable to perform complex exponentation - only constant polynomials supported");
+  } else
+  if (base_degree == 0) {
+    return exact_power(args[0][0], exponent);
+  } else
+  if (integer && exponent >= 0) {
+    charge_power(base_degree, double(exponent));
+
+    // repeated squaring, so large products use transforms
+    ExactValue result(1), base = args[0];
+
+    for (unsigned long e = double(exponent); e > 0; e >>= 1) {
+      if (e & 1)
+        result *= base;
+      if (e > 1)
+        base *= base;
+    }
+
+    return result;
+  } else {
+    throw ExponentationError("Exponent must be a natural number");
+  }
 }
+
+template Value BasicFunctions<Value>::exponentiation(std::vector<Value> const&);
+template FloatValue BasicFunctions<FloatValue>::exponentiation(std::vector<FloatValue> const&);
+template LongDoubleValue BasicFunctions<LongDoubleValue>::exponentiation(std::vector<LongDoubleValue> const&);
+#ifdef XXCALC_FLOAT128
+template Float128Value BasicFunctions<Float128Value>::exponentiation(std::vector<Float128Value> const&);
+#endif
+
 }
 }
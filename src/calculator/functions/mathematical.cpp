@@ -1,19 +1,121 @@
 #include "../functions.hpp"
+#include "../errors.hpp"
 
+#include <algorithm>
 #include <cmath>
 
 namespace XX {
 namespace Calculator {
-namespace Functions {
 
-Value log10(std::vector<Value> const& args) {
-  return std::log10(double(args[0]));
+namespace {
+
+//! Largest denominator of a recognized rational logarithm
+const unsigned long max_log_denominator = 64;
+
+//! Largest size of powers compared by logarithms in bits
+const unsigned long max_log_bits = 1ul << 20;
+
+//! Natural logarithm of a positive integer of any size
+double natural_log(Integer const& value) {
+  unsigned long bits = value.bits();
+  unsigned long shift = bits > 64 ? bits - 64 : 0;
+
+  return std::log(double(value >> shift)) + shift * std::log(2.0);
+}
+
+/**
+ * Computes logarithm exactly. Logarithm of a to base b is
+ * a rational p/q only if b^p = a^q, so fractions close to the
+ * logarithm computed in double are verified with exact powers.
+ *
+ * @throw ValueError When the logarithm is not a rational number
+ */
+Rational exact_log(Rational const& value, Rational const& base) {
+  Rational zero(0), one(1);
+
+  if (!(value > zero) || !(base > zero) || base == one || !value.is_finite() || !base.is_finite())
+    throw ValueError("Logarithm is not a rational number");
+
+  if (value == one)
+    return zero;
+
+  double estimate = (natural_log(value.numerator().abs()) - natural_log(value.denominator())) /
+                    (natural_log(base.numerator().abs()) - natural_log(base.denominator()));
+  unsigned long value_bits = std::max(value.numerator().bits(), value.denominator().bits());
+  unsigned long base_bits = std::max(base.numerator().bits(), base.denominator().bits());
+
+  for (unsigned long q = 1; q <= max_log_denominator; q++) {
+    double p = std::round(estimate * q);
+
+    if (std::fabs(estimate * q - p) > 1e-6 || p == 0)
+      continue;
+    if (value_bits * q > max_log_bits || base_bits * std::fabs(p) > max_log_bits)
+      break;
+
+    if (base.power(static_cast<long long>(p)) == value.power(static_cast<long long>(q)))
+      return Rational(Integer(static_cast<long long>(p)), Integer(static_cast<long long>(q)));
+  }
+
+  throw ValueError("Logarithm is not a rational number");
+}
+
 }
 
-Value log(std::vector<Value> const& args) {
-  return std::log(double(args[0])) / std::log(double(args[1]));
+template <typename V>
+V BasicFunctions<V>::log10(std::vector<V> const& args) {
+  typedef typename V::coefficient_type T;
+  return V(Math<T>::log10(T(args[0])));
 }
 
+template <typename V>
+V BasicFunctions<V>::log(std::vector<V> const& args) {
+  typedef typename V::coefficient_type T;
+  return V(Math<T>::log(T(args[0])) / Math<T>::log(T(args[1])));
 }
+
+template <typename V>
+V BasicFunctions<V>::exp(std::vector<V> const& args) {
+  typedef typename V::coefficient_type T;
+  return V(Math<T>::exp(T(args[0])));
+}
+
+template <>
+ExactValue BasicFunctions<ExactValue>::log10(std::vector<ExactValue> const& args) {
+  return exact_log(Rational(args[0]), Rational(10));
+}
+
+template <>
+ExactValue BasicFunctions<ExactValue>::log(std::vector<ExactValue> const& args) {
+  return exact_log(Rational(args[0]), Rational(args[1]));
+}
+
+template <>
+ExactValue BasicFunctions<ExactValue>::exp(std::vector<ExactValue> const& args) {
+  // e^x is irrational for every rational x but zero
+  if (Rational(args[0]) != Rational(0))
+    throw ValueError("Exponential function is not a rational number");
+
+  return ExactValue(Rational(1));
+}
+
+template Value BasicFunctions<Value>::log10(std::vector<Value> const&);
+template Value BasicFunctions<Value>::log(std::vector<Value> const&);
+template Value BasicFunctions<Value>::exp(std::vector<Value> const&);
+
+template FloatValue BasicFunctions<FloatValue>::log10(std::vector<FloatValue> const&);
+template FloatValue BasicFunctions<FloatValue>::log(std::vector<FloatValue> const&);
+template FloatValue BasicFunctions<FloatValue>::exp(std::vector<FloatValue> const&);
+
+template LongDoubleValue BasicFunctions<LongDoubleValue>::log10(std::vector<LongDoubleValue> const&);
+template LongDoubleValue BasicFunctions<LongDoubleValue>::log(std::vector<LongDoubleValue> const&);
+template LongDoubleValue BasicFunctions<LongDoubleValue>::exp(std::vector<LongDoubleValue> const&);
+
+#ifdef XXCALC_FLOAT128
+template Float128Value BasicFunctions<Float128Value>::log10(std::vector<Float128Value> const&);
+template Float128Value BasicFunctions<Float128Value>::log(std::vector<Float128Value> const&);
+template Float128Value BasicFunctions<Float128Value>::exp(std::vector<Float128Value> const&);
+#endif
+
+
 }
 }
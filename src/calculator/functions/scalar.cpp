@@ -0,0 +1,62 @@
+#include "../functions.hpp"
+
+namespace XX {
+namespace Calculator {
+
+template <typename V>
+typename V::coefficient_type BasicFunctions<V>::Scalar::exponentiation(T const* args) {
+  return Math<T>::pow(args[0], args[1]);
+}
+
+template <>
+Rational BasicFunctions<ExactValue>::Scalar::exponentiation(Rational const* args) {
+  return Rational(BasicFunctions<ExactValue>::exponentiation({args[0], args[1]}));
+}
+
+template <typename V>
+typename V::coefficient_type BasicFunctions<V>::Scalar::log10(T const* args) {
+  return Math<T>::log10(args[0]);
+}
+
+template <typename V>
+typename V::coefficient_type BasicFunctions<V>::Scalar::log(T const* args) {
+  return Math<T>::log(args[0]) / Math<T>::log(args[1]);
+}
+
+template <typename V>
+typename V::coefficient_type BasicFunctions<V>::Scalar::exp(T const* args) {
+  return Math<T>::exp(args[0]);
+}
+
+template <>
+Rational BasicFunctions<ExactValue>::Scalar::log10(Rational const* args) {
+  return Rational(BasicFunctions<ExactValue>::log10({args[0]}));
+}
+
+template <>
+Rational BasicFunctions<ExactValue>::Scalar::log(Rational const* args) {
+  return Rational(BasicFunctions<ExactValue>::log({args[0], args[1]}));
+}
+
+template <>
+Rational BasicFunctions<ExactValue>::Scalar::exp(Rational const* args) {
+  return Rational(BasicFunctions<ExactValue>::exp({args[0]}));
+}
+
+template <typename V>
+typename V::coefficient_type BasicFunctions<V>::Scalar::bind(T const* args) {
+  // evaluated by the polynomial itself, as inlined Horner method
+  // could be contracted differently (ie. nan sign of 0*inf+nan)
+  return T(V(args[0])(V(args[1])));
+}
+
+template class BasicFunctions<Value>::Scalar;
+template class BasicFunctions<FloatValue>::Scalar;
+template class BasicFunctions<LongDoubleValue>::Scalar;
+#ifdef XXCALC_FLOAT128
+template class BasicFunctions<Float128Value>::Scalar;
+#endif
+template class BasicFunctions<ExactValue>::Scalar;
+
+}
+}
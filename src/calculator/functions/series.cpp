@@ -0,0 +1,331 @@
+#include "../functions.hpp"
+#include "../budget.hpp"
+#include "../errors.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace XX {
+namespace Calculator {
+namespace {
+
+/**
+ * Finds index of the first non zero coefficient (a power
+ * of x which can be factored out of the series).
+ */
+template <typename V>
+unsigned long valuation(V const& a) {
+  unsigned long d = a.degree();
+
+  for (unsigned long i = 0; i < d; i++) {
+    if (a[i] != 0)
+      return i;
+  }
+
+  return d;
+}
+
+/**
+ * Divides the series by x^k (removes first k coefficients).
+ */
+template <typename V>
+V shift_down(V const& a, unsigned long k) {
+  unsigned long d = a.degree();
+  V result;
+
+  for (unsigned long i = k; i <= d; i++) {
+    result[i - k] = a[i];
+  }
+
+  return result;
+}
+
+/**
+ * Multiplies the series by x^k, keeping only terms below order.
+ */
+template <typename V>
+V shift_up(V const& a, unsigned long k, unsigned long order) {
+  V result;
+  result.truncate(order);
+
+  for (unsigned long i = 0; i + k < order && i <= a.degree(); i++) {
+    result[i + k] = a[i];
+  }
+
+  return result;
+}
+
+/**
+ * Formal derivative of the series.
+ */
+template <typename V>
+V derivative(V const& a, unsigned long order) {
+  V result;
+  result.truncate(order);
+
+  for (unsigned long i = 1; i < order && i <= a.degree(); i++) {
+    result[i - 1] = a[i] * i;
+  }
+
+  return result;
+}
+
+/**
+ * Formal integral of the series with empty constant term.
+ */
+template <typename V>
+V integral(V const& a, unsigned long order) {
+  V result;
+  result.truncate(order);
+
+  for (unsigned long i = 1; i < order && i - 1 <= a.degree(); i++) {
+    result[i] = a[i - 1] / i;
+  }
+
+  return result;
+}
+
+/**
+ * Copy of the series truncated to given order.
+ */
+template <typename V>
+V truncated(V a, unsigned long order) {
+  return a.truncate(order);
+}
+
+}
+
+template <typename V>
+V BasicFunctions<V>::Series::multiply(V const& a, V const& b, unsigned long order) {
+  typedef typename V::coefficient_type T;
+
+  unsigned long a_degree = std::min(a.degree(), order - 1);
+  unsigned long b_degree = std::min(b.degree(), order - 1);
+
+  // product is charged before it is allocated, as in polynomial
+  // multiplication (so are steps of inverse, logarithm and exponential)
+  Budget::charge(std::min(a_degree + b_degree, order - 1), order * sizeof(T),
+                 std::uint64_t(a_degree + 1) * (b_degree + 1));
+
+  V result;
+  result.truncate(order);
+
+  for (unsigned long i = 0; i <= a_degree; i++) {
+    if (a[i] == 0)
+      continue;
+
+    for (unsigned long j = 0; j <= b_degree && i + j < order; j++) {
+      result[i + j] += a[i] * b[j];
+    }
+  }
+
+  return result;
+}
+
+template <typename V>
+V BasicFunctions<V>::Series::inverse(V const& a, unsigned long order) {
+  if (a[0] == 0)
+    throw SeriesExpansionError("Cannot invert a series with empty constant term");
+
+  V g(1 / a[0]);
+
+  // g' = g * (2 - a * g), each step doubles precision
+  for (unsigned long m = 1; m < order; ) {
+    m = std::min(2 * m, order);
+
+    V e = multiply(a, g, m);
+    for (unsigned long i = 0; i < m; i++) {
+      e[i] = -e[i];
+    }
+    e[0] += 2;
+
+    g = multiply(g, e, m);
+  }
+
+  return g.truncate(order);
+}
+
+template <typename V>
+V BasicFunctions<V>::Series::logarithm(V const& a, unsigned long order) {
+  typedef typename V::coefficient_type T;
+
+  if (!(a[0] > 0))
+    throw SeriesExpansionError("Logarithm requires a positive constant term");
+
+  if (a.degree() == 0)
+    return V(Math<T>::log(a[0])).truncate(order);
+
+  // log(a) = log(a0) + integral(a' / a)
+  V result = integral(multiply(derivative(a, order), inverse(a, order), order), order);
+  result[0] = Math<T>::log(a[0]);
+
+  return result;
+}
+
+template <typename V>
+V BasicFunctions<V>::Series::exponential(V const& a, unsigned long order) {
+  typedef typename V::coefficient_type T;
+
+  T scale = Math<T>::exp(a[0]);
+
+  if (a.degree() == 0)
+    return V(scale).truncate(order);
+
+  V h = truncated(a, order);
+  h[0] = 0;
+
+  V g(1);
+
+  // g' = g * (1 + h - log(g)), each step doubles precision
+  for (unsigned long m = 1; m < order; ) {
+    m = std::min(2 * m, order);
+
+    V e = truncated(h, m) - logarithm(g, m);
+    e[0] += 1;
+
+    g = multiply(g, e, m);
+  }
+
+  for (unsigned long i = 0; i < order; i++) {
+    g[i] *= scale;
+  }
+
+  return g;
+}
+
+template <typename V>
+V BasicFunctions<V>::Series::power(V const& a, typename V::coefficient_type exponent, unsigned long order) {
+  typedef typename V::coefficient_type T;
+
+  T integer_part;
+  bool natural = exponent >= 0 && Math<T>::modf(exponent, &integer_part) == 0;
+
+  if (a.degree() == 0)
+    return V(Math<T>::pow(a[0], exponent)).truncate(order);
+
+  // natural powers are computed exactly by repeated squaring
+  if (natural) {
+    if (!(exponent < static_cast<T>(std::numeric_limits<unsigned long>::max())))
+      throw ExponentationError("Exponent is too large");
+
+    V result(1), base = truncated(a, order);
+
+    for (unsigned long e = exponent; e > 0; e >>= 1) {
+      if (e & 1)
+        result = multiply(result, base, order);
+      if (e > 1)
+        base = multiply(base, base, order);
+    }
+
+    return result.truncate(order);
+  }
+
+  // factor out x^k, it must be raised to a natural power
+  unsigned long k = valuation(a);
+  if (k > 0) {
+    if (k * exponent < 0 || Math<T>::modf(k * exponent, &integer_part) != 0)
+      throw ExponentationError("Power of the series would contain fractional or negative powers of x");
+
+    unsigned long shift = integer_part;
+    if (shift >= order)
+      return V().truncate(order);
+
+    return shift_up(power(shift_down(a, k), exponent, order - shift), shift, order);
+  }
+
+  if (a[0] < 0)
+    throw ExponentationError("Fractional power requires a positive constant term");
+
+  V l = logarithm(a, order);
+  for (unsigned long i = 0; i < order; i++) {
+    l[i] *= exponent;
+  }
+
+  return exponential(l, order);
+}
+
+template <typename V>
+V BasicFunctions<V>::Series::addition(std::vector<V> const& args, unsigned long order) {
+  return truncated(args[0] + args[1], order);
+}
+
+template <typename V>
+V BasicFunctions<V>::Series::subtraction(std::vector<V> const& args, unsigned long order) {
+  return truncated(args[0] - args[1], order);
+}
+
+template <typename V>
+V BasicFunctions<V>::Series::multiplication(std::vector<V> const& args, unsigned long order) {
+  return multiply(args[0], args[1], order);
+}
+
+template <typename V>
+V BasicFunctions<V>::Series::division(std::vector<V> const& args, unsigned long order) {
+  // constant divisors behave as in polynomial arithmetic
+  if (args[1].degree() == 0)
+    return truncated(args[0] / args[1], order);
+
+  // cancel common powers of x, the rest of the divisor must have
+  // a constant term
+  unsigned long k = valuation(args[1]);
+  if (k > 0) {
+    if ((args[0].degree() > 0 && valuation(args[0]) < k) || (args[0].degree() == 0 && args[0][0] != 0))
+      throw SeriesExpansionError("Divisor has no constant term, the quotient is not a power series");
+
+    return multiply(shift_down(args[0], k), inverse(shift_down(args[1], k), order), order);
+  }
+
+  return multiply(args[0], inverse(args[1], order), order);
+}
+
+template <typename V>
+V BasicFunctions<V>::Series::exponentiation(std::vector<V> const& args, unsigned long order) {
+  if (args[1].degree() > 0)
+    throw ExponentationError("Unable to perform complex exponentation - only constant polynomials supported");
+
+  return power(args[0], args[1][0], order);
+}
+
+template <typename V>
+V BasicFunctions<V>::Series::log10(std::vector<V> const& args, unsigned long order) {
+  V result = logarithm(args[0], order);
+  typedef typename V::coefficient_type T;
+
+  T scale = Math<T>::log(10);
+
+  for (unsigned long i = 0; i < order; i++) {
+    result[i] /= scale;
+  }
+
+  return result;
+}
+
+template <typename V>
+V BasicFunctions<V>::Series::log(std::vector<V> const& args, unsigned long order) {
+  V result = logarithm(args[0], order);
+  typedef typename V::coefficient_type T;
+
+  T scale = Math<T>::log(T(args[1]));
+
+  for (unsigned long i = 0; i < order; i++) {
+    result[i] /= scale;
+  }
+
+  return result;
+}
+
+template <typename V>
+V BasicFunctions<V>::Series::exp(std::vector<V> const& args, unsigned long order) {
+  return exponential(args[0], order);
+}
+
+template class BasicFunctions<Value>::Series;
+template class BasicFunctions<FloatValue>::Series;
+template class BasicFunctions<LongDoubleValue>::Series;
+#ifdef XXCALC_FLOAT128
+template class BasicFunctions<Float128Value>::Series;
+#endif
+
+}
+}
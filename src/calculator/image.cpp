@@ -0,0 +1,283 @@
+#include "image.hpp"
+
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace XX {
+namespace Calculator {
+
+namespace {
+
+//! Magic bytes of images
+const char magic[4] = {'X', 'X', 'C', 'P'};
+
+//! Size of the header
+const std::size_t header_size = 64;
+
+//! Integers of an expression, a step, a value and a string
+const std::size_t expression_size = 4;
+const std::size_t step_size = 3;
+const std::size_t value_size = 2;
+const std::size_t string_size = 2;
+
+//! Marks expression which parsed successfully
+const std::uint32_t no_error = ~std::uint32_t(0);
+
+//! Rounds size up to alignment of sections
+std::uint64_t align(std::uint64_t size) {
+  return (size + 15) & ~std::uint64_t(15);
+}
+
+//! Appends raw bytes of integers
+template <typename I>
+void append(std::string& output, std::vector<I> const& integers) {
+  output.append(reinterpret_cast<char const*>(integers.data()), integers.size() * sizeof(I));
+}
+
+//! Pads output to alignment of sections
+void pad(std::string& output) {
+  output.append(align(output.size()) - output.size(), '\0');
+}
+
+//! Number of binary digits of coefficients, identifies their type
+template <typename T>
+unsigned char digits() {
+  return std::numeric_limits<T>::digits;
+}
+
+#ifdef XXCALC_FLOAT128
+template <>
+unsigned char digits<__float128>() {
+  return 113;
+}
+#endif
+
+}
+
+template <typename V>
+void BasicImage<V>::Builder::add(TokenList const& tokens) {
+  std::uint32_t first = steps.size() / step_size;
+
+  for (auto const& token : tokens) {
+    std::uint32_t position = static_cast<std::uint32_t>(token.position);
+
+    if (token.type == TokenType::NUMBER) {
+      try {
+        V value = V::parse(token.value);
+        unsigned long count = value.degree() + 1;
+
+        values.push_back(coefficients.size());
+        values.push_back(count);
+        for (unsigned long i = 0; i < count; i++)
+          coefficients.push_back(value[i]);
+
+        steps.insert(steps.end(), {VALUE, std::uint32_t(values.size() / value_size - 1), position});
+      }
+      catch (std::logic_error&) {
+        steps.insert(steps.end(), {NUMBER, add_string(token.value), position});
+      }
+    } else
+    if (token.type == TokenType::OPERATOR ||
+        token.type == TokenType::IDENTIFIER) {
+      steps.insert(steps.end(), {SYMBOL, add_string(token.value), position});
+    }
+  }
+
+  std::uint32_t count = steps.size() / step_size - first;
+  expressions.insert(expressions.end(), {first, count, no_error, 0});
+}
+
+template <typename V>
+void BasicImage<V>::Builder::add_error(std::string const& message) {
+  expressions.insert(expressions.end(), {0, 0, add_string(message), 0});
+}
+
+template <typename V>
+std::uint32_t BasicImage<V>::Builder::add_string(std::string const& string) {
+  // symbols are repeated in many expressions
+  auto found = indices.find(string);
+  if (found != indices.end())
+    return found->second;
+
+  strings.push_back(text.size());
+  strings.push_back(string.size());
+  text += string;
+
+  std::uint32_t index = strings.size() / string_size - 1;
+  indices.emplace(string, index);
+  return index;
+}
+
+template <typename V>
+void BasicImage<V>::Builder::write(std::string& output) const {
+  std::uint16_t version = BasicImage::version;
+  std::uint8_t type[2] = {sizeof(T), digits<T>()};
+  std::uint32_t counts[4] = {std::uint32_t(expressions.size() / expression_size),
+                             std::uint32_t(steps.size() / step_size),
+                             std::uint32_t(values.size() / value_size),
+                             std::uint32_t(strings.size() / string_size)};
+  std::uint64_t sizes[2] = {coefficients.size(), text.size()};
+
+  output.append(magic, sizeof(magic));
+  output.append(reinterpret_cast<char const*>(&version), sizeof(version));
+  output.append(reinterpret_cast<char const*>(type), sizeof(type));
+  output.append(reinterpret_cast<char const*>(counts), sizeof(counts));
+  output.append(reinterpret_cast<char const*>(sizes), sizeof(sizes));
+  output.append(header_size - 40, '\0');
+
+  append(output, expressions);
+  pad(output);
+  append(output, steps);
+  pad(output);
+  append(output, values);
+  pad(output);
+
+  // x87 extended precision has 80 bits of data, padding is zeroed
+  const std::size_t used = std::numeric_limits<T>::digits == 64 ? 10 : sizeof(T);
+  for (T const& c : coefficients) {
+    char bytes[sizeof(T)] = {};
+    std::memcpy(bytes, &c, used);
+    output.append(bytes, sizeof(T));
+  }
+  pad(output);
+
+  append(output, strings);
+  pad(output);
+  output += text;
+}
+
+template <typename V>
+bool BasicImage<V>::is_image(char const* begin, char const* end) {
+  return end - begin >= static_cast<std::ptrdiff_t>(header_size) &&
+         std::memcmp(begin, magic, sizeof(magic)) == 0;
+}
+
+template <typename V>
+BasicImage<V>::BasicImage(char const* begin, char const* end) {
+  if (!is_image(begin, end))
+    throw std::runtime_error("Input is not a compiled image");
+
+  std::uint16_t image_version;
+  std::memcpy(&image_version, begin + 4, sizeof(image_version));
+  if (image_version != version)
+    throw std::runtime_error("Unsupported version of compiled image");
+
+  if (static_cast<unsigned char>(begin[6]) != sizeof(T) ||
+      static_cast<unsigned char>(begin[7]) != digits<T>())
+    throw std::runtime_error("Compiled image has other type of coefficients");
+
+  std::memcpy(&expression_count, begin + 8, sizeof(expression_count));
+  std::memcpy(&step_count, begin + 12, sizeof(step_count));
+  std::memcpy(&value_count, begin + 16, sizeof(value_count));
+  std::memcpy(&string_count, begin + 20, sizeof(string_count));
+  std::memcpy(&coefficient_count, begin + 24, sizeof(coefficient_count));
+  std::memcpy(&text_size, begin + 32, sizeof(text_size));
+
+  std::uint64_t size = end - begin;
+  if (coefficient_count > size / sizeof(T) || text_size > size)
+    throw std::runtime_error("Compiled image is truncated");
+
+  // sections follow each other, aligned
+  std::uint64_t offset = header_size;
+  std::uint64_t expressions_offset = offset;
+  offset = align(offset + std::uint64_t(expression_count) * expression_size * 4);
+  std::uint64_t steps_offset = offset;
+  offset = align(offset + std::uint64_t(step_count) * step_size * 4);
+  std::uint64_t values_offset = offset;
+  offset = align(offset + std::uint64_t(value_count) * value_size * 8);
+  std::uint64_t coefficients_offset = offset;
+  offset = align(offset + coefficient_count * sizeof(T));
+  std::uint64_t strings_offset = offset;
+  offset = align(offset + std::uint64_t(string_count) * string_size * 4);
+  std::uint64_t text_offset = offset;
+
+  if (text_offset + text_size > size)
+    throw std::runtime_error("Compiled image is truncated");
+
+  expressions = reinterpret_cast<std::uint32_t const*>(begin + expressions_offset);
+  steps = reinterpret_cast<std::uint32_t const*>(begin + steps_offset);
+  values = reinterpret_cast<std::uint64_t const*>(begin + values_offset);
+  coefficients = begin + coefficients_offset;
+  strings = reinterpret_cast<std::uint32_t const*>(begin + strings_offset);
+  text = begin + text_offset;
+
+  // check every reference, so linking never reads outside the image
+  bool valid = true;
+
+  for (std::uint32_t i = 0; i < string_count; i++)
+    valid = valid && std::uint64_t(strings[2*i]) + strings[2*i+1] <= text_size;
+
+  for (std::uint32_t i = 0; i < value_count; i++)
+    valid = valid && values[2*i] <= coefficient_count && values[2*i+1] <= coefficient_count - values[2*i];
+
+  for (std::uint32_t i = 0; i < step_count; i++) {
+    std::uint32_t type = steps[3*i], index = steps[3*i+1];
+    valid = valid && (type == VALUE ? index < value_count :
+                      type == SYMBOL || type == NUMBER ? index < string_count : false);
+  }
+
+  for (std::uint32_t i = 0; i < expression_count; i++) {
+    std::uint32_t const* expression = expressions + 4*i;
+    valid = valid && (expression[2] == no_error ?
+                      std::uint64_t(expression[0]) + expression[1] <= step_count :
+                      expression[2] < string_count);
+  }
+
+  if (!valid)
+    throw std::runtime_error("Compiled image is corrupted");
+}
+
+template <typename V>
+bool BasicImage<V>::error(std::size_t expression, std::string& message) const {
+  std::uint32_t index = expressions[expression_size * expression + 2];
+
+  if (index == no_error)
+    return false;
+
+  message = string(index);
+  return true;
+}
+
+template <typename V>
+void BasicImage<V>::link(std::size_t expression, BasicEvaluator<V>& evaluator,
+                         typename BasicEvaluator<V>::Program& program) const {
+  program.clear();
+
+  std::uint32_t first = expressions[expression_size * expression];
+  std::uint32_t count = expressions[expression_size * expression + 1];
+
+  for (std::uint32_t const* step = steps + step_size * first; step < steps + step_size * (first + count);
+       step += step_size) {
+    if (step[0] == VALUE) {
+      // coefficients are copied into the value
+      std::vector<T> c(values[2*step[1]+1]);
+      std::memcpy(c.data(), coefficients + values[2*step[1]] * sizeof(T), c.size() * sizeof(T));
+      evaluator.compile_value(V(std::move(c)), step[2], program);
+    } else
+    if (step[0] == NUMBER) {
+      evaluator.compile_number(string(step[1]), step[2], program);
+    } else
+    // nothing is evaluated after failure
+    if (!evaluator.compile_symbol(string(step[1]), step[2], program)) {
+      break;
+    }
+  }
+
+  evaluator.finish(program);
+}
+
+template <typename V>
+std::string BasicImage<V>::string(std::uint32_t index) const {
+  return std::string(text + strings[2*index], strings[2*index+1]);
+}
+
+template class BasicImage<Value>;
+template class BasicImage<FloatValue>;
+template class BasicImage<LongDoubleValue>;
+#ifdef XXCALC_FLOAT128
+template class BasicImage<Float128Value>;
+#endif
+
+}
+}
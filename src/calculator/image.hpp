@@ -0,0 +1,185 @@
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "tokenizer.hpp"
+#include "evaluator.hpp"
+
+#pragma once
+
+namespace XX {
+namespace Calculator {
+
+/**
+ * Compiled image of expressions, which can be stored in a file and
+ * evaluated without tokenizing, parsing or parsing of numbers. It
+ * is meant to be memory mapped - loading only checks its structure,
+ * coefficients of values are copied when a program is linked.
+ *
+ * Every expression is stored in RPN form as a list of steps: values
+ * (numbers parsed during compilation), symbols (constants, functions
+ * and operators referenced by name, so they are resolved when a
+ * program is linked with an evaluator) and numbers which could not
+ * be parsed. An expression which failed to parse stores its error
+ * message instead.
+ *
+ * All sections are aligned to 16 bytes and stored in native byte
+ * order (images of other byte order are rejected by their version):
+ *
+ *  - header - magic "XXCP", version (16 bit), size of coefficient
+ *    and its number of binary digits (8 bit each), number of
+ *    expressions, steps, values and strings (32 bit each) and
+ *    number of coefficients and bytes of strings (64 bit each)
+ *  - expressions - first step, number of steps and index of error
+ *    message (or ~0) - 32 bit each, padded to 16 bytes
+ *  - steps - type (VALUE, SYMBOL or NUMBER), index of value or
+ *    string and position in the input (32 bit each)
+ *  - values - first coefficient and number of coefficients (64 bit)
+ *  - coefficients - raw numbers of type T
+ *  - strings - offset and length (32 bit each) followed by bytes
+ *
+ * Images are supported for values with coefficients of fixed size
+ * (BasicValue), not for ExactValue.
+ */
+template <typename V>
+class BasicImage {
+  public:
+
+  //! Type of coefficients
+  typedef typename V::coefficient_type T;
+
+  //! Version of the format
+  static const std::uint16_t version = 1;
+
+  /**
+   * Creates images from expressions.
+   */
+  class Builder {
+    public:
+
+    /**
+     * Adds an expression in RPN form (as returned by the parser).
+     *
+     * @param tokens Parsed expression
+     */
+    void add(TokenList const& tokens);
+
+    /**
+     * Adds an expression which failed to parse.
+     *
+     * @param message Message of the parsing error
+     */
+    void add_error(std::string const& message);
+
+    /**
+     * Writes the image.
+     *
+     * @param[out] output Destination of the image
+     */
+    void write(std::string& output) const;
+
+    private:
+
+    //! Adds a string (unless it is already added), returns its index
+    std::uint32_t add_string(std::string const& string);
+
+    //! First step, number of steps and error of expressions
+    std::vector<std::uint32_t> expressions;
+
+    //! Type, index and position of steps
+    std::vector<std::uint32_t> steps;
+
+    //! First coefficient and number of coefficients of values
+    std::vector<std::uint64_t> values;
+
+    //! Coefficients of values
+    std::vector<T> coefficients;
+
+    //! Offsets and lengths of strings
+    std::vector<std::uint32_t> strings;
+
+    //! Bytes of strings
+    std::string text;
+
+    //! Indices of added strings
+    std::map<std::string, std::uint32_t> indices;
+  };
+
+  /**
+   * Opens an image held in memory, which must be kept until the
+   * image is destroyed. Structure of the image is checked, so its
+   * programs can be linked safely.
+   *
+   * @throw std::runtime_error When the image is not valid or it
+   *        has other type of coefficients
+   * @param begin Beginning of the image (aligned to 16 bytes)
+   * @param end End of the image
+   */
+  BasicImage(char const* begin, char const* end);
+
+  /**
+   * Checks if the data begins with magic of images.
+   *
+   * @param begin Beginning of the data
+   * @param end End of the data
+   * @return True if the data looks like an image
+   */
+  static bool is_image(char const* begin, char const* end);
+
+  //! Number of expressions in the image
+  std::size_t size() const { return expression_count; }
+
+  /**
+   * Gets message of an expression which failed to parse.
+   *
+   * @param expression Index of the expression
+   * @param[out] message Message of the error
+   * @return True if the expression failed to parse
+   */
+  bool error(std::size_t expression, std::string& message) const;
+
+  /**
+   * Compiles program of an expression, resolving its symbols
+   * with the evaluator.
+   *
+   * @param expression Index of the expression (which parsed)
+   * @param evaluator Evaluator executing the program
+   * @param[out] program Compiled program
+   */
+  void link(std::size_t expression, BasicEvaluator<V>& evaluator,
+            typename BasicEvaluator<V>::Program& program) const;
+
+  private:
+
+  //! Type of step
+  enum Step : std::uint32_t { VALUE = 0, SYMBOL = 1, NUMBER = 2 };
+
+  //! Creates string referenced by steps
+  std::string string(std::uint32_t index) const;
+
+  //! Numbers of elements of sections
+  std::uint32_t expression_count;
+  std::uint32_t step_count;
+  std::uint32_t value_count;
+  std::uint32_t string_count;
+  std::uint64_t coefficient_count;
+  std::uint64_t text_size;
+
+  //! Sections of the image
+  std::uint32_t const* expressions;
+  std::uint32_t const* steps;
+  std::uint64_t const* values;
+  char const* coefficients;
+  std::uint32_t const* strings;
+  char const* text;
+};
+
+/**
+ * Image of expressions with double coefficients
+ */
+typedef BasicImage<Value> Image;
+
+}
+}
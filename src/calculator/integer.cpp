@@ -0,0 +1,475 @@
+#include "integer.hpp"
+#include "errors.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace XX {
+namespace Calculator {
+
+Integer::Integer(long long value) : negative(value < 0) {
+  unsigned long long m = negative ? 0ull - static_cast<unsigned long long>(value) : value;
+
+  while (m > 0) {
+    magnitude.push_back(static_cast<std::uint32_t>(m));
+    m >>= 32;
+  }
+}
+
+Integer Integer::from_double(double value) {
+  if (!std::isfinite(value))
+    throw ValueError("Cannot convert non finite value to an integer");
+
+  int exponent;
+  double fraction = std::frexp(std::trunc(std::fabs(value)), &exponent);
+
+  if (exponent <= 0)
+    return Integer();
+
+  // 64 leading bits hold the whole 53 bit mantissa
+  Integer result(static_cast<long long>(std::ldexp(fraction, std::min(exponent, 63))));
+
+  if (exponent > 63)
+    result <<= exponent - 63;
+
+  return value < 0 ? -result : result;
+}
+
+Integer Integer::parse(std::string const& text) {
+  Integer result;
+  unsigned long position = 0;
+  bool negative = false;
+
+  if (position < text.size() && (text[position] == '-' || text[position] == '+')) {
+    negative = text[position] == '-';
+    position++;
+  }
+
+  if (position == text.size() || !std::isdigit(text[position]))
+    throw std::invalid_argument("Integer::parse");
+
+  // consume up to nine digits at once
+  while (position < text.size() && std::isdigit(text[position])) {
+    std::uint32_t chunk = 0;
+    std::uint32_t scale = 1;
+
+    for (int i = 0; i < 9 && position < text.size() && std::isdigit(text[position]); i++) {
+      chunk = chunk * 10 + (text[position++] - '0');
+      scale *= 10;
+    }
+
+    result *= Integer(scale);
+    result += Integer(chunk);
+  }
+
+  if (negative)
+    result = -result;
+
+  return result;
+}
+
+std::string Integer::str() const {
+  if (is_zero())
+    return "0";
+
+  std::vector<std::uint32_t> m = magnitude;
+  std::vector<std::uint32_t> chunks;
+
+  // split into base 10^9 digits
+  while (!m.empty()) {
+    std::uint64_t remainder = 0;
+
+    for (unsigned long i = m.size(); i-- > 0; ) {
+      std::uint64_t current = (remainder << 32) | m[i];
+      m[i] = static_cast<std::uint32_t>(current / 1000000000u);
+      remainder = current % 1000000000u;
+    }
+
+    while (!m.empty() && m.back() == 0)
+      m.pop_back();
+
+    chunks.push_back(static_cast<std::uint32_t>(remainder));
+  }
+
+  std::string result = negative ? "-" : "";
+  result += std::to_string(chunks.back());
+
+  for (unsigned long i = chunks.size() - 1; i-- > 0; ) {
+    std::string chunk = std::to_string(chunks[i]);
+    result.append(9 - chunk.size(), '0');
+    result += chunk;
+  }
+
+  return result;
+}
+
+Integer::operator double() const {
+  unsigned long length = bits();
+
+  if (length <= 64) {
+    std::uint64_t m = 0;
+    for (unsigned long i = magnitude.size(); i-- > 0; )
+      m = (m << 32) | magnitude[i];
+
+    return negative ? -static_cast<double>(m) : static_cast<double>(m);
+  }
+
+  // take 64 leading bits, remaining bits are kept as a sticky
+  // bit so the conversion rounds correctly
+  Integer top = abs() >> (length - 64);
+  std::uint64_t m = (static_cast<std::uint64_t>(top.magnitude[1]) << 32) | top.magnitude[0];
+
+  if (top << (length - 64) != abs())
+    m |= 1;
+
+  double result = std::ldexp(static_cast<double>(m), length - 64);
+  return negative ? -result : result;
+}
+
+int Integer::sign() const {
+  return is_zero() ? 0 : (negative ? -1 : 1);
+}
+
+unsigned long Integer::bits() const {
+  if (is_zero())
+    return 0;
+
+  unsigned long result = (magnitude.size() - 1) * 32;
+  for (std::uint32_t top = magnitude.back(); top > 0; top >>= 1)
+    result++;
+
+  return result;
+}
+
+std::uint32_t Integer::modulo(std::uint32_t modulus) const {
+  std::uint64_t remainder = 0;
+
+  for (unsigned long i = magnitude.size(); i-- > 0; ) {
+    remainder = ((remainder << 32) | magnitude[i]) % modulus;
+  }
+
+  if (negative && remainder != 0)
+    remainder = modulus - remainder;
+
+  return static_cast<std::uint32_t>(remainder);
+}
+
+Integer Integer::abs() const {
+  Integer result(*this);
+  result.negative = false;
+  return result;
+}
+
+const Integer Integer::operator-() const {
+  Integer result(*this);
+  result.negative = !negative;
+  result.trim();
+  return result;
+}
+
+Integer& Integer::operator+=(Integer const& other) {
+  if (negative == other.negative) {
+    add_magnitude(magnitude, other.magnitude);
+  } else
+  if (compare_magnitude(magnitude, other.magnitude) >= 0) {
+    subtract_magnitude(magnitude, other.magnitude);
+  } else {
+    std::vector<std::uint32_t> m = other.magnitude;
+    subtract_magnitude(m, magnitude);
+    magnitude.swap(m);
+    negative = other.negative;
+  }
+
+  trim();
+  return *this;
+}
+
+Integer& Integer::operator-=(Integer const& other) {
+  return *this += -other;
+}
+
+Integer& Integer::operator*=(Integer const& other) {
+  if (is_zero() || other.is_zero()) {
+    magnitude.clear();
+    negative = false;
+    return *this;
+  }
+
+  std::vector<std::uint32_t> result(magnitude.size() + other.magnitude.size(), 0);
+
+  for (unsigned long i = 0; i < magnitude.size(); i++) {
+    std::uint64_t carry = 0;
+    std::uint64_t a = magnitude[i];
+
+    for (unsigned long j = 0; j < other.magnitude.size(); j++) {
+      std::uint64_t current = a * other.magnitude[j] + result[i + j] + carry;
+      result[i + j] = static_cast<std::uint32_t>(current);
+      carry = current >> 32;
+    }
+
+    result[i + other.magnitude.size()] = static_cast<std::uint32_t>(carry);
+  }
+
+  magnitude.swap(result);
+  negative = negative != other.negative;
+  trim();
+
+  return *this;
+}
+
+Integer& Integer::operator/=(Integer const& other) {
+  Integer remainder;
+  divide(*this, other, *this, remainder);
+  return *this;
+}
+
+Integer& Integer::operator%=(Integer const& other) {
+  Integer quotient;
+  divide(*this, other, quotient, *this);
+  return *this;
+}
+
+Integer& Integer::operator<<=(unsigned long shift) {
+  if (is_zero())
+    return *this;
+
+  unsigned long limbs = shift / 32;
+  unsigned long offset = shift % 32;
+
+  if (offset > 0) {
+    std::uint32_t carry = 0;
+    for (unsigned long i = 0; i < magnitude.size(); i++) {
+      std::uint32_t current = magnitude[i];
+      magnitude[i] = (current << offset) | carry;
+      carry = current >> (32 - offset);
+    }
+    if (carry)
+      magnitude.push_back(carry);
+  }
+
+  magnitude.insert(magnitude.begin(), limbs, 0);
+
+  return *this;
+}
+
+Integer& Integer::operator>>=(unsigned long shift) {
+  unsigned long limbs = shift / 32;
+  unsigned long offset = shift % 32;
+
+  if (limbs >= magnitude.size()) {
+    magnitude.clear();
+  } else {
+    magnitude.erase(magnitude.begin(), magnitude.begin() + limbs);
+
+    if (offset > 0) {
+      for (unsigned long i = 0; i < magnitude.size(); i++) {
+        std::uint32_t next = i + 1 < magnitude.size() ? magnitude[i + 1] : 0;
+        magnitude[i] = (magnitude[i] >> offset) | (next << (32 - offset));
+      }
+    }
+  }
+
+  trim();
+  return *this;
+}
+
+bool Integer::operator==(Integer const& other) const {
+  return negative == other.negative && magnitude == other.magnitude;
+}
+
+void Integer::divide(Integer const& dividend, Integer const& divisor,
+                     Integer& quotient, Integer& remainder) {
+  if (divisor.is_zero())
+    throw ValueError("Integer division by zero");
+
+  bool quotient_negative = dividend.negative != divisor.negative;
+  bool remainder_negative = dividend.negative;
+
+  std::vector<std::uint32_t> q, r;
+  divide_magnitude(dividend.magnitude, divisor.magnitude, q, r);
+
+  quotient.magnitude.swap(q);
+  quotient.negative = quotient_negative;
+  quotient.trim();
+
+  remainder.magnitude.swap(r);
+  remainder.negative = remainder_negative;
+  remainder.trim();
+}
+
+Integer Integer::gcd(Integer a, Integer b) {
+  a.negative = false;
+  b.negative = false;
+
+  while (!b.is_zero()) {
+    a %= b;
+    std::swap(a, b);
+  }
+
+  return a;
+}
+
+int Integer::compare(Integer const& a, Integer const& b) {
+  if (a.negative != b.negative)
+    return a.negative ? -1 : 1;
+
+  int result = compare_magnitude(a.magnitude, b.magnitude);
+  return a.negative ? -result : result;
+}
+
+int Integer::compare_magnitude(std::vector<std::uint32_t> const& a,
+                               std::vector<std::uint32_t> const& b) {
+  if (a.size() != b.size())
+    return a.size() < b.size() ? -1 : 1;
+
+  for (unsigned long i = a.size(); i-- > 0; ) {
+    if (a[i] != b[i])
+      return a[i] < b[i] ? -1 : 1;
+  }
+
+  return 0;
+}
+
+void Integer::add_magnitude(std::vector<std::uint32_t>& a,
+                            std::vector<std::uint32_t> const& b) {
+  if (b.size() > a.size())
+    a.resize(b.size(), 0);
+
+  std::uint64_t carry = 0;
+  for (unsigned long i = 0; i < a.size(); i++) {
+    carry += a[i];
+    if (i < b.size())
+      carry += b[i];
+    else if (carry == a[i])
+      return;
+
+    a[i] = static_cast<std::uint32_t>(carry);
+    carry >>= 32;
+  }
+
+  if (carry)
+    a.push_back(static_cast<std::uint32_t>(carry));
+}
+
+void Integer::subtract_magnitude(std::vector<std::uint32_t>& a,
+                                 std::vector<std::uint32_t> const& b) {
+  std::int64_t borrow = 0;
+
+  for (unsigned long i = 0; i < a.size(); i++) {
+    std::int64_t current = static_cast<std::int64_t>(a[i]) - borrow;
+    if (i < b.size())
+      current -= b[i];
+    else if (borrow == 0)
+      break;
+
+    borrow = current < 0 ? 1 : 0;
+    a[i] = static_cast<std::uint32_t>(current + (borrow << 32));
+  }
+}
+
+void Integer::divide_magnitude(std::vector<std::uint32_t> const& u,
+                               std::vector<std::uint32_t> const& v,
+                               std::vector<std::uint32_t>& q,
+                               std::vector<std::uint32_t>& r) {
+  if (compare_magnitude(u, v) < 0) {
+    q.clear();
+    r = u;
+    return;
+  }
+
+  // single limb divisor
+  if (v.size() == 1) {
+    q.assign(u.size(), 0);
+    std::uint64_t remainder = 0;
+
+    for (unsigned long i = u.size(); i-- > 0; ) {
+      std::uint64_t current = (remainder << 32) | u[i];
+      q[i] = static_cast<std::uint32_t>(current / v[0]);
+      remainder = current % v[0];
+    }
+
+    r.assign(1, static_cast<std::uint32_t>(remainder));
+    return;
+  }
+
+  // Knuth's algorithm D, normalize so the top bit of divisor is set
+  unsigned long n = v.size();
+  unsigned long m = u.size() - n;
+  unsigned int s = 0;
+  while ((v.back() << s & 0x80000000u) == 0)
+    s++;
+
+  std::vector<std::uint32_t> vn(n), un(u.size() + 1);
+  for (unsigned long i = n - 1; i > 0; i--)
+    vn[i] = (v[i] << s) | (s ? static_cast<std::uint32_t>(static_cast<std::uint64_t>(v[i-1]) >> (32 - s)) : 0);
+  vn[0] = v[0] << s;
+
+  un[u.size()] = s ? static_cast<std::uint32_t>(static_cast<std::uint64_t>(u.back()) >> (32 - s)) : 0;
+  for (unsigned long i = u.size() - 1; i > 0; i--)
+    un[i] = (u[i] << s) | (s ? static_cast<std::uint32_t>(static_cast<std::uint64_t>(u[i-1]) >> (32 - s)) : 0);
+  un[0] = u[0] << s;
+
+  q.assign(m + 1, 0);
+  const std::uint64_t base = 1ull << 32;
+
+  for (unsigned long j = m + 1; j-- > 0; ) {
+    // estimate quotient digit
+    std::uint64_t numerator = (static_cast<std::uint64_t>(un[j+n]) << 32) | un[j+n-1];
+    std::uint64_t qhat = numerator / vn[n-1];
+    std::uint64_t rhat = numerator % vn[n-1];
+
+    while (qhat >= base || qhat * vn[n-2] > ((rhat << 32) | un[j+n-2])) {
+      qhat--;
+      rhat += vn[n-1];
+      if (rhat >= base)
+        break;
+    }
+
+    // multiply and subtract
+    std::int64_t borrow = 0;
+    std::int64_t t;
+    for (unsigned long i = 0; i < n; i++) {
+      std::uint64_t p = qhat * vn[i];
+      t = static_cast<std::int64_t>(un[i+j]) - borrow - static_cast<std::int64_t>(p & 0xFFFFFFFFu);
+      un[i+j] = static_cast<std::uint32_t>(t);
+      borrow = static_cast<std::int64_t>(p >> 32) - (t >> 32);
+    }
+    t = static_cast<std::int64_t>(un[j+n]) - borrow;
+    un[j+n] = static_cast<std::uint32_t>(t);
+
+    q[j] = static_cast<std::uint32_t>(qhat);
+
+    // add back if subtracted too much
+    if (t < 0) {
+      q[j]--;
+      std::uint64_t carry = 0;
+      for (unsigned long i = 0; i < n; i++) {
+        std::uint64_t sum = static_cast<std::uint64_t>(un[i+j]) + vn[i] + carry;
+        un[i+j] = static_cast<std::uint32_t>(sum);
+        carry = sum >> 32;
+      }
+      un[j+n] = static_cast<std::uint32_t>(un[j+n] + carry);
+    }
+  }
+
+  // unnormalize remainder
+  r.assign(n, 0);
+  for (unsigned long i = 0; i < n; i++)
+    r[i] = (un[i] >> s) | (s ? static_cast<std::uint32_t>(static_cast<std::uint64_t>(un[i+1]) << (32 - s)) : 0);
+}
+
+void Integer::trim() {
+  while (!magnitude.empty() && magnitude.back() == 0)
+    magnitude.pop_back();
+
+  if (magnitude.empty())
+    negative = false;
+}
+
+std::ostream& operator<<(std::ostream& os, Integer const& i) {
+  return os << i.str();
+}
+
+}
+}
@@ -0,0 +1,218 @@
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <iostream>
+
+#pragma once
+
+namespace XX {
+namespace Calculator {
+
+/**
+ * Arbitrary precision signed integer. The integer is stored
+ * as a sign and a magnitude - a vector of 32 bit limbs (least
+ * significant first) without leading zeros, so zero has an
+ * empty magnitude.
+ *
+ * Schoolbook algorithms are used for all the operations (with
+ * Knuth's algorithm D for division). Large polynomials of such
+ * integers are multiplied using number theoretic transforms
+ * (see NTT), not by repeated integer multiplication.
+ */
+class Integer {
+  public:
+
+  /**
+   * Creates zero
+   */
+  Integer() : negative(false) { }
+
+  /**
+   * Creates integer of given value.
+   *
+   * @param value Machine integer
+   */
+  Integer(long long value);
+
+  /**
+   * Creates integer from a double value, a fractional part
+   * is truncated (rounding towards zero).
+   *
+   * @throw ValueError When value is not finite
+   * @param value Double value
+   * @return Truncated integer
+   */
+  static Integer from_double(double value);
+
+  /**
+   * Parses decimal representation of the integer (with
+   * optional sign).
+   *
+   * @throw std::invalid_argument When text contains no digits
+   * @param text Decimal number
+   * @return Parsed integer
+   */
+  static Integer parse(std::string const& text);
+
+  /**
+   * Creates decimal representation of the integer.
+   *
+   * @return Decimal number
+   */
+  std::string str() const;
+
+  /**
+   * Converts the integer to the nearest double value (or
+   * infinity when it is too large).
+   *
+   * @return Double value
+   */
+  explicit operator double() const;
+
+  /**
+   * Checks sign of the integer.
+   *
+   * @return -1, 0 or 1 for negative, zero and positive integer
+   */
+  int sign() const;
+
+  /**
+   * Checks if the integer is zero.
+   *
+   * @return True if zero
+   */
+  bool is_zero() const { return magnitude.empty(); }
+
+  /**
+   * Computes number of bits required to store the magnitude.
+   *
+   * @return Bit length of absolute value
+   */
+  unsigned long bits() const;
+
+  /**
+   * Computes remainder of division by a word modulus. The result
+   * is non negative, also for negative integers.
+   *
+   * @param modulus Positive modulus
+   * @return Value of integer modulo given modulus
+   */
+  std::uint32_t modulo(std::uint32_t modulus) const;
+
+  /**
+   * Computes absolute value.
+   *
+   * @return Absolute value
+   */
+  Integer abs() const;
+
+  /**
+   * Divides two integers, truncating the quotient towards zero,
+   * so the remainder has the sign of dividend.
+   *
+   * @throw ValueError When divisor is zero
+   * @param dividend Integer to divide
+   * @param divisor Divisor
+   * @param[out] quotient Truncated quotient
+   * @param[out] remainder Remainder
+   */
+  static void divide(Integer const& dividend, Integer const& divisor,
+                     Integer& quotient, Integer& remainder);
+
+  //! Negation
+  const Integer operator-() const;
+
+  //! Addition
+  Integer& operator+=(Integer const& other);
+
+  //! Subtraction
+  Integer& operator-=(Integer const& other);
+
+  //! Multiplication
+  Integer& operator*=(Integer const& other);
+
+  //! Truncated division
+  Integer& operator/=(Integer const& other);
+
+  //! Remainder of truncated division
+  Integer& operator%=(Integer const& other);
+
+  //! Multiplication by power of two
+  Integer& operator<<=(unsigned long shift);
+
+  //! Division by power of two (truncated)
+  Integer& operator>>=(unsigned long shift);
+
+  const Integer operator+(Integer const& other) const { return Integer(*this) += other; }
+  const Integer operator-(Integer const& other) const { return Integer(*this) -= other; }
+  const Integer operator*(Integer const& other) const { return Integer(*this) *= other; }
+  const Integer operator/(Integer const& other) const { return Integer(*this) /= other; }
+  const Integer operator%(Integer const& other) const { return Integer(*this) %= other; }
+  const Integer operator<<(unsigned long shift) const { return Integer(*this) <<= shift; }
+  const Integer operator>>(unsigned long shift) const { return Integer(*this) >>= shift; }
+
+  bool operator==(Integer const& other) const;
+  bool operator!=(Integer const& other) const { return !(*this == other); }
+  bool operator<(Integer const& other) const { return compare(*this, other) < 0; }
+  bool operator<=(Integer const& other) const { return compare(*this, other) <= 0; }
+  bool operator>(Integer const& other) const { return compare(*this, other) > 0; }
+  bool operator>=(Integer const& other) const { return compare(*this, other) >= 0; }
+
+  /**
+   * Computes greatest common divisor using Euclidean algorithm.
+   *
+   * @param a First integer
+   * @param b Second integer
+   * @return Non negative greatest common divisor
+   */
+  static Integer gcd(Integer a, Integer b);
+
+  private:
+
+  //! Sign of the integer (zero is never negative)
+  bool negative;
+
+  //! Absolute value, least significant limbs first
+  std::vector<std::uint32_t> magnitude;
+
+  /**
+   * Compares two integers.
+   *
+   * @return Negative, zero or positive number if a is smaller,
+   *         equal or larger than b
+   */
+  static int compare(Integer const& a, Integer const& b);
+
+  //! Compares magnitudes of two limb vectors
+  static int compare_magnitude(std::vector<std::uint32_t> const& a,
+                               std::vector<std::uint32_t> const& b);
+
+  //! Adds magnitude b to a
+  static void add_magnitude(std::vector<std::uint32_t>& a,
+                            std::vector<std::uint32_t> const& b);
+
+  //! Subtracts magnitude b from a (a must not be smaller)
+  static void subtract_magnitude(std::vector<std::uint32_t>& a,
+                                 std::vector<std::uint32_t> const& b);
+
+  //! Divides magnitudes, producing quotient and remainder
+  static void divide_magnitude(std::vector<std::uint32_t> const& u,
+                               std::vector<std::uint32_t> const& v,
+                               std::vector<std::uint32_t>& q,
+                               std::vector<std::uint32_t>& r);
+
+  //! Removes leading zero limbs and normalizes the sign of zero
+  void trim();
+};
+
+/**
+ * Pretty printer for an integer (decimal form).
+ *
+ * @param os Output stream
+ * @param i Integer to print
+ * @return Stream with integer
+ */
+std::ostream& operator<<(std::ostream& os, Integer const& i);
+
+}
+}
@@ -1,35 +1,45 @@
 #include "linear_solver.hpp"
 #include "errors.hpp"
 
-#include <cmath>
 #include <limits>
 
 namespace XX {
 namespace Calculator {
 
-LinearSolver::LinearSolver(Tokenizer& tokenizer, Parser& parser) :
-  PolynomialCalculator(tokenizer, parser) {
-  register_operator("=", std::numeric_limits<int>::min(), -1,
-                    std::bind(&LinearSolver::solve_operator, this, std::placeholders::_1));
+template <typename V>
+BasicLinearSolver<V>::BasicLinearSolver(Tokenizer& tokenizer, Parser& parser) :
+  BasicPolynomialCalculator<V>(tokenizer, parser) {
+  this->register_operator("=", std::numeric_limits<int>::min(), -1,
+                          std::bind(&BasicLinearSolver::solve_operator, this, std::placeholders::_1));
 }
 
-Value LinearSolver::process(std::string const& line) {
+template <typename V>
+V BasicLinearSolver<V>::process(std::string const& line, Status& status) {
   solved = false;
-  return PolynomialCalculator::process(line);
+  return BasicPolynomialCalculator<V>::process(line, status);
 }
 
-Value LinearSolver::solve_operator(std::vector<Value> const& args) {
+template <typename V>
+V BasicLinearSolver<V>::process(typename BasicPolynomialCalculator<V>::Compiler const& compile, Status& status) {
+  solved = false;
+  return BasicPolynomialCalculator<V>::process(compile, status);
+}
+
+template <typename V>
+V BasicLinearSolver<V>::solve_operator(std::vector<V> const& args) {
   unsigned long left_degree = args[0].degree();
   unsigned long right_degree = args[1].degree();
 
-  Value left = args[0];
-  Value right = args[1];
+  V left = args[0];
+  V right = args[1];
 
   if (left_degree > 1 || right_degree > 1) {
-    throw NonLinearEquation();
+    this->fail(Status(ErrorCode::NON_LINEAR_EQUATION));
+    return V();
   } else
   if (left_degree == 0 && right_degree == 0) {
-    throw NoSymbolFound();
+    this->fail(Status(ErrorCode::NO_SYMBOL_FOUND));
+    return V();
   }
 
   left[1] -= right[1];
@@ -42,10 +52,12 @@ Value LinearSolver::solve_operator(std::vector<Value> const& args) {
   left[1] /= left[1];
 
   if (right[0] != right[0]) {
-    throw ExpressionIsTautology();
+    this->fail(Status(ErrorCode::TAUTOLOGY));
+    return V();
   } else
-  if (std::isinf(right[0])) {
-    throw NonSolvableExpression();
+  if (Math<typename V::coefficient_type>::isinf(right[0])) {
+    this->fail(Status(ErrorCode::NON_SOLVABLE));
+    return V();
   }
 
   solved = true;
@@ -53,5 +65,13 @@ Value LinearSolver::solve_operator(std::vector<Value> const& args) {
   return right;
 }
 
+template class BasicLinearSolver<Value>;
+template class BasicLinearSolver<FloatValue>;
+template class BasicLinearSolver<LongDoubleValue>;
+#ifdef XXCALC_FLOAT128
+template class BasicLinearSolver<Float128Value>;
+#endif
+template class BasicLinearSolver<ExactValue>;
+
 }
 }
@@ -15,14 +15,16 @@ namespace Calculator {
  * equation (a polynomial with degree equal 1) for symbol x.
  *
  * If solver cannot solve given equation, an appropriate
- * exception is thrown.
+ * exception is thrown (or the failure is returned by the status
+ * of a calculation which does not throw).
  */
-class LinearSolver : public PolynomialCalculator {
+template <typename V>
+class BasicLinearSolver : public BasicPolynomialCalculator<V> {
   public:
 
   /**
    * Creates instance of linear solver. Solver support the
-   * same operators and functions as PolynomialCalculator,
+   * same operators and functions as BasicPolynomialCalculator,
    * however it registers a '=' operator (with lowest
    * possible precedence, so it always divides expression
    * into halves).
@@ -30,16 +32,29 @@ class LinearSolver : public PolynomialCalculator {
    * @param tokenizer Tokenizer to use
    * @param parser Parser to use
    */
-  LinearSolver(Tokenizer& tokenizer, Parser& parser);
+  BasicLinearSolver(Tokenizer& tokenizer, Parser& parser);
+
+  using BasicPolynomialCalculator<V>::process;
 
   /**
    * Processes the input expression and returns its computed
    * value. Sets solved flag if solving has occured.
    *
    * @param line Expression (with optional x symbol)
+   * @param[out] status Failure of the calculation (unchanged on success)
+   * @return Computed polynomial or its value
+   */
+  V process(std::string const& line, Status& status);
+
+  /**
+   * Evaluates a compiled program (see BasicPolynomialCalculator)
+   * and sets solved flag if solving has occured.
+   *
+   * @param compile Compiles the program using the evaluator
+   * @param[out] status Failure of the calculation (unchanged on success)
    * @return Computed polynomial or its value
    */
-  Value process(std::string const& line);
+  V process(typename BasicPolynomialCalculator<V>::Compiler const& compile, Status& status);
 
   /**
    * Flag marking state of solving. It is true if solving
@@ -61,6 +76,9 @@ class LinearSolver : public PolynomialCalculator {
    * It should be noted that this is not a symbolic solver, as
    * operands are evaluated values of functions (if any).
    *
+   * Failures are reported to the evaluator (see
+   * BasicEvaluator::fail), so they are thrown only by process.
+   *
    * @throw NonLinearEquation When any of operands is not a
    *        linear expression (has a degree large than 1)
    * @throw NoSymbolFound When both operands are a constant
@@ -72,8 +90,13 @@ class LinearSolver : public PolynomialCalculator {
    * @param args Two operands
    * @return Value of the symbol
    */
-   Value solve_operator(std::vector<Value> const& args);
+   V solve_operator(std::vector<V> const& args);
 };
 
+/**
+ * Linear solver operating on double coefficients
+ */
+typedef BasicLinearSolver<Value> LinearSolver;
+
 }
 }
@@ -0,0 +1,102 @@
+#include "math.hpp"
+#include "format.hpp"
+
+#include <stdexcept>
+
+#ifdef XXCALC_FLOAT128
+#include <quadmath.h>
+#include <cerrno>
+#endif
+
+namespace XX {
+namespace Calculator {
+
+template <>
+float Math<float>::parse(std::string const& text) {
+  return std::stof(text);
+}
+
+template <>
+double Math<double>::parse(std::string const& text) {
+  return std::stod(text);
+}
+
+template <>
+long double Math<long double>::parse(std::string const& text) {
+  return std::stold(text);
+}
+
+// float is printed by streams as double
+template <>
+void Math<float>::print(std::string& output, float x) {
+  append_number(output, x);
+}
+
+template <>
+void Math<double>::print(std::string& output, double x) {
+  append_number(output, x);
+}
+
+#ifdef XXCALC_FLOAT128
+__float128 Math<__float128>::parse(std::string const& text) {
+  char* end;
+  errno = 0;
+  __float128 x = strtoflt128(text.c_str(), &end);
+
+  if (end == text.c_str())
+    throw std::invalid_argument("strtoflt128");
+  if (errno == ERANGE)
+    throw std::out_of_range("strtoflt128");
+
+  return x;
+}
+
+void Math<__float128>::print(std::ostream& os, __float128 x) {
+  char buffer[64];
+  quadmath_snprintf(buffer, sizeof(buffer), "%.*Qg", int(os.precision()), x);
+  os << buffer;
+}
+
+void Math<__float128>::print(std::string& output, __float128 x) {
+  char buffer[64];
+  output.append(buffer, quadmath_snprintf(buffer, sizeof(buffer), "%.6Qg", x));
+}
+
+// quadmath constants need GNU literals, so they are parsed instead
+__float128 Math<__float128>::pi() {
+  static const __float128 pi = strtoflt128("3.14159265358979323846264338327950288", nullptr);
+  return pi;
+}
+
+__float128 Math<__float128>::e() {
+  static const __float128 e = strtoflt128("2.71828182845904523536028747135266250", nullptr);
+  return e;
+}
+
+__float128 Math<__float128>::pow(__float128 base, __float128 exponent) {
+  return powq(base, exponent);
+}
+
+__float128 Math<__float128>::log(__float128 x) {
+  return logq(x);
+}
+
+__float128 Math<__float128>::log10(__float128 x) {
+  return log10q(x);
+}
+
+__float128 Math<__float128>::exp(__float128 x) {
+  return expq(x);
+}
+
+__float128 Math<__float128>::modf(__float128 x, __float128* integer) {
+  return modfq(x, integer);
+}
+
+bool Math<__float128>::isinf(__float128 x) {
+  return isinfq(x);
+}
+#endif
+
+}
+}
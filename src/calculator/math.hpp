@@ -0,0 +1,112 @@
+#include "rational.hpp"
+
+#include <cmath>
+#include <string>
+#include <iostream>
+#include <sstream>
+
+#pragma once
+
+namespace XX {
+namespace Calculator {
+
+/**
+ * Mathematical functions of coefficient types. Values are
+ * parameterized with a type of their coefficients (see
+ * BasicValue), so functions of the standard library cannot
+ * be used directly for all of them.
+ *
+ * Float, double and long double use functions from cmath,
+ * __float128 uses libquadmath (it is available only if the
+ * XXCALC_FLOAT128 macro is defined).
+ */
+template <typename T>
+struct Math {
+  /**
+   * Parses a number in decimal notation.
+   *
+   * @throw std::invalid_argument When text is not a number
+   * @throw std::out_of_range When number is out of range of T
+   * @param text Decimal number (scientific notation is allowed)
+   * @return Parsed number
+   */
+  static T parse(std::string const& text);
+
+  /**
+   * Prints a number to the stream (respecting its precision).
+   *
+   * @param os Output stream
+   * @param x Number to print
+   */
+  static void print(std::ostream& os, T x) { os << x; }
+
+  /**
+   * Appends a number to the string, formatted as print does
+   * with default precision of streams.
+   *
+   * @param output Destination string
+   * @param x Number to print
+   */
+  static void print(std::string& output, T x) {
+    std::ostringstream os;
+    os << x;
+    output += os.str();
+  }
+
+  //! Nearest value of pi
+  static T pi() { return static_cast<T>(3.141592653589793238462643383279502884L); }
+
+  //! Nearest value of Euler's number
+  static T e() { return static_cast<T>(2.718281828459045235360287471352662498L); }
+
+  static T pow(T base, T exponent) { return std::pow(base, exponent); }
+  static T log(T x) { return std::log(x); }
+  static T log10(T x) { return std::log10(x); }
+  static T exp(T x) { return std::exp(x); }
+  static T modf(T x, T* integer) { return std::modf(x, integer); }
+  static bool isinf(T x) { return std::isinf(x); }
+};
+
+template <> float Math<float>::parse(std::string const& text);
+template <> double Math<double>::parse(std::string const& text);
+template <> long double Math<long double>::parse(std::string const& text);
+template <> void Math<float>::print(std::string& output, float x);
+template <> void Math<double>::print(std::string& output, double x);
+
+#ifdef XXCALC_FLOAT128
+/**
+ * Quadruple precision functions from libquadmath
+ */
+template <>
+struct Math<__float128> {
+  static __float128 parse(std::string const& text);
+  static void print(std::ostream& os, __float128 x);
+  static void print(std::string& output, __float128 x);
+  static __float128 pi();
+  static __float128 e();
+  static __float128 pow(__float128 base, __float128 exponent);
+  static __float128 log(__float128 x);
+  static __float128 log10(__float128 x);
+  static __float128 exp(__float128 x);
+  static __float128 modf(__float128 x, __float128* integer);
+  static bool isinf(__float128 x);
+};
+#endif
+
+/**
+ * Functions of rational numbers. Transcendental functions are
+ * computed using double precision, their results are exact
+ * rational values of the nearest double.
+ */
+template <>
+struct Math<Rational> {
+  static Rational pi() { return Rational::from_double(M_PI); }
+  static Rational e() { return Rational::from_double(M_E); }
+  static Rational log(Rational const& x) { return Rational::from_double(std::log(double(x))); }
+  static Rational log10(Rational const& x) { return Rational::from_double(std::log10(double(x))); }
+  static Rational exp(Rational const& x) { return Rational::from_double(std::exp(double(x))); }
+  static bool isinf(Rational const& x) { return x.is_infinite(); }
+};
+
+}
+}
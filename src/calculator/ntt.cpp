@@ -0,0 +1,320 @@
+#include "ntt.hpp"
+
+#include <algorithm>
+#include <map>
+#include <mutex>
+
+namespace XX {
+namespace Calculator {
+namespace NTT {
+
+namespace {
+
+/**
+ * Prime suitable for number theoretic transforms
+ */
+struct Prime {
+  //! Prime modulus
+  std::uint32_t value;
+  //! Primitive root modulo the prime
+  std::uint32_t root;
+};
+
+std::uint32_t power_mod(std::uint64_t base, std::uint64_t exponent, std::uint32_t modulus) {
+  std::uint64_t result = 1;
+  base %= modulus;
+
+  for (; exponent > 0; exponent >>= 1) {
+    if (exponent & 1)
+      result = result * base % modulus;
+    base = base * base % modulus;
+  }
+
+  return static_cast<std::uint32_t>(result);
+}
+
+/**
+ * Deterministic Miller-Rabin test (bases 2, 7 and 61 are
+ * sufficient for all 32 bit numbers).
+ */
+bool is_prime(std::uint32_t n) {
+  if (n < 2)
+    return false;
+
+  for (std::uint32_t p : {2u, 3u, 5u, 7u, 61u}) {
+    if (n % p == 0)
+      return n == p;
+  }
+
+  std::uint32_t d = n - 1;
+  unsigned int s = 0;
+  while ((d & 1) == 0) {
+    d >>= 1;
+    s++;
+  }
+
+  for (std::uint32_t a : {2u, 7u, 61u}) {
+    std::uint64_t x = power_mod(a, d, n);
+    if (x == 1 || x == n - 1)
+      continue;
+
+    bool composite = true;
+    for (unsigned int i = 1; i < s && composite; i++) {
+      x = x * x % n;
+      if (x == n - 1)
+        composite = false;
+    }
+
+    if (composite)
+      return false;
+  }
+
+  return true;
+}
+
+/**
+ * Finds the smallest primitive root of prime p = c*2^k+1.
+ */
+std::uint32_t primitive_root(std::uint32_t p, std::uint32_t c) {
+  std::vector<std::uint32_t> factors = {2};
+
+  for (std::uint32_t f = 3; f * f <= c; f += 2) {
+    if (c % f == 0) {
+      factors.push_back(f);
+      while (c % f == 0)
+        c /= f;
+    }
+  }
+  if (c > 2)
+    factors.push_back(c);
+
+  for (std::uint32_t g = 2; ; g++) {
+    bool generator = true;
+
+    for (std::uint32_t f : factors) {
+      if (power_mod(g, (p - 1) / f, p) == 1) {
+        generator = false;
+        break;
+      }
+    }
+
+    if (generator)
+      return g;
+  }
+}
+
+/**
+ * Lists primes of form c*2^k+1 below 2^31 (largest first),
+ * so sum of two residues never overflows. Lists are computed
+ * once for each k.
+ */
+std::vector<Prime> const& primes(unsigned int k) {
+  static std::mutex lock;
+  static std::map<unsigned int, std::vector<Prime>> cache;
+
+  std::lock_guard<std::mutex> guard(lock);
+
+  auto found = cache.find(k);
+  if (found != cache.end())
+    return found->second;
+
+  std::vector<Prime>& list = cache[k];
+  for (std::uint32_t c = (1u << (31 - k)) - 1; c > 0; c--) {
+    std::uint32_t p = (c << k) + 1;
+
+    if (is_prime(p))
+      list.push_back({p, primitive_root(p, c)});
+  }
+
+  return list;
+}
+
+/**
+ * In-place iterative transform (Cooley-Tukey). Length must be
+ * a power of two dividing prime - 1.
+ */
+void transform(std::vector<std::uint32_t>& a, std::uint32_t prime, std::uint32_t root, bool inverse) {
+  unsigned long n = a.size();
+
+  // bit reversal permutation
+  for (unsigned long i = 1, j = 0; i < n; i++) {
+    unsigned long bit = n >> 1;
+    for (; j & bit; bit >>= 1)
+      j ^= bit;
+    j ^= bit;
+
+    if (i < j)
+      std::swap(a[i], a[j]);
+  }
+
+  std::vector<std::uint32_t> twiddles(n / 2);
+
+  for (unsigned long length = 2; length <= n; length <<= 1) {
+    std::uint32_t w = power_mod(root, (prime - 1) / length, prime);
+    if (inverse)
+      w = power_mod(w, prime - 2, prime);
+
+    unsigned long half = length / 2;
+    twiddles[0] = 1;
+    for (unsigned long i = 1; i < half; i++)
+      twiddles[i] = static_cast<std::uint64_t>(twiddles[i-1]) * w % prime;
+
+    for (unsigned long start = 0; start < n; start += length) {
+      for (unsigned long i = 0; i < half; i++) {
+        std::uint32_t u = a[start + i];
+        std::uint32_t v = static_cast<std::uint64_t>(a[start + i + half]) * twiddles[i] % prime;
+
+        a[start + i] = u + v >= prime ? u + v - prime : u + v;
+        a[start + i + half] = u >= v ? u - v : u + prime - v;
+      }
+    }
+  }
+
+  if (inverse) {
+    std::uint64_t scale = power_mod(n, prime - 2, prime);
+    for (auto& x : a)
+      x = x * scale % prime;
+  }
+}
+
+/**
+ * Classic O(n*m) multiplication of integer polynomials.
+ */
+std::vector<Integer> schoolbook(std::vector<Integer> const& a, std::vector<Integer> const& b) {
+  std::vector<Integer> result(a.size() + b.size() - 1);
+
+  for (unsigned long i = 0; i < a.size(); i++) {
+    if (a[i].is_zero())
+      continue;
+
+    for (unsigned long j = 0; j < b.size(); j++) {
+      result[i + j] += a[i] * b[j];
+    }
+  }
+
+  return result;
+}
+
+}
+
+std::vector<std::uint32_t> convolve(std::vector<std::uint32_t> a, std::vector<std::uint32_t> b,
+                                    std::uint32_t prime, std::uint32_t root) {
+  unsigned long size = a.size() + b.size() - 1;
+  unsigned long length = 1;
+  while (length < size)
+    length <<= 1;
+
+  a.resize(length, 0);
+  b.resize(length, 0);
+
+  transform(a, prime, root, false);
+  transform(b, prime, root, false);
+
+  for (unsigned long i = 0; i < length; i++)
+    a[i] = static_cast<std::uint64_t>(a[i]) * b[i] % prime;
+
+  transform(a, prime, root, true);
+  a.resize(size);
+
+  return a;
+}
+
+std::vector<Integer> convolve(std::vector<Integer> const& a, std::vector<Integer> const& b) {
+  if (a.empty() || b.empty())
+    return std::vector<Integer>();
+
+  unsigned long size = a.size() + b.size() - 1;
+  unsigned int k = 1;
+  while ((1ul << k) < size)
+    k++;
+
+  // bound of result coefficients (with a sign bit)
+  unsigned long a_bits = 0, b_bits = 0, terms_bits = 0;
+  for (auto const& x : a)
+    a_bits = std::max(a_bits, x.bits());
+  for (auto const& x : b)
+    b_bits = std::max(b_bits, x.bits());
+  for (unsigned long n = std::min(a.size(), b.size()); n > 0; n >>= 1)
+    terms_bits++;
+
+  unsigned long required_bits = a_bits + b_bits + terms_bits + 1;
+
+  if (k > 27)
+    return schoolbook(a, b);
+
+  // pick enough primes, lists for short transforms are shared
+  std::vector<Prime> const& available = primes(std::max(k, 16u));
+  unsigned long count = 0, bits = 0;
+
+  for (; count < available.size() && bits < required_bits; count++) {
+    for (std::uint32_t p = available[count].value; p > 1; p >>= 1)
+      bits++;
+  }
+
+  if (bits < required_bits)
+    return schoolbook(a, b);
+
+  std::vector<Prime> chosen(available.begin(), available.begin() + count);
+
+  // products modulo each prime
+  std::vector<std::vector<std::uint32_t>> residues(count);
+  for (unsigned long p = 0; p < count; p++) {
+    std::vector<std::uint32_t> fa(a.size()), fb(b.size());
+
+    for (unsigned long i = 0; i < a.size(); i++)
+      fa[i] = a[i].modulo(chosen[p].value);
+    for (unsigned long i = 0; i < b.size(); i++)
+      fb[i] = b[i].modulo(chosen[p].value);
+
+    residues[p] = convolve(fa, fb, chosen[p].value, chosen[p].root);
+  }
+
+  // Garner's algorithm - inverses of primes modulo each other
+  std::vector<std::vector<std::uint32_t>> inverses(count, std::vector<std::uint32_t>(count, 0));
+  for (unsigned long i = 0; i < count; i++) {
+    for (unsigned long j = i + 1; j < count; j++) {
+      inverses[i][j] = power_mod(chosen[i].value, chosen[j].value - 2, chosen[j].value);
+    }
+  }
+
+  Integer modulus(1);
+  for (auto const& p : chosen)
+    modulus *= Integer(static_cast<long long>(p.value));
+  Integer half = modulus >> 1;
+
+  std::vector<Integer> result(size);
+  std::vector<std::uint32_t> digits(count);
+
+  for (unsigned long t = 0; t < size; t++) {
+    // mixed radix digits of the coefficient
+    for (unsigned long j = 0; j < count; j++) {
+      std::uint32_t p = chosen[j].value;
+      std::uint64_t x = residues[j][t];
+
+      for (unsigned long i = 0; i < j; i++) {
+        std::uint64_t d = digits[i] % p;
+        x = (x + p - d) % p * inverses[i][j] % p;
+      }
+
+      digits[j] = static_cast<std::uint32_t>(x);
+    }
+
+    Integer value(static_cast<long long>(digits[count - 1]));
+    for (unsigned long i = count - 1; i-- > 0; ) {
+      value *= Integer(static_cast<long long>(chosen[i].value));
+      value += Integer(static_cast<long long>(digits[i]));
+    }
+
+    // symmetric representation restores negative coefficients
+    if (value > half)
+      value -= modulus;
+
+    result[t] = value;
+  }
+
+  return result;
+}
+
+}
+}
+}
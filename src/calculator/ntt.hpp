@@ -0,0 +1,53 @@
+#include "integer.hpp"
+
+#include <vector>
+
+#pragma once
+
+namespace XX {
+namespace Calculator {
+
+/**
+ * Multi-modular number theoretic transform. Exact products of
+ * integer polynomials are computed modulo several word size
+ * primes of form c*2^k+1 (which support transforms of length
+ * up to 2^k) and reconstructed using the Chinese remainder
+ * theorem (Garner's algorithm).
+ *
+ * The number of primes depends on the size of the largest
+ * possible coefficient of the product, so the complexity is
+ * O(n log n) per prime, instead of O(n^2) multiplications of
+ * big integers performed by the schoolbook method.
+ */
+namespace NTT {
+
+/**
+ * Computes the product of two polynomials with integer
+ * coefficients (the convolution of coefficient vectors).
+ * Coefficients may be arbitrarily large or negative. If
+ * there are not enough primes to represent the result, the
+ * schoolbook multiplication is used instead.
+ *
+ * @param a Coefficients of the first polynomial
+ * @param b Coefficients of the second polynomial
+ * @return Coefficients of the product (a.size()+b.size()-1 of them)
+ */
+std::vector<Integer> convolve(std::vector<Integer> const& a, std::vector<Integer> const& b);
+
+/**
+ * Computes the product of two polynomials modulo a prime
+ * supporting transforms of sufficient length.
+ *
+ * @param a Coefficients of the first polynomial (reduced modulo prime)
+ * @param b Coefficients of the second polynomial (reduced modulo prime)
+ * @param prime Prime of form c*2^k+1 with 2^k >= a.size()+b.size()-1
+ * @param root Primitive root modulo prime
+ * @return Coefficients of the product modulo prime
+ */
+std::vector<std::uint32_t> convolve(std::vector<std::uint32_t> a, std::vector<std::uint32_t> b,
+                                    std::uint32_t prime, std::uint32_t root);
+
+}
+
+}
+}
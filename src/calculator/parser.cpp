@@ -1,42 +1,77 @@
 #include "parser.hpp"
 
+#include <iterator>
 #include <limits>
 
 namespace XX {
 namespace Calculator {
 
 void Parser::register_operator(std::string const& value, int p, int a) {
-  operators.emplace(value, Operator(p, a));
+  // the first registration of a name is kept
+  if (find_operator(value) != nullptr)
+    return;
+
+  table.emplace_back(p, a);
+
+  if (value.size() == 1)
+    slots[static_cast<unsigned char>(value[0])] = table.size();
+  else
+    named.emplace(value, table.size() - 1);
+}
+
+Parser::Operator const* Parser::find_named_operator(std::string const& name) const {
+  auto found = named.find(name);
+  return found != named.end() ? &table[found->second] : nullptr;
 }
 
-bool Parser::lower_precedence(Token const& a, Token const& b) const {
+bool Parser::lower_precedence(Operator const& a, Token const& b) const {
   // functions have always the highest precedence
   if (b.type == TokenType::IDENTIFIER)
     return true;
 
-  auto operator_a = operators.find(a.value);
-  auto operator_b = operators.find(b.value);
-
   // depends on associativity
-  return (operator_a->second.associativity < 0 &&
-          operator_a->second.precedence <= operator_b->second.precedence) ||
-         (operator_a->second.associativity > 0 &&
-          operator_a->second.precedence < operator_b->second.precedence);
+  return lower_precedence(a, *find_operator(b.value));
 }
 
 TokenList Parser::process(TokenList& tokens) const {
-  std::stack<Token> ops;
+  Status status;
+  TokenList output = process(tokens, status);
+
+  status.raise();
+  return output;
+}
+
+TokenList Parser::process(TokenList& tokens, Status& status) const {
+  // tokens are moved between lists by relinking their nodes (so
+  // nothing is copied or allocated), operators wait at the back
+  // of ops list
+  TokenList ops;
   TokenList output;
 
+  auto push = [&](TokenList& destination) {
+    destination.splice(destination.end(), tokens, tokens.begin());
+  };
+
+  auto pop = [&]() {
+    output.splice(output.end(), ops, std::prev(ops.end()));
+  };
+
+  // nodes are given back, so they can be reused
+  auto fail = [&](Status failure) -> TokenList {
+    status = std::move(failure);
+    tokens.splice(tokens.end(), output);
+    tokens.splice(tokens.end(), ops);
+    return TokenList();
+  };
+
   // parse from left to right
   while (!tokens.empty()) {
-    auto token = tokens.front();
-    tokens.pop_front();
+    Token const& token = tokens.front();
 
     // convert number to leaf node
     if (token.type == TokenType::NUMBER) {
       // push number
-      output.push_back(token);
+      push(output);
 
       // check if implicit multiplication
       if (!tokens.empty() &&
@@ -49,82 +84,84 @@ TokenList Parser::process(TokenList& tokens) const {
     // create symbol or function
     if (token.type == TokenType::IDENTIFIER) {
       // check if function (must be followed by brackets)
-      if (!tokens.empty() && tokens.front().type == TokenType::BRACKET_OPENING) {
-        ops.push(token);
+      auto next = std::next(tokens.begin());
+
+      if (next != tokens.end() && next->type == TokenType::BRACKET_OPENING) {
+        push(ops);
       } else {
         // must be a variable/symbol
-        output.push_back(token);
+        push(output);
       }
     } else
     // separators
     if (token.type == TokenType::SEPARATOR) {
-      while (!ops.empty() && ops.top().type != TokenType::BRACKET_OPENING) {
-        output.push_back(ops.top());
-        ops.pop();
-      }
-    }
+      while (!ops.empty() && ops.back().type != TokenType::BRACKET_OPENING)
+        pop();
+
+      tokens.pop_front();
+    } else
     // operator creates a function node
     if (token.type == TokenType::OPERATOR) {
+      // operator is looked up once, not for every comparison
+      Operator const* current = find_operator(token.value);
+      if (current == nullptr) {
+        return fail(Status(ErrorCode::UNKNOWN_OPERATOR, token.position, token.value));
+      }
+
       // any waiting
       while (!ops.empty()) {
         // must be lower precedence
-        if ((ops.top().type == TokenType::OPERATOR ||
-             ops.top().type == TokenType::IDENTIFIER) &&
-            lower_precedence(token, ops.top())) {
+        if ((ops.back().type == TokenType::OPERATOR ||
+             ops.back().type == TokenType::IDENTIFIER) &&
+            lower_precedence(*current, ops.back())) {
           // push args
-          output.push_back(ops.top());
-          ops.pop();
+          pop();
         } else {
           break;
         }
       }
 
-      if (operators.find(token.value) != operators.end()) {
-        // new operator
-        ops.push(token);
-      } else {
-        throw UnknownOperatorError(token.value, token.position);
-      }
+      // new operator
+      push(ops);
     } else
     // mark bracket
     if (token.type == TokenType::BRACKET_OPENING) {
-      ops.push(token);
+      push(ops);
     } else
     // finish bracket
     if (token.type == TokenType::BRACKET_CLOSING) {
       bool found = false;
       while (!ops.empty()) {
-        if (ops.top().type == TokenType::BRACKET_OPENING) {
+        if (ops.back().type == TokenType::BRACKET_OPENING) {
           found = true;
-          ops.pop();
+          ops.pop_back();
           break;
         } else {
           // create args
-          output.push_back(ops.top());
-          ops.pop();
+          pop();
         }
       }
       if (!found) {
-        throw MissingBracketError(token.position);
+        return fail(Status(ErrorCode::MISSING_BRACKET, token.position));
       }
-    } else
-    if (token.type == TokenType::UNKNOWN) {
-      throw ParsingError("Unknown token", token.position);
+
+      tokens.pop_front();
+    } else {
+      return fail(Status(ErrorCode::PARSING, token.position, "Unknown token"));
     }
   }
 
   // put remaining
   while (!ops.empty()) {
-    if (ops.top().type == TokenType::BRACKET_OPENING) {
-      throw MissingBracketError(ops.top().position);
+    if (ops.back().type == TokenType::BRACKET_OPENING) {
+      return fail(Status(ErrorCode::MISSING_BRACKET, ops.back().position));
     }
 
-    output.push_back(ops.top());
-    ops.pop();
+    pop();
   }
 
   if (output.empty()) {
-    throw EmptyExpressionError();
+    return fail(Status(ErrorCode::EMPTY_EXPRESSION));
   }
 
   return output;
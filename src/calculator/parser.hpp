@@ -1,8 +1,11 @@
 #include "tokenizer.hpp"
 #include "errors.hpp"
+#include "status.hpp"
 
+#include <array>
 #include <map>
 #include <stack>
+#include <vector>
 
 #pragma once
 
@@ -60,24 +63,21 @@ class Parser {
    * @param tokens List of tokens representing a single expression
    * @return Tokens in RPN
    */
-  virtual TokenList process(TokenList& tokens) const;
+  TokenList process(TokenList& tokens) const;
 
   //! Process r-value reference
   TokenList process(TokenList&& tokens) const { return process(tokens); }
 
-  private:
-
   /**
-   * Compares precedence of two operators. Operator A has lower
-   * precedence than operator B if its precedence is smaller or
-   * equal or striclty smaller in case of right-associative
-   * operator.
+   * Parses list of tokens into RPN like process, but a failure
+   * is reported by the status instead of being thrown. Tokens of
+   * a failed expression are left in the input list.
    *
-   * @param a First token representing operator
-   * @param b Another token representing operator
-   * @return True if a has lower precedence than b
+   * @param tokens List of tokens representing a single expression
+   * @param[out] status Failure of parsing (unchanged on success)
+   * @return Tokens in RPN (empty on failure)
    */
-  bool lower_precedence(Token const& a, Token const& b) const;
+  virtual TokenList process(TokenList& tokens, Status& status) const;
 
   /**
    * Container for operator metadata
@@ -97,8 +97,62 @@ class Parser {
     Operator(int p, int a) : precedence(p), associativity(a) { }
   };
 
+  /**
+   * Finds a registered operator. Operators named by a single
+   * character (all the tokenizer produces) are found in a table
+   * indexed by the character, others by their name.
+   *
+   * @param name Name of operator
+   * @return Metadata of the operator (or null if it is not registered)
+   */
+  Operator const* find_operator(std::string const& name) const {
+    if (name.size() == 1) {
+      unsigned short slot = slots[static_cast<unsigned char>(name[0])];
+      return slot != 0 ? &table[slot - 1] : nullptr;
+    }
+
+    return find_named_operator(name);
+  }
+
+  /**
+   * Compares precedence of two operators. Operator A has lower
+   * precedence than operator B if its precedence is smaller or
+   * equal or striclty smaller in case of right-associative
+   * operator.
+   *
+   * @param a First operator
+   * @param b Another operator
+   * @return True if a has lower precedence than b
+   */
+  static bool lower_precedence(Operator const& a, Operator const& b) {
+    return (a.associativity < 0 && a.precedence <= b.precedence) ||
+           (a.associativity > 0 && a.precedence < b.precedence);
+  }
+
+  private:
+
+  /**
+   * Compares precedence of an operator with a token waiting on
+   * the stack (functions have always the highest precedence).
+   *
+   * @param a First operator
+   * @param b Another token representing operator or function
+   * @return True if a has lower precedence than b
+   */
+  bool lower_precedence(Operator const& a, Token const& b) const;
+
+  //! Finds a registered operator with a name longer than a character
+  Operator const* find_named_operator(std::string const& name) const;
+
   //! Stores registered operators with their metadata
-  std::map<std::string, Operator> operators;
+  std::vector<Operator> table;
+
+  //! Positions in the table (plus one, zero if not registered) of
+  //! operators named by a single character, indexed by the character
+  std::array<unsigned short, 256> slots{};
+
+  //! Positions in the table of operators with longer names
+  std::map<std::string, std::size_t> named;
 };
 
 }
@@ -1,71 +1,351 @@
 #include "polynomial_calculator.hpp"
 #include "functions.hpp"
+#include "errors.hpp"
+#include "trace.hpp"
 
-#include <cmath>
+#include <chrono>
+#include <new>
 
 namespace XX {
 namespace Calculator {
 
-PolynomialCalculator::PolynomialCalculator(Tokenizer& tokenizer, Parser& parser) :
-  tokenizer(tokenizer), parser(parser) {
+#ifdef XXCALC_TRACE
+namespace {
 
-  register_operator("+", 1, -1, Functions::addition);
-  register_operator("-", 1, -1, Functions::subtraction);
-  register_operator("*", 5, -1, Functions::multiplication);
-  register_operator("/", 5, -1, Functions::division);
-  register_operator("^", 10, 1, Functions::exponentiation);
+typedef std::chrono::steady_clock Clock;
 
-  register_constant("x", Value(0, 1));
-  register_constant("pi", Value(M_PI));
-  register_constant("e", Value(M_E));
+//! Records nanoseconds between two points in time
+void record_duration(Trace::Metric metric, Clock::time_point start, Clock::time_point end) {
+  Trace::histogram(metric).record(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+}
+
+}
+#endif
+
+template <typename V>
+BasicPolynomialCalculator<V>::BasicPolynomialCalculator(Tokenizer& tokenizer, Parser& parser) :
+  series_order(0), tokenizer(tokenizer), parser(parser), pratt_parser(parser), direct_compilation(false),
+  cancellation(nullptr) {
+
+  parser.register_operator("+", 1, -1);
+  parser.register_operator("-", 1, -1);
+  parser.register_operator("*", 5, -1);
+  parser.register_operator("/", 5, -1);
+  parser.register_operator("^", 10, 1);
 
-  register_function("log", 2, Functions::log);
-  register_function("log10", 1, Functions::log10);
+  register_constant("x", V(0, 1));
+  register_constant("pi", V(Math<typename V::coefficient_type>::pi()));
+  register_constant("e", V(Math<typename V::coefficient_type>::e()));
 
-  register_function("ans", 0, [&](std::vector<Value> const& args) {
+  set_series_order(0);
+
+  // ans depends on previous calculations, so it is not pure
+  register_function("ans", 0, [&](std::vector<V> const& args) {
     return last_value;
   });
 
-  register_function("bind", 2, [](std::vector<Value> const& args) {
+  register_function("bind", 2, [](std::vector<V> const& args) {
     return args[0](args[1]);
-  });
+  }, BasicFunctions<V>::Scalar::bind, true);
+}
+
+template <typename V>
+void BasicPolynomialCalculator<V>::register_arithmetic() {
+  typedef typename ScalarFunction::Operation Operation;
+
+  register_function("+", 2, BasicFunctions<V>::addition, Operation::ADDITION, true);
+  register_function("-", 2, BasicFunctions<V>::subtraction, Operation::SUBTRACTION, true);
+  register_function("*", 2, BasicFunctions<V>::multiplication, Operation::MULTIPLICATION, true);
+  register_function("/", 2, BasicFunctions<V>::division, Operation::DIVISION, true);
+  register_function("^", 2, BasicFunctions<V>::exponentiation,
+                    ScalarFunction(Operation::EXPONENTIATION, BasicFunctions<V>::Scalar::exponentiation), true);
+
+  register_function("log", 2, BasicFunctions<V>::log, BasicFunctions<V>::Scalar::log, true);
+  register_function("log10", 1, BasicFunctions<V>::log10, BasicFunctions<V>::Scalar::log10, true);
+  register_function("exp", 1, BasicFunctions<V>::exp, BasicFunctions<V>::Scalar::exp, true);
 }
 
-void PolynomialCalculator::register_operator(std::string const& name,
+template <typename V>
+void BasicPolynomialCalculator<V>::set_series_order(unsigned long order) {
+  using namespace std::placeholders;
+
+  series_order = order;
+
+  // series functions have no scalar implementations, as they
+  // differ for constants (ie. log of negative number fails)
+  if (order == 0) {
+    register_arithmetic();
+  } else {
+    register_function("+", 2, std::bind(BasicFunctions<V>::Series::addition, _1, order), ScalarFunction(), true);
+    register_function("-", 2, std::bind(BasicFunctions<V>::Series::subtraction, _1, order), ScalarFunction(), true);
+    register_function("*", 2, std::bind(BasicFunctions<V>::Series::multiplication, _1, order), ScalarFunction(), true);
+    register_function("/", 2, std::bind(BasicFunctions<V>::Series::division, _1, order), ScalarFunction(), true);
+    register_function("^", 2, std::bind(BasicFunctions<V>::Series::exponentiation, _1, order), ScalarFunction(), true);
+
+    register_function("log", 2, std::bind(BasicFunctions<V>::Series::log, _1, order), ScalarFunction(), true);
+    register_function("log10", 1, std::bind(BasicFunctions<V>::Series::log10, _1, order), ScalarFunction(), true);
+    register_function("exp", 1, std::bind(BasicFunctions<V>::Series::exp, _1, order), ScalarFunction(), true);
+  }
+}
+
+template <typename V>
+void BasicPolynomialCalculator<V>::register_operator(std::string const& name,
                                              int precedence, int associativity,
-                                             std::function<Value(std::vector<Value> const&)> f) {
+                                             std::function<V(std::vector<V> const&)> f,
+                                             ScalarFunction scalar, bool pure) {
   parser.register_operator(name, precedence, associativity);
-  register_function(name, 2, f);
+  register_function(name, 2, f, scalar, pure);
+}
+
+template <typename V>
+void BasicPolynomialCalculator<V>::register_function(std::string const& name, unsigned long arity,
+                                             std::function<V(std::vector<V> const&)> f,
+                                             ScalarFunction scalar, bool pure) {
+  evaluator.register_function(name, arity, f, scalar, pure);
+}
+
+template <typename V>
+void BasicPolynomialCalculator<V>::wrap_functions(std::function<typename BasicEvaluator<V>::Handler(std::string const&,
+                                                                   typename BasicEvaluator<V>::Handler)> const& wrap) {
+  evaluator.wrap_functions(wrap);
+}
+
+template <typename V>
+void BasicPolynomialCalculator<V>::set_limits(Limits const& limits, Cancellation const* cancellation) {
+  this->limits = limits;
+  this->cancellation = cancellation;
 }
 
-void PolynomialCalculator::register_function(std::string const& name, unsigned long arity,
-                                             std::function<Value(std::vector<Value> const&)> f) {
-  evaluator.register_function(name, arity, f);
+template <typename V>
+void BasicPolynomialCalculator<V>::set_direct_compilation(bool enabled) {
+  direct_compilation = enabled;
 }
 
-void PolynomialCalculator::register_constant(std::string const& name, Value value) {
+template <typename V>
+void BasicPolynomialCalculator<V>::register_constant(std::string const& name, V value) {
   evaluator.register_constant(name, value);
 }
 
-Value PolynomialCalculator::process(std::string const& line) {
-  TokenList tokens = tokenizer.process(line);
+template <typename V>
+V BasicPolynomialCalculator<V>::process(std::string const& line) {
+  Status status;
+  V result = process(line, status);
+
+  status.raise();
+  return result;
+}
+
+template <typename V>
+V BasicPolynomialCalculator<V>::process(Compiler const& compile) {
+  Status status;
+  V result = process(compile, status);
+
+  status.raise();
+  return result;
+}
+
+template <typename V>
+V BasicPolynomialCalculator<V>::process(std::string const& line, Status& status) {
+  Budget budget(limits, cancellation);
+  Budget::Scope scope(limits.limited() || cancellation != nullptr ? &budget : nullptr);
+
+  // well-formed lines are compiled directly, others are tokenized
+  // and parsed to report their errors
+  if (direct_compilation) {
+    typename BasicEvaluator<V>::Program current;
+    std::swap(current, program);
+
+#ifdef XXCALC_TRACE
+    Clock::time_point start = Clock::now();
+#endif
+
+    bool compiled = pratt_parser.compile(line, evaluator, current);
+
+#ifdef XXCALC_TRACE
+    Clock::time_point parsed = Clock::now();
+    if (compiled)
+      record_duration(Trace::PARSE, start, parsed);
+#endif
+
+    V result;
+    if (compiled)
+      result = evaluator.execute(current, status);
+    std::swap(current, program);
+
+    if (compiled) {
+      if (!status.ok())
+        return result;
+
+      last_value = std::move(result);
+
+#ifdef XXCALC_TRACE
+      record_duration(Trace::EVALUATE, parsed, Clock::now());
+      Trace::histogram(Trace::DEGREE).record(last_value.degree());
+#endif
+
+      return last_value;
+    }
+  }
+
+  TokenList tokens = parse(line, status);
+  if (!status.ok())
+    return V();
+
+#ifdef XXCALC_TRACE
+  Clock::time_point start = Clock::now();
+#endif
+
+  V result = evaluator.process(tokens, status);
+
+  // nodes of tokens are reused by the next expression
+  spare.splice(spare.end(), tokens);
+
+  if (!status.ok())
+    return result;
+
+  last_value = std::move(result);
+
+#ifdef XXCALC_TRACE
+  record_duration(Trace::EVALUATE, start, Clock::now());
+  Trace::histogram(Trace::DEGREE).record(last_value.degree());
+#endif
+
+  return last_value;
+}
+
+template <typename V>
+V BasicPolynomialCalculator<V>::process(Compiler const& compile, Status& status) {
+  Budget budget(limits, cancellation);
+  Budget::Scope scope(limits.limited() || cancellation != nullptr ? &budget : nullptr);
+
+  // memory of previous program is reused, while nested evaluation
+  // (from a function handler) finds it empty and uses its own
+  typename BasicEvaluator<V>::Program current;
+  std::swap(current, program);
+
+#ifdef XXCALC_TRACE
+  Clock::time_point start = Clock::now();
+#endif
+
+  this->compile(compile, current);
+  V result = evaluator.execute(current, status);
+  std::swap(current, program);
+
+  if (!status.ok())
+    return result;
+
+  last_value = std::move(result);
+
+#ifdef XXCALC_TRACE
+  record_duration(Trace::EVALUATE, start, Clock::now());
+  Trace::histogram(Trace::DEGREE).record(last_value.degree());
+#endif
+
+  return last_value;
+}
+
+template <typename V>
+typename BasicPolynomialCalculator<V>::Outcome BasicPolynomialCalculator<V>::try_process(std::string const& line) {
+  Outcome outcome;
+
+  try {
+    outcome.value = process(line, outcome.status);
+  }
+  catch (Error& error) {
+    outcome.status = Status::of(error);
+  }
+  catch (std::bad_alloc&) {
+    // values of the abandoned calculation are freed by now
+    outcome.status = Status(ErrorCode::BUDGET_EXCEEDED, 0, "Not enough memory for the calculation");
+  }
+
+  return outcome;
+}
+
+template <typename V>
+typename BasicPolynomialCalculator<V>::Outcome BasicPolynomialCalculator<V>::try_process(Compiler const& compile) {
+  Outcome outcome;
+
+  try {
+    outcome.value = process(compile, outcome.status);
+  }
+  catch (Error& error) {
+    outcome.status = Status::of(error);
+  }
+  catch (std::bad_alloc&) {
+    outcome.status = Status(ErrorCode::BUDGET_EXCEEDED, 0, "Not enough memory for the calculation");
+  }
+
+  return outcome;
+}
+
+template <typename V>
+TokenList BasicPolynomialCalculator<V>::parse(std::string const& line) {
+  Status status;
+  TokenList tokens = parse(line, status);
+
+  status.raise();
+  return tokens;
+}
+
+template <typename V>
+TokenList BasicPolynomialCalculator<V>::parse(std::string const& line, Status& status) {
+#ifdef XXCALC_TRACE
+  Clock::time_point start = Clock::now();
+#endif
+
+  TokenList tokens = tokenizer.process(line, spare);
+
+#ifdef XXCALC_TRACE
+  Clock::time_point tokenized = Clock::now();
+  record_duration(Trace::TOKENIZE, start, tokenized);
+  Trace::histogram(Trace::TOKENS).record(tokens.size());
+#endif
 
 #ifdef DEBUG
   std::cerr << "Tokenized '" << line << "': " << std::endl;
   std::cerr << tokens << std::endl;
 #endif
 
-  tokens = parser.process(tokens);
+  TokenList rpn = parser.process(tokens, status);
+
+  // nodes of a failed expression are reused as well
+  spare.splice(spare.end(), tokens);
+  tokens.swap(rpn);
+
+#ifdef XXCALC_TRACE
+  record_duration(Trace::PARSE, tokenized, Clock::now());
+#endif
 
 #ifdef DEBUG
   std::cerr << "Parsed '" << line << "': " << std::endl;
   std::cerr << tokens << std::endl;
 #endif
 
-  last_value = evaluator.process(tokens);
+  return tokens;
+}
 
-  return last_value;
+template <typename V>
+void BasicPolynomialCalculator<V>::compile(Compiler const& compile,
+                                           typename BasicEvaluator<V>::Program& program) {
+  compile(evaluator, program);
 }
 
+template <>
+void BasicPolynomialCalculator<ExactValue>::set_series_order(unsigned long order) {
+  if (order > 0)
+    throw ValueError("Power series are not supported with exact arithmetic");
+
+  register_arithmetic();
+}
+
+template class BasicPolynomialCalculator<Value>;
+template class BasicPolynomialCalculator<FloatValue>;
+template class BasicPolynomialCalculator<LongDoubleValue>;
+#ifdef XXCALC_FLOAT128
+template class BasicPolynomialCalculator<Float128Value>;
+#endif
+template class BasicPolynomialCalculator<ExactValue>;
+
 }
 }
@@ -1,6 +1,9 @@
 #include "tokenizer.hpp"
 #include "parser.hpp"
 #include "evaluator.hpp"
+#include "pratt_parser.hpp"
+#include "budget.hpp"
+#include "status.hpp"
 
 #pragma once
 
@@ -15,20 +18,56 @@ namespace Calculator {
  *
  * Operations such as addition, subtraction, multiplication,
  * division and exponentiation are supported by default.
- * Constants pi and e are defined, functions log(value, base)
- * and log10(value) are supported, but only for constant
- * polynomials (double values). Additionally a function ans
- * is defined and it return value of previous evaluation.
+ * Constants pi and e are defined, functions log(value, base),
+ * log10(value) and exp(value) are supported, but only for
+ * constant polynomials (double values). Additionally a function
+ * ans is defined and it return value of previous evaluation.
+ *
+ * Optionally the calculator can work on power series truncated
+ * at given order, then division, logarithms, exponential function
+ * and fractional powers are available for non constant values.
  *
  * The functionality can be easily extended by registration
  * of new operators, functions and constants. If depending
  * on used tokenizer and parser, variety of input forms can
  * be used (though only popular infix form is implemented a
  * part of the project).
+ *
+ * The calculator is parameterized with a type of values it
+ * operates on - PolynomialCalculator uses double coefficients
+ * (Value), while BasicPolynomialCalculator<ExactValue> computes
+ * with exact rational coefficients.
+ *
+ * Memory of short lived objects of a calculation - nodes of tokens,
+ * the compiled program and stacks of evaluation - is kept by the
+ * calculator (and its evaluator) and reused by following
+ * calculations, so a calculator used by a single thread mostly
+ * allocates only values. Only the result outlives a calculation.
  */
-class PolynomialCalculator {
+template <typename V>
+class BasicPolynomialCalculator {
   public:
 
+  //! Scalar implementation of a function (see BasicEvaluator)
+  typedef typename BasicEvaluator<V>::ScalarFunction ScalarFunction;
+
+  //! Compiles a program for the evaluator (see process)
+  typedef std::function<void(BasicEvaluator<V>& evaluator,
+                             typename BasicEvaluator<V>::Program& program)> Compiler;
+
+  /**
+   * Value or failure of a calculation (see try_process)
+   */
+  struct Outcome {
+    //! Computed polynomial (empty on failure)
+    V value;
+    //! Failure of the calculation
+    Status status;
+
+    //! True if the calculation succeeded
+    bool ok() const { return status.ok(); }
+  };
+
   /**
    * Creates an instance of the calculator. It is created
    * with support of addition (+), subtraction (-),
@@ -46,7 +85,9 @@ class PolynomialCalculator {
    * @param parser Instance of parser processing tokenized
    *               expression
    */
-  PolynomialCalculator(Tokenizer& tokenizer, Parser& parser);
+  BasicPolynomialCalculator(Tokenizer& tokenizer, Parser& parser);
+
+  virtual ~BasicPolynomialCalculator() { }
 
   /**
    * Processes the input expression and returns its computed
@@ -61,7 +102,128 @@ class PolynomialCalculator {
    *             on used tokenizer and parser)
    * @return Computed polynomial
    */
-  Value process(std::string const& line);
+  V process(std::string const& line);
+
+  /**
+   * Evaluates a program compiled by given function instead of
+   * a line of text (ie. linked from a BasicImage). Result of
+   * computation is stored as last_value as well.
+   *
+   * @param compile Compiles the program using the evaluator
+   * @return Computed polynomial
+   */
+  V process(Compiler const& compile);
+
+  /**
+   * Processes the input expression like process, but failures of
+   * parsing, of evaluation and of functions reporting them (see
+   * BasicEvaluator::fail) are returned by the status - so no
+   * exception is thrown and no message is built for them. Errors
+   * thrown by values (ie. division of polynomials) are passed.
+   * Last value is kept on failure.
+   *
+   * @param line Expression to be processed
+   * @param[out] status Failure of the calculation (unchanged on success)
+   * @return Computed polynomial (empty on failure)
+   */
+  virtual V process(std::string const& line, Status& status);
+
+  /**
+   * Evaluates a compiled program like process, but failures are
+   * returned by the status.
+   *
+   * @param compile Compiles the program using the evaluator
+   * @param[out] status Failure of the calculation (unchanged on success)
+   * @return Computed polynomial (empty on failure)
+   */
+  virtual V process(Compiler const& compile, Status& status);
+
+  /**
+   * Processes the input expression and never throws. Errors thrown
+   * during the calculation are caught and returned as a failure,
+   * others are returned without throwing at all. Running out of
+   * memory fails the calculation as if its budget was exceeded.
+   *
+   * @param line Expression to be processed
+   * @return Computed polynomial or failure
+   */
+  Outcome try_process(std::string const& line);
+
+  /**
+   * Evaluates a compiled program and never throws (see try_process).
+   *
+   * @param compile Compiles the program using the evaluator
+   * @return Computed polynomial or failure
+   */
+  Outcome try_process(Compiler const& compile);
+
+  /**
+   * Tokenizes and parses the input expression without evaluating
+   * it (if DEBUG macro symbol is defined, tokens are printed).
+   *
+   * @param line Expression to be parsed
+   * @return Tokens in RPN form
+   */
+  TokenList parse(std::string const& line);
+
+  /**
+   * Tokenizes and parses the input expression, failure of parsing
+   * is returned by the status.
+   *
+   * @param line Expression to be parsed
+   * @param[out] status Failure of parsing (unchanged on success)
+   * @return Tokens in RPN form (empty on failure)
+   */
+  TokenList parse(std::string const& line, Status& status);
+
+  /**
+   * Compiles a program by given function without evaluating it,
+   * so it can be executed elsewhere (ie. by BasicColumnProgram).
+   * The program refers to functions of the calculator and it is
+   * valid until they are registered again.
+   *
+   * @param compile Compiles the program using the evaluator
+   * @param[out] program Compiled program
+   */
+  void compile(Compiler const& compile, typename BasicEvaluator<V>::Program& program);
+
+  /**
+   * Switches between polynomial and power series arithmetic.
+   * With non zero order every value is treated as a power
+   * series truncated to first order coefficients - built-in
+   * operators, log, log10 and exp functions are replaced with
+   * their series counterparts (see Functions::Series), so for
+   * example 1/(1-x) or exp(x) can be expanded. Zero order
+   * restores plain polynomial arithmetic.
+   *
+   * @throw ValueError When series are not supported by the
+   *        type of values
+   * @param order Number of series coefficients to keep (or zero)
+   */
+  void set_series_order(unsigned long order);
+
+  /**
+   * Limits resources of every following calculation (see Budget).
+   * A calculation exceeding a limit fails with BudgetExceededError,
+   * as well as a calculation watching a cancelled token.
+   *
+   * @param limits Limits of a single calculation
+   * @param cancellation Token watched by calculations (or null), it
+   *                     must outlive them
+   */
+  void set_limits(Limits const& limits, Cancellation const* cancellation = nullptr);
+
+  /**
+   * Switches compilation of lines directly from their text (see
+   * BasicPrattParser), instead of tokenizing and parsing them
+   * first. Results and errors are the same, as long as the
+   * tokenizer and the parser are the basic ones (the tokenizer is
+   * not used for well-formed lines then). It is disabled by
+   * default.
+   *
+   * @param enabled True to compile lines directly
+   */
+  void set_direct_compilation(bool enabled);
 
   /**
    * Registers new operator. The operator is registered with
@@ -75,9 +237,13 @@ class PolynomialCalculator {
    * @param precedence Priority of operator
    * @param associativity Direction of associativity
    * @param f Handler for the operator (always takes two args)
+   * @param scalar Optional implementation for constant operands
+   * @param pure True if the operator has no side effects (see
+   *             BasicEvaluator::register_function)
    */
   void register_operator(std::string const& name, int precedence, int associativity,
-                         std::function<Value(std::vector<Value> const&)> f);
+                         std::function<V(std::vector<V> const&)> f,
+                         ScalarFunction scalar = ScalarFunction(), bool pure = false);
 
   /**
    * Registers new function. The functions is registered with
@@ -90,9 +256,23 @@ class PolynomialCalculator {
    * @param name Name of function
    * @param arity Number of arguments
    * @param f Handler for the function
+   * @param scalar Optional implementation for constant arguments
+   * @param pure True if the function has no side effects (see
+   *             BasicEvaluator::register_function)
    */
   void register_function(std::string const& name, unsigned long arity,
-                         std::function<Value(std::vector<Value> const&)> f);
+                         std::function<V(std::vector<V> const&)> f,
+                         ScalarFunction scalar = ScalarFunction(), bool pure = false);
+
+  /**
+   * Replaces handlers of every registered function, see
+   * BasicEvaluator::wrap_functions. Functions registered later
+   * (ie. by set_series_order) are not wrapped.
+   *
+   * @param wrap Makes new handler from name of a function and its handler
+   */
+  void wrap_functions(std::function<typename BasicEvaluator<V>::Handler(std::string const&,
+                                                                        typename BasicEvaluator<V>::Handler)> const& wrap);
 
   /**
    * Registers new constant. The evaluator replaces identifier matching
@@ -101,12 +281,28 @@ class PolynomialCalculator {
    * @param name Name of constant
    * @param value Value of constant
    */
-  void register_constant(std::string const& name, Value value);
+  void register_constant(std::string const& name, V value);
 
   /**
    * Result of last evaluation.
    */
-  Value last_value;
+  V last_value;
+
+  /**
+   * Order of power series arithmetic, zero when plain polynomial
+   * arithmetic is used.
+   */
+  unsigned long series_order;
+
+  protected:
+
+  /**
+   * Reports failure of a function without throwing, see
+   * BasicEvaluator::fail.
+   *
+   * @param status Failure of the function
+   */
+  void fail(Status const& status) { evaluator.fail(status); }
 
   private:
 
@@ -117,8 +313,38 @@ class PolynomialCalculator {
   Parser& parser;
 
   //! Evaluator of parsed tokens
-  Evaluator evaluator;
+  BasicEvaluator<V> evaluator;
+
+  //! Compiles lines directly
+  BasicPrattParser<V> pratt_parser;
+
+  //! True if lines are compiled directly
+  bool direct_compilation;
+
+  //! Nodes of tokens of previous expressions, reused by the tokenizer
+  TokenList spare;
+
+  //! Compiled program reused between evaluations
+  typename BasicEvaluator<V>::Program program;
+
+  //! Limits of a calculation
+  Limits limits;
+
+  //! Token watched by calculations (or null)
+  Cancellation const* cancellation;
+
+  //! Registers built-in polynomial arithmetic and functions
+  void register_arithmetic();
 };
 
+//! Power series are not available for exact values
+template <>
+void BasicPolynomialCalculator<ExactValue>::set_series_order(unsigned long order);
+
+/**
+ * Polynomial calculator operating on double coefficients
+ */
+typedef BasicPolynomialCalculator<Value> PolynomialCalculator;
+
 }
 }
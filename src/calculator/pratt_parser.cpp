@@ -0,0 +1,158 @@
+#include "pratt_parser.hpp"
+
+namespace XX {
+namespace Calculator {
+
+template <typename V>
+bool BasicPrattParser<V>::compile(std::string const& line, BasicEvaluator<V>& evaluator, Program& program) {
+  this->evaluator = &evaluator;
+  this->program = &program;
+  compiling = true;
+  after_number = false;
+
+  program.clear();
+  scanner.reset(line);
+
+  // empty expression is reported by the parser
+  if (scanner.at_end())
+    return false;
+
+  if (!expression(nullptr, 0) || !scanner.at_end())
+    return false;
+
+  evaluator.finish(program);
+  return true;
+}
+
+template <typename V>
+bool BasicPrattParser<V>::expression(Parser::Operator const* level, unsigned depth) {
+  if (depth > max_depth || !primary(depth))
+    return false;
+
+  while (!scanner.at_end()) {
+    Scanner::Lexeme const& token = scanner.peek();
+
+    // number followed by an identifier or a bracket is multiplied
+    bool implicit = after_number &&
+                    (token.type == TokenType::IDENTIFIER || token.type == TokenType::BRACKET_OPENING);
+
+    if (!implicit && token.type != TokenType::OPERATOR)
+      return true;
+
+    std::string name = implicit ? std::string(1, '*') : std::string(token.text, token.length);
+    unsigned long position = token.position;
+
+    // unknown operators are reported by the parser, operators without
+    // associativity are parsed only by it
+    Parser::Operator const* current = parser.find_operator(name);
+    if (current == nullptr || current->associativity == 0)
+      return false;
+
+    // operator of the level is complete
+    if (level != nullptr && Parser::lower_precedence(*current, *level))
+      return true;
+
+    if (!implicit)
+      scanner.next();
+    after_number = false;
+
+    if (!expression(current, depth + 1))
+      return false;
+
+    symbol(name, position);
+  }
+
+  return true;
+}
+
+template <typename V>
+bool BasicPrattParser<V>::primary(unsigned depth) {
+  if (scanner.at_end())
+    return false;
+
+  Scanner::Lexeme const& token = scanner.peek();
+
+  if (token.type == TokenType::NUMBER) {
+    if (compiling) {
+      text.clear();
+      if (token.sign != 0)
+        text += token.sign;
+      text.append(token.text, token.length);
+
+      evaluator->compile_literal(text, token.position, *program);
+    }
+
+    scanner.next();
+    after_number = true;
+    return true;
+  }
+
+  after_number = false;
+
+  if (token.type == TokenType::IDENTIFIER) {
+    std::string name(token.text, token.length);
+    unsigned long position = token.position;
+    scanner.next();
+
+    // a symbol, unless brackets follow
+    if (scanner.at_end() || scanner.peek().type != TokenType::BRACKET_OPENING) {
+      symbol(name, position);
+      return true;
+    }
+
+    scanner.next();
+
+    // arguments are compiled before the function
+    if (!scanner.at_end() && scanner.peek().type == TokenType::BRACKET_CLOSING) {
+      scanner.next();
+    } else {
+      while (true) {
+        if (!expression(nullptr, depth + 1) || scanner.at_end())
+          return false;
+
+        TokenType type = scanner.peek().type;
+        scanner.next();
+
+        if (type == TokenType::BRACKET_CLOSING)
+          break;
+        if (type != TokenType::SEPARATOR)
+          return false;
+      }
+    }
+
+    after_number = false;
+    symbol(name, position);
+    return true;
+  }
+
+  if (token.type == TokenType::BRACKET_OPENING) {
+    scanner.next();
+
+    if (!expression(nullptr, depth + 1) ||
+        scanner.at_end() || scanner.peek().type != TokenType::BRACKET_CLOSING)
+      return false;
+
+    scanner.next();
+    after_number = false;
+    return true;
+  }
+
+  return false;
+}
+
+template <typename V>
+void BasicPrattParser<V>::symbol(std::string const& name, unsigned long position) {
+  if (compiling && !evaluator->compile_symbol(name, position, *program))
+    compiling = false;
+}
+
+template class BasicPrattParser<Value>;
+template class BasicPrattParser<FloatValue>;
+template class BasicPrattParser<LongDoubleValue>;
+#ifdef XXCALC_FLOAT128
+template class BasicPrattParser<Float128Value>;
+#endif
+template class BasicPrattParser<ExactValue>;
+
+}
+}
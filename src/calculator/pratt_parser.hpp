@@ -0,0 +1,113 @@
+#include <string>
+
+#include "tokenizer.hpp"
+#include "parser.hpp"
+#include "evaluator.hpp"
+
+#pragma once
+
+namespace XX {
+namespace Calculator {
+
+/**
+ * Pratt parser compiles a line of text directly into a program of
+ * an evaluator, in a single pass - tokens are pulled one at a time
+ * from a Scanner and every number, constant, function and operator
+ * is compiled as soon as its place in RPN is known. No list of
+ * tokens is built, nothing is rewritten and no text is copied
+ * (except of names looked up in the evaluator).
+ *
+ * Operators are those registered with the parser, compared exactly
+ * as Parser compares them - every level of recursion stands for an
+ * operator which shunting-yard would keep on its stack, so both
+ * produce the same RPN. Implicit multiplication (a number followed
+ * by an identifier or a bracket) and signs are the same as well.
+ *
+ * Only well-formed expressions are compiled. Anything else (ie.
+ * unbalanced brackets, missing operands, unknown tokens) is left
+ * to Tokenizer and Parser, so errors and their positions are the
+ * same as before.
+ */
+template <typename V>
+class BasicPrattParser {
+  public:
+
+  //! Program of an evaluator
+  typedef typename BasicEvaluator<V>::Program Program;
+
+  /**
+   * Creates parser using operators of given parser.
+   *
+   * @param parser Parser with registered operators
+   */
+  explicit BasicPrattParser(Parser const& parser) : parser(parser) { }
+
+  /**
+   * Compiles a line into a program of the evaluator, the same as
+   * compiling tokens parsed by Tokenizer and Parser would.
+   *
+   * @param line Text expression
+   * @param evaluator Evaluator resolving symbols
+   * @param[out] program Compiled program (its previous content is
+   *                     discarded)
+   * @return False if the line is not a well-formed expression
+   *         (then the program is not finished)
+   */
+  bool compile(std::string const& line, BasicEvaluator<V>& evaluator, Program& program);
+
+  private:
+
+  /**
+   * Compiles an expression, until an operator of lower precedence
+   * than the one of the level is found.
+   *
+   * @param level Operator waiting for its right operand (or null)
+   * @param depth Depth of recursion
+   * @return False if the expression is not well-formed
+   */
+  bool expression(Parser::Operator const* level, unsigned depth);
+
+  /**
+   * Compiles a number, a symbol, a call of a function or an
+   * expression in brackets.
+   *
+   * @param depth Depth of recursion
+   * @return False if the expression is not well-formed
+   */
+  bool primary(unsigned depth);
+
+  //! Compiles a constant, a function or an operator
+  void symbol(std::string const& name, unsigned long position);
+
+  //! Deepest recursion, deeper expressions are left to Parser
+  static const unsigned max_depth = 1000;
+
+  //! Parser with registered operators
+  Parser const& parser;
+
+  //! Tokens of the line
+  Scanner scanner;
+
+  //! Evaluator resolving symbols
+  BasicEvaluator<V>* evaluator;
+
+  //! Compiled program
+  Program* program;
+
+  //! False after a failing symbol, nothing is compiled after it
+  bool compiling;
+
+  //! True if the previous token was a number (for implicit multiplication)
+  bool after_number;
+
+  //! Text of a number
+  std::string text;
+};
+
+/**
+ * Pratt parser of polynomials with double coefficients
+ */
+typedef BasicPrattParser<Value> PrattParser;
+
+}
+}
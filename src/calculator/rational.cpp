@@ -0,0 +1,365 @@
+#include "rational.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace XX {
+namespace Calculator {
+
+namespace {
+
+//! Largest accepted decimal exponent of parsed numbers
+const long max_exponent = 100000;
+
+/**
+ * Computes root of a natural number with Newton method, starting
+ * from a power of two not smaller than the root (so the iteration
+ * decreases monotonically to the floor of the root).
+ *
+ * @return True if the root is exact
+ */
+bool natural_root(Integer const& value, unsigned long degree, Integer& result) {
+  if (value.is_zero() || value == Integer(1) || degree == 1) {
+    result = value;
+    return true;
+  }
+
+  // 2^degree is already larger than value
+  if (degree >= value.bits())
+    return false;
+
+  Integer root = Integer(1) << ((value.bits() + degree - 1) / degree);
+  while (true) {
+    Integer power(1);
+    for (unsigned long i = 1; i < degree; i++)
+      power *= root;
+
+    Integer next = (Integer((long long)degree - 1) * root + value / power) / Integer((long long)degree);
+    if (next >= root)
+      break;
+    root = next;
+  }
+
+  Integer power(1);
+  for (unsigned long i = 0; i < degree; i++)
+    power *= root;
+  if (power != value)
+    return false;
+
+  result = root;
+  return true;
+}
+
+/**
+ * Computes power of ten.
+ */
+Integer power_of_ten(unsigned long exponent) {
+  Integer result(1), base(10);
+
+  for (; exponent > 0; exponent >>= 1) {
+    if (exponent & 1)
+      result *= base;
+    if (exponent > 1)
+      base *= base;
+  }
+
+  return result;
+}
+
+}
+
+Rational::Rational(Integer const& numerator, Integer const& denominator) :
+  num(numerator), den(denominator) {
+  normalize();
+}
+
+Rational Rational::from_double(double value) {
+  if (std::isnan(value))
+    return Rational(0, 0);
+
+  if (std::isinf(value))
+    return Rational(value > 0 ? 1 : -1, 0);
+
+  // value = mantissa * 2^exponent with integer mantissa
+  int exponent;
+  Integer mantissa(static_cast<long long>(std::ldexp(std::frexp(value, &exponent), 53)));
+  exponent -= 53;
+
+  if (exponent >= 0)
+    return Rational(mantissa << exponent);
+  else
+    return Rational(mantissa, Integer(1) << -exponent);
+}
+
+Rational Rational::parse(std::string const& text) {
+  unsigned long position = 0;
+  bool negative = false;
+
+  if (position < text.size() && (text[position] == '-' || text[position] == '+')) {
+    negative = text[position] == '-';
+    position++;
+  }
+
+  // special values
+  const char* rest = text.c_str() + position;
+  if (strcasecmp(rest, "inf") == 0 || strcasecmp(rest, "infinity") == 0)
+    return Rational(negative ? -1 : 1, 0);
+  if (strcasecmp(rest, "nan") == 0)
+    return Rational(0, 0);
+
+  // digits of mantissa (without decimal dot)
+  std::string digits;
+  long exponent = 0;
+
+  while (position < text.size() && std::isdigit(text[position]))
+    digits += text[position++];
+
+  if (position < text.size() && text[position] == '.') {
+    position++;
+
+    while (position < text.size() && std::isdigit(text[position])) {
+      digits += text[position++];
+      exponent--;
+    }
+  }
+
+  if (digits.empty())
+    throw std::invalid_argument("Rational::parse");
+
+  // optional decimal exponent (ignored if malformed, like std::stod does)
+  if (position + 1 < text.size() && (text[position] == 'e' || text[position] == 'E')) {
+    unsigned long current = position + 1;
+    bool exponent_negative = false;
+
+    if (text[current] == '-' || text[current] == '+') {
+      exponent_negative = text[current] == '-';
+      current++;
+    }
+
+    if (current < text.size() && std::isdigit(text[current])) {
+      long value = 0;
+
+      while (current < text.size() && std::isdigit(text[current])) {
+        if (value > max_exponent)
+          throw std::out_of_range("Rational::parse");
+
+        value = value * 10 + (text[current++] - '0');
+      }
+
+      exponent += exponent_negative ? -value : value;
+    }
+  }
+
+  if (exponent > max_exponent || exponent < -max_exponent)
+    throw std::out_of_range("Rational::parse");
+
+  Integer mantissa = Integer::parse(digits);
+  if (negative)
+    mantissa = -mantissa;
+
+  if (exponent >= 0)
+    return Rational(mantissa * power_of_ten(exponent));
+  else
+    return Rational(mantissa, power_of_ten(-exponent));
+}
+
+Rational::operator double() const {
+  if (is_nan())
+    return std::nan("");
+
+  if (is_infinite())
+    return num.sign() * std::numeric_limits<double>::infinity();
+
+  unsigned long num_bits = num.bits();
+  unsigned long den_bits = den.bits();
+
+  // exact conversion of both parts, single rounding
+  if (num_bits <= 53 && den_bits <= 53)
+    return double(num) / double(den);
+
+  // scale the fraction, so the quotient has 64 significant bits
+  long shift = 64 - (long(num_bits) - long(den_bits));
+  Integer scaled = num.abs();
+
+  if (shift > 0)
+    scaled <<= shift;
+
+  Integer quotient, remainder;
+  Integer::divide(scaled, shift < 0 ? den << -shift : den, quotient, remainder);
+
+  // keep remaining bits as a sticky bit for correct rounding
+  if (!remainder.is_zero())
+    quotient = (quotient << 1) + Integer(1);
+  else
+    quotient <<= 1;
+
+  double result = std::ldexp(double(quotient), -shift - 1);
+  return num.sign() < 0 ? -result : result;
+}
+
+bool Rational::is_integer() const {
+  return den == Integer(1);
+}
+
+Rational Rational::power(long long exponent) const {
+  Rational result(1), base = exponent < 0 ? Rational(1) / *this : *this;
+  unsigned long long e = exponent < 0 ? 0ull - static_cast<unsigned long long>(exponent) : exponent;
+
+  for (; e > 0; e >>= 1) {
+    if (e & 1)
+      result *= base;
+    if (e > 1)
+      base *= base;
+  }
+
+  return result;
+}
+
+bool Rational::root(unsigned long degree, Rational& result) const {
+  if (degree == 0 || !is_finite() || (num.sign() < 0 && degree % 2 == 0))
+    return false;
+
+  Integer num_root, den_root;
+  if (!natural_root(num.abs(), degree, num_root) || !natural_root(den, degree, den_root))
+    return false;
+
+  result = Rational(num.sign() < 0 ? -num_root : num_root, den_root);
+  return true;
+}
+
+const Rational Rational::operator-() const {
+  Rational result(*this);
+  result.num = -result.num;
+  return result;
+}
+
+Rational& Rational::operator+=(Rational const& other) {
+  if (!is_finite() || !other.is_finite()) {
+    if (is_nan() || other.is_nan() ||
+        (is_infinite() && other.is_infinite() && num != other.num)) {
+      num = 0;
+    } else
+    if (other.is_infinite()) {
+      num = other.num;
+    }
+    den = 0;
+    return *this;
+  }
+
+  if (is_integer() && other.is_integer()) {
+    num += other.num;
+    return *this;
+  }
+
+  num = num * other.den + other.num * den;
+  den *= other.den;
+  normalize();
+
+  return *this;
+}
+
+Rational& Rational::operator-=(Rational const& other) {
+  return *this += -other;
+}
+
+Rational& Rational::operator*=(Rational const& other) {
+  if (!is_finite() || !other.is_finite()) {
+    num = Integer(num.sign() * other.num.sign());
+    den = 0;
+    return *this;
+  }
+
+  num *= other.num;
+
+  if (!other.is_integer() || !is_integer()) {
+    den *= other.den;
+    normalize();
+  }
+
+  return *this;
+}
+
+Rational& Rational::operator/=(Rational const& other) {
+  if (other.is_infinite() && is_finite()) {
+    num = 0;
+    den = 1;
+    return *this;
+  }
+
+  if (!is_finite() || !other.is_finite()) {
+    num = other.is_nan() || is_nan() ? 0 : num.sign() * other.num.sign();
+    den = 0;
+    return *this;
+  }
+
+  // division by zero gives signed infinity (or NaN for 0/0)
+  if (other.num.is_zero()) {
+    num = num.sign();
+    den = 0;
+    return *this;
+  }
+
+  num *= other.den;
+  den *= other.num;
+  normalize();
+
+  return *this;
+}
+
+bool Rational::operator==(Rational const& other) const {
+  return !is_nan() && !other.is_nan() && num == other.num && den == other.den;
+}
+
+bool Rational::operator<(Rational const& other) const {
+  if (is_nan() || other.is_nan())
+    return false;
+
+  if (!is_finite() || !other.is_finite()) {
+    int a = is_finite() ? 0 : num.sign();
+    int b = other.is_finite() ? 0 : other.num.sign();
+    return a < b;
+  }
+
+  return num * other.den < other.num * den;
+}
+
+void Rational::normalize() {
+  if (den.is_zero()) {
+    num = num.sign();
+    return;
+  }
+
+  if (den.sign() < 0) {
+    num = -num;
+    den = -den;
+  }
+
+  if (den == Integer(1))
+    return;
+
+  Integer divisor = Integer::gcd(num, den);
+  if (divisor != Integer(1)) {
+    num /= divisor;
+    den /= divisor;
+  }
+}
+
+std::ostream& operator<<(std::ostream& os, Rational const& r) {
+  if (r.is_nan())
+    return os << "nan";
+
+  if (r.is_infinite())
+    return os << (r.numerator().sign() < 0 ? "-inf" : "inf");
+
+  os << r.numerator();
+
+  if (!r.is_integer())
+    os << '/' << r.denominator();
+
+  return os;
+}
+
+}
+}
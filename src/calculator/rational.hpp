@@ -0,0 +1,169 @@
+#include "integer.hpp"
+
+#pragma once
+
+namespace XX {
+namespace Calculator {
+
+/**
+ * Exact rational number - a fraction of two arbitrary precision
+ * integers. A fraction is always kept normalized, the denominator
+ * is positive and coprime with the numerator.
+ *
+ * To behave like double values in the calculator, the rational
+ * is extended with infinities and not-a-number (stored with
+ * zero denominator). Division by zero results in an infinity,
+ * while undefined operations (like 0/0 or inf-inf) result in
+ * not-a-number, which is not equal to anything.
+ */
+class Rational {
+  public:
+
+  /**
+   * Creates zero
+   */
+  Rational() : num(0), den(1) { }
+
+  /**
+   * Creates rational equal to an integer.
+   *
+   * @param value Integer value
+   */
+  Rational(long long value) : num(value), den(1) { }
+
+  /**
+   * Creates rational equal to an integer.
+   *
+   * @param value Integer value
+   */
+  Rational(Integer const& value) : num(value), den(1) { }
+
+  /**
+   * Creates a fraction, which is normalized. Zero denominator
+   * creates an infinity (or not-a-number for zero numerator).
+   *
+   * @param numerator Numerator
+   * @param denominator Denominator
+   */
+  Rational(Integer const& numerator, Integer const& denominator);
+
+  /**
+   * Creates rational with exactly the same value as given
+   * double (every finite double is a dyadic fraction).
+   *
+   * @param value Double value
+   * @return Equal rational
+   */
+  static Rational from_double(double value);
+
+  /**
+   * Parses decimal representation of a number, including
+   * fractional part and scientific notation (ie. 0.25 is
+   * exactly 1/4). Infinity and NaN are recognized as well.
+   *
+   * @throw std::invalid_argument When text is not a number
+   * @throw std::out_of_range When exponent is too large
+   * @param text Decimal number
+   * @return Parsed number
+   */
+  static Rational parse(std::string const& text);
+
+  //! Numerator (sign of the number)
+  Integer const& numerator() const { return num; }
+
+  //! Denominator (positive, zero for non finite numbers)
+  Integer const& denominator() const { return den; }
+
+  /**
+   * Converts to the nearest double value.
+   *
+   * @return Double value
+   */
+  explicit operator double() const;
+
+  //! Checks if the number is an integer
+  bool is_integer() const;
+
+  //! Checks if the number is finite
+  bool is_finite() const { return !den.is_zero(); }
+
+  //! Checks if the number is not-a-number
+  bool is_nan() const { return den.is_zero() && num.is_zero(); }
+
+  //! Checks if the number is an infinity
+  bool is_infinite() const { return den.is_zero() && !num.is_zero(); }
+
+  /**
+   * Computes integer power of the number using repeated
+   * squaring.
+   *
+   * @param exponent Integer exponent (negative inverts number)
+   * @return Powered number
+   */
+  Rational power(long long exponent) const;
+
+  /**
+   * Computes exact root of the number, if there is one. Both
+   * the numerator and the denominator have to be perfect powers,
+   * otherwise the root is irrational.
+   *
+   * @param degree Degree of the root (positive)
+   * @param result Root, set only if it is rational
+   * @return True if the root is rational
+   */
+  bool root(unsigned long degree, Rational& result) const;
+
+  //! Negation
+  const Rational operator-() const;
+
+  Rational& operator+=(Rational const& other);
+  Rational& operator-=(Rational const& other);
+  Rational& operator*=(Rational const& other);
+  Rational& operator/=(Rational const& other);
+
+  const Rational operator+(Rational const& other) const { return Rational(*this) += other; }
+  const Rational operator-(Rational const& other) const { return Rational(*this) -= other; }
+  const Rational operator*(Rational const& other) const { return Rational(*this) *= other; }
+  const Rational operator/(Rational const& other) const { return Rational(*this) /= other; }
+
+  /**
+   * Compares numbers, not-a-number is not equal to anything
+   * (including itself).
+   */
+  bool operator==(Rational const& other) const;
+  bool operator!=(Rational const& other) const { return !(*this == other); }
+  bool operator<(Rational const& other) const;
+  bool operator>(Rational const& other) const { return other < *this; }
+  bool operator<=(Rational const& other) const { return *this < other || *this == other; }
+  bool operator>=(Rational const& other) const { return other < *this || *this == other; }
+
+  private:
+
+  //! Numerator
+  Integer num;
+
+  //! Denominator
+  Integer den;
+
+  //! Brings fraction to canonical form
+  void normalize();
+};
+
+//! Checks if the number is an infinity
+inline bool isinf(Rational const& r) { return r.is_infinite(); }
+
+//! Checks if the number is not-a-number
+inline bool isnan(Rational const& r) { return r.is_nan(); }
+
+/**
+ * Pretty printer for a rational. Integers are printed as they
+ * are, other numbers as a fraction p/q.
+ *
+ * @param os Output stream
+ * @param r Rational to print
+ * @return Stream with rational
+ */
+std::ostream& operator<<(std::ostream& os, Rational const& r);
+
+}
+}
@@ -0,0 +1,205 @@
+#include "status.hpp"
+
+namespace XX {
+namespace Calculator {
+
+Status Status::of(Error const& error) {
+  Status status(ErrorCode::ERROR);
+  status.text = error.what();
+
+  // the most specific class is checked first
+  if (dynamic_cast<EmptyExpressionError const*>(&error))
+    status.code = ErrorCode::EMPTY_EXPRESSION;
+  else if (dynamic_cast<UnknownOperatorError const*>(&error))
+    status.code = ErrorCode::UNKNOWN_OPERATOR;
+  else if (dynamic_cast<MissingBracketError const*>(&error))
+    status.code = ErrorCode::MISSING_BRACKET;
+  else if (dynamic_cast<ParsingError const*>(&error))
+    status.code = ErrorCode::PARSING;
+  else if (dynamic_cast<PolynomialCastError const*>(&error))
+    status.code = ErrorCode::POLYNOMIAL_CAST;
+  else if (dynamic_cast<PolynomialDivisionError const*>(&error))
+    status.code = ErrorCode::POLYNOMIAL_DIVISION;
+  else if (dynamic_cast<SeriesExpansionError const*>(&error))
+    status.code = ErrorCode::SERIES_EXPANSION;
+  else if (dynamic_cast<ValueError const*>(&error))
+    status.code = ErrorCode::VALUE;
+  else if (dynamic_cast<ConflictingNameError const*>(&error))
+    status.code = ErrorCode::CONFLICTING_NAME;
+  else if (dynamic_cast<ExponentationError const*>(&error))
+    status.code = ErrorCode::EXPONENTATION;
+  else if (dynamic_cast<UnknownSymbolError const*>(&error))
+    status.code = ErrorCode::UNKNOWN_SYMBOL;
+  else if (dynamic_cast<ArgumentMissingError const*>(&error))
+    status.code = ErrorCode::ARGUMENT_MISSING;
+  else if (dynamic_cast<InvalidNumberError const*>(&error))
+    status.code = ErrorCode::INVALID_NUMBER;
+  else if (dynamic_cast<BudgetExceededError const*>(&error))
+    status.code = ErrorCode::BUDGET_EXCEEDED;
+  else if (dynamic_cast<NonLinearEquation const*>(&error))
+    status.code = ErrorCode::NON_LINEAR_EQUATION;
+  else if (dynamic_cast<NoSymbolFound const*>(&error))
+    status.code = ErrorCode::NO_SYMBOL_FOUND;
+  else if (dynamic_cast<ExpressionIsTautology const*>(&error))
+    status.code = ErrorCode::TAUTOLOGY;
+  else if (dynamic_cast<NonSolvableExpression const*>(&error))
+    status.code = ErrorCode::NON_SOLVABLE;
+  else if (dynamic_cast<SolverError const*>(&error))
+    status.code = ErrorCode::SOLVER;
+  else if (dynamic_cast<EvaluationError const*>(&error))
+    status.code = ErrorCode::EVALUATION;
+
+  return status;
+}
+
+char const* Status::name() const {
+  switch (code) {
+    case ErrorCode::NONE: return "OK";
+    case ErrorCode::EMPTY_EXPRESSION: return "EMPTY_EXPRESSION";
+    case ErrorCode::UNKNOWN_OPERATOR: return "UNKNOWN_OPERATOR";
+    case ErrorCode::MISSING_BRACKET: return "MISSING_BRACKET";
+    case ErrorCode::PARSING: return "PARSING";
+    case ErrorCode::POLYNOMIAL_CAST: return "POLYNOMIAL_CAST";
+    case ErrorCode::POLYNOMIAL_DIVISION: return "POLYNOMIAL_DIVISION";
+    case ErrorCode::SERIES_EXPANSION: return "SERIES_EXPANSION";
+    case ErrorCode::VALUE: return "VALUE";
+    case ErrorCode::CONFLICTING_NAME: return "CONFLICTING_NAME";
+    case ErrorCode::EXPONENTATION: return "EXPONENTATION";
+    case ErrorCode::UNKNOWN_SYMBOL: return "UNKNOWN_SYMBOL";
+    case ErrorCode::ARGUMENT_MISSING: return "ARGUMENT_MISSING";
+    case ErrorCode::BUDGET_EXCEEDED: return "BUDGET_EXCEEDED";
+    case ErrorCode::NON_LINEAR_EQUATION: return "NON_LINEAR_EQUATION";
+    case ErrorCode::NO_SYMBOL_FOUND: return "NO_SYMBOL_FOUND";
+    case ErrorCode::TAUTOLOGY: return "TAUTOLOGY";
+    case ErrorCode::NON_SOLVABLE: return "NON_SOLVABLE";
+    case ErrorCode::SOLVER: return "SOLVER";
+    case ErrorCode::EVALUATION: return "EVALUATION";
+    case ErrorCode::INVALID_NUMBER: return "INVALID_NUMBER";
+    case ErrorCode::ERROR: return "ERROR";
+  }
+
+  return "ERROR";
+}
+
+std::string Status::message() const {
+  if (!text.empty())
+    return text;
+
+  std::string at = " at " + std::to_string(position);
+
+  // the same messages as errors of the codes have
+  switch (code) {
+    case ErrorCode::NONE:
+      return std::string();
+    case ErrorCode::EMPTY_EXPRESSION:
+      return "Empty expression provided" + at;
+    case ErrorCode::UNKNOWN_OPERATOR:
+      return "Unknown operator '" + detail + "'" + at;
+    case ErrorCode::MISSING_BRACKET:
+      return "Bracket is missing" + at;
+    case ErrorCode::UNKNOWN_SYMBOL:
+      return "Unknown symbol '" + detail + "'" + at;
+    case ErrorCode::ARGUMENT_MISSING:
+      return "Argument is missing for function '" + detail + "'" + at;
+    case ErrorCode::INVALID_NUMBER:
+      return "Number " + detail + " cannot be represented" + at;
+    case ErrorCode::PARSING:
+    case ErrorCode::EVALUATION:
+      return detail + at;
+    case ErrorCode::POLYNOMIAL_CAST:
+      return PolynomialCastError().what();
+    case ErrorCode::POLYNOMIAL_DIVISION:
+      return PolynomialDivisionError().what();
+    case ErrorCode::NON_LINEAR_EQUATION:
+      return NonLinearEquation().what();
+    case ErrorCode::NO_SYMBOL_FOUND:
+      return NoSymbolFound().what();
+    case ErrorCode::TAUTOLOGY:
+      return ExpressionIsTautology().what();
+    case ErrorCode::NON_SOLVABLE:
+      return NonSolvableExpression().what();
+    default:
+      return detail;
+  }
+}
+
+void Status::raise() const {
+  if (!text.empty()) {
+    switch (code) {
+      case ErrorCode::EMPTY_EXPRESSION:
+      case ErrorCode::UNKNOWN_OPERATOR:
+      case ErrorCode::MISSING_BRACKET:
+      case ErrorCode::PARSING:
+        throw ParsingError(text);
+      case ErrorCode::POLYNOMIAL_CAST:
+      case ErrorCode::POLYNOMIAL_DIVISION:
+      case ErrorCode::SERIES_EXPANSION:
+      case ErrorCode::VALUE:
+        throw ValueError(text);
+      case ErrorCode::BUDGET_EXCEEDED:
+        throw BudgetExceededError(text);
+      case ErrorCode::NON_LINEAR_EQUATION:
+      case ErrorCode::NO_SYMBOL_FOUND:
+      case ErrorCode::TAUTOLOGY:
+      case ErrorCode::NON_SOLVABLE:
+      case ErrorCode::SOLVER:
+        throw SolverError(text);
+      case ErrorCode::ERROR:
+        throw Error(text);
+      case ErrorCode::NONE:
+        return;
+      default:
+        throw EvaluationError(text);
+    }
+  }
+
+  switch (code) {
+    case ErrorCode::NONE:
+      return;
+    case ErrorCode::EMPTY_EXPRESSION:
+      throw EmptyExpressionError();
+    case ErrorCode::UNKNOWN_OPERATOR:
+      throw UnknownOperatorError(detail, position);
+    case ErrorCode::MISSING_BRACKET:
+      throw MissingBracketError(position);
+    case ErrorCode::PARSING:
+      throw ParsingError(detail, position);
+    case ErrorCode::POLYNOMIAL_CAST:
+      throw PolynomialCastError();
+    case ErrorCode::POLYNOMIAL_DIVISION:
+      throw PolynomialDivisionError();
+    case ErrorCode::SERIES_EXPANSION:
+      throw SeriesExpansionError(detail);
+    case ErrorCode::VALUE:
+      throw ValueError(detail);
+    case ErrorCode::CONFLICTING_NAME:
+      throw ConflictingNameError(detail);
+    case ErrorCode::EXPONENTATION:
+      throw ExponentationError(detail);
+    case ErrorCode::UNKNOWN_SYMBOL:
+      throw UnknownSymbolError(detail, position);
+    case ErrorCode::ARGUMENT_MISSING:
+      throw ArgumentMissingError(detail, position);
+    case ErrorCode::BUDGET_EXCEEDED:
+      throw BudgetExceededError(detail);
+    case ErrorCode::NON_LINEAR_EQUATION:
+      throw NonLinearEquation();
+    case ErrorCode::NO_SYMBOL_FOUND:
+      throw NoSymbolFound();
+    case ErrorCode::TAUTOLOGY:
+      throw ExpressionIsTautology();
+    case ErrorCode::NON_SOLVABLE:
+      throw NonSolvableExpression();
+    case ErrorCode::SOLVER:
+      throw SolverError(detail);
+    case ErrorCode::EVALUATION:
+      throw EvaluationError(detail, position);
+    case ErrorCode::INVALID_NUMBER:
+      throw InvalidNumberError(detail, position);
+    case ErrorCode::ERROR:
+      throw Error(detail);
+  }
+}
+
+}
+}
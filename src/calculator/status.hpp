@@ -0,0 +1,108 @@
+#include "errors.hpp"
+
+#include <string>
+
+#pragma once
+
+namespace XX {
+namespace Calculator {
+
+/**
+ * Codes of failures, one for every class of error (see errors.hpp)
+ * and one for numbers which cannot be represented.
+ */
+enum class ErrorCode {
+  NONE,
+  EMPTY_EXPRESSION,
+  UNKNOWN_OPERATOR,
+  MISSING_BRACKET,
+  PARSING,
+  POLYNOMIAL_CAST,
+  POLYNOMIAL_DIVISION,
+  SERIES_EXPANSION,
+  VALUE,
+  CONFLICTING_NAME,
+  EXPONENTATION,
+  UNKNOWN_SYMBOL,
+  ARGUMENT_MISSING,
+  BUDGET_EXCEEDED,
+  NON_LINEAR_EQUATION,
+  NO_SYMBOL_FOUND,
+  TAUTOLOGY,
+  NON_SOLVABLE,
+  SOLVER,
+  EVALUATION,
+  INVALID_NUMBER,
+  ERROR
+};
+
+/**
+ * Outcome of a calculation which does not throw. A failure is
+ * described by its code, position in the input and a detail (ie.
+ * unknown symbol), its message is formatted only when asked for -
+ * so failing lines of a batch cost neither unwinding nor building
+ * of strings.
+ *
+ * Failures of the parser, of the evaluator (unknown symbols,
+ * missing arguments) and of the solver are reported this way,
+ * errors thrown deeper (ie. by values) are caught and kept with
+ * their message.
+ */
+class Status {
+  public:
+
+  //! Creates success
+  Status() : code(ErrorCode::NONE), position(0) { }
+
+  /**
+   * Creates failure.
+   *
+   * @param code Code of the failure
+   * @param position Position in the input
+   * @param detail Symbol, operator or text of the failure
+   */
+  Status(ErrorCode code, unsigned long position = 0, std::string detail = std::string()) :
+    code(code), position(position), detail(std::move(detail)) { }
+
+  /**
+   * Creates failure from a thrown error. The most specific class
+   * of the error gives the code.
+   *
+   * @param error Calculator error
+   * @return Failure with message of the error
+   */
+  static Status of(Error const& error);
+
+  //! True if there is no failure
+  bool ok() const { return code == ErrorCode::NONE; }
+
+  //! Stable name of the code (ie. UNKNOWN_SYMBOL)
+  char const* name() const;
+
+  //! Message of the failure, the same as of the error it describes
+  std::string message() const;
+
+  /**
+   * Throws error described by the failure (nothing is done on
+   * success). Failures made of thrown errors are thrown as
+   * a generic error of their kind with the same message.
+   */
+  void raise() const;
+
+  //! Code of the failure
+  ErrorCode code;
+
+  //! Position in the input
+  unsigned long position;
+
+  //! Symbol, operator or text of the failure
+  std::string detail;
+
+  private:
+
+  //! Complete message of a thrown error
+  std::string text;
+};
+
+}
+}
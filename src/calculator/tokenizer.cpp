@@ -6,7 +6,91 @@
 namespace XX {
 namespace Calculator {
 
+namespace {
+
+//! Appends a token, reusing a node of the spare list if there is any
+void append(TokenList& tokens, TokenList& spare, Token&& token) {
+  if (spare.empty()) {
+    tokens.push_back(std::move(token));
+  } else {
+    tokens.splice(tokens.end(), spare, spare.begin());
+    tokens.back() = std::move(token);
+  }
+}
+
+//! Length of a floating point number starting at given position (see Tokenizer::extract_number)
+unsigned long number_length(std::string const& line, unsigned long position) {
+  // Dot is accepted once
+  bool accept_dot = true;
+  // Exponent is accepted
+  bool accept_exponent = true;
+  // Sign is not accepted initially
+  bool accept_sign = false;
+
+  unsigned long current = position;
+
+  // Process from left to right
+  while (current < line.size()) {
+    // Dot is accepted only once and only before exponent specification
+    if (accept_dot && line[current] == '.' && accept_exponent) {
+      accept_dot = false;
+      current++;
+    } else
+    // Exponent is accepted only once and it can be followed by sign
+    if (accept_exponent && (line[current] == 'E' || line[current] == 'e')) {
+      accept_exponent = false;
+      accept_sign = true;
+      current++;
+    } else
+    // Sign is accepted only once
+    if (accept_sign && (line[current] == '+' || line[current] == '-')) {
+      accept_sign = false;
+      current++;
+    } else
+    // Digits are always accepted
+    if (std::isdigit(line[current])) {
+      accept_sign = false;
+      current++;
+    } else {
+      break;
+    }
+  }
+
+  return current - position;
+}
+
+//! Length of a text identifier starting at given position (see Tokenizer::extract_identifier)
+unsigned long identifier_length(std::string const& line, unsigned long position) {
+  unsigned long current = position;
+
+  // Process from left to right
+  while (current < line.size()) {
+    // First character must be a letter or an underscore, numbers can follow
+    if (std::isalpha(line[current]) || line[current] == '_' ||
+        (std::isalnum(line[current]) && current > position)) {
+      current++;
+    } else {
+      break;
+    }
+  }
+
+  return current - position;
+}
+
+//! True if an identifier is a special number (infinity or NaN)
+bool special_number(char const* text, std::size_t length) {
+  return (length == 3 && (strncasecmp(text, "inf", 3) == 0 || strncasecmp(text, "nan", 3) == 0)) ||
+         (length == 8 && strncasecmp(text, "infinity", 8) == 0);
+}
+
+}
+
 TokenList Tokenizer::process(std::string const& line) const {
+  TokenList spare;
+  return process(line, spare);
+}
+
+TokenList Tokenizer::process(std::string const& line, TokenList& spare) const {
   TokenList tokens;
   unsigned long position = 0;
 
@@ -15,11 +99,11 @@ TokenList Tokenizer::process(std::string const& line) const {
     switch (line[position]) {
       // Brackets
       case '(':
-        tokens.emplace_back(TokenType::BRACKET_OPENING, position);
+        append(tokens, spare, Token(TokenType::BRACKET_OPENING, position));
         position++;
         break;
       case ')':
-        tokens.emplace_back(TokenType::BRACKET_CLOSING, position);
+        append(tokens, spare, Token(TokenType::BRACKET_CLOSING, position));
         position++;
         break;
       // Operators
@@ -29,12 +113,12 @@ TokenList Tokenizer::process(std::string const& line) const {
       case '*':
       case '^':
       case '=':
-        tokens.emplace_back(TokenType::OPERATOR, position, line[position]);
+        append(tokens, spare, Token(TokenType::OPERATOR, position, line[position]));
         position++;
         break;
       // Separator
       case ',':
-        tokens.emplace_back(TokenType::SEPARATOR, position);
+        append(tokens, spare, Token(TokenType::SEPARATOR, position));
         position++;
         break;
       // Skip white characters
@@ -48,15 +132,15 @@ TokenList Tokenizer::process(std::string const& line) const {
       default:
         // A number must start with a digit or a decimal dot
         if (std::isdigit(line[position]) || line[position] == '.') {
-          tokens.emplace_back(extract_number(line, position));
+          append(tokens, spare, extract_number(line, position));
           position += tokens.back().value.length();
         } else
         // An identifier must start with a letter or an underscore
         if (std::isalpha(line[position]) || line[position] == '_') {
-          tokens.emplace_back(extract_identifier(line, position));
+          append(tokens, spare, extract_identifier(line, position));
           position += tokens.back().value.length();
         } else {
-          tokens.emplace_back(TokenType::UNKNOWN, position, line[position]);
+          append(tokens, spare, Token(TokenType::UNKNOWN, position, line[position]));
           position++;
         }
     }
@@ -73,44 +157,8 @@ TokenList Tokenizer::process(std::string const& line) const {
 Token Tokenizer::extract_number(std::string const& line, unsigned long position) const {
   Token token(TokenType::NUMBER, position);
 
-  // Dot is accepted once
-  bool accept_dot = true;
-  // Exponent is accepted
-  bool accept_exponent = true;
-  // Sign is not accepted initially
-  bool accept_sign = false;
-
-  unsigned long current = position;
-
-  // Process from left to right
-  while (current < line.size()) {
-    // Dot is accepted only once and only before exponent specification
-    if (accept_dot && line[current] == '.' && accept_exponent) {
-      accept_dot = false;
-      current++;
-    } else
-    // Exponent is accepted only once and it can be followed by sign
-    if (accept_exponent && (line[current] == 'E' || line[current] == 'e')) {
-      accept_exponent = false;
-      accept_sign = true;
-      current++;
-    } else
-    // Sign is accepted only once
-    if (accept_sign && (line[current] == '+' || line[current] == '-')) {
-      accept_sign = false;
-      current++;
-    } else
-    // Digits are always accepted
-    if (std::isdigit(line[current])) {
-      accept_sign = false;
-      current++;
-    } else {
-      break;
-    }
-  }
-
   // Copy extracted number
-  token.value = line.substr(position, current - position);
+  token.value = line.substr(position, number_length(line, position));
 
   return token;
 }
@@ -118,21 +166,8 @@ Token Tokenizer::extract_number(std::string const& line, unsigned long position)
 Token Tokenizer::extract_identifier(std::string const& line, unsigned long position) const {
   Token token(TokenType::IDENTIFIER, position);
 
-  unsigned long current = position;
-
-  // Process from left to right
-  while (current < line.size()) {
-    // First character must be a letter or an underscore, numbers can follow
-    if (std::isalpha(line[current]) || line[current] == '_' ||
-        (std::isalnum(line[current]) && current > position)) {
-      current++;
-    } else {
-      break;
-    }
-  }
-
   // Copy extracted identifier
-  token.value = line.substr(position, current - position);
+  token.value = line.substr(position, identifier_length(line, position));
 
   return token;
 }
@@ -145,9 +180,7 @@ void Tokenizer::convert_special_numbers(TokenList& tokens) const {
       continue;
 
     // Convert infinity and nan to number
-    if (strcasecmp(token->value.c_str(), "inf") == 0 ||
-        strcasecmp(token->value.c_str(), "infinity") == 0 ||
-        strcasecmp(token->value.c_str(), "nan") == 0) {
+    if (special_number(token->value.data(), token->value.size())) {
       token->type = TokenType::NUMBER;
     }
   }
@@ -205,6 +238,103 @@ void Tokenizer::merge_signs(TokenList& tokens) const {
   }
 }
 
+void Scanner::reset(std::string const& line) {
+  this->line = &line;
+  position = 0;
+  pending = 0;
+  // beginning is like an opening bracket for signs
+  previous = TokenType::BRACKET_OPENING;
+  next();
+}
+
+void Scanner::next() {
+  if (pending > 0) {
+    current = queue[0];
+    queue[0] = queue[1];
+    pending--;
+  } else {
+    end = !scan(current);
+
+    // An operator is the sign operator if it is directly at the beginning
+    // or after opening bracket, separator or another operator (see
+    // Tokenizer::merge_signs) and a number, an identifier or a bracket follows
+    if (!end && current.type == TokenType::OPERATOR && (current.text[0] == '-' || current.text[0] == '+') &&
+        (previous == TokenType::SEPARATOR || previous == TokenType::BRACKET_OPENING ||
+         previous == TokenType::OPERATOR)) {
+      unsigned long after = position;
+      Lexeme following;
+      bool scanned = scan(following);
+
+      if (scanned && following.type == TokenType::NUMBER) {
+        // Merge sign with the number
+        following.sign = current.text[0];
+        following.position = current.position;
+        current = following;
+      } else
+      if (scanned && (following.type == TokenType::IDENTIFIER ||
+                      following.type == TokenType::BRACKET_OPENING)) {
+        // Explicit multiplication by a signed one
+        queue[0] = {TokenType::OPERATOR, following.position, 0, "*", 1};
+        queue[1] = following;
+        pending = 2;
+        current = {TokenType::NUMBER, following.position, current.text[0], "1", 1};
+      } else {
+        // not a sign, following token is scanned again
+        position = after;
+      }
+    }
+  }
+
+  if (!end)
+    previous = current.type;
+}
+
+bool Scanner::scan(Lexeme& lexeme) {
+  // Skip white characters
+  while (position < line->size() &&
+         ((*line)[position] == ' ' || (*line)[position] == '\t' ||
+          (*line)[position] == '\r' || (*line)[position] == '\n'))
+    position++;
+
+  if (position >= line->size())
+    return false;
+
+  char const* text = line->data() + position;
+  lexeme = {TokenType::UNKNOWN, position, 0, text, 1};
+
+  switch (*text) {
+    case '(':
+      lexeme.type = TokenType::BRACKET_OPENING;
+      break;
+    case ')':
+      lexeme.type = TokenType::BRACKET_CLOSING;
+      break;
+    case '+':
+    case '-':
+    case '/':
+    case '*':
+    case '^':
+    case '=':
+      lexeme.type = TokenType::OPERATOR;
+      break;
+    case ',':
+      lexeme.type = TokenType::SEPARATOR;
+      break;
+    default:
+      if (std::isdigit(*text) || *text == '.') {
+        lexeme.type = TokenType::NUMBER;
+        lexeme.length = number_length(*line, position);
+      } else
+      if (std::isalpha(*text) || *text == '_') {
+        lexeme.length = identifier_length(*line, position);
+        lexeme.type = special_number(text, lexeme.length) ? TokenType::NUMBER : TokenType::IDENTIFIER;
+      }
+  }
+
+  position += lexeme.length;
+  return true;
+}
+
 std::ostream& operator<<(std::ostream &os, Token const& t) {
   os << t.position << ' ';
 
@@ -110,6 +110,17 @@ class Tokenizer {
    */
   virtual TokenList process(std::string const& line) const;
 
+  /**
+   * Converts the text expression into a list of tokens, reusing
+   * nodes of given list instead of allocating new ones (ie. nodes
+   * of tokens of a previous expression, see BasicPolynomialCalculator).
+   *
+   * @param line Text expression
+   * @param[in,out] spare Nodes which can be reused (taken from it)
+   * @return List of recognized tokens
+   */
+  virtual TokenList process(std::string const& line, TokenList& spare) const;
+
   private:
 
   /**
@@ -157,6 +168,79 @@ class Tokenizer {
 };
 
 
+/**
+ * Scanner reads tokens of a line one at a time, without building
+ * a list of them or copying their text. It recognizes the same
+ * tokens as Tokenizer does, at the same positions - including
+ * special numbers, numbers merged with their signs and signed
+ * identifiers (read as a signed one multiplied by the identifier).
+ * It is used by parsers compiling a line directly (see
+ * BasicPrattParser).
+ */
+class Scanner {
+  public:
+
+  /**
+   * Token recognized by the scanner. Its text refers to the
+   * scanned line (or to a static text of an inserted token).
+   */
+  struct Lexeme {
+    //! Type of token
+    TokenType type;
+    //! Position (relative to the original input)
+    unsigned long position;
+    //! Sign merged with a number (or zero)
+    char sign;
+    //! Text of token (without the sign)
+    char const* text;
+    //! Length of the text
+    std::size_t length;
+  };
+
+  /**
+   * Starts reading of a line, the first token is current. The
+   * line must outlive the reading.
+   *
+   * @param line Text expression
+   */
+  void reset(std::string const& line);
+
+  //! Moves to the next token
+  void next();
+
+  //! True if the whole line is read (there is no current token)
+  bool at_end() const { return end; }
+
+  //! Current token
+  Lexeme const& peek() const { return current; }
+
+  private:
+
+  /**
+   * Recognizes a token at the position and moves after it.
+   *
+   * @param[out] lexeme Recognized token
+   * @return False at the end of the line
+   */
+  bool scan(Lexeme& lexeme);
+
+  //! Scanned line
+  std::string const* line;
+  //! Position of the next token
+  unsigned long position;
+  //! Current token
+  Lexeme current;
+  //! True at the end of the line
+  bool end;
+  //! Type of the previous token
+  TokenType previous;
+  //! Tokens inserted after the current one
+  Lexeme queue[2];
+  //! Number of inserted tokens
+  unsigned pending;
+};
+
+
 /**
  * Pretty printer for a token. It includes a position, token
  * name and token value (if appropriate).
@@ -0,0 +1,101 @@
+#include "trace.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+namespace XX {
+namespace Calculator {
+
+namespace {
+
+//! Histograms of every metric
+Histogram histograms[Trace::METRICS];
+
+//! Names of metrics
+char const* names[Trace::METRICS] = {"tokenize_ns", "parse_ns", "evaluate_ns", "tokens", "stack_depth", "degree",
+                                     "eliminated"};
+
+}
+
+std::uint64_t Histogram::Snapshot::percentile(double p) const {
+  if (count == 0)
+    return 0;
+
+  // rank of the value, counting from one
+  std::uint64_t rank = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(std::ceil(p / 100 * count)));
+  std::uint64_t seen = 0;
+
+  for (std::size_t i = 0; i < buckets; i++) {
+    seen += counts[i];
+
+    if (seen >= rank) {
+      std::uint64_t upper = i == 0 ? 0 : i == 64 ? ~std::uint64_t(0) : (std::uint64_t(1) << i) - 1;
+      return std::min(upper, max);
+    }
+  }
+
+  return max;
+}
+
+Histogram::Snapshot Histogram::snapshot() const {
+  Snapshot snapshot;
+
+  snapshot.count = count.load(std::memory_order_relaxed);
+  snapshot.sum = sum.load(std::memory_order_relaxed);
+  snapshot.max = max.load(std::memory_order_relaxed);
+  for (std::size_t i = 0; i < buckets; i++)
+    snapshot.counts[i] = counts[i].load(std::memory_order_relaxed);
+
+  return snapshot;
+}
+
+void Histogram::reset() {
+  for (auto& c : counts)
+    c.store(0, std::memory_order_relaxed);
+  count.store(0, std::memory_order_relaxed);
+  sum.store(0, std::memory_order_relaxed);
+  max.store(0, std::memory_order_relaxed);
+}
+
+bool Trace::enabled() {
+#ifdef XXCALC_TRACE
+  return true;
+#else
+  return false;
+#endif
+}
+
+Histogram& Trace::histogram(Metric metric) {
+  return histograms[metric];
+}
+
+char const* Trace::name(Metric metric) {
+  return names[metric];
+}
+
+void Trace::dump(std::string& output) {
+  char line[160];
+
+  std::snprintf(line, sizeof(line), "%-12s %12s %12s %12s %12s %12s %12s\n",
+                "metric", "count", "mean", "p50", "p99", "p999", "max");
+  output += line;
+
+  for (int i = 0; i < METRICS; i++) {
+    Histogram::Snapshot s = histograms[i].snapshot();
+
+    std::snprintf(line, sizeof(line), "%-12s %12llu %12.1f %12llu %12llu %12llu %12llu\n", names[i],
+                  (unsigned long long) s.count, s.mean(), (unsigned long long) s.percentile(50),
+                  (unsigned long long) s.percentile(99), (unsigned long long) s.percentile(99.9),
+                  (unsigned long long) s.max);
+    output += line;
+  }
+}
+
+void Trace::reset() {
+  for (auto& histogram : histograms)
+    histogram.reset();
+}
+
+}
+}
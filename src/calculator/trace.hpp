@@ -0,0 +1,154 @@
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#pragma once
+
+namespace XX {
+namespace Calculator {
+
+/**
+ * Histogram of non negative integers, which can be recorded and read
+ * by many threads at once without locks. Values are counted in
+ * buckets of powers of two - bucket 0 counts zeros and bucket i
+ * counts values in range [2^(i-1), 2^i) - so recording is a few
+ * relaxed atomic additions and percentiles are accurate within
+ * a factor of two.
+ */
+class Histogram {
+  public:
+
+  //! Number of buckets (zero and every power of two)
+  static const std::size_t buckets = 65;
+
+  /**
+   * Copy of the histogram at some point. It is not an atomic
+   * snapshot - values recorded while it is taken may be counted
+   * only partially.
+   */
+  struct Snapshot {
+    //! Number of recorded values
+    std::uint64_t count;
+    //! Sum of recorded values
+    std::uint64_t sum;
+    //! Largest recorded value
+    std::uint64_t max;
+    //! Number of values in every bucket
+    std::uint64_t counts[buckets];
+
+    //! Average of recorded values
+    double mean() const { return count > 0 ? double(sum) / count : 0; }
+
+    /**
+     * Estimates a percentile as the upper bound of the bucket
+     * containing it (but not more than the largest value).
+     *
+     * @param p Percentile in range [0, 100]
+     * @return Estimated value
+     */
+    std::uint64_t percentile(double p) const;
+  };
+
+  //! Creates empty histogram
+  Histogram() { reset(); }
+
+  Histogram(Histogram const&) = delete;
+  Histogram& operator=(Histogram const&) = delete;
+
+  /**
+   * Records a value.
+   *
+   * @param value Recorded value
+   */
+  void record(std::uint64_t value) {
+    std::size_t bucket = value == 0 ? 0 : 64 - __builtin_clzll(value);
+
+    counts[bucket].fetch_add(1, std::memory_order_relaxed);
+    count.fetch_add(1, std::memory_order_relaxed);
+    sum.fetch_add(value, std::memory_order_relaxed);
+
+    std::uint64_t largest = max.load(std::memory_order_relaxed);
+    while (value > largest && !max.compare_exchange_weak(largest, value, std::memory_order_relaxed)) { }
+  }
+
+  //! Copies current state of the histogram
+  Snapshot snapshot() const;
+
+  //! Removes recorded values
+  void reset();
+
+  private:
+
+  //! Number of values in every bucket
+  std::atomic<std::uint64_t> counts[buckets];
+  //! Number of recorded values
+  std::atomic<std::uint64_t> count;
+  //! Sum of recorded values
+  std::atomic<std::uint64_t> sum;
+  //! Largest recorded value
+  std::atomic<std::uint64_t> max;
+};
+
+/**
+ * Histograms of every call of the calculator - durations of stages
+ * of processing and sizes of processed expressions. They are shared
+ * by all calculators of the process.
+ *
+ * Calculators record them only when the library is built with
+ * XXCALC_TRACE macro symbol defined, otherwise tracing is compiled
+ * out and histograms stay empty.
+ */
+class Trace {
+  public:
+
+  /**
+   * Recorded quantity
+   */
+  enum Metric {
+    //! Duration of tokenizing in nanoseconds
+    TOKENIZE,
+    //! Duration of parsing in nanoseconds
+    PARSE,
+    //! Duration of evaluation in nanoseconds
+    EVALUATE,
+    //! Number of tokens of an expression
+    TOKENS,
+    //! Largest number of values on the stack of evaluation
+    STACK_DEPTH,
+    //! Degree of the result
+    DEGREE,
+    //! Number of calls eliminated as repeated subexpressions
+    ELIMINATED,
+    //! Number of metrics
+    METRICS
+  };
+
+  //! True if calculators record traces
+  static bool enabled();
+
+  /**
+   * Gets histogram of a metric.
+   *
+   * @param metric Recorded quantity
+   * @return Its histogram
+   */
+  static Histogram& histogram(Metric metric);
+
+  //! Name of a metric
+  static char const* name(Metric metric);
+
+  /**
+   * Appends a table of every histogram - number of values, their
+   * average, percentiles and the largest value.
+   *
+   * @param output Destination
+   */
+  static void dump(std::string& output);
+
+  //! Removes values of every histogram
+  static void reset();
+};
+
+}
+}
@@ -1,27 +1,154 @@
 #include "value.hpp"
+#include "budget.hpp"
 #include "errors.hpp"
 #include <iostream>
 #include <algorithm>
-#include <sstream>
+#include <limits>
 
 namespace XX {
 namespace Calculator {
 
+namespace {
+
+//! Adds integers, fails if result is not within the limit
+inline bool add(std::int64_t a, std::int64_t b, std::int64_t limit, std::int64_t& result) {
+  std::int64_t r;
+  if (__builtin_add_overflow(a, b, &r) || r > limit || r < -limit)
+    return false;
+
+  result = r;
+  return true;
+}
+
+//! Subtracts integers, fails if result is not within the limit
+inline bool subtract(std::int64_t a, std::int64_t b, std::int64_t limit, std::int64_t& result) {
+  std::int64_t r;
+  if (__builtin_sub_overflow(a, b, &r) || r > limit || r < -limit)
+    return false;
+
+  result = r;
+  return true;
+}
+
+//! Multiplies integers, fails if result is not within the limit
+inline bool multiply(std::int64_t a, std::int64_t b, std::int64_t limit, std::int64_t& result) {
+  std::int64_t r;
+  if (__builtin_mul_overflow(a, b, &r) || r > limit || r < -limit)
+    return false;
+
+  result = r;
+  return true;
+}
+
+}
+
+template <typename T>
+std::int64_t BasicValue<T>::limit() {
+  const int digits = std::numeric_limits<T>::digits;
+
+  if (digits >= 63)
+    return std::numeric_limits<std::int64_t>::max();
+
+  return std::int64_t(1) << std::min(digits, 62);
+}
+
+#ifdef XXCALC_FLOAT128
+template <>
+std::int64_t BasicValue<__float128>::limit() {
+  return std::numeric_limits<std::int64_t>::max();
+}
+#endif
+
+template <typename T>
+void BasicValue<T>::compact() {
+  std::int64_t l = limit();
+  integers.resize(coefficients.size());
+
+  for (unsigned long i = 0; i < coefficients.size(); i++) {
+    T c = coefficients[i];
+
+    // also rejects nan
+    if (!(c >= T(-l) && c <= T(l))) {
+      integers.clear();
+      return;
+    }
+
+    std::int64_t n = static_cast<std::int64_t>(c);
+
+    // fractions and negative zero need T
+    if (T(n) != c || (n == 0 && T(1) / c < 0)) {
+      integers.clear();
+      return;
+    }
+
+    integers[i] = n;
+  }
+
+  integral = true;
+  coefficients.clear();
+}
+
+template <typename T>
+void BasicValue<T>::promote() {
+  coefficients.assign(integers.begin(), integers.end());
+  integers.clear();
+  integral = false;
+}
+
+template <typename T>
+BasicValue<T> BasicValue<T>::parse(std::string const& text) {
+  // plain integers do not need a conversion through T
+  unsigned long start = !text.empty() && (text[0] == '-' || text[0] == '+');
+
+  if (text.size() > start && text.size() - start <= 15) {
+    std::int64_t n = 0;
+    unsigned long i = start;
+
+    for (; i < text.size() && text[i] >= '0' && text[i] <= '9'; i++)
+      n = n * 10 + (text[i] - '0');
+
+    if (i == text.size() && n <= limit() && !(n == 0 && text[0] == '-')) {
+      BasicValue value;
+      value.integers[0] = text[0] == '-' ? -n : n;
+      return value;
+    }
+  }
+
+  return Math<T>::parse(text);
+}
+
+template <typename T>
+T& BasicValue<T>::operator[](const unsigned long index) {
+  if (integral)
+    promote();
 
-double& Value::operator[](const unsigned long index) {
   if (index >= coefficients.size()) {
-    coefficients.resize(index+1, 0.0);
+    coefficients.resize(index+1, T(0));
   }
 
   return coefficients[index];
 }
 
-double Value::operator[](const unsigned long index) const {
-  return coefficients[index];
+template <typename T>
+T BasicValue<T>::operator[](const unsigned long index) const {
+  if (integral)
+    return index < integers.size() ? T(integers[index]) : T(0);
+
+  return index < coefficients.size() ? coefficients[index] : T(0);
 }
 
-unsigned long Value::degree() const {
-  auto it = std::find_if(coefficients.crbegin(), coefficients.crend(), [](double const& a) {
+template <typename T>
+unsigned long BasicValue<T>::degree() const {
+  if (integral) {
+    for (unsigned long i = integers.size(); i-- > 1; ) {
+      if (integers[i] != 0)
+        return i;
+    }
+
+    return 0;
+  }
+
+  auto it = std::find_if(coefficients.crbegin(), coefficients.crend(), [](T const& a) {
     return a != 0;
   });
 
@@ -31,31 +158,77 @@ unsigned long Value::degree() const {
     return coefficients.crend() - it - 1;
 }
 
-Value::operator double() const {
+template <typename T>
+BasicValue<T>& BasicValue<T>::truncate(const unsigned long order) {
+  if (integral)
+    integers.resize(std::max(order, 1ul), 0);
+  else
+    coefficients.resize(std::max(order, 1ul), T(0));
+
+  return *this;
+}
+
+template <typename T>
+BasicValue<T>::operator T() const {
   if (degree() > 0)
     throw PolynomialCastError();
 
-  return coefficients[0];
+  return (*this)[0];
 }
 
-Value::operator std::string() const {
+template <typename T>
+BasicValue<T>::operator std::string() const {
   return repr("x");
 }
 
-Value Value::operator()(Value const& x) const {
-  Value result;
+template <typename T>
+BasicValue<T> BasicValue<T>::operator()(BasicValue const& x) const {
+  BasicValue result;
+  result.promote();
 
   for (long i = degree(); i >= 0; i--) {
-    result.coefficients[0] *= double(x);
-    result.coefficients[0] += coefficients[i];
+    result.coefficients[0] *= T(x);
+    result.coefficients[0] += (*this)[i];
   }
 
+  result.compact();
   return result;
 }
 
-Value& Value::operator+=(Value const& other) {
+template <typename T>
+BasicValue<T>& BasicValue<T>::operator+=(BasicValue const& other) {
+  Budget::charge(0, 0, other.integral ? other.integers.size() : other.coefficients.size());
+
+  if (integral && other.integral) {
+    if (other.integers.size() > integers.size()) {
+      integers.resize(other.integers.size(), 0);
+    }
+
+    unsigned long i = 0;
+    for (; i < other.integers.size(); i++) {
+      if (!add(integers[i], other.integers[i], limit(), integers[i]))
+        break;
+    }
+
+    if (i == other.integers.size())
+      return *this;
+
+    // revert partial result before promotion
+    while (i-- > 0)
+      integers[i] -= other.integers[i];
+  }
+
+  if (integral)
+    promote();
+
+  if (other.integral) {
+    BasicValue promoted(other);
+    promoted.promote();
+    return *this += promoted;
+  }
+
   if (other.coefficients.size() > coefficients.size()) {
-    coefficients.resize(other.coefficients.size(), 0.0);
+    coefficients.resize(other.coefficients.size(), T(0));
   }
 
   for (unsigned long i = 0; i < other.coefficients.size(); i++) {
@@ -65,9 +238,40 @@ Value& Value::operator+=(Value const& other) {
   return *this;
 }
 
-Value& Value::operator-=(Value const& other) {
+template <typename T>
+BasicValue<T>& BasicValue<T>::operator-=(BasicValue const& other) {
+  Budget::charge(0, 0, other.integral ? other.integers.size() : other.coefficients.size());
+
+  if (integral && other.integral) {
+    if (other.integers.size() > integers.size()) {
+      integers.resize(other.integers.size(), 0);
+    }
+
+    unsigned long i = 0;
+    for (; i < other.integers.size(); i++) {
+      if (!subtract(integers[i], other.integers[i], limit(), integers[i]))
+        break;
+    }
+
+    if (i == other.integers.size())
+      return *this;
+
+    // revert partial result before promotion
+    while (i-- > 0)
+      integers[i] += other.integers[i];
+  }
+
+  if (integral)
+    promote();
+
+  if (other.integral) {
+    BasicValue promoted(other);
+    promoted.promote();
+    return *this -= promoted;
+  }
+
   if (other.coefficients.size() > coefficients.size()) {
-    coefficients.resize(other.coefficients.size(), 0.0);
+    coefficients.resize(other.coefficients.size(), T(0));
   }
 
   for (unsigned long i = 0; i < other.coefficients.size(); i++) {
@@ -77,16 +281,60 @@ Value& Value::operator-=(Value const& other) {
   return *this;
 }
 
-Value& Value::operator*=(Value const& other) {
+template <typename T>
+BasicValue<T>& BasicValue<T>::operator*=(BasicValue const& other) {
   unsigned long self_degree = degree();
   unsigned long other_degree = other.degree();
 
+  // product is charged before it is allocated
+  Budget::charge(self_degree + other_degree, (self_degree + other_degree + 1) * sizeof(T),
+                 std::uint64_t(self_degree + 1) * (other_degree + 1));
+
+  if (integral && other.integral) {
+    std::int64_t l = limit();
+
+    if (self_degree == 0 && other_degree == 0) {
+      std::int64_t a = integers[0], b = other.integers[0];
+
+      // negative zero product is left for T
+      if (multiply(a, b, l, integers[0]) && (integers[0] != 0 || (a >= 0 && b >= 0)))
+        return *this;
+
+      integers[0] = a;
+    } else {
+      std::vector<std::int64_t> c(self_degree + other_degree+2, 0);
+      bool exact = true;
+
+      for (unsigned long a = 0; a <= self_degree && exact; a++) {
+        for (unsigned long b = 0; b <= other_degree && exact; b++) {
+          std::int64_t product;
+          exact = multiply(integers[a], other.integers[b], l, product) &&
+                  add(c[a+b], product, l, c[a+b]);
+        }
+      }
+
+      if (exact) {
+        integers.swap(c);
+        return *this;
+      }
+    }
+  }
+
+  if (integral)
+    promote();
+
+  if (other.integral) {
+    BasicValue promoted(other);
+    promoted.promote();
+    return *this *= promoted;
+  }
+
   if (self_degree == 0 && other_degree == 0) {
     coefficients[0] *= other.coefficients[0];
     return *this;
   }
 
-  std::vector<double> c(self_degree + other_degree+2, 0.0);
+  std::vector<T> c(self_degree + other_degree+2, T(0));
 
   for (unsigned long a = 0; a <= self_degree; a++) {
     for (unsigned long b = 0; b <= other_degree; b++) {
@@ -99,7 +347,17 @@ Value& Value::operator*=(Value const& other) {
   return *this;
 }
 
-Value& Value::operator/=(Value const& other) {
+template <typename T>
+BasicValue<T>& BasicValue<T>::operator/=(BasicValue const& other) {
+  if (other.integral) {
+    BasicValue promoted(other);
+    promoted.promote();
+    return *this /= promoted;
+  }
+
+  if (integral)
+    promote();
+
   unsigned long self_degree = degree();
   unsigned long other_degree = other.degree();
 
@@ -113,13 +371,20 @@ Value& Value::operator/=(Value const& other) {
     for (unsigned long i = 0; i <= self_degree; i++) {
       coefficients[i] /= other.coefficients[0];
     }
+
+    compact();
     return *this;
   }
 
-  Value q;
+  Budget::charge(self_degree - other_degree, (self_degree - other_degree + 1) * sizeof(T),
+                 std::uint64_t(self_degree - other_degree + 1) * (other_degree + 1));
+
+  BasicValue q;
+  q.promote();
   while (degree() >= other.degree()) {
     unsigned long diff = degree() - other.degree();
-    Value d;
+    BasicValue d;
+    d.promote();
     d.coefficients.resize(other.degree() + diff + 1, 0);
     for (unsigned long i = 0; i <= other.degree(); i++) {
       d.coefficients[i+diff] = other.coefficients[i];
@@ -130,16 +395,21 @@ Value& Value::operator/=(Value const& other) {
   }
 
   coefficients = q.coefficients;
+  compact();
 
   return *this;
 }
 
-bool Value::operator==(Value const &other) const {
+template <typename T>
+bool BasicValue<T>::operator==(BasicValue const &other) const {
   unsigned long d = degree();
 
   if (other.degree() == d) {
+    if (integral && other.integral)
+      return std::equal(integers.begin(), integers.begin() + d + 1, other.integers.begin());
+
     for (unsigned long i = 0; i <= d; i++)
-      if (other.coefficients[i] != coefficients[i])
+      if (other[i] != (*this)[i])
         return false;
 
     return true;
@@ -148,70 +418,88 @@ bool Value::operator==(Value const &other) const {
   return false;;
 }
 
-bool Value::operator!=(Value const &other) const {
+template <typename T>
+bool BasicValue<T>::operator!=(BasicValue const &other) const {
   return !(*this == other);
 }
 
-const Value Value::operator+(Value const& other) const {
-  return Value(*this) += other;
+template <typename T>
+const BasicValue<T> BasicValue<T>::operator+(BasicValue const& other) const {
+  return BasicValue(*this) += other;
 }
 
-const Value Value::operator-(Value const& other) const {
-  return Value(*this) -= other;
+template <typename T>
+const BasicValue<T> BasicValue<T>::operator-(BasicValue const& other) const {
+  return BasicValue(*this) -= other;
 }
 
-const Value Value::operator*(Value const& other) const {
-  return Value(*this) *= other;
+template <typename T>
+const BasicValue<T> BasicValue<T>::operator*(BasicValue const& other) const {
+  return BasicValue(*this) *= other;
 }
 
-const Value Value::operator/(Value const& other) const {
-  return Value(*this) /= other;
+template <typename T>
+const BasicValue<T> BasicValue<T>::operator/(BasicValue const& other) const {
+  return BasicValue(*this) /= other;
 }
 
-std::string Value::repr(std::string const& name) const {
-  unsigned long d = degree();
+template <typename T>
+std::string BasicValue<T>::repr(std::string const& name) const {
+  std::string output;
+  repr(output, name);
+  return output;
+}
 
-  std::ostringstream output;
+template <typename T>
+void BasicValue<T>::repr(std::string& output, std::string const& name) const {
+  unsigned long d = degree();
 
   if (d == 0) {
-    output << (coefficients.empty() ? 0 : coefficients[0]);
-    return output.str();
+    bool empty = integral ? integers.empty() : coefficients.empty();
+    Math<T>::print(output, empty ? T(0) : (*this)[0]);
+    return;
   }
 
   bool need_sign = false;
 
   for (int i = d; i >= 0; i--) {
-    if (coefficients[i] != 0) {
-      if (coefficients[i] > 0 && need_sign) {
-        output << "+";
+    T c = (*this)[i];
+
+    if (c != 0) {
+      if (c > 0 && need_sign) {
+        output += '+';
         need_sign = false;
       }
 
       if (i > 0) {
-        if (coefficients[i] == -1) {
-          output << "-";
+        if (c == -1) {
+          output += '-';
         } else
-        if (coefficients[i] != 1) {
-          output << coefficients[i];
+        if (c != 1) {
+          Math<T>::print(output, c);
         }
 
-        output << name;
+        output += name;
 
         if (i > 1) {
-          output << "^" << i;
+          output += '^';
+          output += std::to_string(i);
         }
         need_sign = true;
       } else {
-        output << coefficients[i];
+        Math<T>::print(output, c);
       }
 
     }
   }
-
-  return output.str();
 }
 
-
+template class BasicValue<float>;
+template class BasicValue<double>;
+template class BasicValue<long double>;
+#ifdef XXCALC_FLOAT128
+template class BasicValue<__float128>;
+#endif
 
 }
 }
@@ -1,3 +1,6 @@
+#include "math.hpp"
+
+#include <cstdint>
 #include <vector>
 #include <string>
 
@@ -9,21 +12,37 @@ namespace Calculator {
 /**
  * The value is a type used internally in the evaluator. The value
  * represents a polynomial. It is unambiguously characterized by
- * its coefficients. A value of degree 1 is a plain double value,
- * while a value of degree 2 is a linear expression.
+ * its coefficients. A value of degree 1 is a plain number, while
+ * a value of degree 2 is a linear expression.
+ *
+ * Type of coefficients is a template parameter, values are
+ * instantiated for float, double, long double and __float128
+ * (if XXCALC_FLOAT128 is defined). Value is a polynomial
+ * with double coefficients.
+ *
+ * As long as all coefficients are integers, which can be exactly
+ * represented in T, they are stored as 64 bit integers and added,
+ * subtracted and multiplied using checked integer arithmetic. If
+ * a result would exceed this range (or division is performed)
+ * the value is transparently promoted to coefficients of type T.
+ * Results of both representations are always the same.
  *
  * Common operators are implemented, so the value can be easily
  * used in a code.
  */
-class Value {
+template <typename T>
+class BasicValue {
   public:
 
+  //! Type of coefficients
+  typedef T coefficient_type;
+
   /**
    * Creates value (polynomial) with a list of coefficients.
    *
    * @param coefficients List of coefficients
    */
-  Value(std::vector<double> coefficients) : coefficients(coefficients) { }
+  BasicValue(std::vector<T> coefficients) : coefficients(std::move(coefficients)), integral(false) { compact(); }
 
   /**
    * Creates a linear expression of form ax+b.
@@ -31,37 +50,49 @@ class Value {
    * @param b Constant term
    * @param a Linear coefficient
    */
-  Value(double b, double a) : Value(std::vector<double>{b, a}){ }
+  BasicValue(T b, T a) : BasicValue(std::vector<T>{b, a}){ }
 
   /**
    * Creates degenerative polynomial with just a constant term.
    *
    * @param b Constant term
    */
-  Value(double b) : Value(b, 0.0) { }
+  BasicValue(T b) : BasicValue(b, T(0)) { }
 
   /**
    * Creates zero polynomial
    */
-  Value() : Value(0.0) { }
+  BasicValue() : integers(2, 0), integral(true) { }
+
+  /**
+   * Parses a number into a constant polynomial.
+   *
+   * @throw std::invalid_argument When text is not a number
+   * @throw std::out_of_range When number is out of range of T
+   * @param text Decimal number (scientific notation is allowed)
+   * @return Constant polynomial
+   */
+  static BasicValue parse(std::string const& text);
 
   /**
    * Accesses coefficients of the polynomial. If a coefficient
    * with given index is not existing it is created with a zero
-   * value.
+   * value. Integer coefficients are promoted to type T, as they
+   * can be modified using the reference.
    *
    * @param index Coefficient index
    * @return Reference to coefficient
    */
-  double& operator[](const unsigned long index);
+  T& operator[](const unsigned long index);
 
   /**
-   * Accesses coefficients of the polynomial.
+   * Accesses coefficients of the polynomial. Coefficients
+   * which are not existing are zero.
    *
    * @param index Coefficient index
    * @return Coefficient value
    */
-  double operator[](const unsigned long index) const;
+  T operator[](const unsigned long index) const;
 
   /**
    * Computes degree of the polynomial. A degree is an index
@@ -82,6 +113,27 @@ class Value {
    */
   std::string repr(std::string const& name) const;
 
+  /**
+   * Appends the algebraic form of the polynomial (as repr
+   * creates it) to the string, so a buffer of many results
+   * can be filled without temporary strings.
+   *
+   * @param output Destination string
+   * @param name Name of variable used in polynomial
+   */
+  void repr(std::string& output, std::string const& name) const;
+
+  /**
+   * Truncates the polynomial to given number of coefficients.
+   * Terms of degree equal or larger than order are dropped,
+   * while missing coefficients are filled with zeros, so every
+   * coefficient below order can be safely accessed afterwards.
+   *
+   * @param order Number of coefficients to keep (at least one)
+   * @return Reference to self
+   */
+  BasicValue& truncate(const unsigned long order);
+
   /**
    * Evaluates the polynomial using x as its value.
    * Uses quick Horner method to make calculations.
@@ -89,17 +141,17 @@ class Value {
    * @param x Value of x in polynomial (must be constant)
    * @return Evaluated polynomial
    */
-  Value operator()(Value const& x) const;
+  BasicValue operator()(BasicValue const& x) const;
 
   /**
-   * Converts polynomial to singular double value.
+   * Converts polynomial to a singular number.
    * Makes sense only with polynomial of degree zero
    * (constant polynomials).
    *
    * @throw PolynomialCastError When polynomial is not constant
    * @return Value of constant term
    */
-  explicit operator double() const;
+  explicit operator T() const;
 
   /**
    * Creates an algebraic form of polynomial, using
@@ -116,7 +168,7 @@ class Value {
    * @param other Polynomial to add
    * @return Reference to self
    */
-  Value& operator+=(Value const& other);
+  BasicValue& operator+=(BasicValue const& other);
 
   /**
    * Performs polynomial subtraction. This is a linear
@@ -125,7 +177,7 @@ class Value {
    * @param other Polynomial to subtract
    * @return Reference to self
    */
-  Value& operator-=(Value const& other);
+  BasicValue& operator-=(BasicValue const& other);
 
   /**
    * Performs polynomial multiplicaton. This used
@@ -135,7 +187,7 @@ class Value {
    * @param other Polynomial to multiply
    * @return Reference to self
    */
-  Value& operator*=(Value const& other);
+  BasicValue& operator*=(BasicValue const& other);
 
   /**
    * Performs polynomial division. A classical
@@ -148,7 +200,7 @@ class Value {
    * @param other Divider
    * @return Reference to self
    */
-  Value& operator/=(Value const& other);
+  BasicValue& operator/=(BasicValue const& other);
 
   /**
    * Creates a copy of self and adds another value.
@@ -156,7 +208,7 @@ class Value {
    * @param other Value to add
    * @return Copied result
    */
-  const Value operator+(Value const& other) const;
+  const BasicValue operator+(BasicValue const& other) const;
 
   /**
    * Creates a copy of self and subtracts another value.
@@ -164,7 +216,7 @@ class Value {
    * @param other Value to subtract
    * @return Copied result
    */
-  const Value operator-(Value const& other) const;
+  const BasicValue operator-(BasicValue const& other) const;
 
   /**
    * Creates a copy of self and multiples with another
@@ -173,7 +225,7 @@ class Value {
    * @param other Value to multiply
    * @return Copied result
    */
-  const Value operator*(Value const& other) const;
+  const BasicValue operator*(BasicValue const& other) const;
 
   /**
    * Creates a copy of self and divides it by another
@@ -182,7 +234,7 @@ class Value {
    * @param other Divider
    * @return Copied result
    */
-  const Value operator/(Value const& other) const;
+  const BasicValue operator/(BasicValue const& other) const;
 
   /**
    * Compares equality of two values. They values
@@ -192,7 +244,7 @@ class Value {
    * @param other Value to compare
    * @return True if equal
    */
-  bool operator==(Value const &other) const;
+  bool operator==(BasicValue const &other) const;
 
   /**
    * Performs inequality test using previously defined
@@ -201,13 +253,57 @@ class Value {
    * @param other Value to compare
    * @return True if not equal
    */
-  bool operator!=(Value const &other) const;
+  bool operator!=(BasicValue const &other) const;
+
+  /**
+   * Checks if coefficients are stored as integers.
+   *
+   * @return True if integer arithmetic is used
+   */
+  bool is_integral() const { return integral; }
 
   private:
 
-  //! Polynomial coefficients
-  std::vector<double> coefficients;
+  //! Polynomial coefficients (unless integral)
+  std::vector<T> coefficients;
+
+  //! Integer polynomial coefficients (if integral)
+  std::vector<std::int64_t> integers;
+
+  //! Representation of coefficients
+  bool integral;
+
+  /**
+   * Largest magnitude of integer coefficients. Integer
+   * arithmetic is exact in T up to this value, so both
+   * representations give the same results.
+   *
+   * @return Limit of integer coefficients
+   */
+  static std::int64_t limit();
+
+  //! Switches to integer coefficients if all coefficients allow it
+  void compact();
+
+  //! Switches to coefficients of type T
+  void promote();
 };
 
+/**
+ * Polynomial with double coefficients
+ */
+typedef BasicValue<double> Value;
+
+//! Polynomial with single precision coefficients
+typedef BasicValue<float> FloatValue;
+
+//! Polynomial with extended precision coefficients
+typedef BasicValue<long double> LongDoubleValue;
+
+#ifdef XXCALC_FLOAT128
+//! Polynomial with quadruple precision coefficients
+typedef BasicValue<__float128> Float128Value;
+#endif
+
 }
 }
@@ -0,0 +1,110 @@
+#include "calculator/allocations.hpp"
+#include "calculator/columns.hpp"
+#include "calculator/polynomial_calculator.hpp"
+#include "catch.hpp"
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace XX::Calculator;
+
+//! Counts allocations made by an expression
+#define allocations_of(x) ([&]() { Allocations first = Allocations::current(); x; return Allocations::current() - first; }())
+
+TEST_CASE("counting allocations", "[allocations]") {
+  std::unique_ptr<long> number;
+  Allocations made = allocations_of(number.reset(new long(42)));
+  REQUIRE(made.count == 1);
+  REQUIRE(made.bytes == sizeof(long));
+
+  std::vector<char> data;
+  made = allocations_of(data.resize(1000));
+  REQUIRE(made.count == 1);
+  REQUIRE(made.bytes == 1000);
+
+  // allocations of other threads are not counted
+  made = allocations_of(std::thread([&data]() { data.resize(1000000); }).join());
+  REQUIRE(data.size() == 1000000);
+  REQUIRE(made.bytes < 1000000);
+
+  REQUIRE(allocations_of().count == 0);
+}
+
+TEST_CASE("allocation free paths", "[allocations]") {
+  Tokenizer tokenizer;
+  Parser parser;
+  PolynomialCalculator calculator(tokenizer, parser);
+  Evaluator::Program program;
+
+  SECTION("compiled scalar expressions allocate only their result") {
+    TokenList tokens = parser.process(tokenizer.process("1+2*log(3, 2)/4-exp(1)"));
+    calculator.compile([&](Evaluator& evaluator, Evaluator::Program& program) {
+      evaluator.compile(tokens, program);
+    }, program);
+    REQUIRE(program.scalar);
+
+    Evaluator evaluator;
+    Value result;
+    result = evaluator.execute(program);
+
+    Allocations made = allocations_of(result = evaluator.execute(program));
+    REQUIRE(made.count == allocations_of(result = Value(0.5)).count);
+  }
+
+  SECTION("arithmetic in place of values of the same degree") {
+    Value a(1, 2), b(3, 4);
+
+    REQUIRE(allocations_of(a += b).count == 0);
+    REQUIRE(allocations_of(a -= b).count == 0);
+  }
+
+  SECTION("evaluation over columns does not depend on number of rows") {
+    ColumnProgram columns(calculator, "3x^2+log(b, 2)-x/b", {"x", "b"});
+
+    std::vector<double> x(10000, 2), b(10000, 4), output(10000);
+    double const* inputs[] = {x.data(), b.data()};
+
+    Allocations few = allocations_of(columns.evaluate(inputs, 10, output.data()));
+    Allocations many = allocations_of(columns.evaluate(inputs, 10000, output.data()));
+    REQUIRE(few.count == many.count);
+    REQUIRE(few.bytes == many.bytes);
+  }
+}
+
+TEST_CASE("memory reused between calculations", "[allocations]") {
+  Tokenizer tokenizer;
+  Parser parser;
+
+  SECTION("tokenizing into spare nodes") {
+    TokenList spare = tokenizer.process("1+2*(3-4)");
+    TokenList tokens;
+
+    REQUIRE(allocations_of(tokens = tokenizer.process("5-6/(7+8)", spare)).count == 0);
+    REQUIRE(tokens.size() == 9);
+    REQUIRE(spare.empty());
+  }
+
+  SECTION("parsing moves nodes of tokens") {
+    // registers operators
+    PolynomialCalculator calculator(tokenizer, parser);
+    TokenList tokens = tokenizer.process("log(1+2*(3-4), 2)^5");
+    TokenList rpn;
+
+    REQUIRE(allocations_of(rpn = parser.process(tokens)).count == 0);
+    REQUIRE(rpn.size() == 11);
+    REQUIRE(tokens.empty());
+  }
+
+  SECTION("repeated calculations") {
+    for (std::string expression : {"2+2*2", "(x+1)^2*(x-3)", "log(2, 10)*pi+e"}) {
+      PolynomialCalculator calculator(tokenizer, parser);
+
+      Allocations first = allocations_of(calculator.process(expression));
+      Allocations second = allocations_of(calculator.process(expression));
+
+      REQUIRE(second.count < first.count);
+      REQUIRE(allocations_of(calculator.process(expression)).count == second.count);
+    }
+  }
+}
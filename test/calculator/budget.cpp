@@ -0,0 +1,133 @@
+#include "calculator/budget.hpp"
+#include "calculator/allocations.hpp"
+#include "calculator/linear_solver.hpp"
+#include "catch.hpp"
+
+#include <chrono>
+#include <thread>
+
+using namespace XX::Calculator;
+
+TEST_CASE("limits of calculations", "[budget]") {
+  Tokenizer tokenizer;
+  Parser parser;
+  LinearSolver solver(tokenizer, parser);
+  Limits limits;
+
+  SECTION("degree") {
+    limits.degree = 1000;
+    solver.set_limits(limits);
+
+    REQUIRE(solver.process("(x+1)^1000").degree() == 1000);
+    REQUIRE(solver.process("(x+1)^500*(x-1)^500").degree() == 1000);
+
+    // fails before coefficients are allocated
+    Allocations first = Allocations::current();
+    REQUIRE_THROWS_AS(solver.process("x^100000000"), BudgetExceededError);
+    REQUIRE((Allocations::current() - first).bytes < 100000);
+
+    REQUIRE_THROWS_AS(solver.process("(x+1)^600*(x-1)^600"), BudgetExceededError);
+    REQUIRE_THROWS_AS(solver.process("x^1e15"), BudgetExceededError);
+    REQUIRE_THROWS_AS(solver.process("x^1e300"), ExponentationError);
+  }
+
+  SECTION("memory") {
+    limits.memory = 100000;
+    solver.set_limits(limits);
+
+    REQUIRE(solver.process("(x+1)^10").degree() == 10);
+    REQUIRE_THROWS_AS(solver.process("(x+1)^1000"), BudgetExceededError);
+  }
+
+  SECTION("operations") {
+    limits.operations = 100000;
+    solver.set_limits(limits);
+
+    // every calculation has its own budget
+    for (int i = 0; i < 1000; i++)
+      REQUIRE(solver.process("(x+1)^20-2*3").degree() == 20);
+
+    REQUIRE_THROWS_AS(solver.process("(x+1)^100000"), BudgetExceededError);
+    REQUIRE_THROWS_AS(solver.process("(x^300+1)/(x+1)+(x^300+1)/(x+1)"), BudgetExceededError);
+  }
+
+  SECTION("time") {
+    limits.time = 0.05;
+    solver.set_limits(limits);
+
+    auto start = std::chrono::steady_clock::now();
+    REQUIRE_THROWS_AS(solver.process("(x+1)^100000"), BudgetExceededError);
+    REQUIRE(std::chrono::steady_clock::now() - start < std::chrono::seconds(5));
+
+    REQUIRE(solver.process("2+2*2") == 6);
+  }
+
+  SECTION("power series") {
+    limits.operations = 100000;
+    solver.set_limits(limits);
+    solver.set_series_order(20);
+
+    REQUIRE(solver.process("exp(x)").degree() == 19);
+
+    // steps of inverse, logarithm and exponential are charged
+    solver.set_series_order(100000);
+    for (std::string line : {"1/(1-x)", "log(1+x, e)", "exp(x)", "(1+x)^0.5"}) {
+      INFO(line);
+      REQUIRE_THROWS_AS(solver.process(line), BudgetExceededError);
+    }
+  }
+
+  SECTION("exact values") {
+    BasicLinearSolver<ExactValue> exact(tokenizer, parser);
+    limits.degree = 100;
+    exact.set_limits(limits);
+
+    REQUIRE(exact.process("(x+1)^100").degree() == 100);
+    REQUIRE_THROWS_AS(exact.process("(x+1)^101"), BudgetExceededError);
+    REQUIRE_THROWS_AS(exact.process("(x+1)^50*(x+1)^51"), BudgetExceededError);
+  }
+
+  SECTION("errors are evaluation errors") {
+    limits.degree = 10;
+    solver.set_limits(limits);
+
+    REQUIRE_THROWS_AS(solver.process("x^11"), EvaluationError);
+    REQUIRE_THROWS_WITH(solver.process("x^11"), "Degree 11 exceeds limit of 10");
+
+    // no limits
+    solver.set_limits(Limits());
+    REQUIRE(solver.process("x^11").degree() == 11);
+  }
+
+  SECTION("exponents out of range fail without limits") {
+    REQUIRE_THROWS_AS(solver.process("x^inf"), ExponentationError);
+    REQUIRE_THROWS_AS(solver.process("(x+1)^1e20"), ExponentationError);
+    REQUIRE(solver.try_process("x-^inf/1^1e3e*").status.code == ErrorCode::EXPONENTATION);
+  }
+}
+
+TEST_CASE("cancellation of calculations", "[budget]") {
+  Tokenizer tokenizer;
+  Parser parser;
+  LinearSolver solver(tokenizer, parser);
+  Cancellation cancellation;
+
+  solver.set_limits(Limits(), &cancellation);
+  REQUIRE(solver.process("(x+1)^10").degree() == 10);
+
+  SECTION("from another thread") {
+    std::thread canceller([&]() {
+      std::this_thread::sleep_for(std::chrono::milliseconds(20));
+      cancellation.cancel();
+    });
+
+    REQUIRE_THROWS_WITH(solver.process("(x+1)^100000"), "Evaluation was cancelled");
+    canceller.join();
+  }
+
+  SECTION("before calculation") {
+    cancellation.cancel();
+    REQUIRE(cancellation.is_cancelled());
+    REQUIRE_THROWS_AS(solver.process("2+2"), BudgetExceededError);
+  }
+}
@@ -0,0 +1,74 @@
+#include "calculator/columns.hpp"
+#include "calculator/errors.hpp"
+#include "catch.hpp"
+
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+using namespace XX::Calculator;
+
+TEST_CASE("evaluation over columns", "[columns]") {
+  Tokenizer tokenizer;
+  Parser parser;
+  PolynomialCalculator calculator(tokenizer, parser);
+
+  std::mt19937 generator(42);
+  std::uniform_real_distribution<double> distribution(-100, 100);
+
+  // more rows than a single block
+  const std::size_t rows = 1000;
+  std::vector<double> a(rows), b(rows), output(rows);
+  for (std::size_t i = 0; i < rows; i++) {
+    a[i] = distribution(generator);
+    b[i] = distribution(generator);
+  }
+
+  // every row gives the same result as evaluation of the expression
+  // with inputs replaced by numbers of the row
+  for (std::string expression : {"a", "2*a+b/3-pi", "log(a*a+1, 2)+exp(b/100)-b^2",
+                                 "bind(a, b)+a^3", "(a-b)*(a+b)/a", "1+2*3"}) {
+    ColumnProgram program(calculator, expression, {"a", "unused", "b"});
+    double const* columns[] = {a.data(), nullptr, b.data()};
+
+    REQUIRE_FALSE(program.uses(1));
+    program.evaluate(columns, rows, output.data());
+
+    Tokenizer row_tokenizer;
+    Parser row_parser;
+    PolynomialCalculator row_calculator(row_tokenizer, row_parser);
+
+    for (std::size_t i = 0; i < rows; i++) {
+      row_calculator.register_constant("a", a[i]);
+      row_calculator.register_constant("b", b[i]);
+      REQUIRE(row_calculator.process(expression) == output[i]);
+    }
+  }
+
+  // columns take precedence over constants, so polynomials of x
+  // are evaluated by a column named x
+  ColumnProgram program(calculator, "3x^2+x*e", {"x", "e"});
+  double const* columns[] = {a.data(), b.data()};
+  program.evaluate(columns, 3, output.data());
+  REQUIRE(output[2] == 3*a[2]*a[2] + a[2]*b[2]);
+
+  // nothing to evaluate
+  program.evaluate(columns, 0, output.data());
+}
+
+TEST_CASE("invalid columnar expressions", "[columns]") {
+  Tokenizer tokenizer;
+  Parser parser;
+  PolynomialCalculator calculator(tokenizer, parser);
+
+  REQUIRE_THROWS_AS(ColumnProgram(calculator, "(a", {"a"}), ParsingError);
+  REQUIRE_THROWS_AS(ColumnProgram(calculator, "a+foo", {"a"}), UnknownSymbolError);
+  REQUIRE_THROWS_AS(ColumnProgram(calculator, "a+1e999", {"a"}), InvalidNumberError);
+  REQUIRE_THROWS_AS(ColumnProgram(calculator, "log(a)", {"a"}), ArgumentMissingError);
+  REQUIRE_THROWS_AS(ColumnProgram(calculator, "a+x", {"a"}), EvaluationError);
+  REQUIRE_THROWS_AS(ColumnProgram(calculator, "a*ans", {"a"}), EvaluationError);
+
+  // series arithmetic has no scalar implementation
+  calculator.set_series_order(4);
+  REQUIRE_THROWS_AS(ColumnProgram(calculator, "a+1", {"a"}), EvaluationError);
+}
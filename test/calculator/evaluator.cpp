@@ -5,7 +5,9 @@
 #include "catch.hpp"
 
 #include <limits>
+#include <map>
 #include <cmath>
+#include <string>
 
 using namespace XX::Calculator;
 
@@ -101,3 +103,281 @@ TEST_CASE("evaluation", "[evaluator]") {
     REQUIRE(eval("x+x") == eval("2x"));
   }
 }
+
+TEST_CASE("scalar evaluation", "[evaluator]") {
+  typedef Evaluator::ScalarFunction::Operation Operation;
+
+  Tokenizer tokenizer;
+  Parser parser;
+  Evaluator evaluator;
+  Evaluator::Program program;
+
+  parser.register_operator("+", 1, -1);
+  evaluator.register_function("+", 2, Functions::addition, Operation::ADDITION);
+  parser.register_operator("/", 5, -1);
+  evaluator.register_function("/", 2, Functions::division, Operation::DIVISION);
+  parser.register_operator("^", 10, 1);
+  evaluator.register_function("^", 2, Functions::exponentiation, Functions::Scalar::exponentiation);
+  evaluator.register_function("log10", 1, Functions::log10);
+  evaluator.register_constant("x", Value(0, 1));
+  evaluator.register_constant("two", 2);
+
+  #define compile(x) (evaluator.compile(parser.process(tokenizer.process((x))), program))
+
+  SECTION("constant expressions") {
+    compile("1+two^3/4");
+    REQUIRE(program.scalar);
+    REQUIRE(program.instructions.size() == 7);
+    REQUIRE(evaluator.execute(program) == 3);
+
+    REQUIRE(eval("1/0") == std::numeric_limits<double>::infinity());
+    REQUIRE(std::signbit(double(eval("-0+-0"))));
+  }
+
+  SECTION("polynomial expressions") {
+    compile("1+x");
+    REQUIRE_FALSE(program.scalar);
+    REQUIRE(evaluator.execute(program) == Value(1, 1));
+
+    compile("(x+1)^2/x");
+    REQUIRE_FALSE(program.scalar);
+  }
+
+  SECTION("functions without scalar implementation") {
+    compile("log10(100)+1");
+    REQUIRE_FALSE(program.scalar);
+    REQUIRE(evaluator.execute(program) == 3);
+
+    evaluator.register_function("log10", 1, Functions::log10, Functions::Scalar::log10);
+    compile("log10(100)+1");
+    REQUIRE(program.scalar);
+
+    evaluator.register_function("^", 2, Functions::exponentiation);
+    compile("1+two^3/4");
+    REQUIRE_FALSE(program.scalar);
+  }
+
+  SECTION("errors") {
+    compile("1+foo");
+    REQUIRE_FALSE(program.scalar);
+    REQUIRE_THROWS_AS(evaluator.execute(program), UnknownSymbolError);
+
+    // errors are reported in order of evaluation
+    REQUIRE_THROWS_AS(eval("x^x+foo"), ExponentationError);
+    REQUIRE_THROWS_AS(eval("1+2 3"), EvaluationError);
+  }
+
+  #undef compile
+}
+
+TEST_CASE("optimization of programs", "[evaluator]") {
+  typedef Evaluator::ScalarFunction::Operation Operation;
+  typedef Evaluator::Instruction::Type Type;
+
+  Tokenizer tokenizer;
+  Parser parser;
+  Evaluator evaluator;
+  Evaluator::Program program;
+  int counter = 0;
+
+  parser.register_operator("+", 1, -1);
+  evaluator.register_function("+", 2, Functions::addition, Operation::ADDITION, true);
+  parser.register_operator("-", 1, -1);
+  evaluator.register_function("-", 2, Functions::subtraction, Operation::SUBTRACTION, true);
+  parser.register_operator("*", 5, -1);
+  evaluator.register_function("*", 2, Functions::multiplication, Operation::MULTIPLICATION, true);
+  parser.register_operator("/", 5, -1);
+  evaluator.register_function("/", 2, Functions::division, Operation::DIVISION, true);
+  parser.register_operator("^", 10, 1);
+  evaluator.register_function("^", 2, Functions::exponentiation,
+                              Evaluator::ScalarFunction(Operation::EXPONENTIATION, Functions::Scalar::exponentiation),
+                              true);
+  evaluator.register_function("log10", 1, Functions::log10, Evaluator::ScalarFunction(), true);
+  evaluator.register_function("counter", 0, [&](std::vector<Value> const& args) {
+    return counter++;
+  });
+  evaluator.register_constant("x", Value(0, 1));
+  evaluator.register_constant("pi", M_PI);
+
+  #define compile(x) (evaluator.compile(parser.process(tokenizer.process((x))), program))
+
+  SECTION("constant subexpressions are folded") {
+    compile("2*pi*(3+4)*x");
+    REQUIRE(program.instructions.size() == 1);
+    REQUIRE(evaluator.execute(program) == Value(0, 2 * M_PI * 7));
+
+    compile("log10(100)+(x+1)^2");
+    REQUIRE(program.instructions.size() == 1);
+    REQUIRE(program.instructions[0].type == Type::PUSH);
+    REQUIRE(evaluator.execute(program) == Value({3, 2, 1}));
+
+    // folded program is evaluated on scalars
+    compile("log10(100)+1");
+    REQUIRE(program.scalar);
+    REQUIRE(evaluator.execute(program) == 3);
+  }
+
+  SECTION("scalar programs are optimized on demand") {
+    compile("2*pi*(3+4)*1");
+    REQUIRE(program.scalar);
+    REQUIRE(program.instructions.size() == 9);
+
+    evaluator.optimize(program);
+    REQUIRE(program.scalar);
+    REQUIRE(program.instructions.size() == 1);
+    REQUIRE(evaluator.execute(program) == 2 * M_PI * 7);
+  }
+
+  SECTION("impure functions are called when evaluated") {
+    compile("counter*(2+3)");
+    REQUIRE(program.instructions.size() == 3);
+    REQUIRE(evaluator.execute(program) == 0);
+    REQUIRE(eval("counter*(2+3)") == 5);
+    REQUIRE(eval("counter+counter") == 5);
+    REQUIRE(counter == 4);
+  }
+
+  SECTION("operators without effect are removed") {
+    for (std::string line : {"counter*1", "1*counter", "counter/1", "counter^1", "counter-0", "(0*-2)+counter",
+                             "counter+-0", "(counter*1)^(2-1)"}) {
+      INFO(line);
+      compile(line);
+      REQUIRE(program.instructions.size() == 1);
+      REQUIRE(program.instructions[0].type == Type::CALL);
+    }
+
+    compile("3*(1*counter)+1");
+    REQUIRE(program.instructions.size() == 5);
+    REQUIRE(evaluator.execute(program) == 1);
+
+    // adding positive zero changes sign of negative zero
+    compile("counter+0");
+    REQUIRE(program.instructions.size() == 3);
+    compile("counter-(0*-1)");
+    REQUIRE(program.instructions.size() == 3);
+    compile("counter*2");
+    REQUIRE(program.instructions.size() == 3);
+  }
+
+  SECTION("failing calls fail when evaluated") {
+    compile("x^x+foo");
+    REQUIRE_THROWS_AS(evaluator.execute(program), ExponentationError);
+
+    compile("x/x^2");
+    REQUIRE(program.instructions.size() == 3);
+    REQUIRE_THROWS_AS(evaluator.execute(program), PolynomialDivisionError);
+  }
+
+  SECTION("repeated subexpressions are evaluated once") {
+    int calls = 0;
+    evaluator.register_function("slow", 1, [&](std::vector<Value> const& args) {
+      calls++;
+      return args[0] * args[0];
+    }, Evaluator::ScalarFunction(), true);
+
+    compile("slow(x+1)*slow(x+1)+slow(1+x)-slow(x+1)");
+    REQUIRE(calls == 2);
+    REQUIRE(program.eliminated == 4);
+    REQUIRE(evaluator.execute(program) == Value({1, 4, 6, 4, 1}));
+
+    // zeros of different signs are different values
+    compile("slow(-0)+slow(0)+slow(-0)");
+    REQUIRE(calls == 4);
+    REQUIRE(program.eliminated == 1);
+
+    // calls of impure functions are never the same
+    compile("counter*x+counter*x");
+    REQUIRE(program.eliminated == 0);
+    REQUIRE(evaluator.execute(program) == Value(0, 1));
+
+    compile("x^x+slow(x^x)");
+    REQUIRE(program.eliminated == 0);
+    REQUIRE_THROWS_AS(evaluator.execute(program), ExponentationError);
+
+    // exact numbers nearest to the same double are different values
+    BasicEvaluator<ExactValue> exact;
+    BasicEvaluator<ExactValue>::Program exact_program;
+    exact.register_function("+", 2, BasicFunctions<ExactValue>::addition,
+                            BasicEvaluator<ExactValue>::ScalarFunction::Operation::ADDITION, true);
+    exact.register_function("slow", 1, [&](std::vector<ExactValue> const& args) {
+      calls++;
+      return args[0] * args[0];
+    }, BasicEvaluator<ExactValue>::ScalarFunction(), true);
+
+    (exact.compile)(parser.process(tokenizer.process("slow(0.33333333333333333333)+slow(0.333333333333333333333)+"
+                                                     "slow(0.33333333333333333333)")), exact_program);
+    REQUIRE(calls == 6);
+    REQUIRE(exact_program.eliminated == 1);
+  }
+
+  SECTION("chains of additions are summed at once") {
+    std::string sum = "1", difference = "-1";
+    for (int i = 2; i <= 100; i++) {
+      sum += "+" + std::to_string(i);
+      difference += "-" + std::to_string(i);
+    }
+
+    compile(sum + difference);
+    REQUIRE(program.scalar);
+    REQUIRE(program.scalar_instructions.size() == 301);
+    REQUIRE(program.scalar_instructions.back().type == Type::SUM);
+    REQUIRE(program.scalar_instructions.back().index == 200);
+    REQUIRE(evaluator.execute(program) == 0);
+
+    // terms are added pairwise, in order of additions if there are few
+    std::string tenths = "0.1";
+    for (int i = 1; i < 1000; i++)
+      tenths += "+0.1";
+
+    REQUIRE(double(eval(tenths)) == Approx(100).epsilon(1e-15));
+    REQUIRE(double(eval("0.1+0.2-0.3")) == 0.1 + 0.2 - 0.3);
+    REQUIRE(std::signbit(double(eval("-0-0"))));
+    REQUIRE(std::signbit(double(eval("1-0/0"))) == std::signbit(double(eval("0/0"))));
+
+    // products and parentheses end chains
+    compile("1+2*3+(4+5)-6");
+    REQUIRE(program.scalar_instructions.size() == 10);
+    REQUIRE(program.scalar_instructions.back().index == 4);
+    REQUIRE(evaluator.execute(program) == 10);
+  }
+
+  SECTION("wrapped functions are not folded") {
+    evaluator.wrap_functions([](std::string const& name, Evaluator::Handler handler) {
+      return handler;
+    });
+
+    compile("2*pi*x");
+    REQUIRE(program.instructions.size() == 5);
+    REQUIRE(evaluator.execute(program) == Value(0, 2 * M_PI));
+  }
+
+  #undef compile
+}
+
+TEST_CASE("wrapped functions", "[evaluator]") {
+  typedef Evaluator::ScalarFunction::Operation Operation;
+
+  Tokenizer tokenizer;
+  Parser parser;
+  Evaluator evaluator;
+  Evaluator::Program program;
+  std::map<std::string, int> calls;
+
+  parser.register_operator("+", 1, -1);
+  evaluator.register_function("+", 2, Functions::addition, Operation::ADDITION);
+  evaluator.register_function("log10", 1, Functions::log10, Functions::Scalar::log10);
+
+  evaluator.wrap_functions([&](std::string const& name, Evaluator::Handler handler) -> Evaluator::Handler {
+    return [&calls, name, handler](std::vector<Value> const& args) {
+      calls[name]++;
+      return handler(args);
+    };
+  });
+
+  // every call goes through the wrapped handler
+  evaluator.compile(parser.process(tokenizer.process("log10(100)+1+2")), program);
+  REQUIRE_FALSE(program.scalar);
+  REQUIRE(evaluator.execute(program) == 5);
+  REQUIRE(calls["+"] == 2);
+  REQUIRE(calls["log10"] == 1);
+}
@@ -0,0 +1,54 @@
+#include "calculator/exact_value.hpp"
+#include "calculator/errors.hpp"
+#include "catch.hpp"
+
+using namespace XX::Calculator;
+
+TEST_CASE("exact initialization", "[exact_value]") {
+  REQUIRE(ExactValue()[0] == 0);
+  REQUIRE(ExactValue::parse("0.1")[0] == Rational(1) / Rational(10));
+  REQUIRE(ExactValue(0.5, 2.0)[1] == Rational(2));
+  REQUIRE(ExactValue({1, 0, 0}).degree() == 0);
+  REQUIRE(double(ExactValue::parse("0.25")) == 0.25);
+
+  double k;
+  REQUIRE_THROWS_AS((k = double(ExactValue(1.0, 1.0))), PolynomialCastError);
+}
+
+TEST_CASE("exact representation", "[exact_value]") {
+  REQUIRE(ExactValue().repr("x") == "0");
+  REQUIRE(ExactValue({Rational(1) / Rational(3), Rational(-1), Rational(1) / Rational(2)}).repr("x") ==
+          "(1/2)x^2-x+1/3");
+  REQUIRE(ExactValue(Rational(0), Rational(-3) / Rational(4)).repr("y") == "-(3/4)y");
+  REQUIRE(std::string(ExactValue(-1.0, 2.0)) == "2x-1");
+}
+
+TEST_CASE("exact arithmetic", "[exact_value]") {
+  ExactValue a(1.0, 1.0);
+  ExactValue b({Rational(1) / Rational(3), 0, 1});
+
+  REQUIRE((a + b) == ExactValue({Rational(4) / Rational(3), 1, 1}));
+  REQUIRE((a - a) == ExactValue());
+  REQUIRE((a * b) == ExactValue({Rational(1) / Rational(3), Rational(1) / Rational(3), 1, 1}));
+  REQUIRE((a * b / b) == a);
+  REQUIRE((b / ExactValue(3.0)) == ExactValue({Rational(1) / Rational(9), 0, Rational(1) / Rational(3)}));
+  REQUIRE(b(ExactValue(2.0)) == ExactValue(Rational(13) / Rational(3)));
+
+  REQUIRE_THROWS_AS(a / b, PolynomialDivisionError);
+  REQUIRE_THROWS_AS(b(a), PolynomialCastError);
+}
+
+TEST_CASE("exact transform multiplication", "[exact_value]") {
+  std::vector<Rational> p, q;
+  for (long long i = 0; i < 100; i++) {
+    p.push_back(Rational(Integer(i - 50), Integer(i % 7 + 1)));
+    q.push_back(Rational(Integer(3 * i + 1), Integer(i % 5 + 2)));
+  }
+
+  std::vector<Rational> expected(p.size() + q.size() - 1);
+  for (unsigned long i = 0; i < p.size(); i++)
+    for (unsigned long j = 0; j < q.size(); j++)
+      expected[i + j] += p[i] * q[j];
+
+  REQUIRE((ExactValue(p) * ExactValue(q)) == ExactValue(expected));
+}
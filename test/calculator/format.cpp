@@ -0,0 +1,67 @@
+#include "calculator/format.hpp"
+#include "catch.hpp"
+
+#include <cmath>
+#include <limits>
+#include <random>
+#include <sstream>
+
+using namespace XX::Calculator;
+
+namespace {
+
+std::string format(double x, int precision = 6) {
+  std::string output;
+  append_number(output, x, precision);
+  return output;
+}
+
+std::string stream(double x, int precision = 6) {
+  std::ostringstream output;
+  output.precision(precision);
+  output << x;
+  return output.str();
+}
+
+}
+
+TEST_CASE("number formatting", "[format]") {
+  REQUIRE(format(0) == "0");
+  REQUIRE(format(-0.0) == "-0");
+  REQUIRE(format(42) == "42");
+  REQUIRE(format(-0.1) == "-0.1");
+  REQUIRE(format(123456) == "123456");
+  REQUIRE(format(1234567) == "1.23457e+06");
+  REQUIRE(format(999999.5) == "1e+06");
+  REQUIRE(format(0.0001234565) == "0.000123457");
+  REQUIRE(format(1e-5) == "1e-05");
+  REQUIRE(format(1e300) == "1e+300");
+  REQUIRE(format(std::numeric_limits<double>::infinity()) == "inf");
+  REQUIRE(format(-std::numeric_limits<double>::infinity()) == "-inf");
+  REQUIRE(format(std::numeric_limits<double>::quiet_NaN()) == "nan");
+
+  // ties are rounded to even
+  REQUIRE(format(1.015625) == "1.01562");
+  REQUIRE(format(1234565) == "1.23456e+06");
+  REQUIRE(format(2.5, 1) == "2");
+
+  REQUIRE(format(0.1, 17) == "0.10000000000000001");
+  REQUIRE(format(M_PI, 0) == "3");
+  REQUIRE(format(M_PI, 30) == stream(M_PI, 30));
+}
+
+TEST_CASE("number formatting matches streams", "[format]") {
+  std::mt19937_64 random(42);
+  std::uniform_real_distribution<double> mantissa(-1, 1);
+  std::uniform_int_distribution<int> exponent(-330, 330);
+
+  for (int i = 0; i < 10000; i++) {
+    double x = std::ldexp(mantissa(random), exponent(random) * 3);
+    double y = std::round(x * 1e6) / 64;
+    int precision = 1 + i % 17;
+
+    REQUIRE(format(x) == stream(x));
+    REQUIRE(format(x, precision) == stream(x, precision));
+    REQUIRE(format(y) == stream(y));
+  }
+}
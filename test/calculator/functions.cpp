@@ -32,6 +32,15 @@ TEST_CASE("exponentiation function", "[functions]") {
     REQUIRE_THROWS_AS(Functions::exponentiation({2, Value(0, 1)}), ExponentationError);
     REQUIRE_THROWS_AS(Functions::exponentiation({Value(0, 1), 1.23}), ExponentationError);
   }
+
+  SECTION("exponents out of range") {
+    double inf = std::numeric_limits<double>::infinity();
+
+    REQUIRE_THROWS_AS(Functions::exponentiation({Value(0, 1), inf}), ExponentationError);
+    REQUIRE_THROWS_AS(Functions::exponentiation({Value(1, 1), inf}), ExponentationError);
+    REQUIRE_THROWS_AS(Functions::exponentiation({Value(0, 1), 1e30}), ExponentationError);
+    REQUIRE(Functions::exponentiation({2, inf}) == inf);
+  }
 }
 
 TEST_CASE("mathematical functions", "[functions]") {
@@ -41,3 +50,64 @@ TEST_CASE("mathematical functions", "[functions]") {
 
   REQUIRE_THROWS_AS(Functions::log10({Value(1, 1)}), PolynomialCastError);
 }
+
+TEST_CASE("power series functions", "[functions]") {
+  SECTION("arithmetic") {
+    REQUIRE(Functions::Series::multiply(Value(1, 1), Value(1, 1), 2) == Value(1, 2));
+    REQUIRE(Functions::Series::addition({Value({0, 0, 1}), Value(1)}, 2) == 1);
+    REQUIRE(Functions::Series::division({1, Value(1, -1)}, 4) == Value({1, 1, 1, 1}));
+    REQUIRE(Functions::Series::division({Value(0, 1), Value({0, 1, 1})}, 3) == Value({1, -1, 1}));
+    REQUIRE_THROWS_AS(Functions::Series::division({1, Value(0, 1)}, 4), SeriesExpansionError);
+    REQUIRE_THROWS_AS(Functions::Series::division({Value(1, 1), Value({0, 0, 1})}, 4), SeriesExpansionError);
+  }
+
+  SECTION("inverse") {
+    Value a({2, 3, 5, 7});
+    Value b = Functions::Series::multiply(a, Functions::Series::inverse(a, 16), 16);
+
+    REQUIRE(b[0] == Approx(1));
+    for (unsigned long i = 1; i < 16; i++)
+      REQUIRE(b[i] == Approx(0).margin(1e-9));
+
+    REQUIRE_THROWS_AS(Functions::Series::inverse(Value(0, 1), 4), SeriesExpansionError);
+  }
+
+  SECTION("logarithm and exponential") {
+    Value l = Functions::Series::logarithm(Value(1, 1), 5);
+    REQUIRE(l[0] == 0);
+    REQUIRE(l[1] == Approx(1));
+    REQUIRE(l[2] == Approx(-1.0/2));
+    REQUIRE(l[3] == Approx(1.0/3));
+    REQUIRE(l[4] == Approx(-1.0/4));
+
+    Value e = Functions::Series::exponential(Value(0, 1), 6);
+    double factorial = 1;
+    for (unsigned long i = 0; i < 6; i++) {
+      REQUIRE(e[i] == Approx(1 / factorial));
+      factorial *= i + 1;
+    }
+
+    Value a({3, 1, 4, 1, 5});
+    Value b = Functions::Series::exponential(Functions::Series::logarithm(a, 8), 8);
+    for (unsigned long i = 0; i < 8; i++)
+      REQUIRE(b[i] == Approx(i < 5 ? a[i] : 0).margin(1e-9));
+
+    REQUIRE_THROWS_AS(Functions::Series::logarithm(Value(-1, 1), 4), SeriesExpansionError);
+  }
+
+  SECTION("power") {
+    REQUIRE(Functions::Series::power(Value(1, 1), 3, 8) == Value({1, 3, 3, 1}));
+    REQUIRE(Functions::Series::power(Value(1, 1), 3, 2) == Value(1, 3));
+
+    Value s = Functions::Series::power(Value(1, 1), 0.5, 4);
+    REQUIRE(s[0] == Approx(1));
+    REQUIRE(s[1] == Approx(0.5));
+    REQUIRE(s[2] == Approx(-0.125));
+    REQUIRE(s[3] == Approx(0.0625));
+
+    REQUIRE(Functions::Series::power(Value({0, 0, 4}), 0.5, 4) == Value(0, 2));
+    REQUIRE_THROWS_AS(Functions::Series::power(Value(0, 1), 0.5, 4), ExponentationError);
+    REQUIRE_THROWS_AS(Functions::Series::power(Value(-1, 1), 0.5, 4), ExponentationError);
+    REQUIRE_THROWS_AS(Functions::Series::power(Value(1, 1), std::numeric_limits<double>::infinity(), 4), ExponentationError);
+  }
+}
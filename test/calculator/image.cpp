@@ -0,0 +1,83 @@
+#include "calculator/image.hpp"
+#include "calculator/linear_solver.hpp"
+#include "calculator/errors.hpp"
+#include "catch.hpp"
+
+#include <stdexcept>
+#include <vector>
+
+using namespace XX::Calculator;
+
+namespace {
+
+//! Compiles lines into an image
+std::string compile(std::vector<std::string> const& lines) {
+  Tokenizer tokenizer;
+  Parser parser;
+  LinearSolver solver(tokenizer, parser);
+  Image::Builder builder;
+
+  for (auto const& line : lines) {
+    try {
+      builder.add(parser.process(tokenizer.process(line)));
+    }
+    catch (ParsingError& error) {
+      builder.add_error(error.what());
+    }
+  }
+
+  std::string image;
+  builder.write(image);
+  return image;
+}
+
+}
+
+TEST_CASE("compiled image", "[image]") {
+  Tokenizer tokenizer;
+  Parser parser;
+  LinearSolver solver(tokenizer, parser);
+
+  std::string data = compile({"2+2*2", "(x+1)^2", "ans*2", "2x+1=2", "pi", "1e999", "foo", "(1", "1+"});
+  Image image(data.data(), data.data() + data.size());
+  std::string message;
+
+  auto evaluate = [&](std::size_t i) {
+    return solver.process([&](Evaluator& evaluator, Evaluator::Program& program) {
+      image.link(i, evaluator, program);
+    });
+  };
+
+  REQUIRE(image.size() == 9);
+  REQUIRE(evaluate(0) == 6);
+  REQUIRE(evaluate(1) == Value({1, 2, 1}));
+  REQUIRE(evaluate(2) == Value({2, 4, 2}));
+  REQUIRE_FALSE(solver.solved);
+  REQUIRE(evaluate(3) == 0.5);
+  REQUIRE(solver.solved);
+
+  // symbols are resolved when linked
+  solver.register_constant("foo", Value(42));
+  REQUIRE(evaluate(4) == Math<double>::pi());
+  REQUIRE_THROWS_AS(evaluate(5), InvalidNumberError);
+  REQUIRE(evaluate(6) == 42);
+
+  REQUIRE_FALSE(image.error(6, message));
+  REQUIRE(image.error(7, message));
+  REQUIRE(message == "Bracket is missing at 0");
+  REQUIRE_THROWS_AS(evaluate(8), ArgumentMissingError);
+}
+
+TEST_CASE("invalid images", "[image]") {
+  std::string data = compile({"1+2"});
+  char const* text = "1+2";
+
+  REQUIRE(Image::is_image(data.data(), data.data() + data.size()));
+  REQUIRE_FALSE(Image::is_image(text, text + 3));
+  REQUIRE_THROWS_AS(Image(data.data(), data.data() + data.size() - 1), std::runtime_error);
+  REQUIRE_THROWS_AS(BasicImage<FloatValue>(data.data(), data.data() + data.size()), std::runtime_error);
+
+  // step referring to a missing value
+  data[80 + 4] = 7;
+  REQUIRE_THROWS_AS(Image(data.data(), data.data() + data.size()), std::runtime_error);
+}
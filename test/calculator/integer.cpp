@@ -0,0 +1,57 @@
+#include "calculator/integer.hpp"
+#include "calculator/errors.hpp"
+#include "catch.hpp"
+
+#include <cmath>
+#include <limits>
+
+using namespace XX::Calculator;
+
+TEST_CASE("integer initialization", "[integer]") {
+  REQUIRE(Integer().is_zero());
+  REQUIRE(Integer(0).sign() == 0);
+  REQUIRE(Integer(-5).sign() == -1);
+  REQUIRE(Integer(5).str() == "5");
+  REQUIRE(Integer(-1234567890123456789LL).str() == "-1234567890123456789");
+  REQUIRE(Integer::parse("+000123").str() == "123");
+  REQUIRE(Integer::parse("-98765432109876543210987654321").str() == "-98765432109876543210987654321");
+  REQUIRE(Integer::from_double(-2.75) == Integer(-2));
+  REQUIRE(Integer::from_double(std::ldexp(1.0, 100)).str() == "1267650600228229401496703205376");
+
+  REQUIRE_THROWS_AS(Integer::parse("abc"), std::invalid_argument);
+  REQUIRE_THROWS_AS(Integer::from_double(std::numeric_limits<double>::infinity()), ValueError);
+}
+
+TEST_CASE("integer arithmetic", "[integer]") {
+  Integer a = Integer::parse("123456789012345678901234567890");
+  Integer b = Integer::parse("-987654321098765432109876543210");
+
+  REQUIRE((a + b).str() == "-864197532086419753208641975320");
+  REQUIRE((a - b).str() == "1111111110111111111011111111100");
+  REQUIRE((a * b).str() == "-121932631137021795226185032733622923332237463801111263526900");
+  REQUIRE((b / a).str() == "-8");
+  REQUIRE((b % a).str() == "-9000000000900000000090");
+  REQUIRE((a * b / b) == a);
+  REQUIRE((Integer(1) << 64).str() == "18446744073709551616");
+  REQUIRE(((Integer(1) << 64) >> 63) == Integer(2));
+  REQUIRE((Integer(-7) >> 1) == Integer(-3));
+
+  REQUIRE_THROWS_AS(a / Integer(), ValueError);
+}
+
+TEST_CASE("integer properties", "[integer]") {
+  REQUIRE(Integer().bits() == 0);
+  REQUIRE(Integer(255).bits() == 8);
+  REQUIRE(Integer(-256).bits() == 9);
+  REQUIRE(Integer(-7).modulo(5) == 3);
+  REQUIRE(Integer(-7).abs() == Integer(7));
+  REQUIRE(Integer::gcd(Integer(-12), Integer(18)) == Integer(6));
+  REQUIRE(Integer::gcd(Integer(), Integer(7)) == Integer(7));
+
+  REQUIRE(Integer(-3) < Integer(2));
+  REQUIRE(Integer::parse("100000000000000000000") > Integer(1));
+
+  REQUIRE(double(Integer(-12345)) == -12345.0);
+  REQUIRE(double(Integer::parse("9007199254740993")) == 9007199254740992.0);
+  REQUIRE(double(Integer::parse("9007199254740995")) == 9007199254740996.0);
+}
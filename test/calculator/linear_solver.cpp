@@ -5,6 +5,9 @@ using namespace XX::Calculator;
 
 #include <limits>
 #include <cmath>
+#include <random>
+#include <string>
+#include <vector>
 
 #define solve(x) (solver.process((x)))
 
@@ -42,3 +45,62 @@ TEST_CASE("solver", "[calculator]") {
     REQUIRE((solve("2"), solver.solved) == false);
   }
 }
+
+TEST_CASE("exact solver", "[calculator]") {
+  Tokenizer tokenizer;
+  Parser parser;
+  BasicLinearSolver<ExactValue> solver(tokenizer, parser);
+
+  REQUIRE(solve("3x = 1") == ExactValue(Rational(1) / Rational(3)));
+  REQUIRE(solve("0.1x + 0.2 = 0.3") == ExactValue(1.0));
+  REQUIRE(solver.solved);
+
+  REQUIRE_THROWS_AS(solve("x = x"), ExpressionIsTautology);
+  REQUIRE_THROWS_AS(solve("x = x + 1"), NonSolvableExpression);
+}
+
+TEST_CASE("optimized solver", "[calculator]") {
+  static const std::vector<std::string> pieces = {
+    "0", "1", "-0", "2", "0.5", "x", "x", "pi", "ans", "+", "-", "*", "/", "^", "=", "(", "(", ")", ")",
+    "*1", "+0", "-0", "/1", "^1", "1*", "0+", "bind(", "log(", ",", "(x+1)", "(x+1)", "(x-0)", "(ans*x)"
+  };
+
+  Tokenizer tokenizer;
+  Parser parser;
+  std::mt19937 random(11);
+
+  // calls of wrapped functions are never folded nor removed
+  auto outcome = [](LinearSolver& solver, std::string const& line) -> std::string {
+    LinearSolver::Outcome result = solver.try_process(line);
+
+    if (!result.ok())
+      return std::string(result.status.name()) + " " + result.status.message();
+
+    std::string text = (solver.solved ? "x=" : "") + std::string(result.value);
+    for (unsigned long i = 0; i <= result.value.degree(); i++)
+      text += std::signbit(double(result.value[i])) ? " -" : " +";
+
+    return text;
+  };
+
+  for (unsigned long order : {0, 4}) {
+    LinearSolver optimized(tokenizer, parser), plain(tokenizer, parser);
+    optimized.set_series_order(order);
+    plain.set_series_order(order);
+
+    plain.wrap_functions([](std::string const& name, Evaluator::Handler handler) {
+      return handler;
+    });
+
+    for (int i = 0; i < 20000; i++) {
+      std::string line;
+      std::size_t length = random() % 10;
+
+      for (std::size_t j = 0; j < length; j++)
+        line += pieces[random() % pieces.size()];
+
+      INFO(line);
+      REQUIRE(outcome(optimized, line) == outcome(plain, line));
+    }
+  }
+}
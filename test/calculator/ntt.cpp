@@ -0,0 +1,31 @@
+#include "calculator/ntt.hpp"
+#include "catch.hpp"
+
+using namespace XX::Calculator;
+
+TEST_CASE("modular convolution", "[ntt]") {
+  // 998244353 = 119*2^23+1 with primitive root 3
+  std::vector<std::uint32_t> a = {1, 2, 3}, b = {4, 5};
+  std::vector<std::uint32_t> c = NTT::convolve(a, b, 998244353, 3);
+
+  REQUIRE(c == std::vector<std::uint32_t>({4, 13, 22, 15}));
+}
+
+TEST_CASE("integer convolution", "[ntt]") {
+  std::vector<Integer> a, b;
+
+  for (long long i = 0; i < 300; i++) {
+    a.push_back(Integer::parse("123456789012345678901234567890") * Integer(i % 2 ? -i : i));
+    b.push_back(Integer(i * 7919 - 1000000));
+  }
+
+  std::vector<Integer> expected(a.size() + b.size() - 1);
+  for (unsigned long i = 0; i < a.size(); i++)
+    for (unsigned long j = 0; j < b.size(); j++)
+      expected[i + j] += a[i] * b[j];
+
+  REQUIRE(NTT::convolve(a, b) == expected);
+  REQUIRE(NTT::convolve(std::vector<Integer>{Integer(-3)}, std::vector<Integer>{Integer(5)}) ==
+          std::vector<Integer>{Integer(-15)});
+  REQUIRE(NTT::convolve(a, std::vector<Integer>()).empty());
+}
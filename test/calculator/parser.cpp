@@ -19,6 +19,25 @@ TEST_CASE("operator registration", "[parser]") {
 
     REQUIRE(std::next(std::next(parse("2=2").begin()))->value == "=");
   }
+
+  SECTION("finds registered operators") {
+    parser.register_operator("+", 1, -1);
+    parser.register_operator("\xff", 3, 1);
+    parser.register_operator("mod", 5, -1);
+    // the first registration is kept
+    parser.register_operator("+", 7, 1);
+
+    REQUIRE(parser.find_operator("+")->precedence == 1);
+    REQUIRE(parser.find_operator("+")->associativity == -1);
+    REQUIRE(parser.find_operator("\xff")->precedence == 3);
+    REQUIRE(parser.find_operator("mod")->precedence == 5);
+    REQUIRE(parser.find_operator("-") == nullptr);
+    REQUIRE(parser.find_operator("m") == nullptr);
+    REQUIRE(parser.find_operator("") == nullptr);
+
+    // unknown operator is reported before anything waiting is compared
+    REQUIRE_THROWS_AS(parse("2+2-2"), UnknownOperatorError);
+  }
 }
 
 TEST_CASE("precendence and associativity", "[parser]") {
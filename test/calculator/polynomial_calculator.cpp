@@ -66,6 +66,9 @@ TEST_CASE("polynomial calculator", "[calculator]") {
 
     REQUIRE((calc("17"), calc("ans")) == 17);
     REQUIRE(calc("bind(x^2+5, 2)") == 9);
+
+    // sign of nan is the same as of Horner method on coefficients
+    REQUIRE(std::string(calc("bind(log(-6,5)-x*log10(-1), 4)")) == "nan");
   }
 
   SECTION("precedence") {
@@ -76,6 +79,36 @@ TEST_CASE("polynomial calculator", "[calculator]") {
 
     REQUIRE(calc("2+2-4") == calc("-4+2+2"));
   }
+
+  SECTION("invalid numbers") {
+    REQUIRE_THROWS_AS(calc("1e400"), InvalidNumberError);
+    REQUIRE_THROWS_WITH(calc("2*(1+1e400)"), "Number 1e400 cannot be represented at 5");
+  }
+}
+
+TEST_CASE("power series calculator", "[calculator]") {
+  Tokenizer tokenizer;
+  Parser parser;
+  PolynomialCalculator calculator(tokenizer, parser);
+
+  REQUIRE_THROWS_AS(calc("1/(1-x)"), PolynomialDivisionError);
+  REQUIRE_THROWS_AS(calc("exp(x)"), PolynomialCastError);
+
+  calculator.set_series_order(4);
+
+  REQUIRE(calc("1/(1-x)") == Value({1, 1, 1, 1}));
+  REQUIRE(calc("x^2/(x+x^2)") == Value({0, 1, -1, 1}));
+  REQUIRE(calc("(x+1)^5") == Value({1, 5, 10, 10}));
+  REQUIRE(calc("x^4+2") == 2);
+  REQUIRE(calc("exp(log(1+2x, e))") == Value(1, 2));
+  REQUIRE(calc("2/4") == 0.5);
+  REQUIRE(calc("log10(100)") == 2);
+  REQUIRE_THROWS_AS(calc("1/x"), SeriesExpansionError);
+
+  calculator.set_series_order(0);
+
+  REQUIRE(calc("x^4+2") == Value({2, 0, 0, 0, 1}));
+  REQUIRE_THROWS_AS(calc("1/(1-x)"), PolynomialDivisionError);
 }
 
 TEST_CASE("extending calculator", "[calculator]") {
@@ -111,3 +144,76 @@ TEST_CASE("extending calculator", "[calculator]") {
     REQUIRE(calc("0=0") == 42);
   }
 }
+
+TEST_CASE("exact calculator", "[calculator]") {
+  Tokenizer tokenizer;
+  Parser parser;
+  BasicPolynomialCalculator<ExactValue> calculator(tokenizer, parser);
+
+  REQUIRE(calc("0.1+0.2") == ExactValue(Rational(3) / Rational(10)));
+  REQUIRE(calc("2^100")[0] == Rational(Integer(1) << 100));
+  REQUIRE(calc("2^-2") == ExactValue(0.25));
+  REQUIRE(calc("(x+1)^3") == ExactValue({1, 3, 3, 1}));
+  REQUIRE(calc("(x+1)^100")[50] == Rational(Integer::parse("100891344545564193334812497256")));
+  REQUIRE(calc("(x^2-1)/(x-1)") == ExactValue(1.0, 1.0));
+  REQUIRE(calc("ans*2") == ExactValue(2.0, 2.0));
+
+  // results are exact or rejected, never rounded
+  REQUIRE(calc("log(8, 2)") == ExactValue(3.0));
+  REQUIRE(calc("log(8, 4)") == ExactValue(1.5));
+  REQUIRE(calc("log10(0.001)") == ExactValue(-3.0));
+  REQUIRE(calc("exp(0)") == ExactValue(1.0));
+  REQUIRE(calc("4^0.5") == ExactValue(2.0));
+  REQUIRE(calc("(8/27)^(-2/3)") == ExactValue(2.25));
+  REQUIRE(calc("(-1)^(2^60+1)") == ExactValue(-1.0));
+  REQUIRE(calc("0^0") == ExactValue(1.0));
+
+  REQUIRE_THROWS_AS(calc("log(3, 2)"), ValueError);
+  REQUIRE_THROWS_AS(calc("log(-8, 2)"), ValueError);
+  REQUIRE_THROWS_AS(calc("exp(1)"), ValueError);
+  REQUIRE_THROWS_AS(calc("2^0.5"), ValueError);
+  REQUIRE_THROWS_AS(calc("(-4)^0.5"), ValueError);
+  REQUIRE_THROWS_AS(calc("2^(2^60)"), ValueError);
+  REQUIRE_THROWS_AS(calc("1/0"), ValueError);
+  REQUIRE_THROWS_AS(calc("0/0"), ValueError);
+  REQUIRE_THROWS_AS(calc("0^-1"), ValueError);
+  REQUIRE_THROWS_AS(calc("(x-x+1)/0"), ValueError);
+  REQUIRE_THROWS_WITH(calc("inf"), "Number inf cannot be represented at 0");
+
+  REQUIRE_THROWS_AS(calc("x^x"), ExponentationError);
+  REQUIRE_THROWS_AS(calc("x^0.5"), ExponentationError);
+  REQUIRE_THROWS_AS(calculator.set_series_order(4), ValueError);
+}
+
+TEST_CASE("coefficient types calculator", "[calculator]") {
+  Tokenizer tokenizer;
+  Parser parser;
+
+  SECTION("float") {
+    BasicPolynomialCalculator<FloatValue> calculator(tokenizer, parser);
+
+    REQUIRE(calc("(x+1)^2") == FloatValue({1, 2, 1}));
+    REQUIRE(calc("pi")[0] == float(M_PI));
+    REQUIRE(calc("log(8, 2)")[0] == Approx(3));
+  }
+
+  SECTION("long double") {
+    BasicPolynomialCalculator<LongDoubleValue> calculator(tokenizer, parser);
+
+    REQUIRE(calc("pi")[0] == 3.141592653589793238462643383279502884L);
+    REQUIRE(calc("1/3")[0] == 1.0L / 3);
+    REQUIRE(calc("2^0.5")[0] == std::sqrt(2.0L));
+  }
+
+#ifdef XXCALC_FLOAT128
+  SECTION("__float128") {
+    BasicPolynomialCalculator<Float128Value> calculator(tokenizer, parser);
+
+    // 1 + 2^-100 is not representable in smaller types
+    REQUIRE(calc("(1 + 1/2^100) - 1")[0] * std::pow(2.0L, 100) == 1);
+    REQUIRE(calc("(1 + 1/2^120) - 1")[0] == 0);
+    REQUIRE(calc("exp(log(10, e))")[0] - 10 < 1e-30L);
+    REQUIRE(calc("exp(log(10, e))")[0] - 10 > -1e-30L);
+  }
+#endif
+}
@@ -0,0 +1,158 @@
+#include "calculator/pratt_parser.hpp"
+#include "calculator/linear_solver.hpp"
+#include "catch.hpp"
+
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace XX::Calculator;
+
+namespace {
+
+//! Random text made of pieces of expressions, often not well-formed
+std::string random_line(std::mt19937& random) {
+  static const std::vector<std::string> pieces = {
+    "1", "2", "3.5", "0.1", "1e3", "2e-1", "10", "x", "x", "y", "pi", "e", "inf", "NaN", "ans",
+    "log(", "log10(", "exp(", "bind(", "+", "-", "-", "*", "/", "^", "=", "(", "(", ")", ")", ",",
+    " ", " ", "$", "_a"
+  };
+
+  std::string line;
+  std::size_t length = random() % 12;
+
+  for (std::size_t i = 0; i < length; i++)
+    line += pieces[random() % pieces.size()];
+
+  return line;
+}
+
+//! Result or error of an expression as text
+template <typename V>
+std::string outcome(BasicLinearSolver<V>& solver, std::string const& line) {
+  typename BasicLinearSolver<V>::Outcome result = solver.try_process(line);
+
+  if (!result.ok())
+    return std::string(result.status.name()) + " " + result.status.message();
+
+  return (solver.solved ? "x=" : "") + std::string(result.value);
+}
+
+}
+
+TEST_CASE("scanner", "[pratt_parser]") {
+  Tokenizer tokenizer;
+  Scanner scanner;
+  std::mt19937 random(7);
+
+  std::vector<std::string> lines = {"", "2+2", "-2", "--2", "2*-x", "-(1+2)", "2 - -x", "-inf+nan", "1e-5e3",
+                                    "log(2, -3)", "(-x)^-2", "a $ b", "  -  3", ", -x", "x--y"};
+  for (int i = 0; i < 1000; i++)
+    lines.push_back(random_line(random));
+
+  for (auto const& line : lines) {
+    TokenList tokens = tokenizer.process(line);
+    scanner.reset(line);
+
+    INFO(line);
+
+    for (auto const& token : tokens) {
+      REQUIRE(!scanner.at_end());
+
+      Scanner::Lexeme const& lexeme = scanner.peek();
+      std::string text = std::string(lexeme.sign != 0 ? 1 : 0, lexeme.sign) + std::string(lexeme.text, lexeme.length);
+
+      REQUIRE(lexeme.type == token.type);
+      REQUIRE(lexeme.position == token.position);
+      if (token.type != TokenType::BRACKET_OPENING && token.type != TokenType::BRACKET_CLOSING &&
+          token.type != TokenType::SEPARATOR)
+        REQUIRE(text == token.value);
+
+      scanner.next();
+    }
+
+    REQUIRE(scanner.at_end());
+  }
+}
+
+TEST_CASE("direct compilation", "[pratt_parser]") {
+  Tokenizer tokenizer;
+  Parser parser;
+  LinearSolver classic(tokenizer, parser);
+  LinearSolver direct(tokenizer, parser);
+  direct.set_direct_compilation(true);
+
+  SECTION("well-formed expressions") {
+    PrattParser pratt(parser);
+    Evaluator evaluator;
+    Evaluator::Program program;
+
+    for (std::string line : {"2+2*2", "2x+1", "2(3+4)", "-x^2", "2^3^2", "2^-x", "log(100, 10)+pi",
+                             "1-2-3-4", "(((1)))", "-(-(2))", "2^3x", "x=2"}) {
+      INFO(line);
+      REQUIRE(pratt.compile(line, evaluator, program));
+      REQUIRE(outcome(direct, line) == outcome(classic, line));
+    }
+
+    REQUIRE(direct.process("2^3^2") == 512);
+    REQUIRE(direct.process("2x+1=2(1-x)") == 0.25);
+    REQUIRE(direct.solved);
+  }
+
+  SECTION("other expressions are parsed as before") {
+    PrattParser pratt(parser);
+    Evaluator evaluator;
+    Evaluator::Program program;
+
+    for (std::string line : {"", "()", "(1+2", "1+2)", "2 3", "2+", "+", "1,2", "2 $ 3", "(2)(3)"}) {
+      INFO(line);
+      REQUIRE(!pratt.compile(line, evaluator, program));
+      REQUIRE(outcome(direct, line) == outcome(classic, line));
+    }
+
+    // errors found by the evaluator come from the same program
+    REQUIRE(outcome(direct, "log(2)") == "ARGUMENT_MISSING Argument is missing for function 'log' at 0");
+    REQUIRE(outcome(direct, "2+y*(3") == "MISSING_BRACKET Bracket is missing at 4");
+    REQUIRE_THROWS_AS(direct.process("2+y"), UnknownSymbolError);
+  }
+
+  SECTION("the same results and errors as tokens parsed by the parser") {
+    // infinite exponents of x were cast to unsigned long
+    REQUIRE(outcome(direct, "x-^inf/1^1e3e*") == outcome(classic, "x-^inf/1^1e3e*"));
+    REQUIRE(outcome(direct, "x^inf") == "EXPONENTATION Exponent is too large");
+
+    // seeded, so every run checks the same lines
+    std::mt19937 random(42);
+
+    for (int i = 0; i < 20000; i++) {
+      std::string line = random_line(random);
+
+      INFO(line);
+      REQUIRE(outcome(direct, line) == outcome(classic, line));
+    }
+  }
+
+  SECTION("exact values") {
+    BasicLinearSolver<ExactValue> exact_classic(tokenizer, parser);
+    BasicLinearSolver<ExactValue> exact_direct(tokenizer, parser);
+    exact_direct.set_direct_compilation(true);
+    std::mt19937 random(3);
+
+    for (int i = 0; i < 2000; i++) {
+      std::string line = random_line(random);
+
+      INFO(line);
+      REQUIRE(outcome(exact_direct, line) == outcome(exact_classic, line));
+    }
+  }
+
+  SECTION("deep expressions") {
+    std::string line = std::string(5000, '(') + "1" + std::string(5000, ')');
+    REQUIRE(direct.process(line) == 1);
+
+    line = "2";
+    for (int i = 0; i < 5000; i++)
+      line += "^1";
+    REQUIRE(direct.process(line) == 2);
+  }
+}
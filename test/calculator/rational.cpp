@@ -0,0 +1,77 @@
+#include "calculator/rational.hpp"
+#include "calculator/errors.hpp"
+#include "catch.hpp"
+
+#include <limits>
+#include <sstream>
+
+using namespace XX::Calculator;
+
+namespace {
+
+std::string str(Rational const& r) {
+  std::ostringstream output;
+  output << r;
+  return output.str();
+}
+
+}
+
+TEST_CASE("rational initialization", "[rational]") {
+  REQUIRE(str(Rational()) == "0");
+  REQUIRE(str(Rational(Integer(6), Integer(-4))) == "-3/2");
+  REQUIRE(str(Rational::parse("0.1")) == "1/10");
+  REQUIRE(str(Rational::parse("1.25e2")) == "125");
+  REQUIRE(str(Rational::parse("5E-3")) == "1/200");
+  REQUIRE(str(Rational::parse("inf")) == "inf");
+  REQUIRE(str(Rational::from_double(0.5)) == "1/2");
+  REQUIRE(str(Rational::from_double(0.1)) == "3602879701896397/36028797018963968");
+  REQUIRE(str(Rational::from_double(-std::numeric_limits<double>::infinity())) == "-inf");
+  REQUIRE(Rational::from_double(std::numeric_limits<double>::quiet_NaN()).is_nan());
+
+  REQUIRE_THROWS_AS(Rational::parse("."), std::invalid_argument);
+}
+
+TEST_CASE("rational arithmetic", "[rational]") {
+  Rational third = Rational(1) / Rational(3);
+  Rational sixth = Rational(1) / Rational(6);
+
+  REQUIRE(str(third + sixth) == "1/2");
+  REQUIRE(str(third - sixth) == "1/6");
+  REQUIRE(str(third * sixth) == "1/18");
+  REQUIRE(str(third / sixth) == "2");
+  REQUIRE(str(Rational(2).power(-3)) == "1/8");
+  REQUIRE((third + sixth).is_integer() == false);
+  REQUIRE((third * Rational(3)).is_integer());
+  REQUIRE(double(third) == 1.0 / 3.0);
+
+  REQUIRE(third > sixth);
+  REQUIRE(-third < sixth);
+}
+
+TEST_CASE("rational roots", "[rational]") {
+  Rational root;
+
+  REQUIRE(Rational(Integer(8), Integer(27)).root(3, root));
+  REQUIRE(str(root) == "2/3");
+  REQUIRE(Rational(-32).root(5, root));
+  REQUIRE(str(root) == "-2");
+  REQUIRE(Rational::parse("1e300").power(2).root(2, root));
+  REQUIRE(str(root) == str(Rational::parse("1e300")));
+  REQUIRE(Rational(0).root(7, root));
+  REQUIRE(str(root) == "0");
+
+  REQUIRE_FALSE(Rational(2).root(2, root));
+  REQUIRE_FALSE(Rational(-4).root(2, root));
+  REQUIRE_FALSE(Rational(Integer(1), Integer(8)).root(2, root));
+  REQUIRE_FALSE((Rational(1) / Rational(0)).root(3, root));
+}
+
+TEST_CASE("rational extended values", "[rational]") {
+  REQUIRE(str(Rational(1) / Rational(0)) == "inf");
+  REQUIRE(str(Rational(-1) / Rational(0)) == "-inf");
+  REQUIRE(isnan(Rational(0) / Rational(0)));
+  REQUIRE(isnan(Rational(1) / Rational(0) - Rational(1) / Rational(0)));
+  REQUIRE(isinf(Rational(1) / Rational(0) + Rational(1)));
+  REQUIRE(Rational(0) / Rational(0) != Rational(0) / Rational(0));
+}
@@ -0,0 +1,111 @@
+#include "calculator/status.hpp"
+#include "calculator/linear_solver.hpp"
+#include "catch.hpp"
+
+#include <string>
+
+using namespace XX::Calculator;
+
+TEST_CASE("failures without exceptions", "[status]") {
+  Tokenizer tokenizer;
+  Parser parser;
+  LinearSolver solver(tokenizer, parser);
+
+  SECTION("the same codes and messages as thrown errors") {
+    for (std::string line : {"", "()", "2 $ 3", "(2+3", "2+3)", "y+1", "log(2)", "2 3",
+                             "x^2=5", "2=2", "x=x", "x=x+1", "x/x^2", "x^0.5", "1e999999"}) {
+      std::string thrown;
+      Status expected;
+
+      try {
+        solver.process(line);
+      }
+      catch (Error& error) {
+        thrown = error.what();
+        expected = Status::of(error);
+      }
+
+      LinearSolver::Outcome outcome = solver.try_process(line);
+
+      INFO(line);
+      REQUIRE(!outcome.ok());
+      REQUIRE(outcome.status.code == expected.code);
+      REQUIRE(outcome.status.message() == thrown);
+      REQUIRE(std::string(outcome.status.name()) == expected.name());
+    }
+  }
+
+  SECTION("failures of parsing and evaluation have position and detail") {
+    Status status;
+
+    solver.process("2+foo*3", status);
+    REQUIRE(status.code == ErrorCode::UNKNOWN_SYMBOL);
+    REQUIRE(status.position == 2);
+    REQUIRE(status.detail == "foo");
+    REQUIRE(std::string(status.name()) == "UNKNOWN_SYMBOL");
+
+    status = Status();
+    solver.process("(1+2", status);
+    REQUIRE(status.code == ErrorCode::MISSING_BRACKET);
+    REQUIRE(status.position == 0);
+
+    status = Status();
+    solver.process("x=x", status);
+    REQUIRE(status.code == ErrorCode::TAUTOLOGY);
+    REQUIRE(solver.solved == false);
+  }
+
+  SECTION("last value is kept on failure") {
+    REQUIRE(solver.try_process("2*3").value == 6);
+    REQUIRE(!solver.try_process("2*y").ok());
+    REQUIRE(!solver.try_process("x=x").ok());
+    REQUIRE(solver.last_value == 6);
+    REQUIRE(solver.try_process("ans+1").value == 7);
+
+    LinearSolver::Outcome outcome = solver.try_process("2x=1");
+    REQUIRE(outcome.ok());
+    REQUIRE(outcome.value == 0.5);
+    REQUIRE(solver.solved);
+  }
+
+  SECTION("compiled programs") {
+    TokenList tokens = parser.process(tokenizer.process("x+y"));
+    LinearSolver::Outcome outcome = solver.try_process([&](Evaluator& evaluator, Evaluator::Program& program) {
+      evaluator.compile(tokens, program);
+    });
+
+    REQUIRE(outcome.status.code == ErrorCode::UNKNOWN_SYMBOL);
+    REQUIRE(outcome.status.message() == "Unknown symbol 'y' at 2");
+  }
+
+  SECTION("calculator is usable after failures") {
+    for (int i = 0; i < 100; i++) {
+      REQUIRE(!solver.try_process("((2+3)*").ok());
+      REQUIRE(solver.try_process("(2+3)*4").value == 20);
+    }
+  }
+}
+
+TEST_CASE("raising failures", "[status]") {
+  REQUIRE_NOTHROW(Status().raise());
+  REQUIRE(Status().ok());
+
+  REQUIRE_THROWS_AS(Status(ErrorCode::EMPTY_EXPRESSION).raise(), EmptyExpressionError);
+  REQUIRE_THROWS_AS(Status(ErrorCode::UNKNOWN_OPERATOR, 1, "$").raise(), UnknownOperatorError);
+  REQUIRE_THROWS_AS(Status(ErrorCode::MISSING_BRACKET, 3).raise(), MissingBracketError);
+  REQUIRE_THROWS_AS(Status(ErrorCode::UNKNOWN_SYMBOL, 0, "y").raise(), UnknownSymbolError);
+  REQUIRE_THROWS_AS(Status(ErrorCode::ARGUMENT_MISSING, 0, "log").raise(), ArgumentMissingError);
+  REQUIRE_THROWS_AS(Status(ErrorCode::TAUTOLOGY).raise(), ExpressionIsTautology);
+  REQUIRE_THROWS_WITH(Status(ErrorCode::UNKNOWN_SYMBOL, 4, "y").raise(), "Unknown symbol 'y' at 4");
+  REQUIRE_THROWS_WITH(Status(ErrorCode::INVALID_NUMBER, 2, "1e400").raise(), "Number 1e400 cannot be represented at 2");
+
+  // failures made of errors keep their kind and message
+  Status status = Status::of(PolynomialDivisionError());
+  REQUIRE(status.code == ErrorCode::POLYNOMIAL_DIVISION);
+  REQUIRE_THROWS_AS(status.raise(), ValueError);
+  REQUIRE_THROWS_WITH(status.raise(), PolynomialDivisionError().what());
+
+  // functions report failures only during evaluation
+  Evaluator evaluator;
+  REQUIRE_THROWS_AS(evaluator.fail(Status(ErrorCode::NON_SOLVABLE)), NonSolvableExpression);
+}
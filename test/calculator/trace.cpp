@@ -0,0 +1,66 @@
+#include "calculator/trace.hpp"
+#include "calculator/linear_solver.hpp"
+#include "catch.hpp"
+
+using namespace XX::Calculator;
+
+TEST_CASE("histogram", "[trace]") {
+  Histogram histogram;
+
+  REQUIRE(histogram.snapshot().count == 0);
+  REQUIRE(histogram.snapshot().percentile(50) == 0);
+
+  for (std::uint64_t i = 1; i <= 1000; i++)
+    histogram.record(i);
+  histogram.record(0);
+
+  Histogram::Snapshot s = histogram.snapshot();
+  REQUIRE(s.count == 1001);
+  REQUIRE(s.sum == 500500);
+  REQUIRE(s.max == 1000);
+  REQUIRE(s.counts[0] == 1);
+  REQUIRE(s.counts[1] == 1);
+  REQUIRE(s.counts[10] == 1000 - 511);
+
+  // percentiles are upper bounds of buckets
+  REQUIRE(s.percentile(0) == 0);
+  REQUIRE(s.percentile(50) == 511);
+  REQUIRE(s.percentile(99) == 1000);
+  REQUIRE(s.percentile(100) == 1000);
+
+  histogram.record(~std::uint64_t(0));
+  REQUIRE(histogram.snapshot().counts[64] == 1);
+  REQUIRE(histogram.snapshot().percentile(100) == ~std::uint64_t(0));
+
+  histogram.reset();
+  REQUIRE(histogram.snapshot().count == 0);
+  REQUIRE(histogram.snapshot().max == 0);
+}
+
+TEST_CASE("traces of calculations", "[trace]") {
+  Tokenizer tokenizer;
+  Parser parser;
+  LinearSolver solver(tokenizer, parser);
+
+  Trace::reset();
+  solver.process("(x+1)^2");
+  solver.process("2+2*2");
+
+  std::string output;
+  Trace::dump(output);
+  REQUIRE(output.find("tokenize_ns") != std::string::npos);
+  REQUIRE(output.find("degree") != std::string::npos);
+
+  // calculators record only when tracing is built in
+  if (Trace::enabled()) {
+    REQUIRE(Trace::histogram(Trace::TOKENIZE).snapshot().count == 2);
+    REQUIRE(Trace::histogram(Trace::EVALUATE).snapshot().count == 2);
+    REQUIRE(Trace::histogram(Trace::TOKENS).snapshot().max == 7);
+    REQUIRE(Trace::histogram(Trace::STACK_DEPTH).snapshot().max == 3);
+    REQUIRE(Trace::histogram(Trace::DEGREE).snapshot().max == 2);
+    REQUIRE(Trace::histogram(Trace::ELIMINATED).snapshot().count == 1);
+  } else {
+    for (int i = 0; i < Trace::METRICS; i++)
+      REQUIRE(Trace::histogram(Trace::Metric(i)).snapshot().count == 0);
+  }
+}
@@ -22,6 +22,10 @@ TEST_CASE("initialization", "[value]") {
   REQUIRE(zero[3] == 3.0);
   REQUIRE(zero[4] == 0.0);
   REQUIRE(zero[5] == 5.0);
+
+  Value const empty(std::vector<double>{});
+  REQUIRE(empty[0] == 0.0);
+  REQUIRE(Value(1.0, 2.0)[7] == 0.0);
 }
 
 TEST_CASE("casting", "[value]") {
@@ -119,6 +123,12 @@ TEST_CASE("string conversion", "[value]") {
   REQUIRE(std::string(Value(-1, 2)) == "2x-1");
   REQUIRE(std::string(Value({1, 0, -2})) == "-2x^2+1");
   REQUIRE(std::string(Value({-1, 0, -2})) == "-2x^2-1");
+  REQUIRE(std::string(Value({0.5, 1234567, -1e-7})) == "-1e-07x^2+1.23457e+06x+0.5");
+
+  std::string output("x=");
+  Value({1, 0, 2}).repr(output, "y");
+  Value(-0.0).repr(output, "y");
+  REQUIRE(output == "x=2y^2+1-0");
 }
 
 TEST_CASE("polynomial evaluation", "[value]") {
@@ -129,3 +139,66 @@ TEST_CASE("polynomial evaluation", "[value]") {
   REQUIRE(Value({1, 0, 2})(2) == 9);
   REQUIRE_THROWS_AS(Value({1, 0, 2})({1,2}), PolynomialCastError);
 }
+
+TEST_CASE("coefficient types", "[value]") {
+  REQUIRE(FloatValue({1, 2, 3}) * FloatValue(2) == FloatValue({2, 4, 6}));
+  REQUIRE(std::string(FloatValue::parse("0.1") * FloatValue(0, 1)) == "0.1x");
+  REQUIRE(float(FloatValue::parse("0.1")) == 0.1f);
+  REQUIRE_THROWS_AS(FloatValue::parse("1e39"), std::out_of_range);
+
+  REQUIRE(LongDoubleValue::parse("0.1")[0] == 0.1L);
+  REQUIRE(LongDoubleValue({1, 0, 1}) / LongDoubleValue(1, 1) == LongDoubleValue(-1, 1));
+  REQUIRE(std::string(LongDoubleValue({-1, 0, 2})) == "2x^2-1");
+
+#ifdef XXCALC_FLOAT128
+  Float128Value third = Float128Value(1) / Float128Value(3);
+  REQUIRE(third[0] * 3 == 1);
+  REQUIRE(third[0] != __float128(1.0L / 3));
+  REQUIRE(std::string(Float128Value(-1, third[0])) == "0.333333x-1");
+  REQUIRE(Float128Value::parse("1e4000")[0] > std::numeric_limits<long double>::max() / 1e4000L);
+  REQUIRE_THROWS_AS(Float128Value::parse("x"), std::invalid_argument);
+#endif
+}
+
+TEST_CASE("integer coefficients", "[value]") {
+  REQUIRE(Value().is_integral());
+  REQUIRE(Value({1, -2, 3}).is_integral());
+  REQUIRE_FALSE(Value(1, 0.5).is_integral());
+  REQUIRE_FALSE(Value(-0.0).is_integral());
+  REQUIRE_FALSE(Value(std::numeric_limits<double>::quiet_NaN()).is_integral());
+  REQUIRE(Value::parse("-42").is_integral());
+  REQUIRE(Value::parse("-42") == Value(-42));
+  REQUIRE_FALSE(Value::parse("0.5").is_integral());
+  REQUIRE(std::string(Value::parse("-0")) == "-0");
+
+  SECTION("exact operations") {
+    Value a({1, 2, 3});
+    REQUIRE((a + a).is_integral());
+    REQUIRE((a - a).is_integral());
+    REQUIRE((a * a) == Value({1, 4, 10, 12, 9}));
+    REQUIRE((a * a).is_integral());
+    REQUIRE((a * Value(0.5)) == Value({0.5, 1, 1.5}));
+    REQUIRE_FALSE((a * Value(0.5)).is_integral());
+  }
+
+  SECTION("promotion") {
+    Value large(std::ldexp(1.0, 52));
+    REQUIRE(large.is_integral());
+    REQUIRE((large + large).is_integral());
+    REQUIRE_FALSE((large + large + large).is_integral());
+    REQUIRE((large + large + large)[0] == 3 * std::ldexp(1.0, 52));
+    REQUIRE_FALSE((large * large).is_integral());
+    REQUIRE((large * large)[0] == std::ldexp(1.0, 104));
+
+    // negative zero is kept as in double arithmetic
+    REQUIRE(std::string(Value(0) * Value(-1)) == "-0");
+    REQUIRE(std::string(Value(0, 1) * Value(-1) - Value(0, -1)) == "0");
+  }
+
+  SECTION("division") {
+    REQUIRE((Value({-1, 0, 1}) / Value(-1, 1)).is_integral());
+    REQUIRE((Value({-1, 0, 1}) / Value(-1, 1)) == Value(1, 1));
+    REQUIRE_FALSE((Value(1) / Value(3)).is_integral());
+    REQUIRE((Value(1) / Value(3))[0] == 1.0 / 3);
+  }
+}